@@ -3,6 +3,10 @@
 #include <WiFi.h>
 #include <WiFiUdp.h>
 
+// Link protocol shared with the Teensy (include/ of the main project)
+#include "SpiLink.h"
+#include "SpscRing.h"
+
 // --- Configuration ---
 // VSPI Pins
 #define GPIO_MOSI 23
@@ -14,174 +18,299 @@
 #define RCV_HOST VSPI_HOST
 #define DMA_CHAN 2
 
-#define MAX_SPI_BUF 256
+// Two tasks, one per core, joined by lock-free SPSC queues of datagrams:
+//   SPI task (core 1, with the SPI interrupt): keeps SPI_QUEUED transactions
+//     queued in the slave driver, so one is always armed when the Teensy
+//     selects us. Each completion is unpacked, and its buffers get the next
+//     frame and go back at the end of the queue.
+//   UDP task (core 0, with the WiFi stack): socket to toSpi, toNet to socket,
+//     and WiFi config/status.
+// READY is high while a queued frame has something for the Teensy, or
+// datagrams are waiting in toSpi (frames queued after that carry them).
+#define SPI_QUEUED 2        // Transactions queued ahead in the slave driver
+#define BRIDGE_SLOTS 32     // Datagrams per queue (each way)
+#define SPI_TASK_PRIO 10    // Above loop(); the WiFi stack runs on core 0
+#define UDP_TASK_PRIO 5
+#define TASK_STACK 4096
+#define UDP_POLL_TICKS 1 // Socket check interval with nothing from the Teensy
+
+struct Datagram {
+  uint8_t ip[4];
+  uint16_t port;
+  uint16_t len;
+  uint8_t data[SPILINK_MAX_DATAGRAM];
+};
 
 // --- Globals ---
 WiFiUDP udp;
-WORD_ALIGNED_ATTR char sendbuf[MAX_SPI_BUF] = "";
-WORD_ALIGNED_ATTR char recvbuf[MAX_SPI_BUF] = "";
-spi_slave_transaction_t t;
+SpscRing<Datagram, BRIDGE_SLOTS> toSpi; // UDP task -> SPI task
+SpscRing<Datagram, BRIDGE_SLOTS> toNet; // SPI task -> UDP task
+WORD_ALIGNED_ATTR uint8_t sendbuf[SPI_QUEUED][SPILINK_BUFFER];
+WORD_ALIGNED_ATTR uint8_t recvbuf[SPI_QUEUED][SPILINK_BUFFER];
+spi_slave_transaction_t trans[SPI_QUEUED];
+bool hasData[SPI_QUEUED]; // Queued frame carries something for the Teensy
+SpiLinkSlave spiLink;
+TaskHandle_t udpTask = NULL;
 
-void setup() {
-  Serial.begin(115200);
-  delay(2000);
+// UDP task -> SPI task (one writer each)
+volatile bool wifiUp = false;
+volatile uint32_t localIp = 0;
 
-  WiFi.mode(WIFI_STA);
-  WiFi.disconnect();
+// Counters (one writer each: net* and sendFails/tooLong by the UDP task)
+volatile uint32_t netRxPackets = 0, netRxBytes = 0;
+volatile uint32_t netTxPackets = 0, netTxBytes = 0;
+volatile uint32_t sendFails = 0, tooLong = 0;
 
-  pinMode(GPIO_READY, OUTPUT);
-  digitalWrite(GPIO_READY, LOW);
+// WiFi config: SPI task -> UDP task (applied there, it blocks)
+struct WifiConfig {
+  char ssid[33];
+  char pass[65];
+};
+SpscRing<WifiConfig, 2> configs;
+
+// SPI task side of the link: datagrams to and from the queues
+class BridgePort : public SpiLinkPort {
+public:
+  uint16_t nextDatagram(uint8_t *ip, uint16_t *port, uint8_t *data,
+                        uint16_t maxLen) override {
+    if (!toSpi.available())
+      return 0;
+    Datagram *d = toSpi.peek();
+    if (d->len > maxLen)
+      return 0; // It goes in the next frame
+    memcpy(ip, d->ip, 4);
+    *port = d->port;
+    memcpy(data, d->data, d->len);
+    uint16_t len = d->len;
+    toSpi.consume();
+    return len;
+  }
+
+  bool hasDatagram() override { return toSpi.available() > 0; }
+
+  // The Teensy keeps within our credits, so toNet has room
+  bool onDatagram(const uint8_t *ip, uint16_t port, const uint8_t *data,
+                  uint16_t len) override {
+    Datagram *d = toNet.reserve();
+    if (!d)
+      return false;
+    memcpy(d->ip, ip, 4);
+    d->port = port;
+    d->len = len;
+    memcpy(d->data, data, len);
+    toNet.commit();
+    xTaskNotifyGive(udpTask);
+    return true;
+  }
+
+  // Free toNet slots. A frame queued ahead carries an older figure, but with
+  // the ACK of the same moment, so the Teensy still counts what it sent since.
+  uint8_t credits() override {
+    uint32_t used = toNet.available();
+    uint32_t room = used < BRIDGE_SLOTS ? BRIDGE_SLOTS - used : 0;
+    return room > 255 ? 255 : room;
+  }
+
+  // [ID] [SSID_LEN] [SSID] [PASS_LEN] [PASS]
+  void onConfig(const uint8_t *data, uint16_t len) override {
+    uint8_t ssidLen = data[1];
+    if (ssidLen == 0 || ssidLen > 32 || 3 + ssidLen > len)
+      return;
+    uint8_t passLen = data[2 + ssidLen];
+    if (passLen > 64 || 3 + ssidLen + passLen > len)
+      return;
+    WifiConfig *c = configs.reserve();
+    if (!c)
+      return;
+    memset(c, 0, sizeof(*c));
+    memcpy(c->ssid, data + 2, ssidLen);
+    memcpy(c->pass, data + 3 + ssidLen, passLen);
+    configs.commit();
+    xTaskNotifyGive(udpTask);
+  }
+
+  bool getBridgeStats(SpiLinkBridgeStats *s) override {
+    s->uptimeMs = millis();
+    s->netRxPackets = netRxPackets;
+    s->netRxBytes = netRxBytes;
+    s->netTxPackets = netTxPackets;
+    s->netTxBytes = netTxBytes;
+    s->toSpiDrops = toSpi.getOverflows();
+    s->toNetDrops = toNet.getOverflows();
+    s->sendFails = sendFails;
+    s->tooLong = tooLong;
+    s->toSpiHigh = toSpi.getHighWater();
+    s->toSpiSlots = BRIDGE_SLOTS;
+    s->toNetHigh = toNet.getHighWater();
+    s->toNetSlots = BRIDGE_SLOTS;
+    return true;
+  }
+} port;
 
-  // 2. Setup SPI Bus
+// Next frame into slot i's buffers, then to the end of the driver queue
+static void queueFrame(int i) {
+  uint32_t ip = localIp;
+  uint8_t addr[4] = {(uint8_t)(ip >> 24), (uint8_t)(ip >> 16),
+                     (uint8_t)(ip >> 8), (uint8_t)ip};
+  spiLink.setLinkUp(wifiUp);
+  spiLink.setAddress(addr);
+  uint16_t len = spiLink.build(sendbuf[i], port);
+  memset(sendbuf[i] + len, 0, SPILINK_BUFFER - len);
+  hasData[i] = len > SPILINK_HEADER + SPILINK_CRC;
+
+  memset(&trans[i], 0, sizeof(trans[i]));
+  trans[i].length = SPILINK_BUFFER * 8;
+  trans[i].tx_buffer = sendbuf[i];
+  trans[i].rx_buffer = recvbuf[i];
+  trans[i].user = (void *)(intptr_t)i;
+  spi_slave_queue_trans(RCV_HOST, &trans[i], portMAX_DELAY);
+}
+
+// READY: a queued frame has data, or toSpi has datagrams for the next ones.
+// The UDP task raises it too; we only lower it here, and check toSpi after.
+static void updateReady() {
+  bool ready = toSpi.available() > 0;
+  for (int i = 0; i < SPI_QUEUED; i++)
+    ready = ready || hasData[i];
+  digitalWrite(GPIO_READY, ready ? HIGH : LOW);
+}
+
+void spiTask(void *arg) {
+  (void)arg;
   spi_bus_config_t buscfg = {
       .mosi_io_num = GPIO_MOSI,
       .miso_io_num = GPIO_MISO,
       .sclk_io_num = GPIO_SCLK,
       .quadwp_io_num = -1,
       .quadhd_io_num = -1,
-      .max_transfer_sz = MAX_SPI_BUF,
+      .max_transfer_sz = SPILINK_BUFFER,
   };
-
-  // 3. Setup SPI Slave Interface
   spi_slave_interface_config_t slvcfg = {.spics_io_num = GPIO_CS,
                                          .flags = 0,
-                                         .queue_size = 3,
+                                         .queue_size = SPI_QUEUED,
                                          .mode = 0,
                                          .post_setup_cb = NULL,
                                          .post_trans_cb = NULL};
 
-  // 4. Initialize
+  // Initialized here so the SPI interrupt lands on this core
   esp_err_t ret = spi_slave_initialize(RCV_HOST, &buscfg, &slvcfg, DMA_CHAN);
   if (ret != ESP_OK) {
     Serial.print("SPI Init Failed: ");
     Serial.println(ret);
-  } else {
-    Serial.println("ESP32 SPI Debug Mode Started");
+    vTaskDelete(NULL);
+    return;
+  }
+  Serial.printf("ESP32 SPI link v%u started\n", SPILINK_VERSION);
+
+  for (int i = 0; i < SPI_QUEUED; i++)
+    queueFrame(i);
+  updateReady();
+
+  for (;;) {
+    spi_slave_transaction_t *done;
+    if (spi_slave_get_trans_result(RCV_HOST, &done, portMAX_DELAY) != ESP_OK)
+      continue;
+    int i = (int)(intptr_t)done->user;
+    hasData[i] = false;
+    digitalWrite(GPIO_READY, LOW);
+    spiLink.receive(recvbuf[i], done->trans_len / 8, port);
+    queueFrame(i);
+    updateReady();
   }
 }
 
-void loop() {
-  memset(recvbuf, 0, MAX_SPI_BUF);
-  t.length = MAX_SPI_BUF * 8;
-  t.tx_buffer = sendbuf;
-  t.rx_buffer = recvbuf;
-
-  // Timeout 100ms
-  esp_err_t ret = spi_slave_transmit(RCV_HOST, &t, pdMS_TO_TICKS(100));
-
-  if (ret == ESP_OK) {
-    size_t bytesTransferred = t.trans_len / 8;
-
-    // DEBUG: Print Any Transfer
-    if (bytesTransferred > 0) {
-      // Serial.print("RX: "); Serial.print(bytesTransferred); Serial.print(" B.
-      // Cmd: 0x"); Serial.println((uint8_t)recvbuf[0], HEX);
-
-      uint8_t cmd = (uint8_t)recvbuf[0];
-
-      if (cmd == 0x10) { // CMD_SEND_UDP
-        if (bytesTransferred >= 9) {
-          uint16_t payloadLen =
-              ((uint8_t)recvbuf[1] << 8) | (uint8_t)recvbuf[2];
-          if (bytesTransferred >= (9 + payloadLen)) {
-            IPAddress ip((uint8_t)recvbuf[3], (uint8_t)recvbuf[4],
-                         (uint8_t)recvbuf[5], (uint8_t)recvbuf[6]);
-            uint16_t port = ((uint8_t)recvbuf[7] << 8) | (uint8_t)recvbuf[8];
-
-            udp.beginPacket(ip, port);
-            udp.write((uint8_t *)&recvbuf[9], payloadLen);
-            udp.endPacket();
-          }
-        }
-      } else if (cmd == 0x02) { // CMD_SET_CONFIG
-        Serial.println("Got Config Command!");
-        // Try to parse SSID
-        uint8_t ssidLen = (uint8_t)recvbuf[1];
-        if (ssidLen > 0 && ssidLen < 32) {
-          char ssid[33] = {0};
-          memcpy(ssid, &recvbuf[2], ssidLen);
-          uint8_t passOffset = 2 + ssidLen;
-          uint8_t passLen = (uint8_t)recvbuf[passOffset];
-          char pass[64] = {0};
-          if (passLen > 0 && passLen < 64)
-            memcpy(pass, &recvbuf[passOffset + 1], passLen);
-
-          Serial.print("Setting WiFi: ");
-          Serial.println(ssid);
-
-          // Fix "sta is connecting" error
-          WiFi.disconnect();
-          delay(100);
-          WiFi.begin(ssid, pass);
-
-          Serial.print("Parsed Pass: ");
-          Serial.println(pass);
-
-          // FORCE HARDCODED CREDENTIALS FOR TEST
-          // To verify if connection works at all.
-          // Serial.println("Using HARDCODED Credentials for Test...");
-          // WiFi.disconnect();
-          // delay(100);
-          // WiFi.begin("ImWatchinYou", "n0Password");
-          WiFi.begin(ssid, pass); // Restore Original Logic
-          Serial.println("Connecting WiFi...");
-        }
-      } else if (cmd == 0x03) { // CMD_GET_IP
-        Serial.println("Got Get-IP Command!");
-        sendbuf[0] = 0x01;
-        sendbuf[1] = 0x00;
-        sendbuf[2] = 0x04;
-        IPAddress myIP = WiFi.localIP();
-        sendbuf[3] = myIP[0];
-        sendbuf[4] = myIP[1];
-        sendbuf[5] = myIP[2];
-        sendbuf[6] = myIP[3];
-        digitalWrite(GPIO_READY, HIGH);
-      }
+// Everything waiting in the socket (the one the first send opened; only the
+// UDP task touches it). A full toSpi drops, counted by the ring: the Teensy
+// is not keeping up, and the network would drop too.
+// parsePacket() returns 0 while the last datagram is still held, read or
+// not, so each one is released with flush(); a dropped datagram left held
+// would stop reception for good.
+static void pollSocket() {
+  int n;
+  while ((n = udp.parsePacket()) > 0) {
+    Datagram *d = nullptr;
+    int got = 0;
+    if (n > SPILINK_MAX_DATAGRAM) {
+      tooLong++;
+    } else if ((d = toSpi.reserve()) != nullptr) {
+      IPAddress from = udp.remoteIP();
+      d->ip[0] = from[0];
+      d->ip[1] = from[1];
+      d->ip[2] = from[2];
+      d->ip[3] = from[3];
+      d->port = udp.remotePort();
+      got = udp.read(d->data, n);
     }
+    udp.flush();
+    if (got <= 0)
+      continue;
+    d->len = got;
+    toSpi.commit();
+    netRxPackets++;
+    netRxBytes += got;
+    digitalWrite(GPIO_READY, HIGH);
   }
+}
 
-  // --- UDP RECEIVE LOGIC ---
-  // Only if we aren't already waiting to send something
-  if (sendbuf[0] == 0x00) {
-    int packetSize = udp.parsePacket();
-    if (packetSize > 0) {
-      // Protocol:
-      // Byte 0: STATUS_HAS_DATA (0x01)
-      // Byte 1: High Byte Length
-      // Byte 2: Low Byte Length
-      // Byte 3..N: Payload
-
-      // Cap size to fit in buffer (Max 4096 - 4 header bytes)
-      if (packetSize > 4000)
-        packetSize = 4000;
-
-      sendbuf[0] = 0x01; // STATUS_HAS_DATA
-      sendbuf[1] = (packetSize >> 8) & 0xFF;
-      sendbuf[2] = (packetSize & 0xFF);
+// Network side: socket -> toSpi, toNet -> socket, WiFi config and status
+void udpTaskMain(void *arg) {
+  (void)arg;
+  for (;;) {
+    bool up = WiFi.status() == WL_CONNECTED;
+    IPAddress myIP = WiFi.localIP();
+    localIp = ((uint32_t)myIP[0] << 24) | ((uint32_t)myIP[1] << 16) |
+              ((uint32_t)myIP[2] << 8) | myIP[3];
+    wifiUp = up;
 
-      udp.read((char *)&sendbuf[3], packetSize);
+    while (configs.available()) {
+      WifiConfig *c = configs.peek();
+      Serial.print("Setting WiFi: ");
+      Serial.println(c->ssid);
+      // Fix "sta is connecting" error
+      WiFi.disconnect();
+      vTaskDelay(pdMS_TO_TICKS(100));
+      WiFi.begin(c->ssid, c->pass);
+      configs.consume();
+    }
 
-      // Debug
-      // Serial.print("UDP RX: "); Serial.print(packetSize); Serial.println("
-      // bytes. Queued for SPI.");
+    pollSocket();
 
-      digitalWrite(GPIO_READY, HIGH);
+    // Everything the Teensy sent
+    while (toNet.available()) {
+      Datagram *d = toNet.peek();
+      udp.beginPacket(IPAddress(d->ip[0], d->ip[1], d->ip[2], d->ip[3]),
+                      d->port);
+      udp.write(d->data, d->len);
+      if (udp.endPacket()) {
+        netTxPackets++;
+        netTxBytes += d->len;
+      } else {
+        sendFails++;
+      }
+      toNet.consume();
     }
-  }
 
-  // Heartbeat
-  static uint32_t lastHb = 0;
-  if (millis() - lastHb > 2000) {
-    lastHb = millis();
-    Serial.print("Heartbeat (IP: ");
-    Serial.print(WiFi.localIP());
-    Serial.println(")");
+    // Woken at once by the SPI task (datagram or config); the socket is
+    // polled every tick
+    ulTaskNotifyTake(pdTRUE, UDP_POLL_TICKS);
   }
+}
 
-  // Reset Send Buffer if used
-  if (ret == ESP_OK && sendbuf[0] != 0x00) {
-    digitalWrite(GPIO_READY, LOW);
-    sendbuf[0] = 0x00;
-  }
-}
\ No newline at end of file
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+
+  WiFi.mode(WIFI_STA);
+  WiFi.disconnect();
+
+  pinMode(GPIO_READY, OUTPUT);
+  digitalWrite(GPIO_READY, LOW);
+
+  xTaskCreatePinnedToCore(udpTaskMain, "udp", TASK_STACK, NULL, UDP_TASK_PRIO,
+                          &udpTask, 0);
+  xTaskCreatePinnedToCore(spiTask, "spi", TASK_STACK, NULL, SPI_TASK_PRIO, NULL,
+                          1);
+}
+
+// Everything runs in the two tasks; counters go to the Teensy (STATS record)
+void loop() { vTaskDelete(NULL); }
@@ -0,0 +1,85 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <stdint.h>
+
+// IMA ADPCM (4 bits/sample) for PAYLOAD_ADPCM
+// Standard IMA step/index tables. Encoder and decoder share AdpcmState; the
+// state at the start of each packet is sent in-band (see ADPCM_FRAME_SIZE in
+// VoterProtocol.h) so the host can decode each packet independently.
+// Packing: two samples per byte, first sample in the high nibble.
+
+struct AdpcmState {
+  int16_t predictor;
+  uint8_t index; // 0..88
+};
+
+static constexpr int16_t kAdpcmStep[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static constexpr int8_t kAdpcmIndex[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                           -1, -1, -1, -1, 2, 4, 6, 8};
+
+// Apply one code to the state (shared by encoder and decoder)
+static inline int16_t adpcmStep(AdpcmState *s, uint8_t code) {
+  int32_t step = kAdpcmStep[s->index];
+  int32_t diff = step >> 3;
+  if (code & 4)
+    diff += step;
+  if (code & 2)
+    diff += step >> 1;
+  if (code & 1)
+    diff += step >> 2;
+
+  int32_t pred = s->predictor + ((code & 8) ? -diff : diff);
+  if (pred > 32767)
+    pred = 32767;
+  if (pred < -32768)
+    pred = -32768;
+  s->predictor = (int16_t)pred;
+
+  int idx = s->index + kAdpcmIndex[code & 0xF];
+  s->index = (uint8_t)(idx < 0 ? 0 : (idx > 88 ? 88 : idx));
+  return s->predictor;
+}
+
+static inline uint8_t adpcmEncodeSample(AdpcmState *s, int16_t sample) {
+  int32_t diff = (int32_t)sample - s->predictor;
+  uint8_t code = 0;
+  if (diff < 0) {
+    code = 8;
+    diff = -diff;
+  }
+
+  // Successive approximation against step, step/2, step/4
+  int32_t step = kAdpcmStep[s->index];
+  if (diff >= step) {
+    code |= 4;
+    diff -= step;
+  }
+  step >>= 1;
+  if (diff >= step) {
+    code |= 2;
+    diff -= step;
+  }
+  step >>= 1;
+  if (diff >= step)
+    code |= 1;
+
+  adpcmStep(s, code); // Track the decoder's reconstruction
+  return code;
+}
+
+static inline int16_t adpcmDecodeSample(AdpcmState *s, uint8_t code) {
+  return adpcmStep(s, code);
+}
+
+#endif
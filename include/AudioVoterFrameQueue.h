@@ -0,0 +1,158 @@
+#ifndef AUDIO_VOTER_FRAME_QUEUE_H
+#define AUDIO_VOTER_FRAME_QUEUE_H
+
+#include "PpsDiscipline.h"
+#include "Resampler.h"
+#include "SpscRing.h"
+#include "VoterProtocol.h"
+#include <Arduino.h>
+#include <AudioStream.h>
+
+// Voter Frame Queue (Audio Library Node)
+// Sits after mixer1 in the audio graph. Every audio update (128 samples @
+// 44.1kHz) is resampled to 8kHz inside the audio ISR and appended to the
+// frame being assembled. Frames are assembled in place in the next free
+// slot of a lock-free SPSC ring (see SpscRing.h) and published when
+// complete, so loop() can filter and encode them without any copies.
+//
+// Capture time: each block is stamped with micros() on entry to update(),
+// less the capture latency, i.e. the time of its first sample at the ADC.
+// The resampler reports where its outputs fall within the block, so every
+// frame carries the capture time of its own first 8kHz sample, free of any
+// loop() scheduling delay. loop() turns it into GPS time
+// (GPSManager::getTimeAt()). The micros() reading carries the audio ISR's
+// dispatch delay, so block times come from a slow loop tracking the block
+// period rather than from each reading directly.
+//
+// PPS alignment (setPpsAlign()): each PPS edge (ppsEdge(), from the PPS
+// ISR) re-anchors the resampler phase so frames start on exact 20ms GPS
+// boundaries, and the codec samples counted between edges set the resample
+// ratio, so the 8kHz output runs at the GPS rate. See PpsDiscipline.h.
+
+#define VOTER_FRAME_QUEUE_DEPTH 8 // Frames (160ms of audio), power of two
+
+// One audio block at the codec rate
+#define FRAMEQ_BLOCK_US (AUDIO_BLOCK_SAMPLES * 1000000.0 / AUDIO_SAMPLE_RATE_EXACT)
+
+// First sample of a block at the ADC -> update(): one block of I2S DMA,
+// plus the SGTL5000 ADC group delay. Nominal and identical on
+// every site, so it does not skew voting; check against a GPS-timed click.
+#define FRAMEQ_ADC_DELAY_US 200
+#define FRAMEQ_CAPTURE_LATENCY_US                                             \
+  ((uint32_t)FRAMEQ_BLOCK_US + FRAMEQ_ADC_DELAY_US)
+
+// Block clock loop: phase and period gains (critically damped, ~3Hz), and
+// the spacing error that restarts it (a lost block)
+#define FRAMEQ_CLOCK_GAIN (1.0f / 16)
+#define FRAMEQ_CLOCK_PERIOD_GAIN (1.0f / 1024)
+#define FRAMEQ_CLOCK_RESYNC_US 500
+
+// Frames stay flagged PPS-aligned for this long after the last edge
+#define FRAMEQ_PPS_TIMEOUT_BLOCKS ((uint32_t)(1500000.0 / FRAMEQ_BLOCK_US))
+
+// One 20ms Voter frame (8kHz)
+struct VoterFrame {
+  int16_t samples[FRAME_SIZE];
+  uint32_t captureMicros; // micros() at the ADC of samples[0]
+  bool ppsAligned;        // samples[0] is on a 20ms GPS boundary
+};
+
+class AudioVoterFrameQueue : public AudioStream {
+public:
+  AudioVoterFrameQueue();
+
+  // Start/Stop frame production (table: shared resampler phase table)
+  void begin(const DownsampleTable *table);
+  void end();
+
+  // Drop all queued frames and the partial frame (called from loop())
+  void clear();
+
+  // Consumer API (loop() only)
+  int available() { return (int)_queue.available(); }
+  VoterFrame *readFrame() { return _queue.peek(); } // Oldest complete frame
+  void freeFrame() { _queue.consume(1); } // Release frame from readFrame()
+
+  // Statistics
+  uint8_t getDepth() { return (uint8_t)_queue.available(); }
+  uint8_t getMaxDepth() const { return (uint8_t)_queue.getHighWater(); }
+  uint32_t getOverruns() const { return _overruns; }
+  uint32_t getUnderflows() const { return _queue.getUnderflows(); }
+  uint32_t getFramesProduced() const { return _framesProduced; }
+
+  // Capture stamp quality: worst deviation of the block-to-block stamp
+  // spacing from one block period (audio ISR dispatch jitter), since the
+  // last reset.
+  uint32_t getStampJitterMax() const { return _stampJitterMax; }
+  void resetStampJitter() { _stampJitterMax = 0; }
+
+  // PPS alignment on/off (loop()). Off keeps the current phase and goes
+  // back to the nominal ratio.
+  void setPpsAlign(bool on);
+  bool getPpsAlign() const { return _ppsAlign; }
+
+  // PPS ISR: micros() at the edge
+  void ppsEdge(uint32_t ppsMicros) {
+    _ppsMicros = ppsMicros;
+    _ppsPending = true;
+  }
+
+  // Locked to PPS, with an edge in the last 1.5s
+  bool isPpsAligned() const {
+    return _ppsAlign && _pps.isLocked() && _ppsAge < FRAMEQ_PPS_TIMEOUT_BLOCKS;
+  }
+  const PpsDiscipline &getPpsDiscipline() const { return _pps; }
+  double getRatio() const { return _resampler.getRatio(); }
+
+  virtual void update(void);
+
+private:
+  audio_block_t *_inputQueueArray[1];
+  volatile bool _enabled;
+
+  // Producer state (ISR only)
+  Downsampler _resampler;
+  VoterFrame *_assembling; // Reserved ring slot, or &_discard when full
+  VoterFrame _discard;     // Sink for frames that have nowhere to go
+  uint16_t _fill;          // Samples in the frame under assembly
+  uint32_t _lastBlockUs;   // Capture time of the previous block (raw)
+  bool _haveLastBlock;
+  int16_t _lastSample;     // Fill for samples padded in by PPS alignment
+
+  // Block clock: capture time of this block is _clockUs + _clockFrac
+  uint32_t _clockUs;
+  float _clockFrac;
+  float _clockPeriod; // us per block, in micros() time
+
+  // PPS alignment
+  volatile bool _ppsAlign;
+  volatile bool _ppsPending;
+  volatile uint32_t _ppsMicros;
+  uint32_t _ppsAge; // Blocks since the last edge
+  PpsDiscipline _pps;
+
+  // Codec sample count: input samples before this block, and where in it
+  // (samples, from the block capture time) the previous PPS edge fell
+  uint32_t _samplesIn;
+  uint32_t _edgeSamples;
+  float _edgeOffset;
+  bool _haveEdge;
+
+  SpscRing<VoterFrame, VOTER_FRAME_QUEUE_DEPTH> _queue;
+
+  // Statistics
+  volatile uint32_t _overruns; // Frames dropped because loop() fell behind
+  volatile uint32_t _framesProduced;
+  volatile uint32_t _stampJitterMax;
+
+  void _startFrame();
+  void _finishFrame();
+  void _trackClock(uint32_t rawUs);
+  void _alignToPps(float usPerIn);
+  void _measureRate(bool freshEdge);
+  // Append count samples, the first captured firstUs after _clockUs
+  // (src == nullptr repeats the last sample)
+  void _append(const int16_t *src, int count, float firstUs);
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef AUDIO_VOTER_TX_QUEUE_H
+#define AUDIO_VOTER_TX_QUEUE_H
+
+#include "Resampler.h"
+#include "SpscRing.h"
+#include "VoterProtocol.h"
+#include <Arduino.h>
+#include <AudioStream.h>
+
+// Voter TX Audio (Audio Library Source Node)
+// Downlink path for simulcast: the host sends uLaw frames stamped with
+// VTIME, and every site keys up and plays frame T at exactly T + txDelay.
+//
+// loop() side: write() decodes frames into a jitter buffer indexed by their
+//   timestamp (20ms sequence numbers from the start of the burst). service()
+//   hands frames, in order, to the audio ISR a little ahead of their play
+//   time, each with a micros() deadline. Missing frames become silence.
+// ISR side: update() upsamples 8kHz -> 44.1kHz. The first frame of a burst
+//   starts on its deadline (sample accurate within the block); after that
+//   frames follow back to back on the codec clock.
+
+#define TX_JITTER_SLOTS 16   // Frames (320ms) of jitter buffer, power of two
+#define TX_PLAYOUT_DEPTH 4   // Frames queued for the audio ISR, power of two
+#define TX_LEAD_FRAMES 2     // Frames handed to the ISR before play time
+#define TX_HANG_FRAMES 5     // Missing frames (100ms) that end a burst
+#define TX_FRAME_US 20000    // One Voter frame
+
+// Largest txDelay the jitter buffer can hold (plus the ISR lead)
+#define TX_DELAY_MAX_MS ((TX_JITTER_SLOTS - TX_LEAD_FRAMES) * TX_FRAME_US / 1000)
+
+// Time from update() to the first sample at the DAC: two audio blocks of
+// I2S buffering plus the upsampler's group delay. Nominal, check on a scope.
+#define TX_OUTPUT_LATENCY_US                                                  \
+  ((uint32_t)(2.0 * AUDIO_BLOCK_SAMPLES * 1000000.0 /                         \
+              AUDIO_SAMPLE_RATE_EXACT) +                                       \
+   (UPSAMPLER_TAPS / 2) * (1000000 / 8000))
+
+// One frame waiting for the audio ISR
+struct TxFrame {
+  int16_t samples[FRAME_SIZE];
+  uint32_t deadline; // micros() of the first sample at the DAC
+};
+
+class AudioVoterTxQueue : public AudioStream {
+public:
+  AudioVoterTxQueue();
+
+  // Start/Stop playout (table: shared upsampler phase table)
+  void begin(const UpsampleTable *table);
+  void end();
+
+  // Drop the jitter buffer and anything queued for the ISR
+  void clear();
+
+  // Fixed delay from frame timestamp to air (same on every site)
+  void setDelay(uint16_t ms) { _delayUs = (uint32_t)ms * 1000; }
+
+  // loop() only. frameTime in host byte order.
+  bool write(const VTIME &frameTime, const uint8_t *ulaw);
+
+  // loop() only, every pass. gpsNow: current GPS time, or nullptr when not
+  // locked (frames then play txDelay after the first one arrives).
+  void service(const VTIME *gpsNow);
+
+  // PTT: burst in progress or audio still playing
+  bool isKeyed() const { return _active || _playing || _playout.available(); }
+
+  // Statistics
+  uint8_t getDepth() const;           // Frames in the jitter buffer
+  uint8_t getMaxDepth() const { return _maxDepth; }
+  uint32_t getLate() const { return _late; }   // Arrived after play time
+  uint32_t getEarly() const { return _early; } // Too far ahead to buffer
+  uint32_t getLost() const { return _lost; }   // Played as silence mid-burst
+  uint32_t getUnderruns() const { return _underruns; } // ISR ran dry
+  uint32_t getFramesPlayed() const { return _framesPlayed; }
+
+  virtual void update(void);
+
+private:
+  // Jitter buffer (loop() only)
+  struct Slot {
+    int16_t samples[FRAME_SIZE];
+    int32_t seq;
+    bool valid;
+  };
+  Slot _slots[TX_JITTER_SLOTS];
+  bool _anchored;         // _anchorUs set (frames buffered or burst active)
+  uint64_t _anchorUs;     // Timestamp of sequence 0
+  volatile bool _active;  // Burst in progress (read by the ISR)
+  int32_t _nextSeq;       // Next sequence to hand to the ISR
+  uint8_t _missing;       // Consecutive missing frames in this burst
+  uint32_t _delayUs;
+
+  // Free-running clock (no GPS)
+  uint32_t _lastMicros;
+  uint64_t _localUs;
+  int64_t _clockOffsetUs;
+
+  SpscRing<TxFrame, TX_PLAYOUT_DEPTH> _playout;
+
+  // Playout state (ISR only)
+  Upsampler _resampler;
+  volatile bool _playing;
+  volatile bool _enabled;
+  uint16_t _framePos; // Next input sample in the current frame
+  int16_t _out[Upsampler::maxOutput(8000.0 / AUDIO_SAMPLE_RATE_EXACT)];
+  uint8_t _outFill, _outPos;
+
+  // Statistics
+  uint8_t _maxDepth;
+  uint32_t _late, _early, _lost;
+  volatile uint32_t _underruns;
+  volatile uint32_t _framesPlayed;
+
+  uint64_t _playUs(int32_t seq) const {
+    return _anchorUs + (int64_t)seq * TX_FRAME_US + _delayUs;
+  }
+  bool _oldestSlot(int32_t *seq) const;
+  void _endBurst();
+};
+
+#endif
@@ -7,12 +7,36 @@
 
 // Magic Header to detect valid config
 #define CONFIG_MAGIC 0xCAFEBABE
-#define CONFIG_VERSION 8
+#define CONFIG_VERSION 19
 
 // COS/Squelch Modes
 #define COS_MODE_ALWAYS_ON 0 // Always send RSSI (testing/no squelch)
 #define COS_MODE_HARDWARE 1  // Use GPIO pin for COS
 #define COS_MODE_DSP 2       // Use DSP noise detection
+#define COS_MODE_SPECTRAL 3  // Use FFT voice/noise SNR
+#define COS_MODE_CTCSS 4     // Require the configured CTCSS (PL) tone
+
+// DSP Engines
+#define DSP_ENGINE_FLOAT 0 // CMSIS f32 kernels (reference)
+#define DSP_ENGINE_Q15 1   // CMSIS fast Q15 kernels (SIMD, no conversions)
+#define DSP_ENGINE_FUSED 2 // Single-pass float kernel (default)
+
+// Uplink Codecs
+#define CODEC_ULAW 0  // PAYLOAD_ULAW, 20ms per packet (default)
+#define CODEC_ADPCM 1 // PAYLOAD_ADPCM, 40ms per packet, half the audio bytes
+
+// Frame Timing (see FrameClock.h)
+#define TIMING_GPS 0 // GPS time with local holdover (default)
+#define TIMING_MIX 1 // Voter mix mode: local seconds + frame sequence
+
+// Network Links (NetworkManager; applied at boot)
+#define NET_LINKS_WIFI 0     // ESP32 WiFi bridge only (default)
+#define NET_LINKS_ETH 1      // Native Ethernet only
+#define NET_LINKS_ETH_WIFI 2 // Ethernet primary, WiFi backup
+
+// Link bond modes (see NetworkManager.h)
+#define NET_BOND_FAILOVER 0  // Data on the active link only (default)
+#define NET_BOND_DUPLICATE 1 // Every packet on every link
 
 struct SysConfig {
   uint32_t magic;
@@ -24,6 +48,11 @@ struct SysConfig {
   // Voter Host
   uint32_t hostIP; // Stored as uint32 to be generic (Network byte order?)
   uint16_t hostPort;
+  uint32_t backupHostIP; // Second host, same frames (0 = none)
+  uint16_t backupHostPort;
+  bool spiAsync; // ESP32 bridge: DMA transmit queue (else blocking SPI)
+  uint8_t netLinks; // NET_LINKS_* constant
+  uint8_t netBond;  // NET_BOND_* constant
 
   // Authentication
   char clientPwd[20];
@@ -33,6 +62,9 @@ struct SysConfig {
   bool useHwRSSI;
   uint8_t cosMode;          // COS_MODE_* constant
   uint8_t dspSquelchThresh; // 0-255, threshold for DSP squelch
+  uint8_t spectralSnrThresh; // dB, COS_MODE_SPECTRAL open threshold
+  uint8_t ctcssTone;         // COS_MODE_CTCSS tone index (CtcssDecoder.h)
+  uint8_t ctcssWindow;       // CTCSS detect block, 20ms frames (5-25)
   uint8_t rxGain;           // 0-15, SGTL5000 Line In Level
   uint8_t inputSource;      // AUDIO_INPUT_LINEIN or AUDIO_INPUT_MIC
 
@@ -46,6 +78,13 @@ struct SysConfig {
   // Audio Filtering
   bool enablePLFilter; // 300Hz HPF (Block PL)
   bool enableDeemp;    // De-emphasis LPF
+  uint8_t dspEngine;   // DSP_ENGINE_* constant
+  uint8_t codec;       // CODEC_* constant
+  uint8_t timingMode;  // TIMING_* constant
+  bool ppsAlign;       // Frames start on 20ms PPS boundaries
+
+  // Transmit
+  uint16_t txDelayMs; // Host timestamp to air (same on all simulcast sites)
 };
 
 class ConfigManager {
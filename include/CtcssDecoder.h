@@ -0,0 +1,64 @@
+#ifndef CTCSS_DECODER_H
+#define CTCSS_DECODER_H
+
+#include <Arduino.h>
+
+// CTCSS (PL) Tone Decoder
+// Goertzel bank over the 50 standard EIA tones, run on the raw 8kHz frames
+// (before the voice filter removes everything below 300Hz). Each Goertzel
+// block spans a configurable number of 20ms frames:
+//   - Longer blocks: narrower bins, better adjacent-tone rejection and fewer
+//     falses on noise, but slower to open.
+//   - Shorter blocks: faster open, more falsing.
+// A tone is detected when the configured tone beats the CTCSS_NEIGHBOURS
+// standard tones either side of it and holds at least CTCSS_MIN_RATIO of the
+// block energy. Only the neighbours compete: a voice fundamental elsewhere in
+// the 67-254Hz range is often stronger than the PL and must not mask it.
+// On short blocks the ratio must also clear CTCSS_NOISE_MARGIN times the
+// share one bin takes of white noise (2 / samples), or noise falses.
+
+#define CTCSS_NUM_TONES 50
+#define CTCSS_WINDOW_MIN 5   // Frames (100ms)
+#define CTCSS_WINDOW_MAX 25  // Frames (500ms)
+#define CTCSS_MIN_RATIO 0.01f // Tone power / block power (-20dB)
+#define CTCSS_NEIGHBOURS 2    // Tones either side that must be weaker
+#define CTCSS_NOISE_MARGIN 10.0f
+#define CTCSS_HANG_BLOCKS 2  // Missed blocks before closing (voice peaks)
+
+class CtcssDecoder {
+public:
+  CtcssDecoder();
+
+  // toneIndex: 0-49 (see toneHz), windowFrames: CTCSS_WINDOW_MIN..MAX
+  void begin(uint8_t toneIndex, uint8_t windowFrames);
+  void reset();
+
+  // Feed 8kHz samples (any count; blocks complete every windowFrames*160)
+  void process(const int16_t *samples, int count);
+
+  // Status
+  bool isDetected() const { return _detected; }
+  uint8_t getStrongestTone() const { return _strongest; } // Whole bank
+  float getToneRatio() const { return _ratio; } // Configured tone, last block
+
+  static float toneHz(uint8_t index);
+  static int findTone(float hz); // Nearest standard tone index, -1 if none
+
+private:
+  float _s1[CTCSS_NUM_TONES]; // Goertzel state
+  float _s2[CTCSS_NUM_TONES];
+  float _energy;      // Sum of x^2 over the block
+  uint32_t _count;    // Samples in the current block
+  uint32_t _blockLen; // Samples per block
+  float _minRatio;    // Detect threshold for this block length
+
+  uint8_t _tone;
+  uint8_t _strongest;
+  uint8_t _misses;
+  float _ratio;
+  bool _detected;
+
+  void _finishBlock();
+};
+
+#endif
@@ -1,61 +1,141 @@
 #ifndef DSP_PROCESSOR_H
 #define DSP_PROCESSOR_H
 
+#include "Adpcm.h"
+#include "VoterProtocol.h"
 #include <Arduino.h>
+#include <AudioStream.h> // AUDIO_BLOCK_SAMPLES (Audio library block, 128)
 #include <arm_math.h>
 
 // Audio Settings
-#define AUDIO_BLOCK_SAMPLES 160 // Aligned with Voter Protocol (20ms Frame)
 #define SAMPLE_RATE 8000.0f
 #define FFT_SIZE 256 // Need at least block size
 
+// Spectral Squelch (COS_MODE_SPECTRAL)
+// Hann-windowed FFT_SIZE window, hopped by one block (overlapping), compares
+// mean voice-band bin power against mean noise-band bin power.
+// Both bands sit in the flat part of the resampler passband (within 0.4dB
+// to 3.1kHz); above that its transition band would scale the noise estimate.
+#define SPECTRAL_VOICE_LO_HZ 300  // Above CTCSS
+#define SPECTRAL_VOICE_HI_HZ 2500
+#define SPECTRAL_NOISE_LO_HZ 2700 // FM discriminator noise rises with freq
+#define SPECTRAL_NOISE_HI_HZ 3100
+#define SPECTRAL_SNR_FULL_DB 30.0f // SNR mapped to RSSI 255
+#define SPECTRAL_HYST_DB 3.0f      // Close at threshold - hysteresis
+#define SPECTRAL_QUIET_DBFS -70.0f // Noise bins this low = full quieting
+
+// Filter Lengths (coefficients are generated at compile time, see
+// FilterDesign.h and DSPProcessor.cpp)
+#define RSSI_TAPS 23  // High Pass > 2400Hz (Voter2 RSSIFILTER1)
+#define VOICE_TAPS 64 // Band Pass 300Hz - 3300Hz (Blackman windowed sinc)
+
+// DSP chain for one block size. Every state/scratch buffer is sized from the
+// template parameters, so a 160-sample Voter frame and a 128-sample Audio
+// library block can be processed side by side without sharing buffers.
+// The implementation lives in DSPProcessor.cpp; supported sizes are
+// explicitly instantiated there (see the typedefs below).
+template <int BlockSize, int RssiTaps = RSSI_TAPS, int VoiceTaps = VOICE_TAPS>
 class DSPProcessor {
+  static_assert(BlockSize > 0 && BlockSize <= FFT_SIZE,
+                "DSP block must fit the squelch FFT");
+  static_assert(RssiTaps > 0 && RssiTaps < 65536 && VoiceTaps > 0 &&
+                    VoiceTaps < 65536,
+                "CMSIS FIR tap count is uint16_t");
+  static_assert(RssiTaps <= VoiceTaps,
+                "Fused kernel nests the RSSI window inside the voice window");
+
 public:
+  static constexpr int blockSize = BlockSize;
+  static constexpr int rssiTaps = RssiTaps;
+  static constexpr int voiceTaps = VoiceTaps;
+
+  // Q15 kernels need an even tap count (odd filters get a zero tap)
+  static constexpr int rssiTapsQ15 = (RssiTaps + 1) & ~1;
+  static constexpr int voiceTapsQ15 = (VoiceTaps + 1) & ~1;
+
   DSPProcessor();
 
   void begin();
 
+  // Clear all filter history (both engines)
+  void reset();
+
+  // Select processing engine: DSP_ENGINE_FLOAT, DSP_ENGINE_Q15 or
+  // DSP_ENGINE_FUSED (ConfigManager.h). Switching clears filter history.
+  void setEngine(uint8_t engine);
+  uint8_t getEngine() const { return _engine; }
+
   // Process a block of audio (in-place modification)
-  // input: 128 samples of int16
+  // input: BlockSize samples of int16
   // enablePLFilter: High Pass > 300Hz
   // enableDeemp: Low Pass (6dB/oct)
+  // ulawOut: optional, BlockSize bytes of G.711 u-Law written in the same pass
   // Returns: Calculated RSSI (0-255) based on Noise Floor
-  uint8_t process(int16_t *samples, bool enablePLFilter, bool enableDeemp);
+  uint8_t process(int16_t *samples, bool enablePLFilter, bool enableDeemp,
+                  uint8_t *ulawOut = nullptr);
 
-  // Convert linear PCM to uLaw
+  // Convert linear PCM to uLaw (G.711, see ULaw.h)
   void encodeULaw(int16_t *input, uint8_t *output, int count);
 
+  // IMA ADPCM (see Adpcm.h). Encoder state carries across calls, so a
+  // packet is: getADPCMState() header, then one or more encodeADPCM() runs.
+  void getADPCMState(uint8_t *state); // ADPCM_STATE_BYTES
+  void encodeADPCM(const int16_t *input, uint8_t *output, int count); // even
+
   // Get last measured noise level (0-255, higher = more noise)
   uint8_t getNoiseLevel() const { return _lastNoiseLevel; }
 
+  // Spectral squelch (FFT per block, only runs while enabled)
+  void setSpectralSquelch(bool enable);
+  float getSpectralSnr() const { return _spectralSnr; } // dB
+  uint8_t getSpectralRSSI() const { return _spectralRSSI; }
+  bool isSpectralOpen() const { return _spectralOpen; }
+
 private:
   // FIR Filter instances
   arm_fir_instance_f32 _rssiFilter;
   arm_fir_instance_f32 _voiceFilter;
 
-  // Coefficients (Converted to Float)
-  float _rssiCoeffs[24]; // 23 taps + 1 for alignment if needed, but f32 doesn't
-                         // need align
-  float _voiceCoeffs[64];
-
-  // State Buffers (Block Size + NumTaps - 1)
-  float _rssiState[128 + 24];
-  float _voiceState[128 + 64];
+  // State Buffers (CMSIS: NumTaps + BlockSize - 1)
+  float _rssiState[RssiTaps + BlockSize - 1];
+  float _voiceState[VoiceTaps + BlockSize - 1];
 
   // Biquad HPF (300Hz)
   arm_biquad_casd_df1_inst_f32 _hpf;
-  float _hpfState[4];  // 4 state vars per stage (1 stage)
-  float _hpfCoeffs[5]; // {b0, b1, b2, a1, a2}
+  float _hpfState[4]; // 4 state vars per stage (1 stage)
 
-  float _scratchBuffer[256]; // Need a scratch buffer for split path
+  float _scratchBuffer[BlockSize]; // Filter output for split path
 
   // FFT State for Squelch
   arm_rfft_fast_instance_f32 _fft;
-  float _fftBuffer[FFT_SIZE];
+  float _fftBuffer[FFT_SIZE];   // Sliding input window (newest block last)
+  float _fftWindowed[FFT_SIZE]; // Windowed copy (RFFT input), then |X|^2
   float _fftOutput[FFT_SIZE];
+  bool _spectralEnabled;
+  bool _spectralOpen;
+  float _spectralSnr;
+  uint8_t _spectralRSSI;
 
   // Internal Buffers
-  float _floatBuffer[AUDIO_BLOCK_SAMPLES];
+  float _floatBuffer[BlockSize];
+
+  // Q15 Engine (CMSIS fast kernels, dual 16-bit MACs)
+  // State: NumTaps + BlockSize (older CMSIS Q15 FIR needs the extra slot)
+  arm_fir_instance_q15 _rssiFilterQ15;
+  arm_fir_instance_q15 _voiceFilterQ15;
+  q15_t _rssiStateQ15[rssiTapsQ15 + BlockSize];
+  q15_t _voiceStateQ15[voiceTapsQ15 + BlockSize];
+  arm_biquad_casd_df1_inst_q15 _deempQ15; // De-emphasis as a 1 stage biquad
+  q15_t _deempStateQ15[4];
+  q15_t _scratchQ15[BlockSize];
+
+  // Fused Engine: one input history shared by both FIRs
+  float _fusedHistory[VoiceTaps - 1 + BlockSize];
+
+  uint8_t _engine;
+
+  // ADPCM Encoder State
+  AdpcmState _adpcm;
 
   // Last noise measurement (for squelch)
   uint8_t _lastNoiseLevel;
@@ -68,8 +148,18 @@ private:
   float _prevOut;
 
   // Helpers
-  void _calculateCoeffs();
-  uint8_t _calculateRSSI(float *fftMag, int bins);
+  uint8_t _processFloat(int16_t *samples, bool enablePLFilter,
+                        bool enableDeemp);
+  uint8_t _processQ15(int16_t *samples, bool enablePLFilter, bool enableDeemp);
+  uint8_t _processFused(int16_t *samples, bool enablePLFilter,
+                        bool enableDeemp, uint8_t *ulawOut);
+  uint8_t _cookRSSI(float rms); // Noise RMS (0.0-1.0) -> RSSI (10-255)
+  void _spectralSquelch(const int16_t *samples);
+  uint8_t _calculateRSSI(float *fftMag, int bins); // |X|^2 bins -> RSSI
 };
 
+// Instantiated in DSPProcessor.cpp
+typedef DSPProcessor<FRAME_SIZE> VoterFrameDSP;          // 20ms Voter frame
+typedef DSPProcessor<AUDIO_BLOCK_SAMPLES> AudioBlockDSP; // Audio library block
+
 #endif
@@ -4,16 +4,83 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include "NetworkDriver.h"
+#include "SpscRing.h"
+#include "SpiLink.h"
 
-// Simple Protocol Constants
-#define SPI_CMD_SEND_UDP 0x10
-#define SPI_CMD_SET_SSID 0x20
-#define SPI_CMD_GET_STATUS 0x30
+// The SPI bus carries the framed link of SpiProtocol.h/SpiLink.h: one
+// transaction moves one frame each way, with any number of datagrams in it
+// (up to the ESP32's credits), a CRC and sequence numbers. Bus work is
+// started from main-loop context (update(), parsePacket(), sendPacket()).
+//
+// A transaction is run when there is something to move: datagrams queued
+// (and credit for them), READY raised by the ESP32 (it has datagrams or an
+// answer), the ESP32's PENDING flag, link training, config/status, or a
+// keepalive. The 10-byte headers are exchanged directly; the rest of the
+// longer frame goes by DMA (SPI.transfer(..., EventResponder)) and the
+// completion event raises CS. The received frame is checked and unpacked
+// into the receive ring when the main loop retires the transfer.
+//
+// sendPacket() copies the datagram into a queue slot and returns; it is
+// taken into the next frame built. parsePacket()/read() pop the ring and
+// never wait for the bus.
+//
+// The clock is trained at startup (SpiLinkMaster): HELLO at 4MHz, then up in
+// steps while frames stay intact both ways. Until the link is up, datagrams
+// are dropped (counted).
+//
+// The ESP32 keeps its next slave transactions queued, so it only needs the
+// time its SPI interrupt takes to load the next one: transactions are spaced
+// by at least ESPSPI_CS_GAP_US (CS high to CS low). Nothing waits for it: the
+// bus is just not restarted before then.
+//
+// Once a second the ESP32 is asked for its bridge counters (STATS record);
+// rates come from the difference between two answers.
+#define ESPSPI_TX_SLOTS 8    // Datagrams waiting for the next frame
+#define ESPSPI_RX_SLOTS 8    // Receive ring (power of two), sent as credits
+#define ESPSPI_BUS_TIMEOUT_US 5000 // Longest frame is ~3.1ms at 4MHz
+#define ESPSPI_CS_GAP_US 40        // ESP32 loads its next queued transaction
+#define ESPSPI_KEEPALIVE_MS 50     // Link up: poll at least this often
+#define ESPSPI_HELLO_MS 100        // Link down: HELLO interval
+#define ESPSPI_STATUS_REFRESH_MS 1000 // IP answers older than this
+#define ESPSPI_BRIDGE_STATS_MS 1000   // Bridge counters request interval
 
-class EspSpiDriver : public NetworkDriver {
+// Transmit statistics, since the last resetTxStats() or mode change
+struct EspSpiTxStats {
+  uint32_t packets;     // Datagrams queued
+  uint32_t bytes;
+  uint32_t callUsTotal; // Main-loop time inside sendPacket()
+  uint32_t callUsMax;
+  uint32_t transactions;
+  uint32_t wireUsTotal; // CS low to last byte, per transaction
+  uint32_t wireUsMax;
+  uint16_t maxDepth;    // Most slots in use
+  uint32_t queueDrops;  // Queue full after one transaction: dropped
+  uint32_t linkDown;    // Dropped, link not up
+  uint32_t dmaFails;    // DMA refused, transfer done blocking
+  uint32_t dmaTimeouts; // No completion event, transfer given up
+  uint32_t tooLong;     // Payload over SPILINK_MAX_DATAGRAM, dropped
+};
+
+// Receive statistics
+struct EspSpiRxStats {
+  uint32_t readyEdges;  // READY interrupts
+  uint32_t packets;     // Datagrams put in the ring
+  uint32_t bytes;
+  uint32_t ringFull;    // Datagram arrived with the ring full (credit overrun)
+};
+
+// ESP32 bridge throughput between its last two STATS answers
+struct EspSpiBridgeRates {
+  float netRxPps;   // From the network, towards us
+  float netRxKbps;
+  float netTxPps;   // From us, sent on
+  float netTxKbps;
+};
+
+class EspSpiDriver : public NetworkDriver, private SpiLinkPort {
 public:
     EspSpiDriver(uint8_t csPin, uint8_t readyPin, uint8_t resetPin);
-    
+
     // NetworkDriver Implementation
     bool begin(uint8_t* mac) override;
     void update() override;
@@ -23,24 +90,101 @@ public:
 
     void setTarget(IPAddress ip, uint16_t port) override;
     void sendPacket(const uint8_t* data, uint16_t len) override;
+    void sendPacketTo(const uint8_t* data, uint16_t len, IPAddress ip, uint16_t port) override;
     int parsePacket() override;
     int read(uint8_t* buffer, size_t maxLen) override;
+    IPAddress remoteIP() override { return _remoteIP; }
+    uint16_t remotePort() override { return _remotePort; }
 
-    // WiFi Specific
+    // WiFi Specific: sent over the link until the ESP32 confirms it
     void setCredentials(const char* ssid, const char* pass);
 
+    // Transfer mode: DMA (default) or blocking, each datagram sent at once
+    void setAsync(bool async);
+    bool isAsync() const { return _async; }
+    void flush(); // Send what is queued (as credits allow), wait for the bus
+    uint8_t getTxDepth() const { return _txCount; }
+    const EspSpiTxStats& getTxStats() const { return _stats; }
+    void resetTxStats();
+
+    // Receive ring and link
+    const EspSpiRxStats& getRxStats() const { return _rxStats; }
+    uint32_t getRxDepth() const { return _rxRing.available(); }
+    uint32_t getRxHighWater() const { return _rxRing.getHighWater(); }
+    const SpiLinkMaster& getLink() const { return _link; }
+
+    // ESP32 bridge counters (last STATS answer) and rates; false until two
+    // answers have come
+    const SpiLinkBridgeStats& getBridgeStats() const { return _link.getBridgeStats(); }
+    bool getBridgeRates(EspSpiBridgeRates* rates) const;
+
 private:
     uint8_t _cs, _ready, _reset;
     IPAddress _targetIP;
     uint16_t _targetPort;
-    
-    // Buffers
-    uint8_t _rxBuffer[512];
-    int _rxLen;
-
-    // SPI Helpers
-    void _spiTransfer(uint8_t* data, size_t len);
-    uint8_t _readStatus();
+    IPAddress _remoteIP;       // Sender of the last parsePacket()
+    uint16_t _remotePort;
+
+    // Link and the frames of the transaction in progress
+    SpiLinkMaster _link;
+    uint8_t _txFrame[SPILINK_BUFFER];
+    uint8_t _rxFrame[SPILINK_BUFFER];
+    uint16_t _xferLen;         // Bytes clocked each way
+    uint32_t _lastXferMs;
+    uint32_t _ipMs;            // millis() of the last status request
+    uint32_t _bridgeMs;        // millis() of the last STATS request
+    uint32_t _bridgeSeen;      // STATS answers taken into _bridgeRates
+    SpiLinkBridgeStats _bridgePrev;
+    EspSpiBridgeRates _bridgeRates;
+
+    // Bus (main-loop context; the DMA event only raises CS and sets _busDone)
+    bool _busy;
+    volatile bool _busDone;
+    uint32_t _busStartUs;
+    volatile uint32_t _busDoneUs;
+    uint32_t _busEndUs;        // CS high of the last transaction
+    EventResponder _busEvent;
+
+    // Transmit queue: datagrams waiting for the next frame
+    struct TxSlot {
+        uint8_t ip[4];
+        uint16_t port;
+        uint16_t len;
+        uint8_t data[SPILINK_MAX_DATAGRAM];
+    };
+    TxSlot _txQueue[ESPSPI_TX_SLOTS];
+    uint8_t _txHead, _txTail, _txCount;
+    bool _async;
+    EspSpiTxStats _stats;
+
+    // Receive ring: filled when a frame is unpacked, popped by read()
+    struct RxSlot {
+        uint8_t ip[4];
+        uint16_t port;
+        uint16_t len;
+        uint8_t data[SPILINK_MAX_DATAGRAM];
+    };
+    SpscRing<RxSlot, ESPSPI_RX_SLOTS> _rxRing;
+    volatile bool _readyFlag;  // Set by the READY interrupt
+    EspSpiRxStats _rxStats;
+
+    void _queue(const uint8_t* data, uint16_t len, IPAddress ip, uint16_t port);
+    void _service();
+    bool _wantTransaction();
+    void _startTransaction();
+    void _retire();
+    void _waitBus();
+    bool _busReady();
+
+    // SpiLinkPort: frames pull from the queue and push into the ring
+    uint16_t nextDatagram(uint8_t* ip, uint16_t* port, uint8_t* data, uint16_t maxLen) override;
+    bool hasDatagram() override { return _txCount > 0; }
+    bool onDatagram(const uint8_t* ip, uint16_t port, const uint8_t* data, uint16_t len) override;
+    uint8_t credits() override { return ESPSPI_RX_SLOTS - _rxRing.available(); }
+
+    static void _onBusDone(EventResponderRef event);
+    static void _readyISR();
+    static EspSpiDriver* _instance; // Singleton pointer for ISR
 };
 
 #endif
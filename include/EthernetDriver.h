@@ -4,21 +4,53 @@
 #include "NetworkDriver.h"
 #include <NativeEthernet.h>
 #include <NativeEthernetUdp.h>
+#include <fnet.h>
 
+// DHCP gives up after this (the library default is 60s, too long to hold up
+// boot when Ethernet is a bonded link without a cable)
+#define ETH_DHCP_TIMEOUT_MS 10000
+
+// Without an address, update() keeps an FNET DHCP client running on the
+// stack begin() brought up, and polls the interface for its address. The
+// client sends and retries in the background, so the loop is never held
+// and a server of any speed is picked up. Pulling the cable drops the
+// client; plugging it in starts a new one at once.
 class EthernetDriver : public NetworkDriver {
 public:
     bool begin(uint8_t* mac) override {
-        if (Ethernet.begin(mac) == 0) return false;
-        _udp.begin(0);
-        return true;
+        _up = false;
+        bool ok = Ethernet.begin(mac, ETH_DHCP_TIMEOUT_MS) != 0;
+        if (ok) _bound();
+        return ok;
     }
     
     void update() override {
-        Ethernet.maintain();
+        if (_up) {
+            Ethernet.maintain();
+            return;
+        }
+        fnet_netif_desc_t netif = fnet_netif_get_default();
+        if (!netif) return; // No stack (begin() not run)
+        fnet_dhcp_cln_desc_t dhcp = fnet_dhcp_cln_get_by_netif(netif);
+        bool running = dhcp && fnet_dhcp_cln_is_enabled(dhcp);
+        if (Ethernet.linkStatus() == LinkOFF) {
+            if (running) fnet_dhcp_cln_release(dhcp);
+            return;
+        }
+        if (!running) {
+            // begin() releases its client when it times out
+            fnet_dhcp_cln_params_t params;
+            memset(&params, 0, sizeof(params));
+            params.netif = netif;
+            fnet_dhcp_cln_init(&params);
+            return;
+        }
+        if (fnet_netif_get_ip4_addr(netif) != 0) _bound();
     }
 
+    // Needs an address too: without DHCP there is no socket
     bool isConnected() override {
-        return Ethernet.linkStatus() != LinkOFF;
+        return _up && Ethernet.linkStatus() != LinkOFF;
     }
 
     IPAddress getLocalIP() override {
@@ -39,15 +71,29 @@ public:
     }
 
     int parsePacket() override {
-        return _udp.parsePacket();
+        return _up ? _udp.parsePacket() : 0;
     }
 
     int read(uint8_t* buffer, size_t maxLen) override {
         return _udp.read(buffer, maxLen);
     }
 
+    IPAddress remoteIP() override {
+        return _udp.remoteIP();
+    }
+
+    uint16_t remotePort() override {
+        return _udp.remotePort();
+    }
+
 private:
+    void _bound() {
+        _udp.begin(0);
+        _up = true;
+    }
+
     EthernetUDP _udp;
+    bool _up = false;
     IPAddress _targetIP;
     uint16_t _targetPort;
 };
@@ -0,0 +1,224 @@
+#ifndef FILTER_DESIGN_H
+#define FILTER_DESIGN_H
+
+#include <stdint.h>
+
+// Compile-Time Filter Design
+// Everything here is constexpr, so coefficient tables are computed by the
+// compiler and land in the image as plain const data (DTCM on Teensy 4.x,
+// zero-wait for the FIR inner loops). Nothing is calculated at boot.
+//
+// Frequencies are normalized: cycles per sample (Hz / sample rate).
+// Usage:
+//   static constexpr FilterDesign::FirTaps<64> kVoice =
+//       FilterDesign::bandpass<64>(300.0 / 8000.0, 3300.0 / 8000.0);
+
+namespace FilterDesign {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// --- constexpr math (no libm in constant expressions) ---
+
+constexpr double cabs(double x) { return x < 0.0 ? -x : x; }
+
+constexpr double csin(double x) {
+  // Reduce to [-pi, pi], then Taylor series (converges to double precision)
+  double turns = x / (2.0 * kPi);
+  long long whole = (long long)(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+  x -= (double)whole * 2.0 * kPi;
+  double term = x, sum = x;
+  for (int k = 1; k < 16; k++) {
+    term *= -x * x / ((2.0 * k) * (2.0 * k + 1.0));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double ccos(double x) { return csin(x + kPi / 2.0); }
+
+constexpr double ctan(double x) { return csin(x) / ccos(x); }
+
+constexpr double csqrt(double x) {
+  if (x <= 0.0)
+    return 0.0;
+  double r = (x > 1.0) ? x : 1.0;
+  for (int i = 0; i < 64; i++) {
+    double next = 0.5 * (r + x / r);
+    if (cabs(next - r) < 1e-15 * r)
+      return next;
+    r = next;
+  }
+  return r;
+}
+
+// Modified Bessel function of the first kind, order 0 (Kaiser window)
+constexpr double besselI0(double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < 1e-12 * sum)
+      break;
+  }
+  return sum;
+}
+
+// --- FIR (windowed sinc) ---
+
+template <int N> struct FirTaps {
+  static_assert(N > 0, "FIR needs at least one tap");
+  static constexpr int size = N;
+  float h[N];
+  constexpr FirTaps() : h() {}
+};
+
+// Blackman window over n = 0..N-1
+template <int N> constexpr double blackman(int n) {
+  return 0.42 - 0.5 * ccos(2.0 * kPi * n / (N - 1)) +
+         0.08 * ccos(4.0 * kPi * n / (N - 1));
+}
+
+// Periodic Hann window (for overlapped FFT analysis)
+template <int N> constexpr FirTaps<N> hannWindow() {
+  FirTaps<N> t;
+  for (int n = 0; n < N; n++) {
+    t.h[n] = (float)(0.5 - 0.5 * ccos(2.0 * kPi * n / N));
+  }
+  return t;
+}
+
+// Ideal low-pass impulse response at offset k from center
+constexpr double sincLowpass(double fc, double k) {
+  return (k == 0.0) ? 2.0 * fc : csin(2.0 * kPi * fc * k) / (kPi * k);
+}
+
+template <int N> constexpr FirTaps<N> lowpass(double fc) {
+  FirTaps<N> t;
+  for (int n = 0; n < N; n++) {
+    double k = n - (N - 1) / 2.0;
+    t.h[n] = (float)(sincLowpass(fc, k) * blackman<N>(n));
+  }
+  return t;
+}
+
+// Spectral inversion of the low-pass. Needs a center tap (odd N).
+template <int N> constexpr FirTaps<N> highpass(double fc) {
+  static_assert(N % 2 == 1, "High-pass FIR needs an odd tap count");
+  FirTaps<N> t;
+  for (int n = 0; n < N; n++) {
+    double k = n - (N - 1) / 2.0;
+    double ideal = ((k == 0.0) ? 1.0 : 0.0) - sincLowpass(fc, k);
+    t.h[n] = (float)(ideal * blackman<N>(n));
+  }
+  return t;
+}
+
+// Band-pass = LowPass(fh) - LowPass(fl)
+template <int N> constexpr FirTaps<N> bandpass(double fl, double fh) {
+  FirTaps<N> t;
+  for (int n = 0; n < N; n++) {
+    double k = n - (N - 1) / 2.0;
+    double ideal = sincLowpass(fh, k) - sincLowpass(fl, k);
+    t.h[n] = (float)(ideal * blackman<N>(n));
+  }
+  return t;
+}
+
+// Convert an existing Q15 table (e.g. ported Voter2 coefficients)
+template <int N> constexpr FirTaps<N> fromQ15(const int16_t (&q15)[N]) {
+  FirTaps<N> t;
+  for (int n = 0; n < N; n++) {
+    t.h[n] = (float)(q15[n] / 32768.0);
+  }
+  return t;
+}
+
+// --- Fixed point (Q15) ---
+
+template <int N> struct FirTapsQ15 {
+  static_assert(N > 0, "FIR needs at least one tap");
+  static constexpr int size = N;
+  int16_t h[N];
+  constexpr FirTapsQ15() : h() {}
+};
+
+constexpr int16_t toQ15(double x) {
+  double r = x * 32768.0;
+  r = (r < 0.0) ? r - 0.5 : r + 0.5;
+  return (r >= 32767.0) ? 32767 : (r <= -32768.0) ? -32768 : (int16_t)r;
+}
+
+// Float taps -> Q15. M > N pads zero taps at the front: CMSIS stores taps
+// time-reversed, so this adds no delay (used to make tap counts even for
+// the dual-MAC Q15 kernels).
+template <int M, int N> constexpr FirTapsQ15<M> toQ15(const FirTaps<N> &f) {
+  static_assert(M >= N, "Q15 table smaller than source");
+  FirTapsQ15<M> t;
+  for (int n = 0; n < N; n++) {
+    t.h[M - N + n] = toQ15(f.h[n]);
+  }
+  return t;
+}
+
+// --- IIR (2nd order Butterworth via bilinear transform) ---
+
+// CMSIS DF1 order {b0, b1, b2, a1, a2}. Feedback terms are stored NEGATED,
+// since CMSIS computes y = b0*x0 + b1*x1 + b2*x2 + a1*y1 + a2*y2.
+struct BiquadCoeffs {
+  float c[5];
+  constexpr BiquadCoeffs() : c() {}
+};
+
+constexpr BiquadCoeffs butterworthLowpass(double fc) {
+  BiquadCoeffs q;
+  double K = ctan(kPi * fc);
+  double norm = 1.0 / (1.0 + csqrt(2.0) * K + K * K);
+  q.c[0] = (float)(K * K * norm);
+  q.c[1] = (float)(2.0 * K * K * norm);
+  q.c[2] = (float)(K * K * norm);
+  q.c[3] = (float)(-2.0 * (K * K - 1.0) * norm);
+  q.c[4] = (float)(-(1.0 - csqrt(2.0) * K + K * K) * norm);
+  return q;
+}
+
+constexpr BiquadCoeffs butterworthHighpass(double fc) {
+  BiquadCoeffs q;
+  double K = ctan(kPi * fc);
+  double norm = 1.0 / (1.0 + csqrt(2.0) * K + K * K);
+  q.c[0] = (float)norm;
+  q.c[1] = (float)(-2.0 * norm);
+  q.c[2] = (float)norm;
+  q.c[3] = (float)(-2.0 * (K * K - 1.0) * norm);
+  q.c[4] = (float)(-(1.0 - csqrt(2.0) * K + K * K) * norm);
+  return q;
+}
+
+// One-pole low-pass y = alpha*x + (1-alpha)*y1 as a degenerate biquad
+constexpr BiquadCoeffs onePoleLowpass(double alpha) {
+  BiquadCoeffs q;
+  q.c[0] = (float)alpha;
+  q.c[3] = (float)(1.0 - alpha);
+  return q;
+}
+
+// CMSIS Q15 DF1 order {b0, 0, b1, b2, a1, a2}, scaled down by 2^postShift
+// (the kernel shifts the accumulator back up).
+struct BiquadQ15 {
+  int16_t c[6];
+  constexpr BiquadQ15() : c() {}
+};
+
+constexpr BiquadQ15 toQ15(const BiquadCoeffs &f, int postShift) {
+  BiquadQ15 q;
+  double scale = 1.0 / (double)(1 << postShift);
+  q.c[0] = toQ15(f.c[0] * scale);
+  q.c[2] = toQ15(f.c[1] * scale);
+  q.c[3] = toQ15(f.c[2] * scale);
+  q.c[4] = toQ15(f.c[3] * scale);
+  q.c[5] = toQ15(f.c[4] * scale);
+  return q;
+}
+
+} // namespace FilterDesign
+
+#endif
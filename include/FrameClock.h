@@ -0,0 +1,61 @@
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#include "VoterProtocol.h"
+#include <Arduino.h>
+
+// Voter Frame Timestamps
+// Every 20ms frame gets exactly one stamp() call, so the clock advances by
+// one frame per call regardless of when loop() gets to it.
+//
+// TIMING_GPS: the stamp follows GPS time, but moves at most
+//   FRAMECLOCK_SLEW_US per frame away from the previous stamp + 20ms.
+//   - Locked: GPS time (to within the slew limit).
+//   - GPS lost: holdover, previous stamp + 20ms per frame.
+//   - GPS back: slews to GPS time. Only a jump of more than
+//     FRAMECLOCK_RESYNC_US (e.g. a new epoch) is taken in one step.
+//   Before the first lock there is no time to hold over from, so stamps are
+//   0 (the pre-existing behavior).
+// TIMING_MIX: Voter "mix mode" for sites without GPS. vtime_sec counts
+//   local seconds and vtime_nsec carries the frame sequence number, which
+//   the host uses to order and de-jitter the stream.
+
+#define FRAMECLOCK_FRAME_US 20000
+#define FRAMECLOCK_SLEW_US 500        // Max step from nominal 20ms per frame
+#define FRAMECLOCK_RESYNC_US 2000000  // Larger errors are stepped at once
+
+class FrameClock {
+public:
+  FrameClock();
+
+  void begin(uint8_t mode);
+  void setMode(uint8_t mode);
+  uint8_t getMode() const { return _mode; }
+
+  // Stamp for the next frame (host byte order). gpsNow: current GPS time, or
+  // nullptr when GPS is not locked.
+  void stamp(VTIME *t, const VTIME *gpsNow);
+
+  // Round a time to the nearest 20ms frame boundary (PPS-aligned frames,
+  // whose capture time is only off the boundary by measurement noise)
+  static void roundToFrame(VTIME *t);
+
+  // Status
+  bool isHoldover() const { return _holdover; } // GPS mode, running local
+  uint32_t getSequence() const { return _seq; }  // Frames stamped
+  int32_t getLastError() const { return _lastErr; } // GPS - stamp (us)
+  uint32_t getHoldoverFrames() const { return _holdoverFrames; }
+  uint32_t getResyncs() const { return _resyncs; }
+
+private:
+  uint8_t _mode;
+  bool _valid;        // _stampUs holds a real time
+  bool _holdover;
+  uint64_t _stampUs;  // Last stamp (GPS mode) or local time (mix mode)
+  uint32_t _seq;
+  int32_t _lastErr;
+  uint32_t _holdoverFrames;
+  uint32_t _resyncs;
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <Arduino.h>
 #include <TinyGPSPlus.h>
 
+// PPS edge callback, run in the PPS interrupt (keep it short)
+typedef void (*GpsPpsHandler)(uint32_t ppsMicros);
+
 class GPSManager {
 public:
   GPSManager();
@@ -23,6 +26,13 @@ public:
   // Fill the VTIME struct with the exact current network time
   void getNetworkTime(VTIME *t);
 
+  // Network time at an earlier micros() reading (e.g. taken in an ISR).
+  // Valid for readings up to one PPS period before the latest PPS edge.
+  void getTimeAt(uint32_t atMicros, VTIME *t);
+
+  // Called with micros() at each accepted PPS edge
+  void onPps(GpsPpsHandler handler) { _ppsHandler = handler; }
+
   // Debugging / Tuning
   uint32_t getPpsJitter(); // Returns jitter in micros from last second
 
@@ -38,6 +48,7 @@ private:
   volatile uint32_t _lastPpsMicros;
   volatile bool _ppsTriggered;
   uint32_t _ppsPeriod; // Measured duration between PPS
+  GpsPpsHandler _ppsHandler;
 
   // Time State
   uint32_t _currentEpoch; // UTC Seconds
@@ -0,0 +1,43 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <Arduino.h>
+
+// Fixed-Size Latency Histogram
+// Log-linear bins: 8 sub-bins per power of two on a 16us base unit, so every
+// bin is within 12.5% of its value from 16us up to ~4s. No allocation and
+// O(1) add(), so samples can be recorded straight from the packet handler.
+// Percentiles come from the bins (bin midpoint, clamped to the exact
+// min/max); min, max and mean are exact.
+
+#define LATHIST_UNIT_SHIFT 4  // 16us base unit
+#define LATHIST_SUB_BITS 3    // 8 sub-bins per octave
+#define LATHIST_BINS 128      // Top bin holds everything above ~3.9s
+
+class LatencyHistogram {
+public:
+  LatencyHistogram() { clear(); }
+
+  void clear();
+  void add(uint32_t us);
+
+  uint32_t getCount() const { return _count; }
+  uint32_t getMin() const { return _count ? _min : 0; }
+  uint32_t getMax() const { return _max; }
+  uint32_t getMean() const { return _count ? (uint32_t)(_sum / _count) : 0; }
+
+  // pct: 0-100. Returns 0 with no samples.
+  uint32_t getPercentile(uint8_t pct) const;
+
+  // Bin mapping (exposed for the benchmark/self-test)
+  static uint8_t binOf(uint32_t us);
+  static uint32_t binLow(uint8_t bin); // Smallest value in the bin (us)
+
+private:
+  uint32_t _bins[LATHIST_BINS];
+  uint32_t _count;
+  uint32_t _min, _max;
+  uint64_t _sum;
+};
+
+#endif
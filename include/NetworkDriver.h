@@ -29,6 +29,16 @@ public:
     virtual void sendPacket(const uint8_t* data, uint16_t len) = 0;
     virtual int parsePacket() = 0;
     virtual int read(uint8_t* buffer, size_t maxLen) = 0;
+
+    // Multi-host: send to a given destination. Default re-targets and sends.
+    virtual void sendPacketTo(const uint8_t* data, uint16_t len, IPAddress ip, uint16_t port) {
+        setTarget(ip, port);
+        sendPacket(data, len);
+    }
+
+    // Sender of the last parsePacket(). 0.0.0.0 if the driver can't tell.
+    virtual IPAddress remoteIP() { return IPAddress(0, 0, 0, 0); }
+    virtual uint16_t remotePort() { return 0; }
 };
 
 #endif
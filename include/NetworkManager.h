@@ -5,27 +5,116 @@
 #include "NetworkDriver.h"
 // #include "EspSpiDriver.h" // We'll include concrete types in main
 
+// Link bonding
+// Links are added in priority order (begin() = primary, addLink() = backups).
+// Every link is polled for receive; sends go by the bond mode (NET_BOND_*,
+// ConfigManager.h):
+//   FAILOVER:  data on the active link only. Keepalives also go on each
+//              standby link every NET_PROBE_MS, so its health is known
+//              before it is needed.
+//   DUPLICATE: everything on every connected link (the host sees each
+//              packet once per link).
+//
+// Health: a link is DOWN when its driver reports !isConnected(). It is
+// SILENT when something sent on it NET_SILENT_MS ago has had no host answer
+// since (confirmLink(), called by VoterClient for authenticated packets).
+// The active link is re-chosen on every update() and send, so a link that
+// drops is off the air before the next frame: the first link that is up and
+// not silent, else the first one up. Going back to a higher-priority link
+// waits until it has been healthy for NET_FAILBACK_MS.
+#define NET_MAX_LINKS 4
+#define NET_NO_LINK 0xFF
+#define NET_SILENT_MS 3000   // Unanswered this long: silent (VOTER_HOST_TIMEOUT_MS)
+#define NET_PROBE_MS 1000    // Keepalive on each standby link
+#define NET_FAILBACK_MS 5000 // Healthy this long before a failback
+
+// Link health
+#define NET_LINK_DOWN 0
+#define NET_LINK_SILENT 1
+#define NET_LINK_UP 2
+
+// Per-link statistics
+struct NetLinkStats {
+    uint32_t txPackets;   // Data and keepalives sent
+    uint32_t probes;      // Keepalives sent while standby
+    uint32_t rxPackets;   // Datagrams read
+    uint32_t confirms;    // Authenticated host packets
+    uint32_t lastConfirmMs;
+    uint32_t downs;       // Left NET_LINK_UP
+    uint32_t activations; // Became the active link
+};
+
 class NetworkManager {
 public:
     NetworkManager();
-    
-    // Init
+
+    // Init: primary link (replaces any links added before)
     void begin(NetworkDriver* driver, uint8_t* mac_addr);
-    
+    // Backup link, lower priority than those added before. Returns its
+    // index, or -1 (full or begin() failed; the link is kept either way
+    // when there was room, it may come up later: update() runs the
+    // driver's own reconnects, e.g. EthernetDriver's DHCP client).
+    int addLink(NetworkDriver* driver);
+    void setBondMode(uint8_t mode) { _mode = mode; }
+    uint8_t getBondMode() const { return _mode; }
+
     // Passthrough
-    void update(); 
-    bool isConnected();
-    IPAddress getLocalIP();
-    
+    void update();
+    bool isConnected();      // Any link up
+    IPAddress getLocalIP();  // The active link's
+
     // Voter Protocol specific
     void setTarget(IPAddress ip, uint16_t port);
     void sendPacket(const uint8_t* data, uint16_t length);
-    int parsePacket(); 
+    int parsePacket();
     int read(uint8_t* buffer, size_t maxLen);
 
+    // Multi-host
+    void sendPacketTo(const uint8_t* data, uint16_t length, IPAddress ip, uint16_t port);
+    IPAddress remoteIP();
+    uint16_t remotePort();
+
+    // Keepalive/auth: also probes the standby links (see above)
+    void sendKeepaliveTo(const uint8_t* data, uint16_t length, IPAddress ip, uint16_t port);
+
+    // Link of the last parsePacket(); an authenticated host packet that came
+    // in on it proves the link both ways
+    uint8_t getRxLink() const { return _rxLink; }
+    void confirmLink(uint8_t link);
+
+    // Status
+    uint8_t getLinkCount() const { return _count; }
+    uint8_t getActiveLink() const { return _active; }
+    NetworkDriver* getDriver(uint8_t link) { return _links[link].driver; }
+    uint8_t getLinkHealth(uint8_t link) const { return _links[link].health; }
+    const NetLinkStats& getLinkStats(uint8_t link) const { return _links[link].stats; }
+    uint32_t getFailovers() const { return _failovers; } // Active link changes
+    uint32_t getLastFailoverMs() const { return _lastFailoverMs; }
+
+    static const char* typeName(DriverType type);
+    static const char* healthName(uint8_t health);
+
 private:
-    NetworkDriver* _driver;
+    struct Link {
+        NetworkDriver* driver;
+        uint8_t health;
+        uint32_t pendingSinceMs; // First send since the last answer (0 = none)
+        uint32_t healthySinceMs; // Went NET_LINK_UP
+        uint32_t lastProbeMs;
+        NetLinkStats stats;
+    };
+    Link _links[NET_MAX_LINKS];
+    uint8_t _count;
+    uint8_t _active;
+    uint8_t _mode;
+    uint8_t _rxLink;     // Last parsePacket()
+    uint8_t _rxNext;     // Link polled first on the next parsePacket()
+    uint32_t _failovers;
+    uint32_t _lastFailoverMs;
     uint8_t* _mac;
+
+    void _evaluate();
+    void _sendOn(uint8_t link, const uint8_t* data, uint16_t length, IPAddress ip, uint16_t port);
 };
 
 #endif
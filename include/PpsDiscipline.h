@@ -0,0 +1,95 @@
+#ifndef PPS_DISCIPLINE_H
+#define PPS_DISCIPLINE_H
+
+#include "VoterProtocol.h"
+#include <Arduino.h>
+
+// PPS Discipline of the 8kHz Sample Grid
+// Without it the resampler phase, and so where 20ms frames start, is set by
+// whenever the audio started, and differs from receiver to receiver. Here
+// every PPS edge re-anchors the grid: frame sample i must be captured at
+// (i * 125us) mod 20ms after the edge, the same on every GPS site.
+//
+// At the first audio block after each edge the frame queue reports where
+// its next 8kHz output will be captured, relative to the edge, and which
+// frame sample it will become. onPps() returns the correction:
+//   - Acquire (first edge, or error > PPSDISC_REACQUIRE_US): the output
+//     changes frame position to the nearest slot (the queue pads or backs
+//     up the frame under assembly), and the rest is a sub-sample phase step.
+//     A one-off glitch, no frame is dropped.
+//   - Locked: phase step only, at most PPSDISC_SLEW_US per edge. Codec
+//     clock drift (20ppm = 20us per second, up to 100ppm) is absorbed
+//     here, so frames are never dropped or duplicated.
+//
+// Frequency: the codec crystal is off by some ppm, so at a fixed resample
+// ratio the 8kHz grid drifts against GPS between edges. The queue counts
+// codec samples between edges (onInterval()); the averaged count is the
+// codec rate in GPS time, and the resample ratio is set to count / 8000 so
+// the output runs at exactly 8000.000Hz of GPS time. The phase steps then
+// only take out what is left.
+
+#define PPSDISC_SAMPLE_US 125      // One 8kHz sample
+#define PPSDISC_FRAME_US 20000     // One Voter frame
+#define PPSDISC_SLEW_US 100.0f     // Max phase step per edge (100ppm)
+#define PPSDISC_REACQUIRE_US 1000.0f // Larger errors re-align the frame
+
+#define PPSDISC_RATE_AVG 8        // Intervals (seconds) in the rate average
+#define PPSDISC_RATE_LOCK 3       // Good intervals before the ratio is set
+#define PPSDISC_RATE_MAX_PPM 200  // Intervals further off are PPS glitches
+
+// Frequency loop states
+#define PPSDISC_RATE_FREE 0     // Nominal ratio, nothing measured
+#define PPSDISC_RATE_ACQUIRE 1  // Measuring, ratio not set yet
+#define PPSDISC_RATE_LOCKED 2   // Ratio follows the measured rate
+#define PPSDISC_RATE_HOLDOVER 3 // PPS lost, last ratio kept
+
+class PpsDiscipline {
+public:
+  PpsDiscipline();
+
+  // Back to acquire on the next edge (phase only; the rate still holds)
+  void reset();
+
+  // Forget the measured rate (back to the nominal ratio)
+  void resetRate();
+
+  // At the first block after a PPS edge.
+  // nextUs: capture time of the next output minus the PPS edge (us)
+  // index: frame sample the next output would become (0..FRAME_SIZE-1)
+  // *target: frame sample it must become instead (== index when locked)
+  // Returns the phase step for the resampler (us, positive = later).
+  float onPps(float nextUs, int index, int *target);
+
+  // Codec samples between the last two edges. Returns true with the new
+  // resample ratio (input samples per 8kHz output) once the rate is locked.
+  bool onInterval(double samples, double *ratio);
+
+  // No edge for a while: hold the current ratio
+  void onTimeout();
+
+  // Status
+  bool isLocked() const { return _locked; }
+  float getLastError() const { return _lastErr; } // Before correction (us)
+  uint32_t getEdges() const { return _edges; }
+  uint32_t getAcquires() const { return _acquires; }
+
+  uint8_t getRateState() const { return _rateState; }
+  float getPpm() const { return _ppm; } // Codec rate vs nominal, GPS time
+  double getRate() const { return _rateAvg; } // Codec samples per second
+  uint32_t getRateRejects() const { return _rateRejects; }
+  static const char *rateStateName(uint8_t state);
+
+private:
+  bool _locked;
+  float _lastErr;
+  uint32_t _edges;
+  uint32_t _acquires;
+
+  uint8_t _rateState;
+  uint32_t _rateCount; // Good intervals averaged
+  double _rateAvg;
+  float _ppm;
+  uint32_t _rateRejects;
+};
+
+#endif
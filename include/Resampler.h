@@ -0,0 +1,247 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "FilterDesign.h"
+#include <Arduino.h>
+#include <arm_math.h>
+#include <math.h>
+
+// Polyphase Windowed-Sinc Fractional Resampler
+// Converts the codec rate (44117.647 Hz) to the Voter rate (8000 Hz), and
+// back again for TX audio (ratio < 1 interpolates).
+//
+// The prototype low-pass is a Kaiser-windowed sinc sampled on a grid of
+// NumPhases sub-sample positions. Each output sample is the dot product of
+// NumTaps input samples with the two phase rows that bracket its fractional
+// position, linearly blended. The table is designed at compile time. Phase
+// position is tracked in 32.32 fixed point so the per-output cost has no
+// float compares and no drift.
+
+// Downsampler used on the 44.1kHz -> 8kHz path
+#define RESAMPLER_TAPS 128     // Taps per phase (at the input rate)
+#define RESAMPLER_PHASES 64    // Sub-sample phases (power of two)
+// The transition band is about 1.6kHz wide (128 taps at 44.1kHz), centred on
+// the cutoff. With the cutoff 400Hz below the 4kHz output Nyquist frequency,
+// the stopband starts at RESAMPLER_STOPBAND and everything at or above it
+// folds to 0-3.6kHz below -70dB. Inputs between 4kHz and the stopband fold
+// to 3.6-4kHz, above the 3.3kHz voice band, with less rejection. The
+// passband is flat to 3kHz (-0.1dB) and 1.4dB down at 3.3kHz.
+#define RESAMPLER_CUTOFF 3600.0 // -6dB point (Hz)
+#define RESAMPLER_STOPBAND 4400.0 // Aliases < -70dB from here up (Hz)
+#define RESAMPLER_BETA 7.0     // Kaiser window shape
+
+// Input samples of history kept behind the next output, so adjustPhase()
+// can also move the phase backwards
+#define RESAMPLER_SLIP_MARGIN 8
+
+// Upsampler used on the 8kHz -> 44.1kHz TX path. Taps are at the 8kHz input
+// rate, so 32 taps span 4ms (2ms group delay).
+#define UPSAMPLER_TAPS 32
+#define UPSAMPLER_PHASES 64
+#define UPSAMPLER_CUTOFF 3800.0 // -6dB point (Hz), images of 3.3kHz voice < -60dB
+#define UPSAMPLER_BETA 6.0
+#define UPSAMPLER_BLOCK 16 // Input samples per process() call
+
+template <int NumTaps, int NumPhases> struct ResamplerTable {
+  static_assert((NumPhases & (NumPhases - 1)) == 0,
+                "NumPhases must be a power of two");
+  static_assert(NumTaps % 4 == 0, "NumTaps must be a multiple of 4");
+
+  // Row p holds the kernel for fractional delay p / NumPhases.
+  // Row NumPhases is row 0 shifted by one tap (needed for blending).
+  float h[NumPhases + 1][NumTaps];
+
+  constexpr ResamplerTable() : h() {}
+
+  // Compile-time design (see FilterDesign.h)
+  // cutoff: -6dB frequency in cycles per INPUT sample (0 - 0.5)
+  static constexpr ResamplerTable design(double cutoff, double beta) {
+    using namespace FilterDesign;
+    ResamplerTable t;
+    const double half = NumTaps / 2.0;
+    const double i0Beta = besselI0(beta);
+
+    for (int p = 0; p <= NumPhases; p++) {
+      double frac = (double)p / NumPhases;
+      double row[NumTaps] = {};
+      double sum = 0.0;
+      for (int k = 0; k < NumTaps; k++) {
+        // Distance from the output instant to input tap k
+        double tau = frac + half - 1.0 - k;
+        double x = 2.0 * cutoff * tau;
+        double sinc = (cabs(x) < 1e-9) ? 1.0 : csin(kPi * x) / (kPi * x);
+        double r = tau / half;
+        double w = (cabs(r) < 1.0)
+                       ? besselI0(beta * csqrt(1.0 - r * r)) / i0Beta
+                       : 0.0;
+        row[k] = sinc * w;
+        sum += row[k];
+      }
+      // Unity DC gain per phase (no phase-dependent gain ripple)
+      for (int k = 0; k < NumTaps; k++) {
+        t.h[p][k] = (float)(row[k] / sum);
+      }
+    }
+    return t;
+  }
+};
+
+template <int NumTaps, int NumPhases, int MaxBlock = 128>
+class PolyphaseResampler {
+public:
+  typedef ResamplerTable<NumTaps, NumPhases> Table;
+
+  PolyphaseResampler()
+      : _table(nullptr), _fill(0), _posInt(0), _posFrac(0), _overruns(0),
+        _blockOffset(0.0f) {
+    setRatio(1.0);
+  }
+
+  // table: designed phase table (shared, read-only)
+  // ratio: input samples per output sample (e.g. 44117.647 / 8000)
+  void begin(const Table *table, double ratio) {
+    _table = table;
+    setRatio(ratio);
+    reset();
+  }
+
+  void reset() {
+    memset(_history, 0, sizeof(_history));
+    // Pre-fill with silence so the first block produces output immediately
+    _fill = NumTaps - 1;
+    _posInt = 0;
+    _posFrac = 0;
+  }
+
+  void setRatio(double ratio) {
+    _stepInt = (uint32_t)ratio;
+    _stepFrac = (uint32_t)((ratio - (double)_stepInt) * 4294967296.0);
+  }
+
+  double getRatio() const {
+    return (double)_stepInt + (double)_stepFrac / 4294967296.0;
+  }
+
+  // Output samples lost because the caller's buffer was full
+  uint32_t getOverruns() const { return _overruns; }
+
+  // Where the first output of the last process() call sits in time, in
+  // input samples after the first sample of that call's block (the kernel
+  // is linear phase, so this is the centre tap; may be negative). Output k
+  // follows at getBlockOffset() + k * ratio.
+  float getBlockOffset() const { return _blockOffset; }
+
+  // Where the next output will sit, in input samples after the first sample
+  // of the next block passed to process()
+  float getNextOffset() const {
+    return (float)((int)_posInt + NumTaps / 2 - 1 - _fill) +
+           (float)_posFrac * (1.0f / 4294967296.0f);
+  }
+
+  // Move the phase by delta input samples (positive = later outputs).
+  // Backward steps are limited to RESAMPLER_SLIP_MARGIN samples, less the
+  // history actually held (e.g. just after reset()).
+  void adjustPhase(float delta) {
+    int64_t pos = ((int64_t)_posInt << 32) | _posFrac;
+    pos += (int64_t)llroundf(delta * 4294967296.0f);
+    if (pos < 0)
+      pos = 0;
+    _posInt = (uint32_t)(pos >> 32);
+    _posFrac = (uint32_t)pos;
+  }
+
+  static constexpr int maxBlock = MaxBlock;
+
+  // Worst-case outputs for one input block (size output buffers with this)
+  static constexpr int maxOutput(double ratio) {
+    return (int)(MaxBlock / ratio) + 2;
+  }
+
+  // Block API: consume inCount (<= MaxBlock) samples, write up to maxOut
+  // samples. Returns number of output samples produced.
+  int process(const int16_t *in, int inCount, int16_t *out, int maxOut) {
+    if (!_table || inCount > MaxBlock)
+      return 0;
+
+    for (int i = 0; i < inCount; i++) {
+      _history[_fill + i] = (float)in[i];
+    }
+    _fill += inCount;
+
+    // Centre of the kernel for the next output, relative to in[0]
+    _blockOffset = (float)((int)_posInt + NumTaps / 2 - 1 - (_fill - inCount)) +
+                   (float)_posFrac * (1.0f / 4294967296.0f);
+
+    const int phaseShift = 32 - _log2(NumPhases);
+    const float blendScale = 1.0f / (float)(1UL << phaseShift);
+    const uint32_t blendMask = (1UL << phaseShift) - 1;
+
+    int produced = 0;
+    while (_posInt + NumTaps <= (uint32_t)_fill) {
+      uint32_t phase = _posFrac >> phaseShift;
+      float blend = (float)(_posFrac & blendMask) * blendScale;
+
+      const float *x = &_history[_posInt];
+      float y0, y1;
+      arm_dot_prod_f32(x, _table->h[phase], NumTaps, &y0);
+      arm_dot_prod_f32(x, _table->h[phase + 1], NumTaps, &y1);
+      float y = y0 + blend * (y1 - y0);
+
+      if (y > 32767.0f)
+        y = 32767.0f;
+      if (y < -32768.0f)
+        y = -32768.0f;
+      if (produced < maxOut) {
+        out[produced++] = (int16_t)y;
+      } else {
+        _overruns++; // Caller's buffer is full - sample lost
+      }
+
+      // Advance 32.32 position
+      uint32_t frac = _posFrac + _stepFrac;
+      _posInt += _stepInt + (frac < _posFrac ? 1 : 0);
+      _posFrac = frac;
+    }
+
+    // Keep the samples still needed by the next output, plus the slip
+    // margin. If the next output lies in a future block, keep nothing.
+    int start = (int)_posInt - RESAMPLER_SLIP_MARGIN;
+    if (start < 0)
+      start = 0;
+    if (start > _fill)
+      start = _fill;
+    int keep = _fill - start;
+    memmove(_history, &_history[start], keep * sizeof(float));
+    _posInt -= (uint32_t)start;
+    _fill = keep;
+
+    return produced;
+  }
+
+private:
+  const Table *_table;
+
+  // Input history: leftover taps + slip margin + one new block
+  float _history[NumTaps + RESAMPLER_SLIP_MARGIN + MaxBlock];
+  int _fill;
+
+  // Next output position (index of first tap, 32.32 fixed point)
+  uint32_t _posInt;
+  uint32_t _posFrac;
+  uint32_t _stepInt;
+  uint32_t _stepFrac;
+
+  uint32_t _overruns;
+  float _blockOffset;
+
+  static constexpr int _log2(int v) { return (v <= 1) ? 0 : 1 + _log2(v / 2); }
+};
+
+typedef ResamplerTable<RESAMPLER_TAPS, RESAMPLER_PHASES> DownsampleTable;
+typedef PolyphaseResampler<RESAMPLER_TAPS, RESAMPLER_PHASES> Downsampler;
+
+typedef ResamplerTable<UPSAMPLER_TAPS, UPSAMPLER_PHASES> UpsampleTable;
+typedef PolyphaseResampler<UPSAMPLER_TAPS, UPSAMPLER_PHASES, UPSAMPLER_BLOCK>
+    Upsampler;
+
+#endif
@@ -0,0 +1,677 @@
+#ifndef SPI_LINK_H
+#define SPI_LINK_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SpiProtocol.h"
+
+// SPI link codec (wire format in SpiProtocol.h): frame build/parse, sequence
+// and credit bookkeeping, and the master's clock training. No bus or platform
+// code, so the same source runs on the Teensy (EspSpiDriver), the ESP32
+// (Spirit.ino) and both ends at once in the host tests (test/).
+
+// CRC32 (IEEE 802.3, reflected). Nibble table: 64 bytes, two lookups per byte.
+static inline uint32_t spiLinkCrc(const uint8_t* data, uint32_t len) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  uint32_t crc = 0xFFFFFFFF;
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+// Builds one frame in a SPILINK_BUFFER-sized buffer
+class SpiLinkWriter {
+public:
+  void begin(uint8_t* frame) {
+    _frame = frame;
+    _len = 0;
+  }
+
+  // Data bytes that still fit in one more record
+  uint16_t room() const {
+    int r = SPILINK_MAX_BODY - _len - SPILINK_REC_HEADER;
+    return r > 0 ? (uint16_t)r : 0;
+  }
+
+  // Record data area to fill in place (nullptr if maxLen does not fit).
+  // commit() writes the record header with the length actually used.
+  uint8_t* reserve(uint8_t type, uint16_t maxLen) {
+    if (maxLen > room()) return nullptr;
+    _type = type;
+    return _frame + SPILINK_HEADER + _len + SPILINK_REC_HEADER;
+  }
+
+  void commit(uint16_t len) {
+    uint8_t* r = _frame + SPILINK_HEADER + _len;
+    r[0] = _type;
+    r[1] = len >> 8;
+    r[2] = len & 0xFF;
+    _len += SPILINK_REC_HEADER + len;
+  }
+
+  bool add(uint8_t type, const uint8_t* data, uint16_t len) {
+    uint8_t* p = reserve(type, len);
+    if (!p) return false;
+    if (len) memcpy(p, data, len);
+    commit(len);
+    return true;
+  }
+
+  // Header and CRC; returns the frame length
+  uint16_t finish(uint8_t seq, uint8_t ack, uint8_t credits, uint8_t flags, uint8_t errors) {
+    _frame[0] = SPILINK_MAGIC;
+    _frame[1] = SPILINK_VERSION;
+    _frame[2] = seq;
+    _frame[3] = ack;
+    _frame[4] = credits;
+    _frame[5] = flags;
+    _frame[6] = errors;
+    _frame[7] = 0;
+    _frame[8] = _len >> 8;
+    _frame[9] = _len & 0xFF;
+    uint16_t n = SPILINK_HEADER + _len;
+    uint32_t crc = spiLinkCrc(_frame, n);
+    _frame[n++] = crc >> 24;
+    _frame[n++] = (crc >> 16) & 0xFF;
+    _frame[n++] = (crc >> 8) & 0xFF;
+    _frame[n++] = crc & 0xFF;
+    return n;
+  }
+
+private:
+  uint8_t* _frame = nullptr;
+  uint16_t _len = 0; // Body bytes so far
+  uint8_t _type = 0;
+};
+
+// Checks one received frame and walks its records
+class SpiLinkReader {
+public:
+  // Frame length announced by a header, 0 if it is not a frame of this
+  // version (the master sizes the rest of the transaction with it)
+  static uint16_t frameLength(const uint8_t* h) {
+    if (h[0] != SPILINK_MAGIC || h[1] != SPILINK_VERSION) return 0;
+    uint16_t body = ((uint16_t)h[8] << 8) | h[9];
+    if (body > SPILINK_MAX_BODY) return 0;
+    return SPILINK_HEADER + body + SPILINK_CRC;
+  }
+
+  // SPILINK_OK or SPILINK_ERR_*. avail: bytes actually clocked in
+  int open(const uint8_t* frame, uint16_t avail) {
+    _frame = frame;
+    _pos = _end = SPILINK_HEADER;
+    if (avail < SPILINK_HEADER || frame[0] != SPILINK_MAGIC) return SPILINK_ERR_MAGIC;
+    if (frame[1] != SPILINK_VERSION) return SPILINK_ERR_VERSION;
+    uint16_t n = frameLength(frame);
+    if (n == 0 || n > avail) return SPILINK_ERR_LENGTH;
+    uint16_t body = n - SPILINK_CRC;
+    uint32_t crc = ((uint32_t)frame[body] << 24) | ((uint32_t)frame[body + 1] << 16) |
+                   ((uint32_t)frame[body + 2] << 8) | frame[body + 3];
+    if (spiLinkCrc(frame, body) != crc) return SPILINK_ERR_CRC;
+    _end = body;
+    return SPILINK_OK;
+  }
+
+  // Next record; false at the end (or on a record overrunning the body)
+  bool next(uint8_t* type, const uint8_t** data, uint16_t* len) {
+    if (_pos + SPILINK_REC_HEADER > _end) return false;
+    const uint8_t* r = _frame + _pos;
+    uint16_t n = ((uint16_t)r[1] << 8) | r[2];
+    if (_pos + SPILINK_REC_HEADER + n > _end) return false;
+    *type = r[0];
+    *data = r + SPILINK_REC_HEADER;
+    *len = n;
+    _pos += SPILINK_REC_HEADER + n;
+    return true;
+  }
+
+private:
+  const uint8_t* _frame = nullptr;
+  uint16_t _pos = 0, _end = 0;
+};
+
+// ESP32 bridge counters (STATS record, layout in SpiProtocol.h)
+struct SpiLinkBridgeStats {
+  uint32_t uptimeMs;
+  uint32_t netRxPackets;  // From the network, for the Teensy
+  uint32_t netRxBytes;
+  uint32_t netTxPackets;  // From the Teensy, sent
+  uint32_t netTxBytes;
+  uint32_t toSpiDrops;    // Network datagram, queue to the SPI side full
+  uint32_t toNetDrops;    // Teensy datagram, queue to the network side full
+  uint32_t sendFails;
+  uint32_t tooLong;
+  uint16_t toSpiHigh, toSpiSlots;
+  uint16_t toNetHigh, toNetSlots;
+};
+
+static inline void spiLinkPutStats(uint8_t* p, const SpiLinkBridgeStats& s) {
+  const uint32_t w[9] = {s.uptimeMs, s.netRxPackets, s.netRxBytes, s.netTxPackets, s.netTxBytes,
+                         s.toSpiDrops, s.toNetDrops, s.sendFails, s.tooLong};
+  for (int i = 0; i < 9; i++, p += 4) {
+    p[0] = w[i] >> 24;
+    p[1] = (w[i] >> 16) & 0xFF;
+    p[2] = (w[i] >> 8) & 0xFF;
+    p[3] = w[i] & 0xFF;
+  }
+  const uint16_t h[4] = {s.toSpiHigh, s.toSpiSlots, s.toNetHigh, s.toNetSlots};
+  for (int i = 0; i < 4; i++, p += 2) {
+    p[0] = h[i] >> 8;
+    p[1] = h[i] & 0xFF;
+  }
+}
+
+static inline void spiLinkGetStats(const uint8_t* p, SpiLinkBridgeStats* s) {
+  uint32_t* w[9] = {&s->uptimeMs, &s->netRxPackets, &s->netRxBytes, &s->netTxPackets, &s->netTxBytes,
+                    &s->toSpiDrops, &s->toNetDrops, &s->sendFails, &s->tooLong};
+  for (int i = 0; i < 9; i++, p += 4)
+    *w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+  uint16_t* h[4] = {&s->toSpiHigh, &s->toSpiSlots, &s->toNetHigh, &s->toNetSlots};
+  for (int i = 0; i < 4; i++, p += 2) *h[i] = ((uint16_t)p[0] << 8) | p[1];
+}
+
+// What one end does with datagrams; implemented by the driver/firmware
+class SpiLinkPort {
+public:
+  virtual ~SpiLinkPort() {}
+
+  // Next datagram to send if it fits in maxLen: fills ip/port/data, removes
+  // it from the queue and returns its length. 0: none, or it does not fit
+  // (it stays queued for the next frame).
+  virtual uint16_t nextDatagram(uint8_t* ip, uint16_t* port, uint8_t* data, uint16_t maxLen) = 0;
+  virtual bool hasDatagram() = 0;
+
+  // A received datagram. false: no room, dropped
+  virtual bool onDatagram(const uint8_t* ip, uint16_t port, const uint8_t* data, uint16_t len) = 0;
+
+  // Receive slots free now, sent as CREDITS
+  virtual uint8_t credits() = 0;
+
+  // WiFi config (slave only; data is the CONFIG record)
+  virtual void onConfig(const uint8_t* data, uint16_t len) { (void)data; (void)len; }
+
+  // Bridge counters for a STATS answer (slave only); false: none
+  virtual bool getBridgeStats(SpiLinkBridgeStats* s) { (void)s; return false; }
+};
+
+// Counters since reset (both ends)
+struct SpiLinkStats {
+  uint32_t framesTx;
+  uint32_t framesRx;      // Intact frames received
+  uint32_t badFrames;     // Not a frame, bad length or bad CRC
+  uint32_t versionErrors; // Frame of another protocol version
+  uint32_t seqLost;       // Frames missing between received SEQs
+  uint32_t duplicates;    // SEQ not newer than the last one: ignored
+  uint32_t datagramsTx;
+  uint32_t datagramsRx;
+  uint32_t rxDropped;     // Received with no room (peer overran the credits)
+  uint32_t creditStalls;  // Frame sent with datagrams left waiting for credit
+  uint32_t resent;        // Frame sent again after a bad one came back
+  uint16_t maxBatch;      // Most datagrams in one frame
+  uint8_t peerErrors;     // ERRORS byte of the last intact frame
+};
+
+// Sequence, ack and credit bookkeeping shared by both ends. Roles add their
+// own flags and control records.
+class SpiLinkEnd {
+public:
+  virtual ~SpiLinkEnd() {}
+
+  // Forget the other end (new peer or restart). Statistics are kept.
+  void resetLink() {
+    _seq = 0;
+    _rxValid = false;
+    _rxSeq = 0;
+    _peerAck = 0;
+    _peerCredits = 0;
+    _peerFlags = 0;
+    _resend = false;
+    memset(_sent, 0, sizeof(_sent));
+  }
+  void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+  // Next outgoing frame into frame[SPILINK_BUFFER]; returns its length.
+  // After a bad receive the last frame (still in the buffer) goes again with
+  // its SEQ: if the other end was not armed it gets it now, and if it had it,
+  // it drops the repeat.
+  // (Only with a single frame buffer: an end that queues frames ahead has
+  // already sent newer ones.)
+  uint16_t build(uint8_t* frame, SpiLinkPort& port) {
+    if (_resend) {
+      _resend = false;
+      if (frame == _lastFrame) {
+        _stats.resent++;
+        return _lastLen;
+      }
+    }
+    _w.begin(frame);
+    _control(_w, port);
+
+    uint8_t n = 0;
+    if (_datagramsAllowed()) {
+      int credits = sendCredits();
+      while (n < credits) {
+        uint16_t room = _w.room();
+        if (room <= SPILINK_DATAGRAM_ADDR) break;
+        uint16_t maxLen = room - SPILINK_DATAGRAM_ADDR;
+        if (maxLen > SPILINK_MAX_DATAGRAM) maxLen = SPILINK_MAX_DATAGRAM;
+        uint8_t* p = _w.reserve(SPILINK_REC_DATAGRAM, SPILINK_DATAGRAM_ADDR + maxLen);
+        uint16_t remotePort = 0;
+        uint16_t len = port.nextDatagram(p, &remotePort, p + SPILINK_DATAGRAM_ADDR, maxLen);
+        if (len == 0) break;
+        p[4] = remotePort >> 8;
+        p[5] = remotePort & 0xFF;
+        _w.commit(SPILINK_DATAGRAM_ADDR + len);
+        n++;
+      }
+      if (n == credits && port.hasDatagram()) _stats.creditStalls++;
+    }
+
+    uint8_t flags = _flags();
+    if (port.hasDatagram()) flags |= SPILINK_FLAG_PENDING;
+    _seq++;
+    _sent[_seq & 15] = n;
+    _stats.framesTx++;
+    _stats.datagramsTx += n;
+    if (n > _stats.maxBatch) _stats.maxBatch = n;
+    _lastFrame = frame;
+    _lastLen = _w.finish(_seq, _rxSeq, port.credits(), flags, (uint8_t)_stats.badFrames);
+    return _lastLen;
+  }
+
+  // A frame clocked in (avail bytes). Returns SPILINK_OK or SPILINK_ERR_*
+  int receive(const uint8_t* frame, uint16_t avail, SpiLinkPort& port) {
+    int r = _r.open(frame, avail);
+    _resend = r != SPILINK_OK;
+    if (r != SPILINK_OK) {
+      if (r == SPILINK_ERR_VERSION) {
+        _stats.versionErrors++;
+        _peerVersion = frame[1];
+      } else {
+        _stats.badFrames++;
+      }
+      return r;
+    }
+    _stats.framesRx++;
+    _peerVersion = SPILINK_VERSION;
+    _onHeader(frame);
+    if (frame[5] & SPILINK_FLAG_HELLO) {
+      // Peer restarted: any SEQ is new, and it has seen none of our frames
+      _rxValid = false;
+      _peerAck = _seq;
+    }
+
+    uint8_t seq = frame[2];
+    if (_rxValid) {
+      int8_t d = (int8_t)(seq - _rxSeq);
+      if (d <= 0) {
+        _stats.duplicates++;
+        return SPILINK_OK;
+      }
+      _stats.seqLost += d - 1;
+    }
+    _rxValid = true;
+    _rxSeq = seq;
+    _peerAck = frame[3];
+    _peerCredits = frame[4];
+    _peerFlags = frame[5];
+    _stats.peerErrors = frame[6];
+
+    uint8_t type;
+    const uint8_t* data;
+    uint16_t len;
+    while (_r.next(&type, &data, &len)) {
+      if (type == SPILINK_REC_DATAGRAM) {
+        if (len < SPILINK_DATAGRAM_ADDR) continue;
+        uint16_t remotePort = ((uint16_t)data[4] << 8) | data[5];
+        if (port.onDatagram(data, remotePort, data + SPILINK_DATAGRAM_ADDR, len - SPILINK_DATAGRAM_ADDR)) {
+          _stats.datagramsRx++;
+        } else {
+          _stats.rxDropped++;
+        }
+      } else {
+        _onControl(type, data, len, port);
+      }
+    }
+    return SPILINK_OK;
+  }
+
+  // Datagrams the other end can take now: its last CREDITS, less those sent
+  // in frames it had not seen (after its ACK; at most 15 frames back)
+  int sendCredits() const {
+    uint8_t behind = _seq - _peerAck;
+    if (behind > 15) behind = 15;
+    int inflight = 0;
+    for (uint8_t i = 0; i < behind; i++) inflight += _sent[(uint8_t)(_seq - i) & 15];
+    int c = (int)_peerCredits - inflight;
+    return c > 0 ? c : 0;
+  }
+
+  uint8_t getPeerFlags() const { return _peerFlags; }
+  uint8_t getPeerVersion() const { return _peerVersion; }
+  const SpiLinkStats& getStats() const { return _stats; }
+
+protected:
+  SpiLinkEnd() {
+    resetLink();
+    resetStats();
+  }
+
+  virtual uint8_t _flags() = 0;
+  virtual void _control(SpiLinkWriter& w, SpiLinkPort& port) = 0;  // Role records, before datagrams
+  virtual bool _datagramsAllowed() { return true; }
+  virtual void _onHeader(const uint8_t* h) { (void)h; }
+  virtual void _onControl(uint8_t type, const uint8_t* data, uint16_t len, SpiLinkPort& port) = 0;
+
+  // TEST record: fixed pattern, dense in bit transitions
+  static void _addTest(SpiLinkWriter& w) {
+    uint8_t* p = w.reserve(SPILINK_REC_TEST, SPILINK_TEST_LEN);
+    if (!p) return;
+    for (uint16_t i = 0; i < SPILINK_TEST_LEN; i++) p[i] = (i & 1) ? 0xA5 : (uint8_t)(i * 0x3B);
+    w.commit(SPILINK_TEST_LEN);
+  }
+
+  SpiLinkStats _stats;
+
+private:
+  SpiLinkWriter _w;
+  SpiLinkReader _r;
+  uint8_t _seq;         // Last SEQ sent
+  bool _rxValid;
+  uint8_t _rxSeq;       // Last SEQ received (our ACK)
+  uint8_t _peerAck;
+  uint8_t _peerCredits;
+  uint8_t _peerFlags;
+  uint8_t _peerVersion = SPILINK_VERSION;
+  uint8_t _sent[16];    // Datagrams per SEQ (& 15)
+  bool _resend;
+  const uint8_t* _lastFrame = nullptr;
+  uint16_t _lastLen = 0;
+};
+
+// Master (Teensy): clock training, WiFi config delivery, status requests.
+//
+// HELLO: frames with FLAG_HELLO at the lowest clock until an intact answer.
+// TRAIN: SPILINK_TRAIN_FRAMES frames with TEST records per clock step. A bad
+//   frame is one we could not check, or one the slave could not (its ERRORS
+//   rising). The first frame of a step only takes the ERRORS baseline, since
+//   the slave reports a transaction late. No frame at all (slave not re-armed)
+//   is retried rather than counted.
+// RUN:   datagrams; SPILINK_RETRAIN_ERRORS bad frames in a row go to HELLO.
+class SpiLinkMaster : public SpiLinkEnd {
+public:
+  SpiLinkMaster() { hello(); }
+
+  void hello() {
+    resetLink();
+    _state = SPILINK_STATE_HELLO;
+    _step = 0;
+    _runBad = 0;
+    _peerUp = false;
+  }
+
+  // Call after each transaction with receive()'s result
+  void onTransaction(int result) {
+    bool ok = result == SPILINK_OK;
+    uint8_t peerErrors = _stats.peerErrors;
+
+    switch (_state) {
+      case SPILINK_STATE_HELLO:
+        if (ok) {
+          _state = SPILINK_STATE_TRAIN;
+          _step = 0;
+          memset(_stepErrors, 0, sizeof(_stepErrors));
+          _startStep(peerErrors);
+        }
+        break;
+
+      case SPILINK_STATE_TRAIN: {
+        // No frame at all is the slave not re-armed yet, not the clock
+        // (overclocking shows as CRC errors): the frame goes again. Only a
+        // step's worth of them counts.
+        if (result == SPILINK_ERR_MAGIC && ++_stepIdle <= SPILINK_TRAIN_FRAMES) break;
+        uint8_t bad = ok ? 0 : 1;
+        if (ok && !_settle) bad += (uint8_t)(peerErrors - _lastPeerErrors);
+        if (ok) _lastPeerErrors = peerErrors;
+        _settle = false;
+        _stepFrames++;
+        _stepBad += bad;
+        if (_stepBad > SPILINK_TRAIN_MAX_ERRORS) {
+          _stepErrors[_step] = _stepBad;
+          _run(_step > 0 ? _step - 1 : 0);
+        } else if (_stepFrames >= SPILINK_TRAIN_FRAMES) {
+          _stepErrors[_step] = _stepBad;
+          if (_step + 1 < SPILINK_CLOCK_STEPS) {
+            _step++;
+            _startStep(peerErrors);
+          } else {
+            _run(_step);
+          }
+        }
+        break;
+      }
+
+      case SPILINK_STATE_RUN:
+        if (ok && peerErrors == _lastPeerErrors) {
+          _runBad = 0;
+        } else {
+          _runBad++;
+          if (ok) _lastPeerErrors = peerErrors;
+          if (_runBad >= SPILINK_RETRAIN_ERRORS) {
+            _retrains++;
+            hello();
+          }
+        }
+        break;
+    }
+    if (ok) _peerUp = (getPeerFlags() & SPILINK_FLAG_LINK_UP) != 0;
+  }
+
+  uint8_t getState() const { return _state; }
+  bool isUp() const { return _state == SPILINK_STATE_RUN; }
+  uint8_t getStep() const { return _step; }
+  uint32_t getClock() const {
+    static const uint32_t clocks[SPILINK_CLOCK_STEPS] = SPILINK_CLOCKS;
+    return clocks[_step];
+  }
+  // Bad frames per step in the last training (0xFF: step not reached)
+  uint8_t getStepErrors(uint8_t step) const { return _stepErrors[step]; }
+  uint32_t getRetrains() const { return _retrains; }
+
+  // More transactions wanted even with nothing queued
+  bool isTraining() const { return _state == SPILINK_STATE_TRAIN; }
+  bool hasControl() const { return isUp() && (_statusWanted || _statsWanted || _cfgPending); }
+
+  // WiFi config: sent until a STATUS echoes its id
+  void setConfig(const char* ssid, const char* pass) {
+    uint8_t ls = strlen(ssid), lp = strlen(pass);
+    if (ls > 32) ls = 32;
+    if (lp > 64) lp = 64;
+    _cfgId++;
+    _cfg[0] = _cfgId;
+    _cfg[1] = ls;
+    memcpy(_cfg + 2, ssid, ls);
+    _cfg[2 + ls] = lp;
+    memcpy(_cfg + 3 + ls, pass, lp);
+    _cfgLen = 3 + ls + lp;
+    _cfgPending = true;
+    _cfgAge = 0xFF;
+  }
+  bool isConfigPending() const { return _cfgPending; }
+
+  void requestStatus() { _statusWanted = true; }
+  void requestBridgeStats() { _statsWanted = true; }
+  // Last STATS answer; the count moves on each one
+  const SpiLinkBridgeStats& getBridgeStats() const { return _bridge; }
+  uint32_t getBridgeStatsCount() const { return _bridgeCount; }
+  uint32_t getStatusCount() const { return _statusCount; }
+  const uint8_t* getLocalIP() const { return _ip; }
+  bool isPeerLinkUp() const { return isUp() && _peerUp; }
+
+protected:
+  uint8_t _flags() override {
+    if (_state == SPILINK_STATE_HELLO) return SPILINK_FLAG_HELLO;
+    if (_state == SPILINK_STATE_TRAIN) return SPILINK_FLAG_TRAIN;
+    return 0;
+  }
+
+  void _control(SpiLinkWriter& w, SpiLinkPort& port) override {
+    (void)port;
+    if (_state == SPILINK_STATE_TRAIN) {
+      _addTest(w);
+      return;
+    }
+    if (_state != SPILINK_STATE_RUN) return;
+    // Config again every 16 frames until confirmed
+    if (_cfgPending && ++_cfgAge >= 16) {
+      _cfgAge = 0;
+      w.add(SPILINK_REC_CONFIG, _cfg, _cfgLen);
+      _statusWanted = true;
+    }
+    if (_statusWanted) {
+      w.add(SPILINK_REC_GET_STATUS, nullptr, 0);
+      _statusWanted = false;
+    }
+    if (_statsWanted) {
+      w.add(SPILINK_REC_GET_STATS, nullptr, 0);
+      _statsWanted = false;
+    }
+  }
+
+  bool _datagramsAllowed() override { return _state == SPILINK_STATE_RUN; }
+
+  void _onControl(uint8_t type, const uint8_t* data, uint16_t len, SpiLinkPort& port) override {
+    (void)port;
+    if (type == SPILINK_REC_STATS && len >= SPILINK_STATS_LEN) {
+      spiLinkGetStats(data, &_bridge);
+      _bridgeCount++;
+      return;
+    }
+    if (type != SPILINK_REC_STATUS || len < 5) return;
+    memcpy(_ip, data, 4);
+    if (data[4] == _cfgId) _cfgPending = false;
+    _statusCount++;
+  }
+
+private:
+  void _startStep(uint8_t peerErrors) {
+    _stepFrames = 0;
+    _stepBad = 0;
+    _stepIdle = 0;
+    _settle = true;
+    _lastPeerErrors = peerErrors;
+    for (uint8_t s = _step; s < SPILINK_CLOCK_STEPS; s++) _stepErrors[s] = 0xFF;
+  }
+
+  void _run(uint8_t step) {
+    _step = step;
+    _state = SPILINK_STATE_RUN;
+    _runBad = 0;
+  }
+
+  uint8_t _state;
+  uint8_t _step;
+  uint8_t _stepFrames = 0;
+  uint8_t _stepBad = 0;
+  uint8_t _stepIdle = 0;
+  bool _settle = false;
+  uint8_t _lastPeerErrors = 0;
+  uint8_t _stepErrors[SPILINK_CLOCK_STEPS] = {};
+  uint8_t _runBad;
+  uint32_t _retrains = 0;
+  bool _peerUp;
+
+  uint8_t _cfg[3 + 32 + 64];
+  uint8_t _cfgLen = 0;
+  uint8_t _cfgId = 0;
+  uint8_t _cfgAge = 0;
+  bool _cfgPending = false;
+  bool _statusWanted = false;
+  bool _statsWanted = false;
+  uint32_t _statusCount = 0;
+  SpiLinkBridgeStats _bridge = {};
+  uint32_t _bridgeCount = 0;
+  uint8_t _ip[4] = {0, 0, 0, 0};
+};
+
+// Slave (ESP32): answers HELLO/TRAIN, applies config once per id, reports
+// address and WiFi link.
+class SpiLinkSlave : public SpiLinkEnd {
+public:
+  void setLinkUp(bool up) { _linkUp = up; }
+
+  // Local address; a change is reported unasked
+  void setAddress(const uint8_t* ip) {
+    if (memcmp(ip, _ip, 4) == 0) return;
+    memcpy(_ip, ip, 4);
+    _statusDue = true;
+  }
+
+  // Something to say besides datagrams (raise READY)
+  bool hasControl() const { return _statusDue || _statsDue || _testDue; }
+
+protected:
+  // HELLO until the master is heard, so a restarted slave's SEQ is taken as new
+  uint8_t _flags() override {
+    return (_linkUp ? SPILINK_FLAG_LINK_UP : 0) | (_heard ? 0 : SPILINK_FLAG_HELLO);
+  }
+
+  void _control(SpiLinkWriter& w, SpiLinkPort& port) override {
+    if (_testDue) {
+      _addTest(w);
+      _testDue = false;
+    }
+    if (_statusDue) {
+      uint8_t s[5] = {_ip[0], _ip[1], _ip[2], _ip[3], _cfgId};
+      w.add(SPILINK_REC_STATUS, s, 5);
+      _statusDue = false;
+    }
+    if (_statsDue) {
+      uint8_t* p = w.reserve(SPILINK_REC_STATS, SPILINK_STATS_LEN);
+      SpiLinkBridgeStats s;
+      if (p && port.getBridgeStats(&s)) {
+        spiLinkPutStats(p, s);
+        w.commit(SPILINK_STATS_LEN);
+      }
+      _statsDue = false;
+    }
+  }
+
+  void _onHeader(const uint8_t* h) override {
+    _heard = true;
+    if (h[5] & SPILINK_FLAG_TRAIN) _testDue = true;
+  }
+
+  void _onControl(uint8_t type, const uint8_t* data, uint16_t len, SpiLinkPort& port) override {
+    if (type == SPILINK_REC_GET_STATUS) {
+      _statusDue = true;
+    } else if (type == SPILINK_REC_GET_STATS) {
+      _statsDue = true;
+    } else if (type == SPILINK_REC_CONFIG && len >= 3) {
+      // Resent until confirmed: apply each id once
+      if (!_cfgValid || data[0] != _cfgId) {
+        _cfgId = data[0];
+        _cfgValid = true;
+        port.onConfig(data, len);
+      }
+      _statusDue = true;
+    }
+  }
+
+private:
+  bool _linkUp = false;
+  bool _heard = false;
+  bool _statusDue = true;
+  bool _statsDue = false;
+  bool _testDue = false;
+  bool _cfgValid = false;
+  uint8_t _cfgId = 0;
+  uint8_t _ip[4] = {0, 0, 0, 0};
+};
+
+#endif
@@ -3,31 +3,104 @@
 
 #include <stdint.h>
 
-// Commands (Teensy -> ESP)
-#define CMD_NOP 0x00
-#define CMD_GET_STATUS 0x01
-#define CMD_SET_CONFIG 0x02 // SSID, PASS
-#define CMD_GET_IP 0x03     // Returns 4 bytes IPv4
-#define CMD_SEND_UDP 0x10   // + Target Info
-
-// Responses/Status Flags
-#define STATUS_IDLE 0x00
-#define STATUS_HAS_DATA 0x01  // ESP has received data for Teensy
-#define STATUS_WIFI_CONN 0x02 // WiFi is Connected
-#define STATUS_ERROR 0x80
-
-// Command Packets Structures (Conceptual)
-
-// CMD_SEND_UDP Format:
-// [CMD (1)] [LEN_HI] [LEN_LO] [IP1] [IP2] [IP3] [IP4] [PORT_HI] [PORT_LO]
-// [DATA...]
-
-// CMD_SET_CONFIG Format:
-// [CMD (1)] [SSID_LEN (1)] [SSID...] [PASS_LEN (1)] [PASS...]
-
-// Reading Data (Teensy Reads)
-// Send [0x00] continuously to clock out STATUS byte.
-// If STATUS_HAS_DATA bit is set:
-// Continue clocking to get: [LEN_HI] [LEN_LO] [DATA...]
+// Teensy <-> ESP32 SPI Link Protocol
+// Shared by the Teensy (master, EspSpiDriver) and the ESP32 bridge (slave,
+// esp32_firmware/Spirit). Both must be built from the same version.
+//
+// Every transaction carries one frame each way (SPI is full duplex):
+//   [HEADER 10] [BODY LEN] [CRC32 4]
+// The master clocks the two headers first, reads the slave's body length,
+// then clocks max(its frame, the slave's frame) in total. Bytes past the end
+// of a frame are zero and ignored.
+//
+// Header:
+//   0 MAGIC    SPILINK_MAGIC
+//   1 VERSION  SPILINK_VERSION (a frame of another version is rejected)
+//   2 SEQ      Sender's frame number, +1 per frame
+//   3 ACK      Last SEQ received intact from the other end
+//   4 CREDITS  Datagrams the sender can take now (receive slots free)
+//   5 FLAGS    SPILINK_FLAG_*
+//   6 ERRORS   Frames the sender received with a bad CRC (mod 256)
+//   7 (zero)
+//   8 LEN_HI   Body length
+//   9 LEN_LO
+// CRC32 (IEEE 802.3) over header + body, big-endian.
+//
+// An end that receives a bad frame (or none: the slave was not armed) sends
+// its own last frame again, same SEQ; the other end ignores a SEQ it has
+// already had (an end that queues frames ahead, like the ESP32 bridge, cannot
+// resend). There is no other retransmission: a frame that arrives bad
+// while the one coming back is intact is lost, as on the network, and SEQ
+// gaps count it. The WiFi config is the one thing confirmed, by its id coming
+// back in a STATUS record.
+//
+// Flow control: the sender may have no more datagrams outstanding than the
+// CREDITS in the last frame received, less those sent in frames the other
+// end had not seen yet (SEQ after its ACK).
+
+#define SPILINK_VERSION 1
+#define SPILINK_MAGIC 0xA5
+
+#define SPILINK_HEADER 10
+#define SPILINK_CRC 4
+#define SPILINK_MAX_BODY 1536
+#define SPILINK_MAX_FRAME (SPILINK_HEADER + SPILINK_MAX_BODY + SPILINK_CRC)
+#define SPILINK_BUFFER 1552 // SPILINK_MAX_FRAME rounded up for 32-bit DMA
+
+// Header flags
+#define SPILINK_FLAG_HELLO 0x01   // Sender (re)starting: reset SEQ tracking
+#define SPILINK_FLAG_TRAIN 0x02   // Clock training: answer with a TEST record
+#define SPILINK_FLAG_LINK_UP 0x04 // Slave: WiFi associated
+#define SPILINK_FLAG_PENDING 0x08 // More queued than this frame carried
+
+// Body records: [TYPE] [LEN_HI] [LEN_LO] [DATA...]. Unknown types are
+// skipped, so a record can be added without a version change.
+#define SPILINK_REC_HEADER 3
+#define SPILINK_REC_DATAGRAM 0x01   // [IP 4] [PORT 2] [PAYLOAD]
+#define SPILINK_REC_CONFIG 0x02     // [ID] [SSID_LEN] [SSID] [PASS_LEN] [PASS]
+#define SPILINK_REC_GET_STATUS 0x03 // (empty) answer with STATUS
+#define SPILINK_REC_STATUS 0x04     // [IP 4] [CONFIG ID]
+#define SPILINK_REC_TEST 0x05       // Training pattern
+#define SPILINK_REC_GET_STATS 0x06  // (empty) answer with STATS
+#define SPILINK_REC_STATS 0x07      // Bridge counters, SPILINK_STATS_LEN bytes
+
+// Datagram record: IP/port are the destination (to the ESP32) or the
+// sender (from the ESP32)
+#define SPILINK_DATAGRAM_ADDR 6
+#define SPILINK_MAX_DATAGRAM 512
+#define SPILINK_TEST_LEN 256
+
+// STATS record (ESP32 bridge counters, all big-endian, free-running):
+//   0 UPTIME_MS 4
+//   4 NET_RX_PACKETS 4   8 NET_RX_BYTES 4   From the network, for the Teensy
+//  12 NET_TX_PACKETS 4  16 NET_TX_BYTES 4   From the Teensy, sent
+//  20 TO_SPI_DROPS 4    Network datagram, queue to the SPI side full
+//  24 TO_NET_DROPS 4    Teensy datagram, queue to the network side full
+//  28 SEND_FAILS 4      Network send failed
+//  32 TOO_LONG 4        Network datagram over SPILINK_MAX_DATAGRAM
+//  36 TO_SPI_HIGH 2     38 TO_SPI_SLOTS 2   Queue high water / size
+//  40 TO_NET_HIGH 2     42 TO_NET_SLOTS 2
+#define SPILINK_STATS_LEN 44
+
+// Clock training (master): each step runs SPILINK_TRAIN_FRAMES frames with
+// TEST records both ways. A step with more than SPILINK_TRAIN_MAX_ERRORS
+// bad frames (either direction) ends the climb one step down.
+#define SPILINK_CLOCKS {4000000, 8000000, 12000000, 16000000, 20000000, 24000000, 30000000}
+#define SPILINK_CLOCK_STEPS 7
+#define SPILINK_TRAIN_FRAMES 32
+#define SPILINK_TRAIN_MAX_ERRORS 0
+#define SPILINK_RETRAIN_ERRORS 8 // Bad frames in a row in RUN: train again
+
+// Link states (master)
+#define SPILINK_STATE_HELLO 0 // Lowest clock, waiting for a valid frame
+#define SPILINK_STATE_TRAIN 1 // Stepping the clock up
+#define SPILINK_STATE_RUN 2   // Datagrams flow
+
+// Received-frame results
+#define SPILINK_OK 0
+#define SPILINK_ERR_MAGIC 1   // Not a frame (slave not armed, noise)
+#define SPILINK_ERR_VERSION 2
+#define SPILINK_ERR_LENGTH 3
+#define SPILINK_ERR_CRC 4
 
 #endif
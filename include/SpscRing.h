@@ -0,0 +1,128 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Lock-Free Single-Producer / Single-Consumer Ring
+// Fixed capacity (power of two). One side may run in an ISR, the other in
+// loop(). Head/tail are free-running 32-bit counters, so all Capacity slots
+// are usable and "full" vs "empty" never needs a spare slot.
+//
+// Producer: push() copies an item in; reserve()/commit() lets the producer
+//           fill the next slot in place (e.g. across several audio ISRs).
+// Consumer: readView() returns the longest contiguous run of readable items
+//           so it can be processed in place, then consume() releases it.
+
+template <typename T, uint32_t Capacity> class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscRing capacity must be a power of two");
+
+public:
+  SpscRing() : _head(0), _tail(0), _overflows(0), _underflows(0), _highWater(0) {}
+
+  static constexpr uint32_t capacity() { return Capacity; }
+
+  // --- Producer side ---
+
+  // Copy one item in. Returns false (and counts an overflow) when full.
+  bool push(const T &item) {
+    T *slot = reserve();
+    if (!slot)
+      return false;
+    *slot = item;
+    commit();
+    return true;
+  }
+
+  // Next free slot for in-place writing, or nullptr (overflow) when full.
+  // The slot is not visible to the consumer until commit().
+  T *reserve() {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= Capacity) {
+      _overflows++;
+      return nullptr;
+    }
+    return &_buf[head & (Capacity - 1)];
+  }
+
+  // Publish the slot returned by reserve()
+  void commit() {
+    uint32_t head = _head.load(std::memory_order_relaxed) + 1;
+    _head.store(head, std::memory_order_release);
+
+    uint32_t used = head - _tail.load(std::memory_order_relaxed);
+    if (used > _highWater)
+      _highWater = used;
+  }
+
+  // --- Consumer side ---
+
+  uint32_t available() const {
+    return _head.load(std::memory_order_acquire) -
+           _tail.load(std::memory_order_relaxed);
+  }
+
+  // Contiguous readable run starting at the oldest item (0 = empty).
+  // Items stay owned by the consumer until consume().
+  uint32_t readView(T **first) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t count = _head.load(std::memory_order_acquire) - tail;
+    if (count == 0) {
+      _underflows++;
+      *first = nullptr;
+      return 0;
+    }
+    uint32_t index = tail & (Capacity - 1);
+    uint32_t toEnd = Capacity - index;
+    *first = &_buf[index];
+    return (count < toEnd) ? count : toEnd;
+  }
+
+  // Oldest item in place, or nullptr (underflow) when empty
+  T *peek() {
+    T *first;
+    return readView(&first) ? first : nullptr;
+  }
+
+  // Release n items obtained through readView()/peek()
+  void consume(uint32_t n = 1) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t count = _head.load(std::memory_order_acquire) - tail;
+    if (n > count)
+      n = count;
+    _tail.store(tail + n, std::memory_order_release);
+  }
+
+  // Copy the oldest item out. Returns false (underflow) when empty.
+  bool pop(T &out) {
+    T *item = peek();
+    if (!item)
+      return false;
+    out = *item;
+    consume(1);
+    return true;
+  }
+
+  // Drop everything currently queued (consumer side)
+  void clear() {
+    _tail.store(_head.load(std::memory_order_acquire),
+                std::memory_order_release);
+  }
+
+  // --- Statistics ---
+  uint32_t getOverflows() const { return _overflows; }   // Producer found it full
+  uint32_t getUnderflows() const { return _underflows; } // Consumer found it empty
+  uint32_t getHighWater() const { return _highWater; }
+
+private:
+  T _buf[Capacity];
+  std::atomic<uint32_t> _head; // Written by producer only
+  std::atomic<uint32_t> _tail; // Written by consumer only
+
+  volatile uint32_t _overflows;
+  volatile uint32_t _underflows;
+  volatile uint32_t _highWater;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ULAW_H
+#define ULAW_H
+
+#include <stdint.h>
+
+// G.711 u-Law Encoder (16-bit linear PCM in)
+// ulawEncode() finds the segment with a count-leading-zeros (single CLZ
+// instruction on Cortex-M7) instead of searching the segment table, so it is
+// branch-light and constant time. ulawEncodeRef() is the classic table
+// search from the original 16-bit Sun g711.c; the host test
+// (test/test_ulaw.cpp) checks both on all 65536 inputs, and the CLI [B]
+// compares their throughput. Sun's later 14-bit g711.c drops the 2 low bits
+// before negating, so it encodes a negative input as if rounded away from
+// zero to a multiple of 4 (0x7E for -1, where these give 0x7F). ulawDecode()
+// is the inverse (the middle of each step).
+
+#define ULAW_BIAS 0x84  // Added to magnitude before segment search
+#define ULAW_CLIP 32635 // Magnitude clip (0x7FFF - ULAW_BIAS)
+
+static inline uint8_t ulawEncode(int16_t pcm) {
+  int32_t x = pcm;
+  uint8_t mask = 0xFF;
+  if (x < 0) {
+    x = -x; // int32: -32768 is fine
+    mask = 0x7F;
+  }
+  if (x > ULAW_CLIP)
+    x = ULAW_CLIP;
+  x += ULAW_BIAS; // 0x84 .. 0x7FFF, MSB at bit 7..14
+
+  int seg = (31 - __builtin_clz((uint32_t)x)) - 7; // 0..7
+  uint8_t uval = (uint8_t)((seg << 4) | ((x >> (seg + 3)) & 0xF));
+  return uval ^ mask;
+}
+
+static inline uint8_t ulawEncodeRef(int16_t pcm) {
+  static const int32_t segEnd[8] = {0xFF,  0x1FF,  0x3FF,  0x7FF,
+                                    0xFFF, 0x1FFF, 0x3FFF, 0x7FFF};
+  int32_t x = pcm;
+  uint8_t mask;
+  if (x < 0) {
+    x = ULAW_BIAS - x;
+    mask = 0x7F;
+  } else {
+    x += ULAW_BIAS;
+    mask = 0xFF;
+  }
+  if (x > 0x7FFF)
+    x = 0x7FFF;
+
+  int seg = 8;
+  for (int i = 0; i < 8; i++) {
+    if (x <= segEnd[i]) {
+      seg = i;
+      break;
+    }
+  }
+  if (seg >= 8)
+    return (0x7F ^ mask);
+
+  uint8_t uval = (uint8_t)((seg << 4) | ((x >> (seg + 3)) & 0xF));
+  return uval ^ mask;
+}
+
+static inline int16_t ulawDecode(uint8_t uval) {
+  uval = ~uval;
+  int32_t t = ((uval & 0x0F) << 3) + ULAW_BIAS;
+  t <<= (uval & 0x70) >> 4;
+  return (int16_t)((uval & 0x80) ? (ULAW_BIAS - t) : (t - ULAW_BIAS));
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define VOTER_CLIENT_H
 
 #include "GPSManager.h"
+#include "LatencyHistogram.h"
 #include "NetworkManager.h"
 #include "VoterProtocol.h"
 #include <Arduino.h>
@@ -13,22 +14,144 @@ enum VoterState {
   VOTER_CONNECTED = 2
 };
 
+// Host Sessions
+// Each host (primary, backup, ...) gets its own challenge/digest state
+// machine. Audio is packetized once; only the digest is patched per host.
+#define VOTER_MAX_HOSTS 4
+#define VOTER_HOST_TIMEOUT_MS 3000 // Silence counted as a host outage (stats)
+
+// Round-trip latency (PAYLOAD_PING)
+#define VOTER_PING_COUNT 100       // Default pings per burst
+#define VOTER_PING_INTERVAL_MS 50  // Default spacing
+#define VOTER_PING_WINDOW 32       // Pings in flight; older ones are lost
+#define VOTER_PING_TIMEOUT_MS 1000 // After the last send of a burst
+
+// Receive: each update() drains up to VOTER_RX_BATCH datagrams into a
+// preallocated pool (so the driver's buffer is freed at once), then
+// dispatches them by payload type. Anything left waits for the next pass.
+#define VOTER_RX_BATCH 8      // Datagrams per update(), bounds loop() time
+#define VOTER_RX_MAX_LEN MAX_BUFFER_SIZE // Larger datagrams are dropped
+#define VOTER_RX_TYPES 6      // Payload types counted (PAYLOAD_AUTH..PING)
+
+// Per-host statistics
+struct VoterHostStats {
+  uint32_t connects;    // Transitions to CONNECTED
+  uint32_t challenges;  // New server challenges (host restarts)
+  uint32_t authSent;    // Auth requests sent
+  uint32_t packetsRx;   // Authenticated packets from the host
+  uint32_t audioSent;   // Audio packets sent
+  uint32_t audioMissed; // Audio packets this host missed (not connected)
+  uint32_t lastRxMs;    // millis() of the last authenticated packet
+  uint32_t timeouts;    // Silences longer than VOTER_HOST_TIMEOUT_MS
+};
+
+// Receive statistics (all hosts)
+struct VoterRxStats {
+  uint32_t packets;     // Datagrams read
+  uint32_t bytes;
+  uint32_t byType[VOTER_RX_TYPES]; // Authenticated, by payload type
+  uint32_t dropShort;   // Shorter than a Voter header
+  uint32_t dropLong;    // Longer than VOTER_RX_MAX_LEN
+  uint32_t dropNoHost;  // Not from one of our hosts
+  uint32_t dropDigest;  // Bad host digest (non-auth packets)
+  uint32_t dropType;    // Unknown payload type
+  uint32_t passes;      // update() passes that read anything
+  uint32_t fullPasses;  // Passes that stopped at VOTER_RX_BATCH
+  uint16_t maxBatch;    // Most datagrams in one pass
+  uint32_t procUsTotal; // Drain + dispatch time, over `passes`
+  uint32_t procUsMax;
+};
+
+// One received datagram and its sender
+struct VoterRxPacket {
+  uint8_t data[VOTER_RX_MAX_LEN];
+  uint16_t len;
+  IPAddress ip; // 0.0.0.0 if the driver can't tell
+  uint16_t port;
+  uint8_t link; // NetworkManager link it came in on
+};
+
+// One host: address, auth state machine, statistics and ping results
+struct VoterHostSession {
+  IPAddress ip;
+  uint16_t port;
+  VoterState state;
+  char serverChallenge[VOTER_CHALLENGE_LEN + 1];
+  uint32_t serverDigest; // The digest we expect FROM the host
+  uint32_t myDigest;     // The digest we send TO the host
+  uint32_t lastAttemptTime;
+  uint32_t lastGPSSend;
+  bool silent; // Connected, but nothing heard for VOTER_HOST_TIMEOUT_MS
+  VoterHostStats stats;
+
+  LatencyHistogram pingHist;
+  uint32_t pingPending; // Bit (seq % VOTER_PING_WINDOW) per ping in flight
+  uint32_t pingsSent;
+};
+
+// TX audio from the host: timestamp (host byte order) + FRAME_SIZE uLaw
+typedef void (*VoterTxAudioHandler)(const VTIME &frameTime,
+                                    const uint8_t *ulaw);
+
 class VoterClient {
 public:
   VoterClient();
 
-  // Init
+  // Init (host = primary host, session 0)
   void begin(NetworkManager *net, GPSManager *gps, IPAddress host,
              uint16_t port, const char *clientPwd, const char *hostPwd);
 
+  // Additional (backup) host, same passwords. Returns its index, or -1.
+  int addHost(IPAddress host, uint16_t port);
+
   // Main Loop
   void update();
 
   // Audio Input (called by Audio ISR or polling)
-  void processAudioFrame(uint8_t *ulawData, uint8_t rssi, VTIME frameTime);
+  // Encode straight into getAudioPayload() (FRAME_SIZE bytes) and pass that
+  // pointer back: the packet is then sent in place with no copies. Any other
+  // buffer is copied into the packet first. frameTime (FrameClock's stamp)
+  // goes on the wire unchanged.
+  uint8_t *getAudioPayload() { return _audioPkt.audio; }
+  void processAudioFrame(const uint8_t *ulawData, uint8_t rssi,
+                         VTIME frameTime);
+
+  // ADPCM Input: ADPCM_FRAME_SIZE bytes (state + 40ms of codes), same rules
+  uint8_t *getAdpcmPayload() { return _adpcmPkt.audio; }
+  void processAdpcmFrame(const uint8_t *adpcmData, uint8_t rssi,
+                         VTIME frameTime);
+
+  // Downlink: called from update() for each authenticated host audio frame
+  void onTxAudio(VoterTxAudioHandler handler) { _txHandler = handler; }
+
+  // Round-trip latency: send `count` pings to every connected host, one
+  // every intervalMs. Clears the previous results. The hosts must echo them
+  // back (re-signed); RTTs go into getPingStats(host).
+  void startPing(uint16_t count, uint16_t intervalMs);
+  void stopPing() { _pingRemaining = 0; }
+  bool isPinging() const { return _pingRemaining > 0; }
+  const LatencyHistogram &getPingStats(uint8_t host = 0) const {
+    return _hosts[host].pingHist;
+  }
+  uint32_t getPingsSent(uint8_t host = 0) const {
+    return _hosts[host].pingsSent;
+  }
+  uint32_t getPingsLost(uint8_t host = 0) const;
+  uint32_t getPingsEchoed() const { return _pingsEchoed; } // Host pings
+
+  // Instrumentation: bytes written into audio packets outside the encoder
+  uint32_t getBytesCopied() { return _bytesCopied; }
+  uint32_t getAudioPackets() { return _audioPackets; }
 
-  // Status
-  bool isConnected() { return _state == VOTER_CONNECTED; }
+  // Status: any host connected, or one host
+  bool isConnected();
+  bool isConnected(uint8_t host) { return _hosts[host].state == VOTER_CONNECTED; }
+  uint8_t getHostCount() const { return _hostCount; }
+  const VoterHostSession &getHost(uint8_t host) const { return _hosts[host]; }
+
+  // Receive path
+  const VoterRxStats &getRxStats() const { return _rx; }
+  uint32_t getRxRate() const { return _rxRate; } // Datagrams/s, last second
 
 private:
   // Core Dependencies
@@ -36,28 +159,58 @@ private:
   GPSManager *_gps;
 
   // Config
-  IPAddress _hostIP;
-  uint16_t _hostPort;
   const char *_clientPwd;
   const char *_hostPwd;
 
-  // State
-  VoterState _state;
-  uint32_t _lastAttemptTime;
+  // Sessions
+  VoterHostSession _hosts[VOTER_MAX_HOSTS];
+  uint8_t _hostCount;
 
-  // Protocol State
+  // Protocol State (our challenge is the same for every host)
   char _myChallenge[VOTER_CHALLENGE_LEN + 1];
-  char _serverChallenge[VOTER_CHALLENGE_LEN + 1];
-  uint32_t _serverDigest; // The digest we expect FROM the server
-  uint32_t _myDigest;     // The digest we send TO the server
+
+  // Audio Packet Templates
+  // Challenge and payload type are filled once; each frame sets time and
+  // RSSI, and each host only its digest.
+  PROXY_AUDIO_PACKET _audioPkt;
+  PROXY_ADPCM_PACKET _adpcmPkt;
+  uint32_t _bytesCopied;
+  uint32_t _audioPackets;
+
+  VoterTxAudioHandler _txHandler;
+
+  // Ping State (results are per host)
+  uint32_t _pingSeq; // Next sequence number, shared by all hosts
+  uint16_t _pingRemaining;
+  uint16_t _pingIntervalMs;
+  uint32_t _lastPingSend;
+  uint32_t _pingsEchoed;
+
+  // Receive pool and statistics
+  VoterRxPacket _rxPool[VOTER_RX_BATCH];
+  VoterRxStats _rx;
+  uint32_t _rxRate;
+  uint32_t _rxRateBase;  // _rx.packets at the start of the rate window
+  uint32_t _rxRateStart; // millis()
 
   // Helpers
   uint32_t _crc32(const uint8_t *buf1, const uint8_t *buf2);
-  void _sendAuthPacket();
-  void _handlePacket(const uint8_t *data, int len);
+  void _initSession(VoterHostSession &s, IPAddress host, uint16_t port);
+  VoterHostSession *_findSession(const VoterRxPacket &pkt);
+  void _receive();
+  void _sendTo(VoterHostSession &s, const uint8_t *data, int len);
+  void _sendKeepalive(VoterHostSession &s, const uint8_t *data, int len);
+  void _sendAuthPacket(VoterHostSession &s);
+  void _handlePacket(VoterHostSession &s, uint8_t *data, int len,
+                     uint8_t link);
+  void _handleTxAudio(VoterHostSession &s, const uint8_t *data, int len);
   void _generateChallenge();
-  void _sendGPSPacket();
-  uint32_t _lastGPSSend;
+  void _sendGPSPacket(VoterHostSession &s);
+  void _buildAudioTemplates();
+  void _setAudioTime(VOTER_PACKET_HEADER *hdr, VTIME frameTime);
+  void _sendAudio(VOTER_PACKET_HEADER *hdr, int len);
+  void _sendPing(VoterHostSession &s);
+  void _handlePing(VoterHostSession &s, uint8_t *data, int len);
 };
 
 #endif
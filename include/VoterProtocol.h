@@ -8,12 +8,23 @@
 #define FRAME_SIZE 160      // 20ms of 8kHz audio
 #define MAX_BUFFER_SIZE 512 // Enough for header + payload
 
+// ADPCM: 3 state bytes (predictor as big endian int16, step index) then
+// 160 bytes of 4-bit codes = 320 samples (two 20ms frames) per packet.
+// Same 163 byte frame size as chan_voter's ADPCM_FRAME_SIZE.
+#define ADPCM_STATE_BYTES 3
+#define ADPCM_SAMPLES (FRAME_SIZE * 2)
+#define ADPCM_FRAME_SIZE (ADPCM_STATE_BYTES + ADPCM_SAMPLES / 2)
+
 // --- Payload Types ---
 #define PAYLOAD_AUTH 0
 #define PAYLOAD_ULAW 1
 #define PAYLOAD_GPS 2
-#define PAYLOAD_ADPCM 3 // Not planned for initial port
-#define PAYLOAD_PING 5
+#define PAYLOAD_ADPCM 3 // IMA ADPCM, 40ms per packet (see PROXY_ADPCM_PACKET)
+#define PAYLOAD_PING 5 // Echoed back by the other side (see VOTER_PING)
+
+// Ping requests from this client carry PING_MAGIC; any other PAYLOAD_PING
+// is a host ping (chan_voter "voter ping") and is echoed back.
+#define PING_MAGIC 0x54565047 // "TVPG"
 
 // --- Structures ---
 // Ensure strict packing to match the wire format of the original PIC firmware
@@ -38,6 +49,13 @@ typedef struct {
   uint8_t audio[FRAME_SIZE]; // Exact 160 bytes for ULAW (Total packet 185)
 } PROXY_AUDIO_PACKET;
 
+// RSSI + ADPCM Payload Wrapper (Total packet 188, every 40ms)
+typedef struct {
+  VOTER_PACKET_HEADER header;
+  uint8_t rssi;
+  uint8_t audio[ADPCM_FRAME_SIZE];
+} PROXY_ADPCM_PACKET;
+
 // GPS Payload Wrapper
 typedef struct {
   VOTER_PACKET_HEADER header;
@@ -46,6 +64,20 @@ typedef struct {
   char elev[7];
 } PROXY_GPS_PACKET;
 
+// Ping Payload (all fields network byte order). The echo must come back
+// re-signed with the host's challenge/digest and the payload unchanged.
+typedef struct {
+  uint32_t magic;     // PING_MAGIC
+  uint32_t seq;
+  VTIME txtime;       // GPS time at send (0 if not locked)
+  uint32_t txMicros;  // Local micros() at send, for the RTT
+} VOTER_PING;
+
+typedef struct {
+  VOTER_PACKET_HEADER header;
+  VOTER_PING ping;
+} PROXY_PING_PACKET;
+
 #pragma pack(pop)
 
 #endif
@@ -0,0 +1,227 @@
+#include "AudioVoterFrameQueue.h"
+
+static_assert(AUDIO_BLOCK_SAMPLES <= Downsampler::maxBlock,
+              "Audio library block larger than the resampler input block");
+
+AudioVoterFrameQueue::AudioVoterFrameQueue()
+    : AudioStream(1, _inputQueueArray) {
+  _enabled = false;
+  _assembling = nullptr;
+  _fill = 0;
+  _overruns = 0;
+  _framesProduced = 0;
+  _lastBlockUs = 0;
+  _haveLastBlock = false;
+  _stampJitterMax = 0;
+  _lastSample = 0;
+  _clockUs = 0;
+  _clockFrac = 0.0f;
+  _clockPeriod = FRAMEQ_BLOCK_US;
+  _ppsAlign = false;
+  _ppsPending = false;
+  _ppsMicros = 0;
+  _ppsAge = FRAMEQ_PPS_TIMEOUT_BLOCKS;
+  _samplesIn = 0;
+  _edgeSamples = 0;
+  _edgeOffset = 0.0f;
+  _haveEdge = false;
+}
+
+void AudioVoterFrameQueue::begin(const DownsampleTable *table) {
+  AudioNoInterrupts();
+  _resampler.begin(table, AUDIO_SAMPLE_RATE_EXACT / 8000.0);
+  _queue.clear();
+  _assembling = nullptr;
+  _fill = 0;
+  _haveLastBlock = false;
+  _haveEdge = false;
+  _pps.reset();
+  _pps.resetRate();
+  _enabled = true;
+  AudioInterrupts();
+}
+
+void AudioVoterFrameQueue::end() { _enabled = false; }
+
+void AudioVoterFrameQueue::clear() {
+  // Stop the audio ISR while we reset producer and consumer state together
+  AudioNoInterrupts();
+  _resampler.reset();
+  _queue.clear();
+  _assembling = nullptr;
+  _fill = 0;
+  _haveLastBlock = false;
+  _haveEdge = false;
+  _pps.reset();
+  AudioInterrupts();
+}
+
+void AudioVoterFrameQueue::setPpsAlign(bool on) {
+  AudioNoInterrupts();
+  _ppsAlign = on;
+  _haveEdge = false;
+  _pps.reset(); // Acquire again when turned back on
+  _pps.resetRate();
+  _resampler.setRatio(AUDIO_SAMPLE_RATE_EXACT / 8000.0);
+  AudioInterrupts();
+}
+
+void AudioVoterFrameQueue::_startFrame() {
+  _assembling = _queue.reserve();
+  if (!_assembling) {
+    // Queue full: loop() is behind. Assemble into the discard frame.
+    _assembling = &_discard;
+  }
+  _fill = 0;
+}
+
+void AudioVoterFrameQueue::_finishFrame() {
+  if (_assembling == &_discard) {
+    _overruns++;
+  } else {
+    _queue.commit();
+    _framesProduced++;
+  }
+  _assembling = nullptr;
+}
+
+void AudioVoterFrameQueue::_trackClock(uint32_t rawUs) {
+  if (!_haveLastBlock) {
+    _clockUs = rawUs;
+    _clockFrac = 0.0f;
+    _clockPeriod = FRAMEQ_BLOCK_US;
+  } else {
+    int32_t err = (int32_t)(rawUs - _lastBlockUs) - (int32_t)FRAMEQ_BLOCK_US;
+    uint32_t absErr = (uint32_t)(err < 0 ? -err : err);
+    if (absErr > _stampJitterMax)
+      _stampJitterMax = absErr;
+
+    // Predict this block from the last one, then pull towards the reading
+    float next = _clockFrac + _clockPeriod;
+    float clockErr = (float)(int32_t)(rawUs - _clockUs) - next;
+    if (fabsf(clockErr) > FRAMEQ_CLOCK_RESYNC_US) {
+      _clockUs = rawUs;
+      _clockFrac = 0.0f;
+      _clockPeriod = FRAMEQ_BLOCK_US;
+    } else {
+      next += clockErr * FRAMEQ_CLOCK_GAIN;
+      _clockPeriod += clockErr * FRAMEQ_CLOCK_PERIOD_GAIN;
+      int32_t whole = (int32_t)floorf(next);
+      _clockUs += (uint32_t)whole;
+      _clockFrac = next - (float)whole;
+    }
+  }
+  _lastBlockUs = rawUs;
+  _haveLastBlock = true;
+}
+
+void AudioVoterFrameQueue::_append(const int16_t *src, int count,
+                                   float firstUs) {
+  int i = 0;
+  while (i < count) {
+    if (!_assembling) {
+      _startFrame();
+      _assembling->captureMicros =
+          _clockUs + (int32_t)lroundf(firstUs + i * (1000000.0f / 8000.0f));
+      _assembling->ppsAligned = isPpsAligned();
+    }
+
+    int chunk = FRAME_SIZE - _fill;
+    if (chunk > count - i)
+      chunk = count - i;
+    if (src) {
+      memcpy(&_assembling->samples[_fill], &src[i], chunk * sizeof(int16_t));
+    } else {
+      for (int k = 0; k < chunk; k++)
+        _assembling->samples[_fill + k] = _lastSample;
+    }
+    _fill += chunk;
+    i += chunk;
+
+    if (_fill >= FRAME_SIZE)
+      _finishFrame();
+  }
+  if (src && count > 0)
+    _lastSample = src[count - 1];
+}
+
+// First block after a PPS edge: codec samples since the previous edge.
+// micros() and the codec run off the same crystal, so the edge's position
+// within the block is found with the tracked block period.
+void AudioVoterFrameQueue::_measureRate(bool freshEdge) {
+  float offset = ((float)(int32_t)(_ppsMicros - _clockUs) - _clockFrac) *
+                 ((float)AUDIO_BLOCK_SAMPLES / _clockPeriod);
+  if (freshEdge && _haveEdge) {
+    double samples = (double)(_samplesIn - _edgeSamples) +
+                     (double)(offset - _edgeOffset);
+    double ratio;
+    if (_pps.onInterval(samples, &ratio))
+      _resampler.setRatio(ratio);
+  }
+  _edgeSamples = _samplesIn;
+  _edgeOffset = offset;
+  _haveEdge = true;
+}
+
+// First block after a PPS edge: put the next output on its 20ms-grid slot
+void AudioVoterFrameQueue::_alignToPps(float usPerIn) {
+  float nextRel = _clockFrac + _resampler.getNextOffset() * usPerIn;
+  float nextUs = (float)(int32_t)(_clockUs - _ppsMicros) + nextRel;
+  int index = _assembling ? _fill : 0;
+  int target;
+  float stepUs = _pps.onPps(nextUs, index, &target);
+  _resampler.adjustPhase(stepUs / usPerIn);
+
+  if (target != index) {
+    // Acquire: back up within the frame if that is the shorter way,
+    // otherwise pad with the last sample up to the new position
+    int pad = (target - index + FRAME_SIZE) % FRAME_SIZE;
+    int back = FRAME_SIZE - pad;
+    if (_assembling && back <= _fill && back < pad)
+      _fill -= back;
+    else
+      _append(nullptr, pad,
+              nextRel + stepUs - pad * (1000000.0f / 8000.0f));
+  }
+}
+
+// Audio ISR: 128 samples @ 44.1kHz in, ~23 samples @ 8kHz appended
+void AudioVoterFrameQueue::update(void) {
+  // Stamp first, before any processing time
+  uint32_t blockUs = micros() - FRAMEQ_CAPTURE_LATENCY_US;
+
+  audio_block_t *block = receiveReadOnly();
+  if (!block)
+    return;
+
+  _trackClock(blockUs);
+
+  if (!_enabled) {
+    release(block);
+    return;
+  }
+
+  const float usPerIn = 1000000.0f / AUDIO_SAMPLE_RATE_EXACT;
+  if (_ppsPending) {
+    _ppsPending = false;
+    bool fresh = _ppsAge < FRAMEQ_PPS_TIMEOUT_BLOCKS; // Last edge ~1s ago
+    _ppsAge = 0;
+    if (_ppsAlign) {
+      _measureRate(fresh);
+      _alignToPps(usPerIn);
+    }
+  } else if (_ppsAge < FRAMEQ_PPS_TIMEOUT_BLOCKS) {
+    if (++_ppsAge == FRAMEQ_PPS_TIMEOUT_BLOCKS)
+      _pps.onTimeout(); // Keep the last ratio
+  }
+
+  int16_t out[Downsampler::maxOutput(AUDIO_SAMPLE_RATE_EXACT / 8000.0)];
+  int n = _resampler.process(block->data, AUDIO_BLOCK_SAMPLES, out,
+                             (int)(sizeof(out) / sizeof(out[0])));
+  release(block);
+  _samplesIn += AUDIO_BLOCK_SAMPLES;
+
+  // Copy resampled output straight into the ring slot being assembled.
+  // Output 0 is getBlockOffset() input samples after the block's first.
+  _append(out, n, _clockFrac + _resampler.getBlockOffset() * usPerIn);
+}
@@ -0,0 +1,278 @@
+#include "AudioVoterTxQueue.h"
+#include "ULaw.h"
+
+static_assert(FRAME_SIZE % UPSAMPLER_BLOCK == 0,
+              "Frames must split evenly into upsampler blocks");
+
+static uint64_t vtimeToUs(const VTIME &t) {
+  return (uint64_t)t.vtime_sec * 1000000ULL + t.vtime_nsec / 1000;
+}
+
+AudioVoterTxQueue::AudioVoterTxQueue() : AudioStream(0, NULL) {
+  _enabled = false;
+  _playing = false;
+  _active = false;
+  _anchored = false;
+  _anchorUs = 0;
+  _nextSeq = 0;
+  _missing = 0;
+  _delayUs = 0;
+  _lastMicros = 0;
+  _localUs = 0;
+  _clockOffsetUs = 0;
+  _framePos = 0;
+  _outFill = 0;
+  _outPos = 0;
+  _maxDepth = 0;
+  _late = 0;
+  _early = 0;
+  _lost = 0;
+  _underruns = 0;
+  _framesPlayed = 0;
+  memset(_slots, 0, sizeof(_slots));
+}
+
+void AudioVoterTxQueue::begin(const UpsampleTable *table) {
+  AudioNoInterrupts();
+  _resampler.begin(table, 8000.0 / AUDIO_SAMPLE_RATE_EXACT);
+  _lastMicros = micros();
+  _enabled = true;
+  AudioInterrupts();
+  clear();
+}
+
+void AudioVoterTxQueue::end() { _enabled = false; }
+
+void AudioVoterTxQueue::clear() {
+  // Stop the audio ISR while we reset both sides together
+  AudioNoInterrupts();
+  for (int i = 0; i < TX_JITTER_SLOTS; i++)
+    _slots[i].valid = false;
+  _anchored = false;
+  _active = false;
+  _missing = 0;
+  _playout.clear();
+  _playing = false;
+  _outFill = 0;
+  _outPos = 0;
+  AudioInterrupts();
+}
+
+uint8_t AudioVoterTxQueue::getDepth() const {
+  uint8_t depth = 0;
+  for (int i = 0; i < TX_JITTER_SLOTS; i++) {
+    if (_slots[i].valid)
+      depth++;
+  }
+  return depth;
+}
+
+bool AudioVoterTxQueue::_oldestSlot(int32_t *seq) const {
+  bool found = false;
+  for (int i = 0; i < TX_JITTER_SLOTS; i++) {
+    if (_slots[i].valid && (!found || _slots[i].seq < *seq)) {
+      *seq = _slots[i].seq;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void AudioVoterTxQueue::_endBurst() {
+  // Trailing missing frames are the end of the transmission, not losses.
+  // They were still queued as silence, which gives the PTT its hang time.
+  _active = false;
+  _missing = 0;
+  int32_t seq;
+  if (!_oldestSlot(&seq))
+    _anchored = false; // Next burst re-anchors on its first frame
+}
+
+bool AudioVoterTxQueue::write(const VTIME &frameTime, const uint8_t *ulaw) {
+  if (!_enabled)
+    return false;
+
+  uint64_t frameUs = vtimeToUs(frameTime);
+  if (!_anchored) {
+    _anchorUs = frameUs;
+    _anchored = true;
+  }
+
+  // Sequence number, rounded to the nearest frame (host stamps may jitter)
+  int64_t rel = (int64_t)(frameUs - _anchorUs);
+  rel += (rel >= 0) ? TX_FRAME_US / 2 : -(TX_FRAME_US / 2);
+  int32_t seq = (int32_t)(rel / TX_FRAME_US);
+
+  int32_t base = seq;
+  if (_active)
+    base = _nextSeq;
+  else
+    _oldestSlot(&base);
+
+  if (seq < base) {
+    if (_active || base - seq >= TX_JITTER_SLOTS) {
+      _late++; // Its turn has passed (or it would evict newer audio)
+      return false;
+    }
+  } else if (seq - base >= TX_JITTER_SLOTS) {
+    _early++; // Beyond the end of the jitter buffer
+    return false;
+  }
+
+  Slot *slot = &_slots[seq & (TX_JITTER_SLOTS - 1)];
+  if (slot->valid && slot->seq == seq)
+    return false; // Duplicate
+  for (int i = 0; i < FRAME_SIZE; i++)
+    slot->samples[i] = ulawDecode(ulaw[i]);
+  slot->seq = seq;
+  slot->valid = true;
+
+  uint8_t depth = getDepth();
+  if (depth > _maxDepth)
+    _maxDepth = depth;
+  return true;
+}
+
+void AudioVoterTxQueue::service(const VTIME *gpsNow) {
+  uint32_t nowMicros = micros();
+  _localUs += (uint32_t)(nowMicros - _lastMicros);
+  _lastMicros = nowMicros;
+
+  if (!_enabled || !_anchored)
+    return;
+
+  // 1. Idle: start a burst on the oldest buffered frame that is still usable
+  if (!_active) {
+    int32_t seq = 0;
+    while (_oldestSlot(&seq)) {
+      if (gpsNow) {
+        uint64_t nowUs = vtimeToUs(*gpsNow);
+        uint64_t playUs = _playUs(seq);
+        if (playUs + TX_FRAME_US <= nowUs) {
+          _slots[seq & (TX_JITTER_SLOTS - 1)].valid = false;
+          _late++;
+          continue;
+        }
+        if (playUs > nowUs + _delayUs + TX_JITTER_SLOTS * TX_FRAME_US) {
+          _slots[seq & (TX_JITTER_SLOTS - 1)].valid = false;
+          _early++; // Host clock far ahead of ours
+          continue;
+        }
+      } else {
+        // No GPS: play txDelay after the first frame of the burst arrives
+        _clockOffsetUs =
+            (int64_t)(_playUs(seq) - _delayUs) - (int64_t)_localUs;
+      }
+      _active = true;
+      _nextSeq = seq;
+      _missing = 0;
+      break;
+    }
+    if (!_active) {
+      _anchored = false;
+      return;
+    }
+  }
+
+  // 2. Hand frames to the ISR once they are within the lead time
+  uint64_t nowUs =
+      gpsNow ? vtimeToUs(*gpsNow) : (uint64_t)(_localUs + _clockOffsetUs);
+  while (_active) {
+    int64_t lead = (int64_t)(_playUs(_nextSeq) - nowUs);
+    if (lead > (int64_t)TX_LEAD_FRAMES * TX_FRAME_US)
+      break;
+    TxFrame *out = _playout.reserve();
+    if (!out)
+      break; // ISR still has TX_PLAYOUT_DEPTH frames
+
+    Slot *slot = &_slots[_nextSeq & (TX_JITTER_SLOTS - 1)];
+    if (slot->valid && slot->seq == _nextSeq) {
+      memcpy(out->samples, slot->samples, sizeof(out->samples));
+      slot->valid = false;
+      _lost += _missing; // The gap was mid-burst after all
+      _missing = 0;
+    } else {
+      memset(out->samples, 0, sizeof(out->samples));
+      _missing++;
+    }
+    out->deadline = nowMicros + (int32_t)lead;
+    _playout.commit();
+    _nextSeq++;
+
+    if (_missing >= TX_HANG_FRAMES)
+      _endBurst();
+  }
+}
+
+// Audio ISR: 8kHz frames in, 128 samples @ 44.1kHz out
+void AudioVoterTxQueue::update(void) {
+  if (!_enabled || (!_playing && _playout.available() == 0))
+    return; // Nothing transmitted = silence
+
+  audio_block_t *block = allocate();
+  if (!block)
+    return;
+
+  int n = 0;
+  while (n < AUDIO_BLOCK_SAMPLES) {
+    // 1. Drain upsampled output
+    if (_outPos < _outFill) {
+      int chunk = _outFill - _outPos;
+      if (chunk > AUDIO_BLOCK_SAMPLES - n)
+        chunk = AUDIO_BLOCK_SAMPLES - n;
+      memcpy(&block->data[n], &_out[_outPos], chunk * sizeof(int16_t));
+      _outPos += chunk;
+      n += chunk;
+      continue;
+    }
+
+    // 2. Start of a burst: wait for the first frame's deadline
+    if (!_playing) {
+      if (_playout.available() == 0)
+        break;
+      TxFrame *f = _playout.peek();
+      int32_t waitUs =
+          (int32_t)(f->deadline - (micros() + TX_OUTPUT_LATENCY_US));
+      int32_t wait =
+          (int32_t)((float)waitUs * (AUDIO_SAMPLE_RATE_EXACT / 1000000.0f)) -
+          n;
+      if (wait >= AUDIO_BLOCK_SAMPLES - n)
+        break; // Starts in a later block
+      if (wait > 0) {
+        memset(&block->data[n], 0, wait * sizeof(int16_t));
+        n += wait;
+      }
+      _resampler.reset();
+      _framePos = 0;
+      _playing = true;
+      continue;
+    }
+
+    // 3. Next frame, back to back on the codec clock
+    if (_framePos >= FRAME_SIZE) {
+      _playout.consume(1);
+      _framesPlayed++;
+      _framePos = 0;
+      if (_playout.available() == 0) {
+        _playing = false;
+        if (_active)
+          _underruns++; // loop() fell behind mid-burst
+        break;
+      }
+    }
+
+    // 4. Upsample the next few input samples
+    TxFrame *f = _playout.peek();
+    _outFill = (uint8_t)_resampler.process(
+        &f->samples[_framePos], UPSAMPLER_BLOCK, _out,
+        (int)(sizeof(_out) / sizeof(_out[0])));
+    _outPos = 0;
+    _framePos += UPSAMPLER_BLOCK;
+  }
+
+  if (n < AUDIO_BLOCK_SAMPLES)
+    memset(&block->data[n], 0, (AUDIO_BLOCK_SAMPLES - n) * sizeof(int16_t));
+
+  transmit(block);
+  release(block);
+}
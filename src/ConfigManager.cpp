@@ -42,6 +42,11 @@ void ConfigManager::resetDefaults() {
   // Default Host: 10.10.10.42 : 667
   data.hostIP = (uint32_t)IPAddress(10, 10, 10, 42);
   data.hostPort = 1667;
+  data.backupHostIP = 0; // Single host
+  data.backupHostPort = 1667;
+  data.spiAsync = true;
+  data.netLinks = NET_LINKS_WIFI;
+  data.netBond = NET_BOND_FAILOVER;
 
   strcpy(data.clientPwd, "teensyvoter");
   strcpy(data.hostPwd, "K5LMA146980");
@@ -54,6 +59,9 @@ void ConfigManager::resetDefaults() {
   data.dspCalib = 50.0f; // Was 13.0f
 
   data.dspSquelchThresh = 30; // Default DSP squelch threshold
+  data.spectralSnrThresh = 6; // dB voice over noise to open spectral squelch
+  data.ctcssTone = 12;        // 100.0Hz
+  data.ctcssWindow = 10;      // 200ms detect blocks
   data.rxGain = 6;            // Default Gain (User found 5-6 good)
   data.inputSource = 0;       // Default to Line In (AUDIO_INPUT_LINEIN = 0)
 
@@ -61,6 +69,11 @@ void ConfigManager::resetDefaults() {
   data.enablePLFilter =
       true; // Enable 300Hz HPF (blocks PL tones & low-freq noise)
   data.enableDeemp = true; // Enable de-emphasis (reduces high-freq noise)
+  data.dspEngine = DSP_ENGINE_FUSED;
+  data.codec = CODEC_ULAW;
+  data.timingMode = TIMING_GPS;
+  data.ppsAlign = true; // No effect until PPS edges arrive
+  data.txDelayMs = 100; // Covers host-to-site network jitter
 
   save();
   Serial.println("[Config] Reset to Defaults");
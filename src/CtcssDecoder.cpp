@@ -0,0 +1,130 @@
+#include "CtcssDecoder.h"
+#include "FilterDesign.h"
+#include "VoterProtocol.h"
+
+#define CTCSS_SAMPLE_RATE 8000.0
+
+// Standard EIA CTCSS tones (Hz x 10)
+static constexpr uint16_t kToneDeciHz[CTCSS_NUM_TONES] = {
+    670,  693,  719,  744,  770,  797,  825,  854,  885,  915,
+    948,  974,  1000, 1035, 1072, 1109, 1148, 1188, 1230, 1273,
+    1318, 1365, 1413, 1462, 1514, 1567, 1598, 1622, 1655, 1679,
+    1713, 1738, 1773, 1799, 1835, 1862, 1899, 1928, 1966, 1995,
+    2035, 2065, 2107, 2181, 2257, 2291, 2336, 2418, 2503, 2541};
+
+// Goertzel coefficients 2*cos(2*pi*f/fs), generated at compile time
+struct GoertzelTable {
+  float coeff[CTCSS_NUM_TONES];
+  constexpr GoertzelTable() : coeff() {
+    for (int i = 0; i < CTCSS_NUM_TONES; i++) {
+      coeff[i] = (float)(2.0 * FilterDesign::ccos(2.0 * FilterDesign::kPi *
+                                                  (kToneDeciHz[i] / 10.0) /
+                                                  CTCSS_SAMPLE_RATE));
+    }
+  }
+};
+static constexpr GoertzelTable kGoertzel;
+
+CtcssDecoder::CtcssDecoder() { begin(12, 10); } // 100.0Hz, 200ms
+
+void CtcssDecoder::begin(uint8_t toneIndex, uint8_t windowFrames) {
+  if (toneIndex >= CTCSS_NUM_TONES)
+    toneIndex = 12;
+  if (windowFrames < CTCSS_WINDOW_MIN)
+    windowFrames = CTCSS_WINDOW_MIN;
+  if (windowFrames > CTCSS_WINDOW_MAX)
+    windowFrames = CTCSS_WINDOW_MAX;
+
+  _tone = toneIndex;
+  _blockLen = (uint32_t)windowFrames * FRAME_SIZE;
+  _minRatio = CTCSS_NOISE_MARGIN * 2.0f / (float)_blockLen;
+  if (_minRatio < CTCSS_MIN_RATIO)
+    _minRatio = CTCSS_MIN_RATIO;
+  reset();
+}
+
+void CtcssDecoder::reset() {
+  memset(_s1, 0, sizeof(_s1));
+  memset(_s2, 0, sizeof(_s2));
+  _energy = 0.0f;
+  _count = 0;
+  _strongest = 0;
+  _misses = CTCSS_HANG_BLOCKS;
+  _ratio = 0.0f;
+  _detected = false;
+}
+
+float CtcssDecoder::toneHz(uint8_t index) {
+  return (index < CTCSS_NUM_TONES) ? kToneDeciHz[index] / 10.0f : 0.0f;
+}
+
+int CtcssDecoder::findTone(float hz) {
+  int deci = (int)(hz * 10.0f + 0.5f);
+  for (int i = 0; i < CTCSS_NUM_TONES; i++) {
+    if (abs(deci - (int)kToneDeciHz[i]) <= 1)
+      return i;
+  }
+  return -1;
+}
+
+void CtcssDecoder::process(const int16_t *samples, int count) {
+  int i = 0;
+  while (i < count) {
+    int chunk = (int)(_blockLen - _count);
+    if (chunk > count - i)
+      chunk = count - i;
+
+    // Sample-outer, tone-inner: each sample is loaded once for the bank
+    for (int n = i; n < i + chunk; n++) {
+      float x = samples[n] * (1.0f / 32768.0f);
+      _energy += x * x;
+      for (int t = 0; t < CTCSS_NUM_TONES; t++) {
+        float s0 = x + kGoertzel.coeff[t] * _s1[t] - _s2[t];
+        _s2[t] = _s1[t];
+        _s1[t] = s0;
+      }
+    }
+    _count += chunk;
+    i += chunk;
+
+    if (_count >= _blockLen)
+      _finishBlock();
+  }
+}
+
+void CtcssDecoder::_finishBlock() {
+  // Tone power, normalized so a pure tone holding all the block energy = 1.0
+  // (Goertzel |X|^2 = (A*N/2)^2, block energy = A^2*N/2)
+  float norm = (_energy > 0.0f) ? 2.0f / (_energy * (float)_blockLen) : 0.0f;
+  float power[CTCSS_NUM_TONES];
+  float best = -1.0f;
+  for (int t = 0; t < CTCSS_NUM_TONES; t++) {
+    power[t] = _s1[t] * _s1[t] + _s2[t] * _s2[t] -
+               kGoertzel.coeff[t] * _s1[t] * _s2[t];
+    if (power[t] > best) {
+      best = power[t];
+      _strongest = t;
+    }
+  }
+  _ratio = power[_tone] * norm;
+
+  bool peak = true;
+  for (int t = _tone - CTCSS_NEIGHBOURS; t <= _tone + CTCSS_NEIGHBOURS; t++) {
+    if (t >= 0 && t < CTCSS_NUM_TONES && t != _tone && power[t] >= power[_tone])
+      peak = false;
+  }
+  bool hit = peak && (_ratio >= _minRatio);
+  if (hit) {
+    _misses = 0;
+    _detected = true;
+  } else if (_misses < CTCSS_HANG_BLOCKS) {
+    _misses++;
+    if (_misses >= CTCSS_HANG_BLOCKS)
+      _detected = false;
+  }
+
+  memset(_s1, 0, sizeof(_s1));
+  memset(_s2, 0, sizeof(_s2));
+  _energy = 0.0f;
+  _count = 0;
+}
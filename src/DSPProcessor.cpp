@@ -1,124 +1,191 @@
 #include "DSPProcessor.h"
 #include "ConfigManager.h"
+#include "FilterDesign.h"
+#include "ULaw.h"
 #include <Arduino.h>
 #include <math.h>
+#include <type_traits>
 
 extern ConfigManager cfg; // Access global config
 
-DSPProcessor::DSPProcessor() {
-  memset(_rssiState, 0, sizeof(_rssiState));
-  memset(_voiceState, 0, sizeof(_voiceState));
+// -----------------------------------------------------------------------------
+// Filter Coefficients (generated at compile time)
+// -----------------------------------------------------------------------------
+
+// --- RSSI Filter (High Pass > 2400Hz) - 23 Taps ---
+// Source: Voter2 RSSIFilter.c (RSSIFILTER1), Q15 format
+static constexpr int16_t kRssiQ15[RSSI_TAPS] = {
+    128,   402,   -1225, 1927, -1674, 164,   1729,  -2249,
+    54,    4461,  -9036, 10962, -9036, 4461, 54,    -2249,
+    1729,  164,   -1674, 1927, -1225, 402,   128};
+
+// Default tap count uses the Voter2 table; other lengths get an equivalent
+// windowed-sinc high-pass (odd length). Picked by overload, not if constexpr,
+// so this builds as C++14 (the Teensy toolchain default).
+template <int N>
+static constexpr FilterDesign::FirTaps<N> rssiDesign(std::true_type) {
+  return FilterDesign::fromQ15(kRssiQ15);
 }
-
-void DSPProcessor::begin() {
-  // 1. Calculate Filter Coefficients (Convert Q15 to Float)
-  _calculateCoeffs();
-
-  // 2. Init FIR Filters
-  // 23 taps for RSSI, 64 taps for Voice
-  arm_fir_init_f32(&_rssiFilter, 23, _rssiCoeffs, _rssiState,
-                   AUDIO_BLOCK_SAMPLES);
-  arm_fir_init_f32(&_voiceFilter, 64, _voiceCoeffs, _voiceState,
-                   AUDIO_BLOCK_SAMPLES);
-
-  // 3. Init Biquad HPF
-  arm_biquad_cascade_df1_init_f32(&_hpf, 1, _hpfCoeffs, _hpfState);
+template <int N>
+static constexpr FilterDesign::FirTaps<N> rssiDesign(std::false_type) {
+  return FilterDesign::highpass<N>(2400.0 / SAMPLE_RATE);
+}
+template <int N> static constexpr FilterDesign::FirTaps<N> rssiDesign() {
+  return rssiDesign<N>(std::integral_constant<bool, N == RSSI_TAPS>());
+}
+template <int N>
+static constexpr FilterDesign::FirTaps<N> kRssiCoeffs = rssiDesign<N>();
+
+// --- Voice Filter (Band Pass 300Hz - 3300Hz) - 64 Taps ---
+// Wide bandpass for NBFM voice: removes PL, passes full voice.
+// Blackman windowed sinc. (Voter2 voice_filter_taps1 is 300-2400Hz.)
+template <int N>
+static constexpr FilterDesign::FirTaps<N> kVoiceCoeffs =
+    FilterDesign::bandpass<N>(300.0 / SAMPLE_RATE, 3300.0 / SAMPLE_RATE);
+
+// --- Biquad HPF 300Hz (2nd Order Butterworth, Fs=8000) ---
+// Expected: b={0.846, -1.692, 0.846}, a1/a2 (CMSIS, negated) = {1.669, -0.716}
+static constexpr FilterDesign::BiquadCoeffs kHpfCoeffs =
+    FilterDesign::butterworthHighpass(300.0 / SAMPLE_RATE);
+
+// --- De-emphasis (1-pole LPF) ---
+// Alpha tuned to 0.20 (middle ground between 0.15 too weak, 0.30 too
+// aggressive) Balances noise reduction with voice clarity
+static constexpr float kDeempAlpha = 0.20f;
+
+// --- Spectral Squelch ---
+static constexpr FilterDesign::FirTaps<FFT_SIZE> kHann =
+    FilterDesign::hannWindow<FFT_SIZE>();
+
+static constexpr int hzToBin(int hz) {
+  return (int)((float)hz * FFT_SIZE / SAMPLE_RATE + 0.5f);
+}
+static constexpr int kVoiceBinLo = hzToBin(SPECTRAL_VOICE_LO_HZ);
+static constexpr int kVoiceBinHi = hzToBin(SPECTRAL_VOICE_HI_HZ);
+static constexpr int kNoiseBinLo = hzToBin(SPECTRAL_NOISE_LO_HZ);
+static constexpr int kNoiseBinHi = hzToBin(SPECTRAL_NOISE_HI_HZ);
+static_assert(kVoiceBinLo > 0 && kVoiceBinLo < kVoiceBinHi &&
+                  kVoiceBinHi < kNoiseBinLo && kNoiseBinLo < kNoiseBinHi &&
+                  kNoiseBinHi < FFT_SIZE / 2,
+              "Spectral squelch bands must be ordered and below Nyquist");
+
+// |X|^2 of a full-scale sine through the Hann window: (N/2 * 0.5)^2
+static constexpr float kFullScaleBinPower =
+    (FFT_SIZE / 4.0f) * (FFT_SIZE / 4.0f);
+
+// --- Q15 Engine Tables ---
+template <int N, int M>
+static constexpr FilterDesign::FirTapsQ15<N> kRssiCoeffsQ15 =
+    FilterDesign::toQ15<N>(kRssiCoeffs<M>);
+template <int N, int M>
+static constexpr FilterDesign::FirTapsQ15<N> kVoiceCoeffsQ15 =
+    FilterDesign::toQ15<N>(kVoiceCoeffs<M>);
+static constexpr FilterDesign::BiquadQ15 kDeempQ15 =
+    FilterDesign::toQ15(FilterDesign::onePoleLowpass(kDeempAlpha), 0);
+
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::DSPProcessor() {
+  _engine = DSP_ENGINE_FLOAT;
+  _spectralEnabled = false;
+  reset();
 }
 
-void DSPProcessor::_calculateCoeffs() {
-  // Coefficients from Voter2 Project (Q15 format)
-  // We convert them to float by dividing by 32768.0f
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::begin() {
+  // 1. Init FIR Filters (coefficients are compile-time constants)
+  // CMSIS takes non-const coefficient pointers but never writes them.
+  arm_fir_init_f32(&_rssiFilter, RssiTaps,
+                   (float32_t *)kRssiCoeffs<RssiTaps>.h, _rssiState,
+                   BlockSize);
+  arm_fir_init_f32(&_voiceFilter, VoiceTaps,
+                   (float32_t *)kVoiceCoeffs<VoiceTaps>.h, _voiceState,
+                   BlockSize);
+
+  // 2. Init Biquad HPF
+  arm_biquad_cascade_df1_init_f32(&_hpf, 1, (float32_t *)kHpfCoeffs.c,
+                                  _hpfState);
+
+  // 3. Init Q15 Engine
+  arm_fir_init_q15(&_rssiFilterQ15, rssiTapsQ15,
+                   (q15_t *)kRssiCoeffsQ15<rssiTapsQ15, RssiTaps>.h,
+                   _rssiStateQ15, BlockSize);
+  arm_fir_init_q15(&_voiceFilterQ15, voiceTapsQ15,
+                   (q15_t *)kVoiceCoeffsQ15<voiceTapsQ15, VoiceTaps>.h,
+                   _voiceStateQ15, BlockSize);
+  arm_biquad_cascade_df1_init_q15(&_deempQ15, 1, (q15_t *)kDeempQ15.c,
+                                  _deempStateQ15, 0);
+
+  // 4. Init Spectral Squelch FFT
+  arm_rfft_fast_init_f32(&_fft, FFT_SIZE);
+}
 
-  // --- RSSI Filter (High Pass > 2400Hz) - 23 Taps ---
-  // Source: RSSIFilter.c (RSSIFILTER1)
-  static const int16_t rssi_q15[] = {128,   402,   -1225, 1927,  -1674, 164,
-                                     1729,  -2249, 54,    4461,  -9036, 10962,
-                                     -9036, 4461,  54,    -2249, 1729,  164,
-                                     -1674, 1927,  -1225, 402,   128};
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::reset() {
+  memset(_rssiState, 0, sizeof(_rssiState));
+  memset(_voiceState, 0, sizeof(_voiceState));
+  memset(_hpfState, 0, sizeof(_hpfState));
+  memset(_rssiStateQ15, 0, sizeof(_rssiStateQ15));
+  memset(_voiceStateQ15, 0, sizeof(_voiceStateQ15));
+  memset(_deempStateQ15, 0, sizeof(_deempStateQ15));
+  memset(_fusedHistory, 0, sizeof(_fusedHistory));
+  memset(_fftBuffer, 0, sizeof(_fftBuffer));
+  _spectralOpen = false;
+  _spectralSnr = 0.0f;
+  _spectralRSSI = 0;
+  _lastNoiseLevel = 0;
+  _deempState = 0.0f;
+  _prevIn = 0.0f;
+  _prevOut = 0.0f;
+  _adpcm.predictor = 0;
+  _adpcm.index = 0;
+}
 
-  for (int i = 0; i < 23; i++) {
-    _rssiCoeffs[i] = (float)rssi_q15[i] / 32768.0f;
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::setEngine(uint8_t engine) {
+  if (engine != DSP_ENGINE_Q15 && engine != DSP_ENGINE_FUSED)
+    engine = DSP_ENGINE_FLOAT;
+  if (engine != _engine) {
+    _engine = engine;
+    reset(); // The other engine's history is stale
   }
+}
 
-  // --- Voice Filter (Band Pass 300Hz - 2400Hz) - 64 Taps ---
-  // Source: VoiceFilter.c (voice_filter_taps2 - Passes CTCSS)
-  // User can likely switch between tap1 and tap2 later, but tap2 (Passes CTCSS)
-  // is safer default. Wait, the original code uses taps2 for Flat Audio (CTCSS
-  // passed) and taps1 for filtered. Let's implement Taps1 (Voice Only, No PL)
-  // as standard default, unless requested otherwise. Actually, usually "Flat"
-  // means NO filtering. Voter2: if (DIAL_FLATAUDIO) use taps2 (Pass CTCSS).
-  // Else use taps1 (Block CTCSS). Let's use Taps1 (Block CTCSS) as the default
-  // "Processed" audio.
-
-  // --- Generate Wide Bandpass FIR (300Hz - 3300Hz) ---
-  // Ideal for NBFM Voice (removes PL, passes full voice).
-  // Uses Windowed Sinc method (Blackman Window).
-
-  float fl = 300.0f / SAMPLE_RATE;  // Low Cut (Normalized)
-  float fh = 3300.0f / SAMPLE_RATE; // High Cut (Normalized)
-  int N = 64;                       // Taps
-  int M = N - 1;
-
-  for (int n = 0; n < N; n++) {
-    float k = n - M / 2.0f;
-    float h_n;
-
-    if (k == 0.0f) {
-      h_n = 2.0f * (fh - fl);
-    } else {
-      float pi_k = PI * k;
-      // Bandpass = LowPass(fh) - LowPass(fl)
-      // LowPass(f) = 2f * sinc(2*pi*f*k) = 2f * sin(2*pi*f*k)/(2*pi*f*k) =
-      // sin(2*pi*f*k)/(pi*k)
-      h_n = (sinf(2.0f * PI * fh * k) - sinf(2.0f * PI * fl * k)) / pi_k;
-    }
-
-    // Blackman Window
-    // w[n] = 0.42 - 0.5 cos(2pi n / M) + 0.08 cos(4pi n / M)
-    float w = 0.42f - 0.5f * cosf(2.0f * PI * n / M) +
-              0.08f * cosf(4.0f * PI * n / M);
-
-    _voiceCoeffs[n] = h_n * w;
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::setSpectralSquelch(
+    bool enable) {
+  if (enable && !_spectralEnabled) {
+    // Start from an empty window and a closed squelch
+    memset(_fftBuffer, 0, sizeof(_fftBuffer));
+    _spectralOpen = false;
+    _spectralSnr = 0.0f;
+    _spectralRSSI = 0;
   }
+  _spectralEnabled = enable;
+}
 
-  // Update Biquad? No, we are switching back to FIR.
-  // We can leave the Biquad junk in the header, it won't hurt.
-
-  // --- Biquad HPF 300Hz Coeffs (2nd Order Butterworth, Fs=8000) ---
-  // Calculated: b={0.846, -1.692, 0.846}, a={1.0, -1.669, 0.716}
-  // CMSIS Format: {b0, b1, b2, a1, a2} where a1/a2 are negated
-  // So a1_stored = -(-1.669) = 1.669. a2_stored = -(0.716) = -0.716.
-  // Wait, standard form: y[n] = b0*x + ... - a1*y[n-1] ...
-  // T.F. Denom: 1 - 1.669 z^-1 + 0.716 z^-2.
-  // So a1 = -1.669, a2 = 0.716.
-  // CMSIS expects NEGATED coefficients for the feedback path if the loop adds
-  // them. Standard CMSIS df1: y[n] = b0*x + ... + a1*y[n-1] + a2*y[n-2] So we
-  // store a1, a2 as positive 1.669, -0.716.
-  _hpfCoeffs[0] = 0.846f;  // b0
-  _hpfCoeffs[1] = -1.692f; // b1
-  _hpfCoeffs[2] = 0.846f;  // b2
-  _hpfCoeffs[3] = 1.669f;  // a1 (Feedback 1)
-  _hpfCoeffs[4] = -0.716f; // a2 (Feedback 2)
-}
-
-uint8_t DSPProcessor::process(int16_t *samples, bool enablePLFilter,
-                              bool enableDeemp) {
-  // 1. Convert Input to Float
-  arm_q15_to_float(samples, _floatBuffer, AUDIO_BLOCK_SAMPLES);
-
-  // ---------------------------------------------------------
-  // Path A: RSSI Calculation (Side Chain)
-  // ---------------------------------------------------------
-  // Apply RSSI Filter (High Pass > 2.4kHz) to a copy
-  arm_fir_f32(&_rssiFilter, _floatBuffer, _scratchBuffer, AUDIO_BLOCK_SAMPLES);
-
-  // Calculate RMS of the High-Passed Signal (Noise)
-  float energy = 0.0f;
-  for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-    energy += _scratchBuffer[i] * _scratchBuffer[i];
-  }
-  float rms = sqrtf(energy / (float)AUDIO_BLOCK_SAMPLES);
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+uint8_t DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::process(int16_t *samples,
+                                                      bool enablePLFilter,
+                                                      bool enableDeemp,
+                                                      uint8_t *ulawOut) {
+  // Spectral squelch analyses the unfiltered input: de-emphasis would
+  // flatten the rising noise slope it relies on
+  if (_spectralEnabled)
+    _spectralSquelch(samples);
+
+  if (_engine == DSP_ENGINE_FUSED)
+    return _processFused(samples, enablePLFilter, enableDeemp, ulawOut);
+
+  uint8_t rssi = (_engine == DSP_ENGINE_Q15)
+                     ? _processQ15(samples, enablePLFilter, enableDeemp)
+                     : _processFloat(samples, enablePLFilter, enableDeemp);
+  if (ulawOut)
+    encodeULaw(samples, ulawOut, BlockSize);
+  return rssi;
+}
 
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+uint8_t DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::_cookRSSI(float rms) {
   // Convert Float RMS (0.0-1.0) back to Q15 scale (0-32768) roughly for formula
   // match Voter2 formula: cooked_rssi = 255 - (rms_accum / 13) where rms_accum
   // is Q15.
@@ -149,6 +216,86 @@ uint8_t DSPProcessor::process(int16_t *samples, bool enablePLFilter,
   // Store noise level (inverse of RSSI) for squelch detection
   _lastNoiseLevel = 255 - finalRSSI;
 
+  return finalRSSI;
+}
+
+// Slide the analysis window by one block, then FFT the Hann-windowed copy.
+// Windows overlap by FFT_SIZE - BlockSize samples (96 for Voter frames).
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::_spectralSquelch(
+    const int16_t *samples) {
+  memmove(_fftBuffer, &_fftBuffer[BlockSize],
+          (FFT_SIZE - BlockSize) * sizeof(float));
+  arm_q15_to_float((q15_t *)samples, &_fftBuffer[FFT_SIZE - BlockSize],
+                   BlockSize);
+
+  arm_mult_f32(_fftBuffer, (float32_t *)kHann.h, _fftWindowed, FFT_SIZE);
+  arm_rfft_fast_f32(&_fft, _fftWindowed, _fftOutput, 0); // Trashes input
+  arm_cmplx_mag_squared_f32(_fftOutput, _fftWindowed, FFT_SIZE / 2);
+
+  _spectralRSSI = _calculateRSSI(_fftWindowed, FFT_SIZE / 2);
+
+  // COS with hysteresis
+  float thresh = (float)cfg.data.spectralSnrThresh;
+  if (_spectralOpen) {
+    if (_spectralSnr < thresh - SPECTRAL_HYST_DB)
+      _spectralOpen = false;
+  } else if (_spectralSnr >= thresh) {
+    _spectralOpen = true;
+  }
+}
+
+// Mean voice-band bin power over mean noise-band bin power (window gain and
+// FFT scaling cancel). A receiver in full quieting has almost nothing in
+// either band, so very low absolute noise counts as full SNR.
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+uint8_t DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::_calculateRSSI(
+    float *fftMag, int bins) {
+  (void)bins; // Band edges are compile-time (static_assert above)
+  float voice = 0.0f;
+  for (int k = kVoiceBinLo; k <= kVoiceBinHi; k++)
+    voice += fftMag[k];
+  voice /= (float)(kVoiceBinHi - kVoiceBinLo + 1);
+
+  float noise = 0.0f;
+  for (int k = kNoiseBinLo; k <= kNoiseBinHi; k++)
+    noise += fftMag[k];
+  noise /= (float)(kNoiseBinHi - kNoiseBinLo + 1);
+
+  const float eps = 1e-12f;
+  float noiseDbfs = 10.0f * log10f(noise / kFullScaleBinPower + eps);
+  float snr = 10.0f * log10f((voice + eps) / (noise + eps));
+  if (noiseDbfs < SPECTRAL_QUIET_DBFS)
+    snr = SPECTRAL_SNR_FULL_DB;
+  _spectralSnr = snr;
+
+  float rssi = snr * 255.0f / SPECTRAL_SNR_FULL_DB;
+  if (rssi < 0.0f)
+    rssi = 0.0f;
+  if (rssi > 255.0f)
+    rssi = 255.0f;
+  return (uint8_t)rssi;
+}
+
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+uint8_t DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::_processFloat(
+    int16_t *samples, bool enablePLFilter, bool enableDeemp) {
+  // 1. Convert Input to Float
+  arm_q15_to_float(samples, _floatBuffer, BlockSize);
+
+  // ---------------------------------------------------------
+  // Path A: RSSI Calculation (Side Chain)
+  // ---------------------------------------------------------
+  // Apply RSSI Filter (High Pass > 2.4kHz) to a copy
+  arm_fir_f32(&_rssiFilter, _floatBuffer, _scratchBuffer, BlockSize);
+
+  // Calculate RMS of the High-Passed Signal (Noise)
+  float energy = 0.0f;
+  for (int i = 0; i < BlockSize; i++) {
+    energy += _scratchBuffer[i] * _scratchBuffer[i];
+  }
+  uint8_t finalRSSI = _cookRSSI(sqrtf(energy / (float)BlockSize));
+
   // ---------------------------------------------------------
   // Path B: Audio Processing (Main Chain)
   // ---------------------------------------------------------
@@ -160,17 +307,15 @@ uint8_t DSPProcessor::process(int16_t *samples, bool enablePLFilter,
   // FULL BANDWIDTH (No Thinness).
   if (enablePLFilter) {
     arm_fir_f32(&_voiceFilter, _floatBuffer, _scratchBuffer,
-                AUDIO_BLOCK_SAMPLES);
-    memcpy(_floatBuffer, _scratchBuffer, AUDIO_BLOCK_SAMPLES * sizeof(float));
+                BlockSize);
+    memcpy(_floatBuffer, _scratchBuffer, BlockSize * sizeof(float));
   }
 
   // 3. De-emphasis
-  // Alpha tuned to 0.20 (middle ground between 0.15 too weak, 0.30 too
-  // aggressive) Balances noise reduction with voice clarity
   if (enableDeemp) {
-    const float alpha = 0.20f; // Moderate de-emphasis
+    const float alpha = kDeempAlpha; // Moderate de-emphasis
     const float beta = 1.0f - alpha;
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+    for (int i = 0; i < BlockSize; i++) {
       float in = _floatBuffer[i];
       float out = alpha * in + beta * _deempState;
       _floatBuffer[i] = out;
@@ -181,7 +326,7 @@ uint8_t DSPProcessor::process(int16_t *samples, bool enablePLFilter,
   // 4. Gain Compensation - REMOVED (causing distortion)
   // Voter2 adds 1.5x gain after filter, but this is too much for our setup
   // Combined with LINE IN gain + mixer gain + radio output = saturation
-  // for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+  // for (int i = 0; i < BlockSize; i++) {
   //   _floatBuffer[i] *= 1.5f;
   //   // Clip
   //   if (_floatBuffer[i] > 1.0f)
@@ -191,51 +336,133 @@ uint8_t DSPProcessor::process(int16_t *samples, bool enablePLFilter,
   // }
 
   // 5. Convert back to Int16
-  arm_float_to_q15(_floatBuffer, samples, AUDIO_BLOCK_SAMPLES);
+  arm_float_to_q15(_floatBuffer, samples, BlockSize);
 
   return finalRSSI;
 }
 
-// uLaw Encode Helper
-#define BIAS 0x84
-#define CLIP 32635
-
-static uint8_t linear2ulaw(int16_t sample) {
-  static int16_t seg_uend[8] = {0x3F,  0x7F,  0xFF,  0x1FF,
-                                0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+// Same chain as _processFloat, entirely in Q15: no int16<->float
+// conversions, and the fast kernels use the M7 dual 16-bit MACs (SMLAD).
+// Fast kernels use a 32-bit accumulator and truncate, so output differs
+// from the float path by a few LSB (test/test_dsp_engines.cpp).
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+uint8_t DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::_processQ15(
+    int16_t *samples, bool enablePLFilter, bool enableDeemp) {
+  // Path A: RSSI (High Pass > 2.4kHz, then energy)
+  arm_fir_fast_q15(&_rssiFilterQ15, samples, _scratchQ15, BlockSize);
+
+  q63_t power; // Sum of squares, 34.30
+  arm_power_q15(_scratchQ15, BlockSize, &power);
+  float rms = sqrtf((float)power / (float)BlockSize) / 32768.0f;
+  uint8_t finalRSSI = _cookRSSI(rms);
+
+  // Path B: Voice Filter, then De-emphasis (biquad runs in place)
+  const q15_t *src = samples;
+  if (enablePLFilter) {
+    arm_fir_fast_q15(&_voiceFilterQ15, samples, _scratchQ15, BlockSize);
+    src = _scratchQ15;
+  }
+  if (enableDeemp) {
+    arm_biquad_cascade_df1_fast_q15(&_deempQ15, (q15_t *)src, samples,
+                                    BlockSize);
+  } else if (src != samples) {
+    memcpy(samples, src, BlockSize * sizeof(q15_t));
+  }
 
-  int16_t mask;
-  int16_t seg;
-  uint8_t uval;
+  return finalRSSI;
+}
 
-  if (sample < 0) {
-    sample = BIAS - sample;
-    mask = 0x7F;
-  } else {
-    sample += BIAS;
-    mask = 0xFF;
-  }
+// Same chain as _processFloat in a single pass over the block: each input
+// sample is converted once into a history shared by both FIRs, and the
+// RSSI energy, de-emphasis, int16 conversion and (optionally) u-Law encoding
+// are done on the spot.
+// The RSSI window is the newest RssiTaps samples of the voice window, so
+// while both filters run their taps share each history load.
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+uint8_t DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::_processFused(
+    int16_t *samples, bool enablePLFilter, bool enableDeemp,
+    uint8_t *ulawOut) {
+  constexpr int histLen = VoiceTaps - 1;
+  constexpr int rssiOffset = VoiceTaps - RssiTaps;
+  const float *rc = kRssiCoeffs<RssiTaps>.h;
+  const float *vc = kVoiceCoeffs<VoiceTaps>.h;
+  const float alpha = kDeempAlpha;
+  const float beta = 1.0f - alpha;
 
-  if (sample > CLIP)
-    sample = CLIP;
+  float energy = 0.0f;
+  float deemp = _deempState;
+
+  for (int n = 0; n < BlockSize; n++) {
+    _fusedHistory[histLen + n] = (float)samples[n] * (1.0f / 32768.0f);
+    const float *w = &_fusedHistory[n]; // Oldest sample of the voice window
+
+    float rssi = 0.0f;
+    float out;
+    if (enablePLFilter) {
+      float voice = 0.0f;
+      for (int k = 0; k < rssiOffset; k++)
+        voice += vc[k] * w[k];
+      for (int k = rssiOffset; k < VoiceTaps; k++) {
+        float x = w[k];
+        voice += vc[k] * x;
+        rssi += rc[k - rssiOffset] * x;
+      }
+      out = voice;
+    } else {
+      for (int k = 0; k < RssiTaps; k++)
+        rssi += rc[k] * w[rssiOffset + k];
+      out = w[histLen];
+    }
+    energy += rssi * rssi;
 
-  seg = 0;
-  for (int i = 0; i < 8; i++) {
-    if (sample <= seg_uend[i]) {
-      seg = i;
-      break;
+    if (enableDeemp) {
+      deemp = alpha * out + beta * deemp;
+      out = deemp;
     }
+
+    // Same truncation/saturation as arm_float_to_q15
+    int32_t q = (int32_t)(out * 32768.0f);
+    int16_t pcm = (int16_t)(q > 32767 ? 32767 : (q < -32768 ? -32768 : q));
+    samples[n] = pcm;
+    if (ulawOut)
+      ulawOut[n] = ulawEncode(pcm);
   }
 
-  if (seg >= 8)
-    return (0x7F ^ mask);
+  if (enableDeemp)
+    _deempState = deemp;
+
+  // Keep the newest VoiceTaps-1 samples for the next block
+  memmove(_fusedHistory, &_fusedHistory[BlockSize], histLen * sizeof(float));
 
-  uval = (seg << 4) | ((sample >> (seg + 3)) & 0xF);
-  return (uval ^ mask);
+  return _cookRSSI(sqrtf(energy / (float)BlockSize));
 }
 
-void DSPProcessor::encodeULaw(int16_t *input, uint8_t *output, int count) {
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::encodeULaw(int16_t *input, uint8_t *output,
+                                                     int count) {
   for (int i = 0; i < count; i++) {
-    output[i] = linear2ulaw(input[i]);
+    output[i] = ulawEncode(input[i]);
+  }
+}
+
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::getADPCMState(
+    uint8_t *state) {
+  state[0] = (uint8_t)((uint16_t)_adpcm.predictor >> 8);
+  state[1] = (uint8_t)((uint16_t)_adpcm.predictor & 0xFF);
+  state[2] = _adpcm.index;
+}
+
+template <int BlockSize, int RssiTaps, int VoiceTaps>
+void DSPProcessor<BlockSize, RssiTaps, VoiceTaps>::encodeADPCM(
+    const int16_t *input, uint8_t *output, int count) {
+  for (int i = 0; i + 1 < count; i += 2) {
+    uint8_t hi = adpcmEncodeSample(&_adpcm, input[i]);
+    uint8_t lo = adpcmEncodeSample(&_adpcm, input[i + 1]);
+    output[i / 2] = (uint8_t)((hi << 4) | lo);
   }
 }
+
+// Supported block sizes (see typedefs in DSPProcessor.h)
+template class DSPProcessor<FRAME_SIZE>;
+template class DSPProcessor<AUDIO_BLOCK_SAMPLES>;
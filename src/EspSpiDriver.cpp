@@ -1,11 +1,32 @@
 #include "EspSpiDriver.h"
-#include "SpiProtocol.h"
+
+EspSpiDriver *EspSpiDriver::_instance = nullptr;
 
 EspSpiDriver::EspSpiDriver(uint8_t csPin, uint8_t readyPin, uint8_t resetPin) {
   _cs = csPin;
   _ready = readyPin;
   _reset = resetPin;
-  _rxLen = 0;
+  _targetPort = 0;
+  _remoteIP = IPAddress(0, 0, 0, 0);
+  _remotePort = 0;
+  _xferLen = 0;
+  _lastXferMs = 0;
+  _ipMs = 0;
+  _bridgeMs = 0;
+  _bridgeSeen = 0;
+  memset(&_bridgePrev, 0, sizeof(_bridgePrev));
+  memset(&_bridgeRates, 0, sizeof(_bridgeRates));
+  _busy = false;
+  _busDone = false;
+  _busStartUs = 0;
+  _busDoneUs = 0;
+  _busEndUs = 0;
+  _txHead = _txTail = _txCount = 0;
+  _async = true;
+  resetTxStats();
+  _readyFlag = false;
+  memset(&_rxStats, 0, sizeof(_rxStats));
+  _instance = this;
 }
 
 bool EspSpiDriver::begin(uint8_t *mac) {
@@ -20,168 +41,321 @@ bool EspSpiDriver::begin(uint8_t *mac) {
   pinMode(_ready, INPUT);
 
   SPI.begin();
-  // Default to generic SPI speed
+  // The clock is set per transaction by the link training
+
+  _busEvent.setContext(this);
+  _busEvent.attachImmediate(&EspSpiDriver::_onBusDone);
+
+  // ESP32 raises READY when its next frame has something for us
+  attachInterrupt(digitalPinToInterrupt(_ready), _readyISR, RISING);
+  _readyFlag = digitalRead(_ready) == HIGH;
+  _link.hello();
   return true;
 }
 
+void EspSpiDriver::_readyISR() {
+  if (_instance) {
+    _instance->_readyFlag = true;
+    _instance->_rxStats.readyEdges++;
+  }
+}
+
+// DMA complete (interrupt context)
+void EspSpiDriver::_onBusDone(EventResponderRef event) {
+  EspSpiDriver *d = (EspSpiDriver *)event.getContext();
+  digitalWrite(d->_cs, HIGH);
+  d->_busDoneUs = micros();
+  d->_busDone = true;
+}
+
 void EspSpiDriver::update() {
-  // Check READY pin from ESP if we aren't using interrupts
-  // If HIGH, it means ESP has data for us.
-  if (digitalRead(_ready) == HIGH) {
-    // Prepare to read?
-    // For simplicity, we just let parsePacket handle it when called.
-    // Or we could buffer here.
+  if (_link.isUp() && millis() - _bridgeMs >= ESPSPI_BRIDGE_STATS_MS) {
+    _bridgeMs = millis();
+    _link.requestBridgeStats();
+  }
+
+  // Retire the finished transaction and start the next one
+  _service();
+
+  // New STATS answer: rates over the ESP32's own uptime since the last one
+  uint32_t count = _link.getBridgeStatsCount();
+  if (count != _bridgeSeen) {
+    const SpiLinkBridgeStats &s = _link.getBridgeStats();
+    uint32_t ms = s.uptimeMs - _bridgePrev.uptimeMs;
+    if (_bridgeSeen > 0 && ms > 0 && s.uptimeMs > _bridgePrev.uptimeMs) {
+      float perSec = 1000.0f / ms;
+      _bridgeRates.netRxPps = (s.netRxPackets - _bridgePrev.netRxPackets) * perSec;
+      _bridgeRates.netRxKbps = (s.netRxBytes - _bridgePrev.netRxBytes) * 8 * perSec / 1000.0f;
+      _bridgeRates.netTxPps = (s.netTxPackets - _bridgePrev.netTxPackets) * perSec;
+      _bridgeRates.netTxKbps = (s.netTxBytes - _bridgePrev.netTxBytes) * 8 * perSec / 1000.0f;
+    }
+    _bridgePrev = s;
+    _bridgeSeen = count;
   }
 }
 
+bool EspSpiDriver::getBridgeRates(EspSpiBridgeRates *rates) const {
+  if (_bridgeSeen < 2)
+    return false;
+  *rates = _bridgeRates;
+  return true;
+}
+
 void EspSpiDriver::sendPacket(const uint8_t *data, uint16_t len) {
-  // Format: [CMD] [LEN_HI] [LEN_LO] [IP...4] [PORT...2] [DATA...]
+  _queue(data, len, _targetIP, _targetPort);
+}
 
-  SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
-  digitalWrite(_cs, LOW);
+// Per-datagram destination: no re-targeting needed
+void EspSpiDriver::sendPacketTo(const uint8_t *data, uint16_t len,
+                                IPAddress ip, uint16_t port) {
+  _queue(data, len, ip, port);
+}
 
-  // Header
-  uint8_t header[9];
-  header[0] = CMD_SEND_UDP;
-  header[1] = (len >> 8) & 0xFF;
-  header[2] = (len & 0xFF);
-  header[3] = _targetIP[0];
-  header[4] = _targetIP[1];
-  header[5] = _targetIP[2];
-  header[6] = _targetIP[3];
-  header[7] = (_targetPort >> 8) & 0xFF;
-  header[8] = (_targetPort & 0xFF);
-
-  SPI.transfer(header, 9);
-
-  // Data
-  for (uint16_t i = 0; i < len; i++) {
-    SPI.transfer(data[i]);
+void EspSpiDriver::_queue(const uint8_t *data, uint16_t len, IPAddress ip,
+                          uint16_t port) {
+  uint32_t start = micros();
+  if (len > SPILINK_MAX_DATAGRAM) {
+    _stats.tooLong++;
+    return;
+  }
+  if (!_link.isUp()) {
+    _stats.linkDown++;
+    _service();
+    return;
   }
 
-  // Padding bytes to ensure FIFO flushes and last byte is latched (Fix for
-  // dropped bytes)
-  for (int k = 0; k < 4; k++) {
-    SPI.transfer(0x00);
-    delayMicroseconds(5);
+  _service();
+  if (_txCount == ESPSPI_TX_SLOTS) {
+    // Only when datagrams come faster than frames go: one transaction takes
+    // the queue (as far as credits allow), then drop rather than stall
+    _waitBus();
+    while (!_busReady())
+      ;
+    _service();
+    if (_txCount == ESPSPI_TX_SLOTS) {
+      _stats.queueDrops++;
+      return;
+    }
   }
 
-  // Wait before CS HIGH
-  delayMicroseconds(50);
+  TxSlot &slot = _txQueue[_txHead];
+  slot.ip[0] = ip[0];
+  slot.ip[1] = ip[1];
+  slot.ip[2] = ip[2];
+  slot.ip[3] = ip[3];
+  slot.port = port;
+  slot.len = len;
+  memcpy(slot.data, data, len);
+  _txHead = (_txHead + 1) % ESPSPI_TX_SLOTS;
+  _txCount++;
+  if (_txCount > _stats.maxDepth)
+    _stats.maxDepth = _txCount;
+  _stats.packets++;
+  _stats.bytes += len;
+
+  if (_async)
+    _service();
+  else
+    flush();
+
+  uint32_t us = micros() - start;
+  _stats.callUsTotal += us;
+  if (us > _stats.callUsMax)
+    _stats.callUsMax = us;
+}
 
-  digitalWrite(_cs, HIGH);
-  SPI.endTransaction();
+// Retire a completed transaction, then start the next if there is a reason
+void EspSpiDriver::_service() {
+  _retire();
+  if (_busReady() && _wantTransaction())
+    _startTransaction();
 }
 
-void EspSpiDriver::setCredentials(const char *ssid, const char *pass) {
-  uint8_t ssidLen = strlen(ssid);
-  uint8_t passLen = strlen(pass);
+bool EspSpiDriver::_wantTransaction() {
+  if (_readyFlag || _link.isTraining() || _link.hasControl())
+    return true;
+  if (_link.isUp()) {
+    if (_link.getPeerFlags() & SPILINK_FLAG_PENDING)
+      return true;
+    if (_txCount > 0 && _link.sendCredits() > 0)
+      return true;
+  }
+  uint32_t interval = _link.isUp() ? ESPSPI_KEEPALIVE_MS : ESPSPI_HELLO_MS;
+  return millis() - _lastXferMs >= interval;
+}
 
-  SPI.beginTransaction(
-      SPISettings(1000000, MSBFIRST, SPI_MODE0)); // Slow for config
+// Build our frame (taking queued datagrams), swap headers, then clock the
+// longer of the two frames
+void EspSpiDriver::_startTransaction() {
+  uint16_t ours = _link.build(_txFrame, *this);
+  _readyFlag = false;
+  _lastXferMs = millis();
+
+  SPI.beginTransaction(SPISettings(_link.getClock(), MSBFIRST, SPI_MODE0));
   digitalWrite(_cs, LOW);
+  _busy = true;
+  _busDone = false;
+  _busStartUs = micros();
+
+  SPI.transfer(_txFrame, _rxFrame, SPILINK_HEADER);
+  uint16_t theirs = SpiLinkReader::frameLength(_rxFrame);
+  _xferLen = ours > theirs ? ours : theirs;
+  memset(_txFrame + ours, 0, _xferLen - ours);
+
+  uint16_t rest = _xferLen - SPILINK_HEADER;
+  if (!_async) {
+    SPI.transfer(_txFrame + SPILINK_HEADER, _rxFrame + SPILINK_HEADER, rest);
+  } else if (!SPI.transfer(_txFrame + SPILINK_HEADER, _rxFrame + SPILINK_HEADER,
+                           rest, _busEvent)) {
+    _stats.dmaFails++;
+    SPI.transfer(_txFrame + SPILINK_HEADER, _rxFrame + SPILINK_HEADER, rest);
+  } else {
+    return;
+  }
+  digitalWrite(_cs, HIGH);
+  _busDoneUs = micros();
+  _busDone = true;
+}
 
-  SPI.transfer(CMD_SET_CONFIG);
-  SPI.transfer(ssidLen);
-  for (int i = 0; i < ssidLen; i++)
-    SPI.transfer(ssid[i]);
+// Finished transaction: check and unpack the frame received, feed the
+// result to the link training
+void EspSpiDriver::_retire() {
+  if (!_busy || !_busDone)
+    return;
 
-  SPI.transfer(passLen);
-  for (int i = 0; i < passLen; i++) {
-    SPI.transfer(pass[i]);
-    delayMicroseconds(5);
+  SPI.endTransaction();
+  _busy = false;
+  _busEndUs = _busDoneUs;
+  uint32_t us = _busDoneUs - _busStartUs;
+  _stats.transactions++;
+  _stats.wireUsTotal += us;
+  if (us > _stats.wireUsMax)
+    _stats.wireUsMax = us;
+
+  int result = _link.receive(_rxFrame, _xferLen, *this);
+  _link.onTransaction(result);
+}
+
+// Idle, and the ESP32 has had time to take the last transaction
+bool EspSpiDriver::_busReady() {
+  return !_busy && micros() - _busEndUs >= ESPSPI_CS_GAP_US;
+}
+
+// Spin until the bus is free. Bounded: a lost completion event must not
+// hang the loop.
+void EspSpiDriver::_waitBus() {
+  uint32_t start = micros();
+  while (_busy && !_busDone) {
+    if (micros() - start > ESPSPI_BUS_TIMEOUT_US) {
+      _stats.dmaTimeouts++;
+      digitalWrite(_cs, HIGH);
+      _busDoneUs = micros();
+      _busDone = true;
+    }
   }
+  _retire();
+}
+
+// SpiLinkPort: oldest queued datagram, if it fits in this frame
+uint16_t EspSpiDriver::nextDatagram(uint8_t *ip, uint16_t *port,
+                                    uint8_t *data, uint16_t maxLen) {
+  if (_txCount == 0)
+    return 0;
+  TxSlot &slot = _txQueue[_txTail];
+  if (slot.len > maxLen)
+    return 0;
+  memcpy(ip, slot.ip, 4);
+  *port = slot.port;
+  memcpy(data, slot.data, slot.len);
+  _txTail = (_txTail + 1) % ESPSPI_TX_SLOTS;
+  _txCount--;
+  return slot.len;
+}
 
-  // Padding bytes to ensure FIFO flushes and last byte is latched
-  for (int k = 0; k < 4; k++) {
-    SPI.transfer(0x00);
-    delayMicroseconds(5);
+// SpiLinkPort: datagram from the ESP32 into the ring. The ESP32 keeps within
+// our credits, so a full ring means it did not.
+bool EspSpiDriver::onDatagram(const uint8_t *ip, uint16_t port,
+                              const uint8_t *data, uint16_t len) {
+  RxSlot *slot = _rxRing.reserve();
+  if (!slot || len > SPILINK_MAX_DATAGRAM) {
+    _rxStats.ringFull++;
+    return false;
   }
+  memcpy(slot->ip, ip, 4);
+  slot->port = port;
+  slot->len = len;
+  memcpy(slot->data, data, len);
+  _rxRing.commit();
+  _rxStats.packets++;
+  _rxStats.bytes += len;
+  return true;
+}
 
-  // Wait before CS HIGH to ensure physical transmission matches FIFO
-  delayMicroseconds(50);
+// Send what is queued now (as far as credits allow), then leave the bus idle
+void EspSpiDriver::flush() {
+  _waitBus();
+  while (_txCount > 0 && _link.isUp() && _link.sendCredits() > 0) {
+    while (!_busReady())
+      ;
+    _startTransaction();
+    _waitBus();
+  }
+}
 
-  digitalWrite(_cs, HIGH);
-  SPI.endTransaction();
+void EspSpiDriver::setAsync(bool async) {
+  flush();
+  _async = async;
+  resetTxStats();
 }
 
-int EspSpiDriver::parsePacket() {
-  // If ESP says "Ready", we read.
-  if (digitalRead(_ready) == HIGH) {
-    SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
-    digitalWrite(_cs, LOW);
-
-    // We expect ESP to clock out: [STATUS] [LEN_HI] [LEN_LO] [DATA...]
-    // Since ESP is Slave, we must send Dummy bytes to shift data in.
-
-    uint8_t status = SPI.transfer(0x00);
-
-    if (status == STATUS_HAS_DATA) {
-      uint8_t lenHi = SPI.transfer(0x00);
-      uint8_t lenLo = SPI.transfer(0x00);
-      uint16_t len = (lenHi << 8) | lenLo;
-
-      if (len > 0 && len < 512) {
-        // Read Payload
-        for (int i = 0; i < len; i++) {
-          _rxBuffer[i] = SPI.transfer(0x00);
-        }
-        _rxLen = len;
-      } else {
-        _rxLen = 0;
-      }
-    }
+void EspSpiDriver::resetTxStats() { memset(&_stats, 0, sizeof(_stats)); }
 
-    digitalWrite(_cs, HIGH);
-    SPI.endTransaction();
+// Goes out with the next frames until the ESP32 echoes it in a STATUS
+void EspSpiDriver::setCredentials(const char *ssid, const char *pass) {
+  _link.setConfig(ssid, pass);
+  _service();
+}
 
-    return _rxLen;
-  }
-  return 0;
+int EspSpiDriver::parsePacket() {
+  // Retire/start a transaction if one is due; what is already in the ring is
+  // returned without waiting for it
+  _service();
+  if (!_rxRing.available())
+    return 0;
+  RxSlot *slot = _rxRing.peek();
+  _remoteIP = IPAddress(slot->ip[0], slot->ip[1], slot->ip[2], slot->ip[3]);
+  _remotePort = slot->port;
+  return slot->len;
 }
 
 int EspSpiDriver::read(uint8_t *buffer, size_t maxLen) {
-  if (_rxLen > 0) {
-    size_t copyLen = (_rxLen < (int)maxLen) ? _rxLen : maxLen;
-    memcpy(buffer, _rxBuffer, copyLen);
-    _rxLen = 0; // Clear buffer
-    return copyLen;
-  }
-  return 0;
+  if (!_rxRing.available())
+    return 0;
+  RxSlot *slot = _rxRing.peek();
+  size_t copyLen = (slot->len < maxLen) ? slot->len : maxLen;
+  memcpy(buffer, slot->data, copyLen);
+  _rxRing.consume();
+  return copyLen;
 }
 
-// Stubs
-bool EspSpiDriver::isConnected() { return true; }
+// Link trained and the ESP32 reports WiFi associated (flag in every frame)
+bool EspSpiDriver::isConnected() {
+  _service();
+  return _link.isPeerLinkUp();
+}
 
+// Last STATUS answer (0.0.0.0 until the first one); asks for a fresh one
+// when it is stale
 IPAddress EspSpiDriver::getLocalIP() {
-  // Send CMD_GET_IP
-  uint8_t cmd[1] = {CMD_GET_IP};
-  sendPacket(cmd, 0); // Need to handle 0 length or just send 1 byte command?
-  // sendPacket assumes UDP packet structure which adds headers.
-  // We need a raw "sendCommand" or just manually do it here.
-
-  // Manual Command Send
-  SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
-  digitalWrite(_cs, LOW);
-  SPI.transfer(CMD_GET_IP);
-  digitalWrite(_cs, HIGH);
-  SPI.endTransaction();
-
-  // Wait for Response (Poll Ready)
-  uint32_t start = millis();
-  while (millis() - start < 200) { // 200ms Timeout
-    if (digitalRead(_ready) == HIGH) {
-      // Read it!
-      int len = parsePacket(); // This reads into _rxBuffer
-      if (len == 4) {
-        return IPAddress(_rxBuffer[0], _rxBuffer[1], _rxBuffer[2],
-                         _rxBuffer[3]);
-      }
-    }
+  if (millis() - _ipMs > ESPSPI_STATUS_REFRESH_MS) {
+    _ipMs = millis();
+    _link.requestStatus();
   }
-
-  return IPAddress(0, 0, 0, 0);
+  _service();
+  const uint8_t *ip = _link.getLocalIP();
+  return IPAddress(ip[0], ip[1], ip[2], ip[3]);
 }
+
 void EspSpiDriver::setTarget(IPAddress ip, uint16_t port) {
   _targetIP = ip;
   _targetPort = port;
@@ -0,0 +1,85 @@
+#include "FrameClock.h"
+#include "ConfigManager.h"
+
+FrameClock::FrameClock() {
+  _mode = TIMING_GPS;
+  _valid = false;
+  _holdover = false;
+  _stampUs = 0;
+  _seq = 0;
+  _lastErr = 0;
+  _holdoverFrames = 0;
+  _resyncs = 0;
+}
+
+void FrameClock::begin(uint8_t mode) {
+  setMode(mode);
+  _seq = 0;
+}
+
+void FrameClock::setMode(uint8_t mode) {
+  _mode = (mode == TIMING_MIX) ? TIMING_MIX : TIMING_GPS;
+  _valid = false;
+  _holdover = false;
+  _stampUs = 0;
+}
+
+void FrameClock::roundToFrame(VTIME *t) {
+  const uint32_t frameNs = FRAMECLOCK_FRAME_US * 1000UL;
+  uint32_t ns = t->vtime_nsec + frameNs / 2;
+  ns -= ns % frameNs;
+  if (ns >= 1000000000UL) {
+    t->vtime_sec++;
+    ns -= 1000000000UL;
+  }
+  t->vtime_nsec = ns;
+}
+
+void FrameClock::stamp(VTIME *t, const VTIME *gpsNow) {
+  _seq++;
+
+  if (_mode == TIMING_MIX) {
+    // Local time is the frame count itself: exactly 20ms per frame
+    _stampUs += FRAMECLOCK_FRAME_US;
+    t->vtime_sec = (uint32_t)(_stampUs / 1000000ULL);
+    t->vtime_nsec = _seq;
+    return;
+  }
+
+  if (!_valid) {
+    // Wait for the first GPS time to hold over from
+    if (!gpsNow) {
+      t->vtime_sec = 0;
+      t->vtime_nsec = 0;
+      return;
+    }
+    _stampUs = (uint64_t)gpsNow->vtime_sec * 1000000ULL +
+               gpsNow->vtime_nsec / 1000;
+    _valid = true;
+  } else {
+    _stampUs += FRAMECLOCK_FRAME_US;
+    if (gpsNow) {
+      uint64_t gpsUs = (uint64_t)gpsNow->vtime_sec * 1000000ULL +
+                       gpsNow->vtime_nsec / 1000;
+      int64_t err = (int64_t)(gpsUs - _stampUs);
+      if (err > FRAMECLOCK_RESYNC_US || err < -FRAMECLOCK_RESYNC_US) {
+        _stampUs = gpsUs;
+        _resyncs++;
+      } else if (err > FRAMECLOCK_SLEW_US) {
+        _stampUs += FRAMECLOCK_SLEW_US;
+      } else if (err < -FRAMECLOCK_SLEW_US) {
+        _stampUs -= FRAMECLOCK_SLEW_US;
+      } else {
+        _stampUs = gpsUs;
+      }
+      _lastErr = (int32_t)(gpsUs - _stampUs);
+      _holdover = false;
+    } else {
+      _holdover = true;
+      _holdoverFrames++;
+    }
+  }
+
+  t->vtime_sec = (uint32_t)(_stampUs / 1000000ULL);
+  t->vtime_nsec = (uint32_t)(_stampUs % 1000000ULL) * 1000;
+}
@@ -10,6 +10,7 @@ GPSManager::GPSManager() {
   _currentEpoch = 0;
   _validTime = false;
   _ppsPeriod = 1000000;
+  _ppsHandler = nullptr;
   _instance = this;
 }
 
@@ -36,6 +37,9 @@ void GPSManager::_handlePPS() {
 
     _lastPpsMicros = now;
     _ppsTriggered = true;
+
+    if (_ppsHandler)
+      _ppsHandler(now);
   }
 }
 
@@ -102,17 +106,26 @@ uint32_t GPSManager::getPpsJitter() {
   }
 }
 
-void GPSManager::getNetworkTime(VTIME *t) {
+void GPSManager::getNetworkTime(VTIME *t) { getTimeAt(micros(), t); }
+
+void GPSManager::getTimeAt(uint32_t atMicros, VTIME *t) {
   if (!t)
     return;
 
   noInterrupts();
   uint32_t lastPps = _lastPpsMicros;
   uint32_t epoch = _currentEpoch;
+  uint32_t period = _ppsPeriod;
   interrupts();
 
-  uint32_t now = micros();
-  uint32_t deltaMicros = now - lastPps;
+  uint32_t deltaMicros = atMicros - lastPps;
+
+  // Reading from before the latest PPS edge (the edge came in between):
+  // it belongs to the previous second
+  if ((int32_t)deltaMicros < 0) {
+    epoch--;
+    deltaMicros += period;
+  }
 
   // If we are way past 1 second (lost PPS?), just rely on math
   if (deltaMicros >= 1000000) {
@@ -0,0 +1,66 @@
+#include "LatencyHistogram.h"
+
+void LatencyHistogram::clear() {
+  memset(_bins, 0, sizeof(_bins));
+  _count = 0;
+  _min = 0xFFFFFFFF;
+  _max = 0;
+  _sum = 0;
+}
+
+uint8_t LatencyHistogram::binOf(uint32_t us) {
+  uint32_t v = us >> LATHIST_UNIT_SHIFT;
+  if (v < (1u << LATHIST_SUB_BITS))
+    return (uint8_t)v; // Linear below 8 units
+  uint32_t e = 31 - __builtin_clz(v); // >= LATHIST_SUB_BITS
+  uint32_t bin = ((e - LATHIST_SUB_BITS + 1) << LATHIST_SUB_BITS) +
+                 ((v >> (e - LATHIST_SUB_BITS)) & ((1u << LATHIST_SUB_BITS) - 1));
+  return bin < LATHIST_BINS ? (uint8_t)bin : LATHIST_BINS - 1;
+}
+
+uint32_t LatencyHistogram::binLow(uint8_t bin) {
+  const uint32_t sub = 1u << LATHIST_SUB_BITS;
+  if (bin < sub)
+    return (uint32_t)bin << LATHIST_UNIT_SHIFT;
+  uint32_t e = (bin >> LATHIST_SUB_BITS) + LATHIST_SUB_BITS - 1;
+  uint32_t v = (sub + (bin & (sub - 1))) << (e - LATHIST_SUB_BITS);
+  return v << LATHIST_UNIT_SHIFT;
+}
+
+void LatencyHistogram::add(uint32_t us) {
+  _bins[binOf(us)]++;
+  _count++;
+  _sum += us;
+  if (us < _min)
+    _min = us;
+  if (us > _max)
+    _max = us;
+}
+
+uint32_t LatencyHistogram::getPercentile(uint8_t pct) const {
+  if (_count == 0)
+    return 0;
+  if (pct > 100)
+    pct = 100;
+
+  // Rank of the sample we want (1-based, nearest rank)
+  uint32_t rank = (uint32_t)(((uint64_t)_count * pct + 99) / 100);
+  if (rank == 0)
+    rank = 1;
+
+  uint32_t seen = 0;
+  for (int i = 0; i < LATHIST_BINS; i++) {
+    seen += _bins[i];
+    if (seen >= rank) {
+      uint32_t lo = binLow(i);
+      uint32_t hi = (i + 1 < LATHIST_BINS) ? binLow(i + 1) : _max + 1;
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (mid < getMin())
+        mid = getMin();
+      if (mid > _max)
+        mid = _max;
+      return mid;
+    }
+  }
+  return _max;
+}
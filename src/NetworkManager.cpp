@@ -1,46 +1,189 @@
 #include "NetworkManager.h"
+#include "ConfigManager.h"
 
 NetworkManager::NetworkManager() {
-    _driver = nullptr;
+    _count = 0;
+    _active = NET_NO_LINK;
+    _mode = NET_BOND_FAILOVER;
+    _rxLink = NET_NO_LINK;
+    _rxNext = 0;
+    _failovers = 0;
+    _lastFailoverMs = 0;
+    _mac = nullptr;
 }
 
 void NetworkManager::begin(NetworkDriver* driver, uint8_t* mac_addr) {
-    _driver = driver;
     _mac = mac_addr;
-    
-    if (_driver) {
-        _driver->begin(_mac);
+    _count = 0;
+    _active = NET_NO_LINK;
+    _rxLink = NET_NO_LINK;
+    _rxNext = 0;
+    addLink(driver);
+}
+
+int NetworkManager::addLink(NetworkDriver* driver) {
+    if (!driver || _count == NET_MAX_LINKS) return -1;
+    Link& l = _links[_count];
+    memset(&l, 0, sizeof(l));
+    l.driver = driver;
+    l.health = NET_LINK_DOWN;
+    bool ok = driver->begin(_mac);
+    int index = _count++;
+    _evaluate();
+    return ok ? index : -1;
+}
+
+// Health of every link, then the active one
+void NetworkManager::_evaluate() {
+    uint32_t now = millis();
+    uint8_t firstUp = NET_NO_LINK, firstConnected = NET_NO_LINK;
+    for (uint8_t i = 0; i < _count; i++) {
+        Link& l = _links[i];
+        uint8_t health = NET_LINK_DOWN;
+        if (l.driver->isConnected()) {
+            bool silent = l.pendingSinceMs && now - l.pendingSinceMs >= NET_SILENT_MS;
+            health = silent ? NET_LINK_SILENT : NET_LINK_UP;
+        }
+        if (health != l.health) {
+            if (l.health == NET_LINK_UP) l.stats.downs++;
+            if (health == NET_LINK_UP) l.healthySinceMs = now;
+            if (health == NET_LINK_DOWN) l.pendingSinceMs = 0; // Fresh start when back
+            l.health = health;
+        }
+        if (health == NET_LINK_UP && firstUp == NET_NO_LINK) firstUp = i;
+        if (health != NET_LINK_DOWN && firstConnected == NET_NO_LINK) firstConnected = i;
+    }
+
+    uint8_t best = firstUp != NET_NO_LINK ? firstUp : firstConnected;
+    if (best == NET_NO_LINK || best == _active) return;
+
+    // Leave a working link for a better one only once that has settled
+    if (_active != NET_NO_LINK && best < _active &&
+        _links[_active].health == NET_LINK_UP &&
+        now - _links[best].healthySinceMs < NET_FAILBACK_MS)
+        return;
+
+    if (_active != NET_NO_LINK) {
+        _failovers++;
+        _lastFailoverMs = now;
     }
+    _active = best;
+    _links[best].stats.activations++;
 }
 
 void NetworkManager::update() {
-    if (_driver) _driver->update();
+    for (uint8_t i = 0; i < _count; i++) _links[i].driver->update();
+    _evaluate();
 }
 
 void NetworkManager::setTarget(IPAddress ip, uint16_t port) {
-    if (_driver) _driver->setTarget(ip, port);
+    for (uint8_t i = 0; i < _count; i++) _links[i].driver->setTarget(ip, port);
+}
+
+void NetworkManager::_sendOn(uint8_t link, const uint8_t* data, uint16_t length, IPAddress ip, uint16_t port) {
+    Link& l = _links[link];
+    l.driver->sendPacketTo(data, length, ip, port);
+    l.stats.txPackets++;
+    if (!l.pendingSinceMs) l.pendingSinceMs = millis();
 }
 
 void NetworkManager::sendPacket(const uint8_t* data, uint16_t length) {
-    if (_driver) _driver->sendPacket(data, length);
+    _evaluate();
+    if (_mode == NET_BOND_DUPLICATE) {
+        for (uint8_t i = 0; i < _count; i++) {
+            if (_links[i].health == NET_LINK_DOWN) continue;
+            _links[i].driver->sendPacket(data, length);
+            _links[i].stats.txPackets++;
+        }
+    } else if (_active != NET_NO_LINK) {
+        _links[_active].driver->sendPacket(data, length);
+        _links[_active].stats.txPackets++;
+    }
+}
+
+void NetworkManager::sendPacketTo(const uint8_t* data, uint16_t length, IPAddress ip, uint16_t port) {
+    _evaluate();
+    if (_mode == NET_BOND_DUPLICATE) {
+        for (uint8_t i = 0; i < _count; i++)
+            if (_links[i].health != NET_LINK_DOWN) _sendOn(i, data, length, ip, port);
+    } else if (_active != NET_NO_LINK) {
+        _sendOn(_active, data, length, ip, port);
+    }
+}
+
+void NetworkManager::sendKeepaliveTo(const uint8_t* data, uint16_t length, IPAddress ip, uint16_t port) {
+    sendPacketTo(data, length, ip, port);
+    if (_mode == NET_BOND_DUPLICATE) return;
+
+    // Standby links: one keepalive per NET_PROBE_MS (any host)
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < _count; i++) {
+        Link& l = _links[i];
+        if (i == _active || l.health == NET_LINK_DOWN || now - l.lastProbeMs < NET_PROBE_MS) continue;
+        l.lastProbeMs = now;
+        l.stats.probes++;
+        _sendOn(i, data, length, ip, port);
+    }
+}
+
+void NetworkManager::confirmLink(uint8_t link) {
+    if (link >= _count) return;
+    Link& l = _links[link];
+    l.pendingSinceMs = 0;
+    l.stats.confirms++;
+    l.stats.lastConfirmMs = millis();
+}
+
+IPAddress NetworkManager::remoteIP() {
+    if (_rxLink < _count) return _links[_rxLink].driver->remoteIP();
+    return IPAddress(0,0,0,0);
+}
+
+uint16_t NetworkManager::remotePort() {
+    if (_rxLink < _count) return _links[_rxLink].driver->remotePort();
+    return 0;
 }
 
+// Every link in turn (round robin, so one busy link can't starve the others)
 int NetworkManager::parsePacket() {
-    if (_driver) return _driver->parsePacket();
+    for (uint8_t n = 0; n < _count; n++) {
+        uint8_t i = (_rxNext + n) % _count;
+        int size = _links[i].driver->parsePacket();
+        if (size > 0) {
+            _rxLink = i;
+            _rxNext = (i + 1) % _count;
+            _links[i].stats.rxPackets++;
+            return size;
+        }
+    }
     return 0;
 }
 
 int NetworkManager::read(uint8_t* buffer, size_t maxLen) {
-    if (_driver) return _driver->read(buffer, maxLen);
+    if (_rxLink < _count) return _links[_rxLink].driver->read(buffer, maxLen);
     return 0;
 }
 
 bool NetworkManager::isConnected() {
-    if (_driver) return _driver->isConnected();
+    for (uint8_t i = 0; i < _count; i++)
+        if (_links[i].driver->isConnected()) return true;
     return false;
 }
 
 IPAddress NetworkManager::getLocalIP() {
-    if (_driver) return _driver->getLocalIP();
+    if (_active != NET_NO_LINK) return _links[_active].driver->getLocalIP();
     return IPAddress(0,0,0,0);
 }
+
+const char* NetworkManager::typeName(DriverType type) {
+    switch (type) {
+    case DRIVER_ETHERNET: return "Ethernet";
+    case DRIVER_WIFI_SPI: return "WiFi (ESP32 SPI)";
+    case DRIVER_WIFI_UART: return "WiFi (UART)";
+    default: return "None";
+    }
+}
+
+const char* NetworkManager::healthName(uint8_t health) {
+    return health == NET_LINK_UP ? "UP" : health == NET_LINK_SILENT ? "SILENT" : "DOWN";
+}
@@ -0,0 +1,94 @@
+#include "PpsDiscipline.h"
+#include <AudioStream.h>
+
+PpsDiscipline::PpsDiscipline() {
+  _edges = 0;
+  _acquires = 0;
+  _rateRejects = 0;
+  reset();
+  resetRate();
+}
+
+void PpsDiscipline::reset() {
+  _locked = false;
+  _lastErr = 0.0f;
+}
+
+void PpsDiscipline::resetRate() {
+  _rateState = PPSDISC_RATE_FREE;
+  _rateCount = 0;
+  _rateAvg = AUDIO_SAMPLE_RATE_EXACT;
+  _ppm = 0.0f;
+}
+
+bool PpsDiscipline::onInterval(double samples, double *ratio) {
+  double ppm = (samples / AUDIO_SAMPLE_RATE_EXACT - 1.0) * 1e6;
+  if (fabs(ppm) > PPSDISC_RATE_MAX_PPM) {
+    // Missed or spurious edge, or a lost audio block
+    _rateRejects++;
+    return false;
+  }
+
+  // Running mean over the first intervals, then an exponential average
+  _rateCount++;
+  uint32_t n =
+      (_rateCount < PPSDISC_RATE_AVG) ? _rateCount : PPSDISC_RATE_AVG;
+  _rateAvg += (samples - _rateAvg) / (double)n;
+  _ppm = (float)((_rateAvg / AUDIO_SAMPLE_RATE_EXACT - 1.0) * 1e6);
+
+  if (_rateCount < PPSDISC_RATE_LOCK) {
+    _rateState = PPSDISC_RATE_ACQUIRE;
+    return false;
+  }
+  _rateState = PPSDISC_RATE_LOCKED;
+  *ratio = _rateAvg / 8000.0;
+  return true;
+}
+
+void PpsDiscipline::onTimeout() {
+  if (_rateState == PPSDISC_RATE_LOCKED)
+    _rateState = PPSDISC_RATE_HOLDOVER;
+}
+
+const char *PpsDiscipline::rateStateName(uint8_t state) {
+  switch (state) {
+  case PPSDISC_RATE_ACQUIRE:
+    return "ACQUIRE";
+  case PPSDISC_RATE_LOCKED:
+    return "LOCKED";
+  case PPSDISC_RATE_HOLDOVER:
+    return "HOLDOVER";
+  default:
+    return "FREE";
+  }
+}
+
+float PpsDiscipline::onPps(float nextUs, int index, int *target) {
+  _edges++;
+
+  // How late the output is for its slot, folded into one frame
+  float err = fmodf(nextUs - (float)index * PPSDISC_SAMPLE_US,
+                    (float)PPSDISC_FRAME_US);
+  if (err >= PPSDISC_FRAME_US / 2)
+    err -= PPSDISC_FRAME_US;
+  else if (err < -PPSDISC_FRAME_US / 2)
+    err += PPSDISC_FRAME_US;
+  _lastErr = err;
+
+  if (!_locked || fabsf(err) > PPSDISC_REACQUIRE_US) {
+    // Move the output to the slot it is nearest to, then step the phase
+    // by what is left (at most half a sample)
+    int slots = (int)lroundf(err / PPSDISC_SAMPLE_US);
+    *target = ((index + slots) % FRAME_SIZE + FRAME_SIZE) % FRAME_SIZE;
+    _locked = true;
+    _acquires++;
+    return -(err - (float)slots * PPSDISC_SAMPLE_US);
+  }
+
+  *target = index;
+  if (err > PPSDISC_SLEW_US)
+    return -PPSDISC_SLEW_US;
+  if (err < -PPSDISC_SLEW_US)
+    return PPSDISC_SLEW_US;
+  return -err;
+}
@@ -1,4 +1,5 @@
 #include "VoterClient.h"
+#include "ConfigManager.h"
 #include <stdint.h>
 
 // Local byte-swap helpers with unique names to avoid toolchain builtin issues
@@ -57,11 +58,22 @@ static const uint32_t crc_32_tab[] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d};
 
 VoterClient::VoterClient() {
-  _state = VOTER_DISCONNECTED;
-  _lastAttemptTime = 0;
-  _serverDigest = 0;
-  _myDigest = 0;
-  memset(_serverChallenge, 0, sizeof(_serverChallenge));
+  _hostCount = 0;
+  memset(_myChallenge, 0, sizeof(_myChallenge));
+  memset(&_audioPkt, 0, sizeof(_audioPkt));
+  memset(&_adpcmPkt, 0, sizeof(_adpcmPkt));
+  _bytesCopied = 0;
+  _audioPackets = 0;
+  _txHandler = nullptr;
+  _pingSeq = 0;
+  _pingRemaining = 0;
+  _pingIntervalMs = VOTER_PING_INTERVAL_MS;
+  _lastPingSend = 0;
+  _pingsEchoed = 0;
+  memset(&_rx, 0, sizeof(_rx));
+  _rxRate = 0;
+  _rxRateBase = 0;
+  _rxRateStart = 0;
 }
 
 void VoterClient::begin(NetworkManager *net, GPSManager *gps, IPAddress host,
@@ -69,36 +81,198 @@ void VoterClient::begin(NetworkManager *net, GPSManager *gps, IPAddress host,
                         const char *hostPwd) {
   _net = net;
   _gps = gps;
-  _hostIP = host;
-  _hostPort = port;
   _clientPwd = clientPwd;
   _hostPwd = hostPwd;
 
+  _hostCount = 0;
+  addHost(host, port);
+
   _generateChallenge();
+  _buildAudioTemplates();
+}
+
+int VoterClient::addHost(IPAddress host, uint16_t port) {
+  if (_hostCount >= VOTER_MAX_HOSTS)
+    return -1;
+  _initSession(_hosts[_hostCount], host, port);
+  return _hostCount++;
+}
+
+void VoterClient::_initSession(VoterHostSession &s, IPAddress host,
+                               uint16_t port) {
+  s.ip = host;
+  s.port = port;
+  s.state = VOTER_DISCONNECTED;
+  memset(s.serverChallenge, 0, sizeof(s.serverChallenge));
+  s.serverDigest = 0;
+  s.myDigest = 0;
+  s.lastAttemptTime = 0;
+  s.lastGPSSend = 0;
+  s.silent = false;
+  memset(&s.stats, 0, sizeof(s.stats));
+  s.pingHist.clear();
+  s.pingPending = 0;
+  s.pingsSent = 0;
+}
+
+bool VoterClient::isConnected() {
+  for (uint8_t i = 0; i < _hostCount; i++) {
+    if (_hosts[i].state == VOTER_CONNECTED)
+      return true;
+  }
+  return false;
+}
+
+void VoterClient::_receive() {
+  uint32_t start = micros();
+
+  // 1. Drain: free the driver's buffer before any processing
+  int count = 0;
+  while (count < VOTER_RX_BATCH) {
+    int size = _net->parsePacket();
+    if (size <= 0)
+      break;
+    VoterRxPacket &pkt = _rxPool[count];
+    int len = _net->read(pkt.data, sizeof(pkt.data));
+    _rx.packets++;
+    if (len > 0)
+      _rx.bytes += len;
+    if (size > VOTER_RX_MAX_LEN) {
+      _rx.dropLong++;
+      continue;
+    }
+    if (len < (int)sizeof(VOTER_PACKET_HEADER)) {
+      _rx.dropShort++;
+      continue;
+    }
+    pkt.len = (uint16_t)len;
+    pkt.ip = _net->remoteIP();
+    pkt.port = _net->remotePort();
+    pkt.link = _net->getRxLink();
+    count++;
+  }
+
+  // 2. Dispatch
+  for (int i = 0; i < count; i++) {
+    VoterRxPacket &pkt = _rxPool[i];
+    VoterHostSession *s = _findSession(pkt);
+    if (s)
+      _handlePacket(*s, pkt.data, pkt.len, pkt.link);
+    else
+      _rx.dropNoHost++;
+  }
+
+  if (count > 0) {
+    uint32_t us = micros() - start;
+    _rx.passes++;
+    _rx.procUsTotal += us;
+    if (us > _rx.procUsMax)
+      _rx.procUsMax = us;
+    if (count > _rx.maxBatch)
+      _rx.maxBatch = count;
+    if (count == VOTER_RX_BATCH)
+      _rx.fullPasses++;
+  }
+
+  if (millis() - _rxRateStart >= 1000) {
+    _rxRate = _rx.packets - _rxRateBase;
+    _rxRateBase = _rx.packets;
+    _rxRateStart = millis();
+  }
 }
 
 void VoterClient::update() {
-  // 1. Check Incoming
-  int packetSize = _net->parsePacket();
-  if (packetSize >= (int)sizeof(VOTER_PACKET_HEADER)) {
-    uint8_t buffer[MAX_BUFFER_SIZE];
-    _net->read(buffer, sizeof(buffer));
-    _handlePacket(buffer, packetSize);
+  // 1. Incoming
+  _receive();
+
+  bool pingDue =
+      _pingRemaining > 0 && millis() - _lastPingSend >= _pingIntervalMs;
+  if (pingDue) {
+    _lastPingSend = millis();
+    _pingRemaining--;
   }
 
-  // 2. Authentication Loop
-  if (_state == VOTER_DISCONNECTED) {
-    if (millis() - _lastAttemptTime > 500) { // ATTEMPT_TIME
-      _lastAttemptTime = millis();
-      _sendAuthPacket();
+  for (uint8_t i = 0; i < _hostCount; i++) {
+    VoterHostSession &s = _hosts[i];
+
+    // 2. Authentication Loop
+    if (s.state == VOTER_DISCONNECTED) {
+      if (millis() - s.lastAttemptTime > 500) { // ATTEMPT_TIME
+        s.lastAttemptTime = millis();
+        _sendAuthPacket(s);
+      }
+    } else if (s.state == VOTER_CONNECTED) {
+      // 3. Keepalive / GPS Packet (Periodic)
+      if (millis() - s.lastGPSSend > 500) { // Every 500 ms
+        s.lastGPSSend = millis();
+        _sendGPSPacket(s);
+      }
+
+      // 4. Latency probe
+      if (pingDue)
+        _sendPing(s);
+
+      // 5. Outage statistics only: a host may legitimately stay quiet, so
+      // this does not drop the session (a restarted host re-challenges).
+      if (!s.silent && s.stats.packetsRx &&
+          millis() - s.stats.lastRxMs > VOTER_HOST_TIMEOUT_MS) {
+        s.silent = true;
+        s.stats.timeouts++;
+      }
     }
-  } else if (_state == VOTER_CONNECTED) {
-    // 3. Keepalive / GPS Packet (Periodic)
-    if (millis() - _lastGPSSend > 500) { // Every 500 ms
-      _lastGPSSend = millis();
-      _sendGPSPacket();
+
+    // Whatever has not come back by now is lost
+    if (_pingRemaining == 0 && s.pingPending &&
+        millis() - _lastPingSend > VOTER_PING_TIMEOUT_MS)
+      s.pingPending = 0;
+  }
+  if (pingDue)
+    _pingSeq++;
+}
+
+// Which host sent this packet. By source address when the driver knows it
+// (exact port first, so two hosts may share an IP). Drivers that can't tell
+// (ESP32 SPI bridge) fall back to the challenge: the session that holds it,
+// else one still waiting for its first challenge.
+VoterHostSession *VoterClient::_findSession(const VoterRxPacket &pkt) {
+  if (_hostCount == 1)
+    return &_hosts[0];
+
+  const VOTER_PACKET_HEADER *header = (const VOTER_PACKET_HEADER *)pkt.data;
+  if ((uint32_t)pkt.ip != 0) {
+    VoterHostSession *ipMatch = nullptr;
+    for (uint8_t i = 0; i < _hostCount; i++) {
+      if (_hosts[i].ip == pkt.ip) {
+        if (_hosts[i].port == pkt.port)
+          return &_hosts[i];
+        if (!ipMatch)
+          ipMatch = &_hosts[i];
+      }
     }
+    return ipMatch; // nullptr: not one of our hosts
   }
+
+  for (uint8_t i = 0; i < _hostCount; i++) {
+    if (strncmp((const char *)header->challenge, _hosts[i].serverChallenge,
+                VOTER_CHALLENGE_LEN) == 0)
+      return &_hosts[i];
+  }
+  for (uint8_t i = 0; i < _hostCount; i++) {
+    if (_hosts[i].serverChallenge[0] == 0)
+      return &_hosts[i];
+  }
+  return nullptr;
+}
+
+void VoterClient::_sendTo(VoterHostSession &s, const uint8_t *data, int len) {
+  _net->sendPacketTo(data, len, s.ip, s.port);
+}
+
+// Auth and keepalives: these also probe the standby network links, whose
+// answers keep them known-good (NetworkManager::confirmLink())
+void VoterClient::_sendKeepalive(VoterHostSession &s, const uint8_t *data,
+                                 int len) {
+  _net->sendKeepaliveTo(data, len, s.ip, s.port);
 }
 
 // Ported from Voter.c crc32_bufs
@@ -120,7 +294,7 @@ void VoterClient::_generateChallenge() {
   snprintf(_myChallenge, 10, "%lu", random(10000000, 99999999));
 }
 
-void VoterClient::_sendAuthPacket() {
+void VoterClient::_sendAuthPacket(VoterHostSession &s) {
   // Construct Header-Only Packet
   VOTER_PACKET_HEADER header;
   memset(&header, 0, sizeof(header));
@@ -136,14 +310,16 @@ void VoterClient::_sendAuthPacket() {
   memcpy(header.challenge, _myChallenge, VOTER_CHALLENGE_LEN);
 
   // Digest
-  header.digest = my_htonl(_myDigest); // 0 initially
+  header.digest = my_htonl(s.myDigest); // 0 initially
   header.payload_type = my_htons(PAYLOAD_AUTH);
 
-  Serial.println("[Voter] Sending Auth Request...");
-  _net->sendPacket((uint8_t *)&header, sizeof(header));
+  Serial.printf("[Voter] Sending Auth Request to host %d...\r\n",
+                (int)(&s - _hosts));
+  s.stats.authSent++;
+  _sendKeepalive(s, (uint8_t *)&header, sizeof(header));
 }
 
-void VoterClient::_sendGPSPacket() {
+void VoterClient::_sendGPSPacket(VoterHostSession &s) {
   // if (!_gps || !_gps->isLocked()) return; // FIXED: Don't return, send empty
   // if needed
   bool locked = (_gps && _gps->isLocked());
@@ -157,7 +333,7 @@ void VoterClient::_sendGPSPacket() {
   pkt.header.curtime.vtime_nsec = my_htonl(pkt.header.curtime.vtime_nsec);
 
   memcpy(pkt.header.challenge, _myChallenge, VOTER_CHALLENGE_LEN);
-  pkt.header.digest = my_htonl(_myDigest);
+  pkt.header.digest = my_htonl(s.myDigest);
   pkt.header.payload_type = my_htons(PAYLOAD_GPS);
 
   // 2. Location Payload
@@ -174,11 +350,13 @@ void VoterClient::_sendGPSPacket() {
   }
 
   // 3. Send
-  _net->sendPacket((uint8_t *)&pkt, sizeof(pkt));
+  _sendKeepalive(s, (uint8_t *)&pkt, sizeof(pkt));
 }
 
-void VoterClient::_handlePacket(const uint8_t *data, int len) {
+void VoterClient::_handlePacket(VoterHostSession &s, uint8_t *data, int len,
+                                uint8_t link) {
   VOTER_PACKET_HEADER *header = (VOTER_PACKET_HEADER *)data;
+  int host = (int)(&s - _hosts);
 
   // Check if challenge changed (New Session start) OR if it is an Auth Request
   char rcvChallenge[VOTER_CHALLENGE_LEN + 1];
@@ -190,101 +368,244 @@ void VoterClient::_handlePacket(const uint8_t *data, int len) {
   // my_ntohs(header->payload_type));
 
   bool newChallenge =
-      (strncmp(rcvChallenge, _serverChallenge, VOTER_CHALLENGE_LEN) != 0);
+      (strncmp(rcvChallenge, s.serverChallenge, VOTER_CHALLENGE_LEN) != 0);
   uint16_t type = my_ntohs(header->payload_type);
 
   if (newChallenge) {
-    Serial.printf("[Voter] New Server Challenge: %s\r\n", rcvChallenge);
-    memcpy(_serverChallenge, rcvChallenge, VOTER_CHALLENGE_LEN);
+    Serial.printf("[Voter] Host %d New Server Challenge: %s\r\n", host,
+                  rcvChallenge);
+    memcpy(s.serverChallenge, rcvChallenge, VOTER_CHALLENGE_LEN);
+    s.stats.challenges++;
 
     // Recalculate Digests
-    _myDigest = _crc32((uint8_t *)_serverChallenge, (uint8_t *)_clientPwd);
-    _serverDigest = _crc32((uint8_t *)_myChallenge, (uint8_t *)_hostPwd);
+    s.myDigest = _crc32((uint8_t *)s.serverChallenge, (uint8_t *)_clientPwd);
+    s.serverDigest = _crc32((uint8_t *)_myChallenge, (uint8_t *)_hostPwd);
 
     Serial.printf("[Voter] My Pwd: '%s' -> My Digest: 0x%08X\r\n", _clientPwd,
-                  _myDigest);
+                  s.myDigest);
     Serial.printf("[Voter] Hst Pwd: '%s' -> Svr Digest: 0x%08X\r\n", _hostPwd,
-                  _serverDigest);
+                  s.serverDigest);
 
     // Always reply to a NEW challenge immediately
-    _state = VOTER_DISCONNECTED;
-    _sendAuthPacket();
+    s.state = VOTER_DISCONNECTED;
+    _sendAuthPacket(s);
     return;
   }
 
   // Verify Server Digest
   uint32_t incomingDigest = my_ntohl(header->digest);
-  if (incomingDigest == _serverDigest) {
-    if (_state != VOTER_CONNECTED) {
+  if (incomingDigest == s.serverDigest) {
+    _net->confirmLink(link); // The host answers on this link
+    s.stats.packetsRx++;
+    s.stats.lastRxMs = millis();
+    s.silent = false;
+    if (s.state != VOTER_CONNECTED) {
       if (type != PAYLOAD_AUTH) { // Only transition on Data/Keepalive
         // Serial.println("[Voter] Connected to Host!");
-        _state = VOTER_CONNECTED;
-        _lastGPSSend = millis(); // Reset timer
+        s.state = VOTER_CONNECTED;
+        s.stats.connects++;
+        s.lastGPSSend = millis(); // Reset timer
       }
     }
+
+    if (type < VOTER_RX_TYPES)
+      _rx.byType[type]++;
+
+    switch (type) {
+    case PAYLOAD_ULAW:
+      _handleTxAudio(s, data, len);
+      break;
+    case PAYLOAD_PING:
+      if (s.state == VOTER_CONNECTED)
+        _handlePing(s, data, len);
+      break;
+    case PAYLOAD_AUTH:
+    case PAYLOAD_GPS:
+      break; // Keepalive: the digest check above is all there is
+    default:
+      _rx.dropType++;
+      break;
+    }
   } else {
     // If Digest Mismatch AND it was an AUTH packet, it might be a challenge we
     // missed or a retry
     if (type == PAYLOAD_AUTH) {
-      Serial.printf("[Voter] Auth Retry/Mismatch! Exp: 0x%08X Got: 0x%08X\r\n",
-                    _serverDigest, incomingDigest);
-      _sendAuthPacket();
+      Serial.printf(
+          "[Voter] Host %d Auth Retry/Mismatch! Exp: 0x%08X Got: 0x%08X\r\n",
+          host, s.serverDigest, incomingDigest);
+      _sendAuthPacket(s);
+    } else {
+      _rx.dropDigest++;
     }
   }
 }
 
-void VoterClient::processAudioFrame(uint8_t *ulawData, uint8_t rssi,
-                                    VTIME frameTime) {
-  if (_state != VOTER_CONNECTED)
+// Host TX audio (same layout as our uplink packets). With several hosts
+// keyed, the TX queue drops the duplicate frames.
+void VoterClient::_handleTxAudio(VoterHostSession &s, const uint8_t *data,
+                                 int len) {
+  if (s.state != VOTER_CONNECTED || !_txHandler ||
+      len < (int)sizeof(PROXY_AUDIO_PACKET))
     return;
+  const PROXY_AUDIO_PACKET *pkt = (const PROXY_AUDIO_PACKET *)data;
+  VTIME t;
+  t.vtime_sec = my_ntohl(pkt->header.curtime.vtime_sec);
+  t.vtime_nsec = my_ntohl(pkt->header.curtime.vtime_nsec);
+  _txHandler(t, pkt->audio);
+}
 
-  // Construct Packet
-  PROXY_AUDIO_PACKET pkt;
-  memset(&pkt, 0, sizeof(pkt));
+// Fill the static part of the audio packet headers: our challenge and the
+// payload type. Only the header is touched: a half-built ADPCM packet may
+// already be in the payload.
+void VoterClient::_buildAudioTemplates() {
+  memset(&_audioPkt.header, 0, sizeof(_audioPkt.header));
+  memcpy(_audioPkt.header.challenge, _myChallenge, VOTER_CHALLENGE_LEN);
+  _audioPkt.header.payload_type = my_htons(PAYLOAD_ULAW);
 
-  // 1. Header Standard Fields
-  // VOTER2 TIMING MIMIC: Use the exact timestamp passed from the main loop
-  // This trusts that the caller (main.cpp) has captured the time correctly
-  // at the moment the frame was generated/buffered.
+  memcpy(&_adpcmPkt.header, &_audioPkt.header, sizeof(_adpcmPkt.header));
+  _adpcmPkt.header.payload_type = my_htons(PAYLOAD_ADPCM);
 
-  if (_gps && _gps->isLocked()) {
-    pkt.header.curtime = frameTime;
+  _bytesCopied += 2 * sizeof(VOTER_PACKET_HEADER);
+}
 
-    // Optional: If you still wanted the 100ms backdate for latency
-    // compensation, you could do it here. For now, we use the RAW capture time
-    // as requested. To match the previous "Latency Profile" backdate:
-    if (pkt.header.curtime.vtime_nsec >= 100000000) {
-      pkt.header.curtime.vtime_nsec -= 100000000;
-    } else {
-      pkt.header.curtime.vtime_sec--;
-      pkt.header.curtime.vtime_nsec += 900000000;
-    }
+void VoterClient::_setAudioTime(VOTER_PACKET_HEADER *hdr, VTIME frameTime) {
+  // The caller's stamp goes out unchanged: the capture time of the frame's
+  // first sample (TIMING_GPS, 0 = no time yet) or local seconds + sequence
+  // number (TIMING_MIX). Network byte order.
+  hdr->curtime.vtime_sec = my_htonl(frameTime.vtime_sec);
+  hdr->curtime.vtime_nsec = my_htonl(frameTime.vtime_nsec);
+  _bytesCopied += sizeof(VTIME);
+}
 
-  } else {
-    // Fallback
-    pkt.header.curtime.vtime_sec = 0;
+// Send one built audio packet to every connected host, patching only the
+// digest in between (drivers take the pointer; nothing is staged).
+void VoterClient::_sendAudio(VOTER_PACKET_HEADER *hdr, int len) {
+  for (uint8_t i = 0; i < _hostCount; i++) {
+    VoterHostSession &s = _hosts[i];
+    if (s.state != VOTER_CONNECTED) {
+      s.stats.audioMissed++;
+      continue;
+    }
+    hdr->digest = my_htonl(s.myDigest);
+    _bytesCopied += sizeof(hdr->digest);
+    s.stats.audioSent++;
+    _sendTo(s, (const uint8_t *)hdr, len);
   }
+  _audioPackets++;
+}
 
-  // Network Byte Order for Time
-  pkt.header.curtime.vtime_sec = my_htonl(pkt.header.curtime.vtime_sec);
-  pkt.header.curtime.vtime_nsec = my_htonl(pkt.header.curtime.vtime_nsec);
+void VoterClient::processAudioFrame(const uint8_t *ulawData, uint8_t rssi,
+                                    VTIME frameTime) {
+  if (!isConnected())
+    return;
 
-  memcpy(pkt.header.challenge, _myChallenge, VOTER_CHALLENGE_LEN);
-  pkt.header.digest = my_htonl(_myDigest);
-  pkt.header.payload_type = my_htons(PAYLOAD_ULAW); // Always uLaw for now
+  // 1. Header: only the timestamp changes per frame
+  _setAudioTime(&_audioPkt.header, frameTime);
 
-  // 2. RSSI & Audio
-  pkt.rssi = rssi;
-  // pkt.audio is FRAME_SIZE (160 bytes)
-  memcpy(pkt.audio, ulawData, FRAME_SIZE);
+  // 2. RSSI & Audio (already in place if encoded into getAudioPayload())
+  _audioPkt.rssi = rssi;
+  _bytesCopied += 1;
+  if (ulawData != _audioPkt.audio) {
+    memcpy(_audioPkt.audio, ulawData, FRAME_SIZE);
+    _bytesCopied += FRAME_SIZE;
+  }
 
   // Debug: Print RSSI value every 100 packets
   // static int pktCount = 0;
   // if (++pktCount >= 100) {
-  //   Serial.printf("[Voter] Sending Audio: RSSI=%u, Size=%u\r\n", pkt.rssi,
-  //   sizeof(pkt)); pktCount = 0;
+  //   Serial.printf("[Voter] Sending Audio: RSSI=%u, Size=%u\r\n",
+  //   _audioPkt.rssi, sizeof(_audioPkt)); pktCount = 0;
   // }
 
-  // 3. Send
-  _net->sendPacket((uint8_t *)&pkt, sizeof(pkt));
+  // 3. Send (per-host digest patched in)
+  _sendAudio(&_audioPkt.header, sizeof(_audioPkt));
+}
+
+void VoterClient::processAdpcmFrame(const uint8_t *adpcmData, uint8_t rssi,
+                                    VTIME frameTime) {
+  if (!isConnected())
+    return;
+
+  _setAudioTime(&_adpcmPkt.header, frameTime);
+  _adpcmPkt.rssi = rssi;
+  _bytesCopied += 1;
+  if (adpcmData != _adpcmPkt.audio) {
+    memcpy(_adpcmPkt.audio, adpcmData, ADPCM_FRAME_SIZE);
+    _bytesCopied += ADPCM_FRAME_SIZE;
+  }
+
+  _sendAudio(&_adpcmPkt.header, sizeof(_adpcmPkt));
+}
+
+void VoterClient::startPing(uint16_t count, uint16_t intervalMs) {
+  for (uint8_t i = 0; i < _hostCount; i++) {
+    _hosts[i].pingHist.clear();
+    _hosts[i].pingPending = 0;
+    _hosts[i].pingsSent = 0;
+  }
+  _pingRemaining = count;
+  _pingIntervalMs = intervalMs ? intervalMs : 1;
+  _lastPingSend = millis() - _pingIntervalMs; // First one on the next update()
+}
+
+uint32_t VoterClient::getPingsLost(uint8_t host) const {
+  const VoterHostSession &s = _hosts[host];
+  return s.pingsSent - s.pingHist.getCount() -
+         __builtin_popcount(s.pingPending);
+}
+
+void VoterClient::_sendPing(VoterHostSession &s) {
+  PROXY_PING_PACKET pkt;
+  memset(&pkt, 0, sizeof(pkt));
+
+  memcpy(pkt.header.challenge, _myChallenge, VOTER_CHALLENGE_LEN);
+  pkt.header.digest = my_htonl(s.myDigest);
+  pkt.header.payload_type = my_htons(PAYLOAD_PING);
+
+  // GPS time goes in the header (as on every packet) and the payload, so the
+  // host can split the RTT into up/down legs if its own clock is GPS/NTP
+  // disciplined. The RTT itself is measured on micros(), which does not step
+  // when the PPS corrects the interpolated time.
+  if (_gps && _gps->isLocked())
+    _gps->getNetworkTime(&pkt.ping.txtime);
+  pkt.ping.txtime.vtime_sec = my_htonl(pkt.ping.txtime.vtime_sec);
+  pkt.ping.txtime.vtime_nsec = my_htonl(pkt.ping.txtime.vtime_nsec);
+  pkt.header.curtime = pkt.ping.txtime;
+
+  pkt.ping.magic = my_htonl(PING_MAGIC);
+  pkt.ping.seq = my_htonl(_pingSeq);
+
+  // Anything still in flight from VOTER_PING_WINDOW pings ago is lost
+  uint32_t bit = 1u << (_pingSeq % VOTER_PING_WINDOW);
+  s.pingPending |= bit;
+  s.pingsSent++;
+
+  pkt.ping.txMicros = my_htonl(micros());
+  _sendTo(s, (const uint8_t *)&pkt, sizeof(pkt));
+}
+
+void VoterClient::_handlePing(VoterHostSession &s, uint8_t *data, int len) {
+  const PROXY_PING_PACKET *pkt = (const PROXY_PING_PACKET *)data;
+
+  // 1. Echo of one of ours
+  if (len >= (int)sizeof(PROXY_PING_PACKET) &&
+      my_ntohl(pkt->ping.magic) == PING_MAGIC) {
+    uint32_t rxMicros = micros();
+    uint32_t seq = my_ntohl(pkt->ping.seq);
+    uint32_t age = _pingSeq - 1 - seq; // 0 = most recent
+    uint32_t bit = 1u << (seq % VOTER_PING_WINDOW);
+    if (age < VOTER_PING_WINDOW && (s.pingPending & bit)) {
+      s.pingPending &= ~bit;
+      s.pingHist.add(rxMicros - my_ntohl(pkt->ping.txMicros));
+    }
+    return; // Stale or duplicate otherwise
+  }
+
+  // 2. Host ping: send it straight back under our own signature (in place,
+  // the pool slot is ours until the next update())
+  VOTER_PACKET_HEADER *hdr = (VOTER_PACKET_HEADER *)data;
+  memcpy(hdr->challenge, _myChallenge, VOTER_CHALLENGE_LEN);
+  hdr->digest = my_htonl(s.myDigest);
+  _pingsEchoed++;
+  _sendTo(s, data, len);
 }
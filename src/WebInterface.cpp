@@ -45,6 +45,14 @@ void WebInterface::update() {
                 client.println("Location: /");
                 client.println();
             }
+            else if (request.indexOf("GET /ping") >= 0) {
+                // Start a latency burst, results show on the status card
+                if (_voter->isConnected() && !_voter->isPinging())
+                    _voter->startPing(VOTER_PING_COUNT, VOTER_PING_INTERVAL_MS);
+                client.println("HTTP/1.1 303 See Other");
+                client.println("Location: /");
+                client.println();
+            }
             else {
                 // Serve Page
                 _handleRequest(client);
@@ -75,11 +83,39 @@ void WebInterface::_handleRequest(EthernetClient& client) {
     else client.print(F("<span class='bad'>SEARCHING</span>"));
     client.println(F("</span><br>"));
 
-    // Voter
-    client.print(F("Host: <span class='stat'>"));
-    if (_voter->isConnected()) client.print(F("<span class='ok'>CONNECTED</span>"));
-    else client.print(F("<span class='bad'>DISCONNECTED</span>"));
-    client.println(F("</span><br>"));
+    // Voter (one line per host session)
+    for (uint8_t h = 0; h < _voter->getHostCount(); h++) {
+        const VoterHostSession& s = _voter->getHost(h);
+        client.printf("Host %u (%d.%d.%d.%d:%u): <span class='stat'>", h,
+                      s.ip[0], s.ip[1], s.ip[2], s.ip[3], s.port);
+        if (s.state == VOTER_CONNECTED) client.print(F("<span class='ok'>CONNECTED</span>"));
+        else client.print(F("<span class='bad'>DISCONNECTED</span>"));
+        client.printf("</span> %lu connects, %lu audio sent, %lu missed<br>",
+                      (unsigned long)s.stats.connects,
+                      (unsigned long)s.stats.audioSent,
+                      (unsigned long)s.stats.audioMissed);
+
+        // Host Round Trip (PAYLOAD_PING)
+        const LatencyHistogram& rtt = s.pingHist;
+        client.print(F("&nbsp;&nbsp;Ping RTT: <span class='stat'>"));
+        if (rtt.getCount()) {
+            client.printf("%.2f / %.2f / %.2f ms", rtt.getMin() / 1000.0f,
+                          rtt.getMean() / 1000.0f, rtt.getMax() / 1000.0f);
+            client.print(F("</span> (min/avg/max), p50 "));
+            client.printf("%.2f, p90 %.2f, p99 %.2f ms, %lu/%lu replies, %lu lost",
+                          rtt.getPercentile(50) / 1000.0f,
+                          rtt.getPercentile(90) / 1000.0f,
+                          rtt.getPercentile(99) / 1000.0f,
+                          (unsigned long)rtt.getCount(),
+                          (unsigned long)_voter->getPingsSent(h),
+                          (unsigned long)_voter->getPingsLost(h));
+        } else {
+            client.print(F("--</span>"));
+        }
+        client.println(F("<br>"));
+    }
+    if (_voter->isPinging()) client.println(F("<i>Ping running...</i><br>"));
+    else client.println(F("<a href='/ping'>[Ping Hosts]</a><br>"));
     
     // Config
     IPAddress ip = Ethernet.localIP();
@@ -100,6 +136,15 @@ void WebInterface::_handleRequest(EthernetClient& client) {
     client.print(_cfg->data.hostPort);
     client.println(F("' required>"));
     
+    // Backup Host (0.0.0.0 = none)
+    IPAddress backup(_cfg->data.backupHostIP);
+    client.println(F("Backup Host IP (0.0.0.0 = none):<br><input name='ip2' value='"));
+    client.printf("%d.%d.%d.%d", backup[0], backup[1], backup[2], backup[3]);
+    client.println(F("'>"));
+    client.println(F("Backup Port:<br><input name='port2' type='number' value='"));
+    client.print(_cfg->data.backupHostPort);
+    client.println(F("'>"));
+
     // RSSI Mode
     client.println(F("RSSI Mode:<br><select name='rssiam' style='width:100%;padding:8px;margin-bottom:15px'>"));
     client.print(F("<option value='0'")); if(!_cfg->data.useHwRSSI) client.print(" selected"); client.println(F(">Software (DSP)</option>"));
@@ -147,6 +192,26 @@ void WebInterface::_parseParams(String& body) {
         _cfg->data.hostPort = val.toInt();
     }
     
+    // Backup Host
+    idx = body.indexOf("ip2=");
+    if (idx != -1) {
+        String val = body.substring(idx + 4);
+        int end = val.indexOf('&');
+        if (end != -1) val = val.substring(0, end);
+        val = _urlDecode(val);
+
+        IPAddress newIP;
+        if (newIP.fromString(val)) _cfg->data.backupHostIP = (uint32_t)newIP;
+    }
+
+    idx = body.indexOf("port2=");
+    if (idx != -1) {
+        String val = body.substring(idx + 6);
+        int end = val.indexOf('&');
+        if (end != -1) val = val.substring(0, end);
+        if (val.toInt() > 0) _cfg->data.backupHostPort = val.toInt();
+    }
+
     // RSSI
     idx = body.indexOf("rssiam=");
     if (idx != -1) {
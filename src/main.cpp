@@ -9,11 +9,21 @@
   - TinyGPSPlus
 */
 
+#include "Adpcm.h"
 #include "ConfigManager.h"
+#include "CtcssDecoder.h"
 #include "DSPProcessor.h"
+#include "FrameClock.h"
+#include "LatencyHistogram.h"
+#include "AudioVoterFrameQueue.h"
+#include "AudioVoterTxQueue.h"
 #include "EspSpiDriver.h"
+#include "EthernetDriver.h"
 #include "GPSManager.h"
 #include "NetworkManager.h"
+#include "PpsDiscipline.h"
+#include "Resampler.h"
+#include "ULaw.h"
 #include "VoterClient.h"
 #include "VoterProtocol.h"
 #include "WebInterface.h"
@@ -22,33 +32,29 @@
 #include <NativeEthernet.h>
 #include <SPI.h>
 #include <Wire.h>
-#include <arm_math.h> // CMSIS DSP Library for FIR decimator
+#include <arm_math.h> // CMSIS DSP Library
 
 #define RSSI_PIN A14 // Connect to voltage divider output (0-3.3V)
 #define COS_PIN 41   // Hardware COS input (active HIGH/LOW depending on radio)
 #define PIN_DEBUG_TX 3 // Debug / oscilloscope pin
 #define PPS_PIN 2      // GPS PPS Input
+#define PTT_PIN 40     // Transmitter PTT output (active HIGH)
 // #define WIFI_SERIAL Serial5 // REMOVED (Conflicted with GPS)
 #define GPS_SERIAL Serial1 // GPS Module RX/TX (Pins 0/1)
 
 // --- Global State ---
 float g_headphoneVol = 0.5f;
 bool g_testToneMode = false;
-float g_testTonePhase = 0.0f;
-
-// CMSIS FIR Decimator for 44.1kHz -> 8kHz (factor ~5.5)
-// We'll use decimation factor of 6 (44.1kHz / 6 = 7.35kHz, close enough)
-#define DECIMATION_FACTOR 6
-#define DECIMATOR_NUM_TAPS 48 // FIR filter taps for anti-aliasing
-arm_fir_decimate_instance_f32 decimator;
-float decimatorState[AUDIO_BLOCK_SAMPLES + DECIMATOR_NUM_TAPS - 1];
-float decimatorCoeffs[DECIMATOR_NUM_TAPS];
-float decimatorInputBuf[256];
-int decimatorInputLen = 0;
-
-// Buffer for 8kHz downsampled audio
-int16_t accumulationBuf[512]; // Circular-ish buffer for outgoing samples
-int accHead = 0;
+
+// Polyphase Resampler Phase Table for 44.1kHz -> 8kHz (see Resampler.h)
+// Designed at compile time. Shared by the frame queue (audio ISR) and the CLI
+// benchmark.
+constexpr DownsampleTable resampleTable = DownsampleTable::design(
+    RESAMPLER_CUTOFF / AUDIO_SAMPLE_RATE_EXACT, RESAMPLER_BETA);
+
+// 8kHz -> 44.1kHz for host TX audio (cutoff relative to the 8kHz input)
+constexpr UpsampleTable upsampleTable =
+    UpsampleTable::design(UPSAMPLER_CUTOFF / 8000.0, UPSAMPLER_BETA);
 
 // --- Configuration (Managed by ConfigManager) ---
 // const char* CLIENT_PWD = "password"; (Removed)
@@ -59,30 +65,51 @@ int accHead = 0;
 // --- Audio System ---
 AudioInputI2S i2s_in;
 AudioMixer4 mixer1;
-AudioRecordQueue recordQueue;
-AudioOutputI2S i2s_out; // Defined before connections
+AudioVoterFrameQueue voterFrames; // Resample + 20ms framing in the audio ISR
+AudioVoterTxQueue txAudio;        // Host TX audio, GPS-timed playout
+AudioOutputI2S i2s_out;           // Defined before connections
+AudioSynthWaveformSine sine1;     // Test tone source (mixer input 1)
 
 AudioConnection patchCord1(i2s_in, 0, mixer1, 0); // L -> Mixer
-AudioConnection patchCord4(i2s_in, 0, i2s_out,
-                           0); // Left In -> Left Out (Monitoring)
+AudioConnection patchCord4(txAudio, 0, i2s_out,
+                           0); // TX Audio -> Left Out (Transmitter)
 AudioConnection patchCord5(i2s_in, 0, i2s_out,
-                           1); // Left In -> Right Out (Mono Mix)
-AudioConnection patchCord3(mixer1, 0, recordQueue,
-                           0); // Mixer -> Queue (CRITICAL FOR DSP)
-
-AudioSynthWaveformSine sine1;
-// AudioConnection patchCord6(sine1, 0, i2s_out, 1); // Tone Disabled
+                           1); // Left In -> Right Out (Monitoring)
+AudioConnection patchCord3(mixer1, 0, voterFrames,
+                           0); // Mixer -> Frame Queue (CRITICAL FOR DSP)
+AudioConnection patchCord6(sine1, 0, mixer1, 1); // Test Tone -> Mixer
 
 AudioControlSGTL5000 sgtl5000_1;
 
 // --- Global Objects ---
-// Select your Active Driver Here:
-// EthernetDriver ethDriver;
+// Network links in use: SysConfig.netLinks (CLI [Y], applied at boot)
+EthernetDriver ethDriver;
 EspSpiDriver spiDriver(26, 24, 25); // CS=26 (Uncovered), Ready=24, Reset=25
 NetworkManager netMgr;
+uint8_t g_netLinks = NET_LINKS_WIFI; // Started at boot (cfg may differ)
+
+// spiDriver is only started when a WiFi link is in use
+static bool wifiLinkInUse() { return g_netLinks != NET_LINKS_ETH; }
+
+static const char *netLinksName(uint8_t links) {
+  return links == NET_LINKS_ETH        ? "Ethernet"
+         : links == NET_LINKS_ETH_WIFI ? "Ethernet + WiFi backup"
+                                       : "WiFi (ESP32)";
+}
 GPSManager gpsMgr;
 VoterClient voter;
-DSPProcessor dsp;
+VoterFrameDSP dsp; // 160-sample Voter frames
+CtcssDecoder ctcss;
+FrameClock frameClock; // Frame timestamps (GPS / holdover / mix mode)
+LatencyHistogram g_captureLag; // ADC capture -> loop(): what a loop() stamp
+                               // would have carried
+
+// ADPCM uplink: one packet carries two frames, encoded straight into the
+// VoterClient packet. The first frame's timestamp and RSSI are held until the
+// second is encoded.
+bool g_adpcmHalf = false; // First frame encoded, waiting for the second
+VTIME g_adpcmTime;
+uint8_t g_adpcmRSSI;
 WebInterface web;
 ConfigManager cfg;
 
@@ -95,25 +122,349 @@ bool g_noSignalMode =
 // -----------------------------------------------------------------------------
 // Helper: Reset Audio State
 // -----------------------------------------------------------------------------
+// Downlink audio from VoterClient -> jitter buffer
+void handleTxAudio(const VTIME &frameTime, const uint8_t *ulaw) {
+  txAudio.write(frameTime, ulaw);
+}
+
+// PPS interrupt -> frame queue (re-anchors the 20ms frame grid)
+void handlePps(uint32_t ppsMicros) { voterFrames.ppsEdge(ppsMicros); }
+
 void resetAudioState() {
-  // Clear DSP filters
-  // dsp.reset(); // If DSP class has reset
+  // Clear DSP filters (and ADPCM encoder state)
+  dsp.reset();
+  g_adpcmHalf = false;
 
-  // Reset decimation
-  accHead = 0;
-  g_testTonePhase = 0.0f;
+  // Clear Resampler History, Partial Frame & Queued Frames
+  voterFrames.clear();
+  Serial.println("Audio State Reset");
+}
 
-  // Clear Decimator State (Filter History)
-  // This resets the internal state of the CMSIS filter
-  memset(decimatorState, 0, sizeof(decimatorState));
+// -----------------------------------------------------------------------------
+// Helper: Route Test Tone (1kHz @ 5000 peak) or Radio Audio into mixer1
+// -----------------------------------------------------------------------------
+void applyTestTone() {
+  if (g_testToneMode) {
+    sine1.frequency(1000);
+    sine1.amplitude(5000.0f / 32768.0f);
+    mixer1.gain(0, 0.0); // Mute radio input
+    mixer1.gain(1, 1.0); // Tone (unity gain)
+  } else {
+    sine1.amplitude(0.0);
+    mixer1.gain(0, 0.5); // Left Channel
+    mixer1.gain(1, 0.0);
+  }
+}
 
-  // Clear Input Buffer
-  decimatorInputLen = 0;
-  // memset(decimatorInputBuf, 0, sizeof(decimatorInputBuf)); // Optional
+// -----------------------------------------------------------------------------
+// Helper: DSP Benchmark (Cycle Counts & Filter Quality)
+// -----------------------------------------------------------------------------
+// Feeds a tone through a private resampler instance (sharing the live phase
+// table) and returns the output RMS. Cycle count is accumulated via the DWT.
+static float benchResampleTone(Downsampler &rs, float freq, uint32_t *cycles,
+                               int *outputs) {
+  static int16_t in[128];
+  static int16_t out[Downsampler::maxOutput(AUDIO_SAMPLE_RATE_EXACT / 8000.0)];
+  const int blocks = 200;
+  const int warmup = 10; // Let the filter history fill
+  float phase = 0.0f;
+  const float inc = 2.0f * PI * freq / AUDIO_SAMPLE_RATE_EXACT;
+  double energy = 0.0;
+  int count = 0;
+
+  rs.reset();
+  for (int b = 0; b < blocks; b++) {
+    for (int i = 0; i < 128; i++) {
+      in[i] = (int16_t)(10000.0f * sinf(phase));
+      phase += inc;
+      if (phase >= 2.0f * PI)
+        phase -= 2.0f * PI;
+    }
+    uint32_t start = ARM_DWT_CYCCNT;
+    int n = rs.process(in, 128, out, (int)(sizeof(out) / sizeof(out[0])));
+    *cycles += ARM_DWT_CYCCNT - start;
+    *outputs += n;
+    if (b >= warmup) {
+      for (int i = 0; i < n; i++)
+        energy += (double)out[i] * out[i];
+      count += n;
+    }
+  }
+  return (count > 0) ? sqrtf(energy / count) : 0.0f;
+}
 
-  memset(accumulationBuf, 0, sizeof(accumulationBuf));
-  recordQueue.clear();
-  Serial.println("Audio State Reset");
+static const char *dspEngineName(uint8_t engine) {
+  switch (engine) {
+  case DSP_ENGINE_Q15:
+    return "Q15";
+  case DSP_ENGINE_FUSED:
+    return "FUSED";
+  default:
+    return "FLOAT";
+  }
+}
+
+// Runs the same test frames (two tones + noise) through every DSP engine.
+// Reports best-case cycles per frame (audio ISRs may preempt any one frame)
+// and how far each engine strays from the multi-pass float reference.
+static void benchDspEngines() {
+  const uint8_t engines[] = {DSP_ENGINE_FLOAT, DSP_ENGINE_Q15,
+                             DSP_ENGINE_FUSED};
+  const int numEngines = sizeof(engines) / sizeof(engines[0]);
+  static VoterFrameDSP proc[numEngines];
+  static int16_t frame[numEngines][FRAME_SIZE];
+  const int frames = 100;
+  const int warmup = 5; // Let the FIR history fill
+  uint32_t best[numEngines];
+  double err[numEngines];
+  int maxDiff[numEngines], maxRssiDiff[numEngines];
+  double sig = 0.0;
+  uint32_t noise = 12345;
+  float phase = 0.0f;
+  const float inc = 2.0f * PI * 700.0f / 8000.0f;
+
+  for (int e = 0; e < numEngines; e++) {
+    proc[e].begin();
+    proc[e].setEngine(engines[e]);
+    proc[e].reset();
+    best[e] = UINT32_MAX;
+    err[e] = 0.0;
+    maxDiff[e] = 0;
+    maxRssiDiff[e] = 0;
+  }
+
+  for (int f = 0; f < frames; f++) {
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      noise = noise * 1664525u + 1013904223u; // LCG
+      frame[0][i] =
+          (int16_t)(8000.0f * sinf(phase) + 3000.0f * sinf(3.3f * phase) +
+                    (float)((int32_t)(noise >> 22) - 512));
+      phase += inc;
+      if (phase >= 2.0f * PI)
+        phase -= 2.0f * PI;
+    }
+    for (int e = 1; e < numEngines; e++)
+      memcpy(frame[e], frame[0], sizeof(frame[0]));
+
+    uint8_t rssi[numEngines];
+    for (int e = 0; e < numEngines; e++) {
+      uint32_t start = ARM_DWT_CYCCNT;
+      rssi[e] = proc[e].process(frame[e], true, true);
+      uint32_t cycles = ARM_DWT_CYCCNT - start;
+      if (cycles < best[e])
+        best[e] = cycles;
+    }
+
+    if (f < warmup)
+      continue;
+    for (int i = 0; i < FRAME_SIZE; i++)
+      sig += (double)frame[0][i] * frame[0][i];
+    for (int e = 1; e < numEngines; e++) {
+      int rd = abs((int)rssi[0] - (int)rssi[e]);
+      if (rd > maxRssiDiff[e])
+        maxRssiDiff[e] = rd;
+      for (int i = 0; i < FRAME_SIZE; i++) {
+        int d = abs((int)frame[0][i] - (int)frame[e][i]);
+        if (d > maxDiff[e])
+          maxDiff[e] = d;
+        err[e] += (double)d * d;
+      }
+    }
+  }
+
+  for (int e = 0; e < numEngines; e++) {
+    Serial.printf("DSP %-6s: %lu cycles/frame (%.2f%% CPU)\r\n",
+                  dspEngineName(engines[e]), (unsigned long)best[e],
+                  best[e] * 50.0f * 100.0f / F_CPU_ACTUAL);
+    if (e == 0)
+      continue;
+    Serial.printf("  vs FLOAT: max %d LSB, SNR %.1f dB, RSSI diff %d\r\n",
+                  maxDiff[e],
+                  (err[e] > 0.0) ? 10.0f * log10f(sig / err[e]) : 120.0f,
+                  maxRssiDiff[e]);
+  }
+}
+
+// Cost of the spectral squelch (window + 256-point RFFT + band powers) on top
+// of the active engine, against the 20ms frame budget.
+static void benchSpectral() {
+  static VoterFrameDSP proc;
+  static int16_t frame[FRAME_SIZE];
+  const int frames = 50;
+  uint32_t best[2] = {UINT32_MAX, UINT32_MAX};
+  uint32_t noise = 777;
+
+  proc.begin();
+  proc.setEngine(cfg.data.dspEngine);
+  for (int pass = 0; pass < 2; pass++) {
+    proc.setSpectralSquelch(pass == 1);
+    for (int f = 0; f < frames; f++) {
+      for (int i = 0; i < FRAME_SIZE; i++) {
+        noise = noise * 1664525u + 1013904223u;
+        frame[i] = (int16_t)((int32_t)(noise >> 20) - 2048);
+      }
+      uint32_t start = ARM_DWT_CYCCNT;
+      proc.process(frame, true, true);
+      uint32_t cycles = ARM_DWT_CYCCNT - start;
+      if (cycles < best[pass])
+        best[pass] = cycles;
+    }
+  }
+  proc.setSpectralSquelch(false);
+
+  uint32_t spectral = best[1] - best[0];
+  float frameCycles = F_CPU_ACTUAL / 50.0f; // 20ms
+  Serial.printf("Spectral  : %lu cycles/frame (%.2f%% of 20ms frame)\r\n",
+                (unsigned long)spectral, spectral * 100.0f / frameCycles);
+  Serial.printf("  DSP+Spectral total %.2f%% of frame\r\n",
+                best[1] * 100.0f / frameCycles);
+}
+
+// Per-frame cost of the 50-tone CTCSS Goertzel bank
+static void benchCtcss() {
+  static CtcssDecoder bench;
+  static int16_t frame[FRAME_SIZE];
+  const int frames = 100;
+  uint32_t best = UINT32_MAX, total = 0;
+  float phase = 0.0f;
+  const float inc = 2.0f * PI * 100.0f / 8000.0f;
+
+  bench.begin(12, 10); // 100.0Hz
+  for (int f = 0; f < frames; f++) {
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      frame[i] = (int16_t)(1500.0f * sinf(phase));
+      phase += inc;
+      if (phase >= 2.0f * PI)
+        phase -= 2.0f * PI;
+    }
+    uint32_t start = ARM_DWT_CYCCNT;
+    bench.process(frame, FRAME_SIZE);
+    uint32_t cycles = ARM_DWT_CYCCNT - start;
+    total += cycles;
+    if (cycles < best)
+      best = cycles;
+  }
+
+  float frameCycles = F_CPU_ACTUAL / 50.0f; // 20ms
+  Serial.printf("CTCSS     : %lu cycles/frame best, %lu avg (%.2f%% of "
+                "frame), detect %s\r\n",
+                (unsigned long)best, (unsigned long)(total / frames),
+                (total / frames) * 100.0f / frameCycles,
+                bench.isDetected() ? "OK" : "FAIL");
+}
+
+// Exhaustive G.711 check of the CLZ u-Law encoder against the reference table
+// search, plus throughput of both over all 65536 inputs.
+static void benchULaw() {
+  volatile uint8_t sink = 0; // Keep the loops from being optimized away
+  uint8_t acc = 0;
+  uint32_t start = ARM_DWT_CYCCNT;
+  for (int32_t x = -32768; x <= 32767; x++)
+    acc ^= ulawEncodeRef((int16_t)x);
+  uint32_t refCycles = ARM_DWT_CYCCNT - start;
+  start = ARM_DWT_CYCCNT;
+  for (int32_t x = -32768; x <= 32767; x++)
+    acc ^= ulawEncode((int16_t)x);
+  uint32_t clzCycles = ARM_DWT_CYCCNT - start;
+  sink = acc;
+  (void)sink;
+
+  Serial.printf("uLaw      : Ref %.2f / CLZ %.2f cycles/sample\r\n",
+                refCycles / 65536.0f, clzCycles / 65536.0f);
+}
+
+// ADPCM vs uLaw uplink codec: encode cost per 20ms frame and round-trip SNR
+// on the same tone + noise signal as the engine benchmark.
+static void benchAdpcm() {
+  static VoterFrameDSP enc; // Only the ADPCM state is used
+  const int frames = 100;
+  int16_t frame[FRAME_SIZE];
+  uint8_t ulaw[FRAME_SIZE];
+  uint8_t adpcm[FRAME_SIZE / 2];
+  AdpcmState dec = {0, 0};
+  uint32_t bestULaw = UINT32_MAX, bestAdpcm = UINT32_MAX;
+  double sig = 0.0, errULaw = 0.0, errAdpcm = 0.0;
+  uint32_t noise = 12345;
+  float phase = 0.0f;
+  const float inc = 2.0f * PI * 700.0f / 8000.0f;
+
+  enc.reset();
+  for (int f = 0; f < frames; f++) {
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      noise = noise * 1664525u + 1013904223u; // LCG
+      frame[i] =
+          (int16_t)(8000.0f * sinf(phase) + 3000.0f * sinf(3.3f * phase) +
+                    (float)((int32_t)(noise >> 22) - 512));
+      phase += inc;
+      if (phase >= 2.0f * PI)
+        phase -= 2.0f * PI;
+    }
+
+    uint32_t start = ARM_DWT_CYCCNT;
+    enc.encodeULaw(frame, ulaw, FRAME_SIZE);
+    uint32_t cycles = ARM_DWT_CYCCNT - start;
+    if (cycles < bestULaw)
+      bestULaw = cycles;
+
+    start = ARM_DWT_CYCCNT;
+    enc.encodeADPCM(frame, adpcm, FRAME_SIZE);
+    cycles = ARM_DWT_CYCCNT - start;
+    if (cycles < bestAdpcm)
+      bestAdpcm = cycles;
+
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      uint8_t code = (i & 1) ? (adpcm[i / 2] & 0x0F) : (adpcm[i / 2] >> 4);
+      double du = (double)frame[i] - ulawDecode(ulaw[i]);
+      double da = (double)frame[i] - adpcmDecodeSample(&dec, code);
+      sig += (double)frame[i] * frame[i];
+      errULaw += du * du;
+      errAdpcm += da * da;
+    }
+  }
+
+  Serial.printf("Codec     : uLaw %lu / ADPCM %lu cycles/frame best\r\n",
+                (unsigned long)bestULaw, (unsigned long)bestAdpcm);
+  Serial.printf("  Round trip SNR uLaw %.1f dB / ADPCM %.1f dB\r\n",
+                (errULaw > 0.0) ? 10.0 * log10(sig / errULaw) : 99.0,
+                (errAdpcm > 0.0) ? 10.0 * log10(sig / errAdpcm) : 99.0);
+}
+
+void runDspBenchmark() {
+  static Downsampler bench;
+  bench.begin(&resampleTable, AUDIO_SAMPLE_RATE_EXACT / 8000.0);
+
+  Serial.println("\r\n--- DSP Benchmark ---");
+
+  // 1. Resampler: cost per output sample & aliasing rejection
+  uint32_t cycles = 0;
+  int outputs = 0;
+  float ref = benchResampleTone(bench, 1000.0f, &cycles, &outputs);
+  float cyclesPerOut = (float)cycles / (float)outputs;
+  Serial.printf("Resampler : %.1f cycles/output (%.2f%% CPU @ 8kHz)\r\n",
+                cyclesPerOut, cyclesPerOut * 8000.0f * 100.0f / F_CPU_ACTUAL);
+
+  const float aliasFreqs[] = {4500.0f, 5000.0f, 6000.0f, 10000.0f, 15000.0f};
+  for (float f : aliasFreqs) {
+    float rms = benchResampleTone(bench, f, &cycles, &outputs);
+    float db = (rms > 0.0f) ? 20.0f * log10f(rms / ref) : -120.0f;
+    Serial.printf("  Alias %5.0f Hz : %6.1f dB\r\n", f, db);
+  }
+
+  // 2. Voter frame DSP: float vs Q15 engine (same input, PL + de-emphasis)
+  benchDspEngines();
+
+  // 3. Spectral squelch budget
+  benchSpectral();
+
+  // 4. CTCSS decoder
+  benchCtcss();
+
+  // 5. uLaw encoder
+  benchULaw();
+
+  // 6. Uplink codecs
+  benchAdpcm();
+  Serial.println("---------------------\r");
 }
 
 // Helper for proper input echo
@@ -152,6 +503,13 @@ void printMenu() {
   Serial.println("\r========================================");
   Serial.printf(" [1] Host IP     : %-15s\r\n", ipStr);
   Serial.printf(" [2] Host Port   : %-5u\r\n", cfg.data.hostPort);
+  if (cfg.data.backupHostIP) {
+    IPAddress b(cfg.data.backupHostIP);
+    Serial.printf(" [K] Backup Host : %u.%u.%u.%u:%u\r\n", b[0], b[1], b[2],
+                  b[3], cfg.data.backupHostPort);
+  } else {
+    Serial.println(" [K] Backup Host : (none)");
+  }
   Serial.printf(" [3] RSSI Mode   : %s\r\n",
                 cfg.data.useHwRSSI ? "HARDWARE (Analog)" : "SOFTWARE (DSP)");
   Serial.printf(" [4] Client PWD  : %s\r\n", cfg.data.clientPwd);
@@ -159,8 +517,16 @@ void printMenu() {
   Serial.printf(" [6] COS Mode    : %s\r\n",
                 cfg.data.cosMode == COS_MODE_ALWAYS_ON  ? "Always On"
                 : cfg.data.cosMode == COS_MODE_HARDWARE ? "Hardware GPIO"
+                : cfg.data.cosMode == COS_MODE_SPECTRAL ? "Spectral SNR"
+                : cfg.data.cosMode == COS_MODE_CTCSS    ? "CTCSS Tone"
                                                         : "DSP Squelch");
-  Serial.printf(" [7] DSP Squelch : %u\r\n", cfg.data.dspSquelchThresh);
+  if (cfg.data.cosMode == COS_MODE_SPECTRAL)
+    Serial.printf(" [7] SNR Squelch : %u dB\r\n", cfg.data.spectralSnrThresh);
+  else
+    Serial.printf(" [7] DSP Squelch : %u\r\n", cfg.data.dspSquelchThresh);
+  Serial.printf(" [P] CTCSS Tone  : %.1f Hz (%u ms detect)\r\n",
+                CtcssDecoder::toneHz(cfg.data.ctcssTone),
+                cfg.data.ctcssWindow * 20);
   Serial.printf(" [R] Sim RSSI    : %u\r\n", g_simRSSI);
   Serial.printf(" [N] No Signal   : %s\r\n",
                 g_noSignalMode ? "ON (No Audio)" : "OFF");
@@ -171,6 +537,18 @@ void printMenu() {
                 cfg.data.inputSource == AUDIO_INPUT_MIC ? "MIC" : "LINE IN");
   Serial.printf(" [T] Test Tone    : %s\r\n",
                 g_testToneMode ? "ON (1kHz sine wave)" : "OFF");
+  Serial.printf(" [E] DSP Engine   : %s\r\n",
+                dspEngineName(cfg.data.dspEngine));
+  Serial.printf(" [U] Uplink Codec : %s\r\n",
+                cfg.data.codec == CODEC_ADPCM ? "ADPCM (40ms)" : "uLaw (20ms)");
+  Serial.printf(" [X] TX Delay     : %u ms\r\n", cfg.data.txDelayMs);
+  Serial.printf(" [F] Frame Timing : %s\r\n",
+                cfg.data.timingMode == TIMING_MIX ? "MIX (no GPS)"
+                                                  : "GPS + holdover");
+  Serial.printf(" [J] PPS Align    : %s\r\n",
+                !cfg.data.ppsAlign          ? "OFF"
+                : voterFrames.isPpsAligned() ? "ON (aligned)"
+                                             : "ON (no PPS)");
   Serial.println("----------------------------------------");
   Serial.printf(" [8] Cal Min RSSI: %u (Current: %d)\r\n", cfg.data.rssiMin,
                 analogRead(RSSI_PIN));
@@ -182,6 +560,20 @@ void printMenu() {
   Serial.println("\r [M] Refresh Menu");
   Serial.println("\r [I] GPS Status");
   Serial.println("\r [D] Signal Monitor (Live Dashboard)");
+  Serial.println("\r [A] Audio Status");
+  Serial.println("\r [B] DSP Benchmark");
+  Serial.println("\r [Q] Ping Host (RTT)");
+  Serial.println("\r [V] Voter Host Status");
+  Serial.println("\r [W] ESP32 SPI Status");
+  Serial.printf("\r [Z] ESP32 SPI TX   : %s\r\n",
+                spiDriver.isAsync() ? "DMA queue" : "Blocking");
+  Serial.println("\r [O] Network Link Status");
+  Serial.printf("\r [0] Link Bonding   : %s\r\n",
+                cfg.data.netBond == NET_BOND_DUPLICATE ? "Duplicate"
+                                                       : "Failover");
+  Serial.printf("\r [Y] Network Links  : %s%s\r\n",
+                netLinksName(cfg.data.netLinks),
+                cfg.data.netLinks != g_netLinks ? " (after Save & Reboot)" : "");
   Serial.println("========================================\r\n");
   Serial.print("> ");
 }
@@ -192,6 +584,10 @@ void handleSerialCLI() {
     switch (c) {
     case 'c':
     case 'C':
+      if (!wifiLinkInUse()) {
+        Serial.println("\nWiFi link not in use ([Y])");
+        break;
+      }
       Serial.println("\nResending WiFi Credentials...");
       spiDriver.setCredentials("ImWatchinYou", "n0Password");
       break;
@@ -199,6 +595,111 @@ void handleSerialCLI() {
     case 'M':
       printMenu();
       break;
+    case 'w':
+    case 'W': {
+      if (!wifiLinkInUse()) {
+        Serial.println("\nWiFi link not in use ([Y])");
+        break;
+      }
+      // Figures for the current TX mode ([Z] switches it and clears them)
+      const EspSpiTxStats &t = spiDriver.getTxStats();
+      Serial.printf("\r\n--- ESP32 SPI TX (%s) ---\r\n",
+                    spiDriver.isAsync() ? "DMA queue" : "Blocking");
+      Serial.printf("Packets   : %lu (%lu bytes), %lu too long\r\n",
+                    (unsigned long)t.packets, (unsigned long)t.bytes,
+                    (unsigned long)t.tooLong);
+      Serial.printf("Loop time : %.1f us avg, %lu us max per packet\r\n",
+                    t.packets ? (float)t.callUsTotal / t.packets : 0.0f,
+                    (unsigned long)t.callUsMax);
+      Serial.printf("Wire time : %.1f us avg, %lu us max per transaction "
+                    "(%lu, %s)\r\n",
+                    t.transactions ? (float)t.wireUsTotal / t.transactions
+                                   : 0.0f,
+                    (unsigned long)t.wireUsMax, (unsigned long)t.transactions,
+                    spiDriver.isAsync() ? "DMA" : "blocking");
+      Serial.printf("Queue     : %u/%u max, %lu dropped full, %lu link down, "
+                    "%lu DMA fails, %lu timeouts\r\n",
+                    t.maxDepth, ESPSPI_TX_SLOTS, (unsigned long)t.queueDrops,
+                    (unsigned long)t.linkDown, (unsigned long)t.dmaFails,
+                    (unsigned long)t.dmaTimeouts);
+      const EspSpiRxStats &r = spiDriver.getRxStats();
+      Serial.printf("RX        : %lu packets (%lu bytes), %lu READY edges\r\n",
+                    (unsigned long)r.packets, (unsigned long)r.bytes,
+                    (unsigned long)r.readyEdges);
+      Serial.printf("RX ring   : %lu/%u now, %lu max, %lu full\r\n",
+                    (unsigned long)spiDriver.getRxDepth(), ESPSPI_RX_SLOTS,
+                    (unsigned long)spiDriver.getRxHighWater(),
+                    (unsigned long)r.ringFull);
+
+      // Link: training result, then frame counters (both directions)
+      const SpiLinkMaster &link = spiDriver.getLink();
+      const SpiLinkStats &ls = link.getStats();
+      static const char *linkStates[] = {"HELLO", "TRAIN", "RUN"};
+      Serial.printf("Link      : %s v%u, %.0f MHz, %lu retrains",
+                    linkStates[link.getState()], SPILINK_VERSION,
+                    link.getClock() / 1e6f,
+                    (unsigned long)link.getRetrains());
+      if (link.getPeerVersion() != SPILINK_VERSION)
+        Serial.printf(", ESP32 speaks v%u", link.getPeerVersion());
+      Serial.print("\r\nTraining  :");
+      static const uint32_t clocks[] = SPILINK_CLOCKS;
+      for (uint8_t i = 0; i < SPILINK_CLOCK_STEPS; i++) {
+        if (link.getStepErrors(i) != 0xFF)
+          Serial.printf(" %luM:%u", (unsigned long)(clocks[i] / 1000000),
+                        link.getStepErrors(i));
+      }
+      Serial.println(" (bad frames per step)\r");
+      Serial.printf("Frames    : %lu out, %lu in, %lu bad in, %u bad at "
+                    "ESP32, %lu resent, %lu lost, %lu dup\r\n",
+                    (unsigned long)ls.framesTx, (unsigned long)ls.framesRx,
+                    (unsigned long)ls.badFrames, ls.peerErrors,
+                    (unsigned long)ls.resent, (unsigned long)ls.seqLost,
+                    (unsigned long)ls.duplicates);
+      Serial.printf("Datagrams : %lu out, %lu in, %u max per frame, %lu "
+                    "credit stalls\r\n",
+                    (unsigned long)ls.datagramsTx,
+                    (unsigned long)ls.datagramsRx, ls.maxBatch,
+                    (unsigned long)ls.creditStalls);
+      // Last answer; this also asks the ESP32 for a fresh one
+      IPAddress ip = spiDriver.getLocalIP();
+      Serial.printf("WiFi      : %s, IP %u.%u.%u.%u%s\r\n",
+                    spiDriver.isConnected() ? "up" : "down", ip[0], ip[1],
+                    ip[2], ip[3],
+                    link.isConfigPending() ? " (config not confirmed)" : "");
+      // ESP32 side: its counters, asked for once a second
+      EspSpiBridgeRates br;
+      if (spiDriver.getBridgeRates(&br)) {
+        const SpiLinkBridgeStats &b = spiDriver.getBridgeStats();
+        Serial.printf("Bridge RX : %lu packets (%.1f/s, %.1f kbit/s), queue "
+                      "%u/%u max, %lu dropped, %lu too long\r\n",
+                      (unsigned long)b.netRxPackets, br.netRxPps, br.netRxKbps,
+                      b.toSpiHigh, b.toSpiSlots, (unsigned long)b.toSpiDrops,
+                      (unsigned long)b.tooLong);
+        Serial.printf("Bridge TX : %lu packets (%.1f/s, %.1f kbit/s), queue "
+                      "%u/%u max, %lu dropped, %lu send fails\r\n",
+                      (unsigned long)b.netTxPackets, br.netTxPps, br.netTxKbps,
+                      b.toNetHigh, b.toNetSlots, (unsigned long)b.toNetDrops,
+                      (unsigned long)b.sendFails);
+      } else {
+        Serial.println("Bridge    : no counters from the ESP32 yet\r");
+      }
+      Serial.print("> ");
+      break;
+    }
+    case 'z':
+    case 'Z': {
+      if (!wifiLinkInUse()) {
+        Serial.println("\nWiFi link not in use ([Y])");
+        break;
+      }
+      // Clears the TX counters, so [W] before and after compares the modes
+      cfg.data.spiAsync = !cfg.data.spiAsync;
+      spiDriver.setAsync(cfg.data.spiAsync);
+      Serial.printf("\nESP32 SPI TX: %s\r\n",
+                    cfg.data.spiAsync ? "DMA queue" : "Blocking");
+      Serial.print("> ");
+      break;
+    }
     case '1': {
       Serial.print("\nEnter New Host IP: ");
       // Use new non-blocking-ish echo reader
@@ -230,6 +731,28 @@ void handleSerialCLI() {
       printMenu();
       break;
     }
+    case 'k':
+    case 'K': {
+      Serial.print("\nEnter Backup Host IP (0.0.0.0 = none): ");
+      String ipStr = readStringEcho();
+      ipStr.trim();
+      IPAddress newIP;
+      if (!newIP.fromString(ipStr)) {
+        Serial.println("Invalid IP Address!");
+        printMenu();
+        break;
+      }
+      cfg.data.backupHostIP = (uint32_t)newIP;
+      if (cfg.data.backupHostIP) {
+        Serial.print("Enter Backup Host Port: ");
+        int port = readStringEcho().toInt();
+        if (port > 0 && port < 65535)
+          cfg.data.backupHostPort = (uint16_t)port;
+      }
+      Serial.println("Saved on [S] (applies after reboot)");
+      printMenu();
+      break;
+    }
     case '3': {
       cfg.data.useHwRSSI = !cfg.data.useHwRSSI;
       Serial.printf("\nToggled RSSI Mode to: %s\n",
@@ -327,6 +850,44 @@ void handleSerialCLI() {
         Serial.printf("Voter Time: %u.%09u\r\n", t.vtime_sec, t.vtime_nsec);
       }
       Serial.printf("PPS Jitter: %u us\r\n", gpsMgr.getPpsJitter());
+      Serial.printf("Frame Time: %s, seq %lu, GPS-stamp %ld us\r\n",
+                    frameClock.getMode() == TIMING_MIX ? "MIX (local)"
+                    : frameClock.isHoldover()          ? "HOLDOVER"
+                                                       : "GPS",
+                    (unsigned long)frameClock.getSequence(),
+                    (long)frameClock.getLastError());
+      Serial.printf("Holdover  : %lu frames, %lu resyncs\r\n",
+                    (unsigned long)frameClock.getHoldoverFrames(),
+                    (unsigned long)frameClock.getResyncs());
+      // Frames are stamped at capture (audio ISR). Jitter of those stamps,
+      // and the capture -> loop() delay a loop() stamp would have carried.
+      Serial.printf("Capture TS: ISR jitter max %lu us\r\n",
+                    (unsigned long)voterFrames.getStampJitterMax());
+      if (g_captureLag.getCount())
+        Serial.printf("Loop Lag  : %lu..%lu us (p50 %lu, p99 %lu) over %lu "
+                      "frames, removed from stamps\r\n",
+                      (unsigned long)g_captureLag.getMin(),
+                      (unsigned long)g_captureLag.getMax(),
+                      (unsigned long)g_captureLag.getPercentile(50),
+                      (unsigned long)g_captureLag.getPercentile(99),
+                      (unsigned long)g_captureLag.getCount());
+      voterFrames.resetStampJitter();
+      g_captureLag.clear();
+      {
+        const PpsDiscipline &pps = voterFrames.getPpsDiscipline();
+        Serial.printf("PPS Align : %s, last error %.1f us, %lu edges, %lu "
+                      "acquires\r\n",
+                      !voterFrames.getPpsAlign()  ? "OFF"
+                      : voterFrames.isPpsAligned() ? "ALIGNED"
+                                                   : "WAITING",
+                      pps.getLastError(), (unsigned long)pps.getEdges(),
+                      (unsigned long)pps.getAcquires());
+        Serial.printf("Codec Rate: %s, %+.3f ppm (%.3f Hz), ratio %.9f, "
+                      "%lu rejected\r\n",
+                      PpsDiscipline::rateStateName(pps.getRateState()),
+                      pps.getPpm(), pps.getRate(), voterFrames.getRatio(),
+                      (unsigned long)pps.getRateRejects());
+      }
       // Re-print menu after a pause or keypress?
       // For now just back to prompt
       Serial.println("------------------\r");
@@ -352,19 +913,36 @@ void handleSerialCLI() {
       Serial.println(" [0] Always On (No Squelch)");
       Serial.println(" [1] Hardware COS (GPIO Pin)");
       Serial.println(" [2] DSP Squelch (Noise Detection)");
+      Serial.println(" [3] Spectral Squelch (FFT Voice/Noise SNR)");
+      Serial.println(" [4] CTCSS Tone (PL Decoder)");
       Serial.print("Enter mode: ");
       String val = readStringEcho();
       int mode = val.toInt();
-      if (mode >= 0 && mode <= 2) {
+      if (mode >= 0 && mode <= 4) {
         cfg.data.cosMode = mode;
+        dsp.setSpectralSquelch(cfg.data.cosMode == COS_MODE_SPECTRAL);
+        ctcss.reset();
         Serial.printf("\nCOS Mode set to %d\n", mode);
       } else {
-        Serial.println("\nInvalid Mode (0-2).");
+        Serial.println("\nInvalid Mode (0-4).");
       }
       printMenu();
       break;
     }
     case '7': {
+      if (cfg.data.cosMode == COS_MODE_SPECTRAL) {
+        Serial.print("\nEnter SNR Squelch Threshold (0-40 dB): ");
+        String val = readStringEcho();
+        int thresh = val.toInt();
+        if (thresh >= 0 && thresh <= 40) {
+          cfg.data.spectralSnrThresh = thresh;
+          Serial.printf("\nSNR Squelch Threshold set to %u dB\n", thresh);
+        } else {
+          Serial.println("\nInvalid Value (0-40).");
+        }
+        printMenu();
+        break;
+      }
       Serial.print("\nEnter DSP Squelch Threshold (0-255): ");
       String val = readStringEcho();
       int thresh = val.toInt();
@@ -403,12 +981,270 @@ void handleSerialCLI() {
     case 't':
     case 'T': {
       g_testToneMode = !g_testToneMode;
+      applyTestTone();
       resetAudioState(); // CRITICAL: Reset filters and buffers
       Serial.printf("\nTest Tone Mode: %s\n",
                     g_testToneMode ? "ON (1kHz sine wave)" : "OFF");
       printMenu();
       break;
     }
+    case 'e':
+    case 'E': {
+      // Cycle FLOAT -> Q15 -> FUSED
+      cfg.data.dspEngine = (cfg.data.dspEngine + 1) % 3;
+      dsp.setEngine(cfg.data.dspEngine);
+      Serial.printf("\nDSP Engine: %s\n", dspEngineName(cfg.data.dspEngine));
+      printMenu();
+      break;
+    }
+    case 'f':
+    case 'F': {
+      cfg.data.timingMode =
+          (cfg.data.timingMode == TIMING_MIX) ? TIMING_GPS : TIMING_MIX;
+      frameClock.setMode(cfg.data.timingMode);
+      Serial.printf("\nFrame Timing: %s\n",
+                    cfg.data.timingMode == TIMING_MIX ? "MIX" : "GPS");
+      printMenu();
+      break;
+    }
+    case 'o':
+    case 'O': {
+      // Report every link ([0] switches the bond mode)
+      Serial.printf("\r\n--- Network Links (%s) ---\r\n",
+                    cfg.data.netBond == NET_BOND_DUPLICATE ? "Duplicate"
+                                                           : "Failover");
+      uint32_t now = millis();
+      for (uint8_t i = 0; i < netMgr.getLinkCount(); i++) {
+        const NetLinkStats &ls = netMgr.getLinkStats(i);
+        IPAddress ip = netMgr.getDriver(i)->getLocalIP();
+        Serial.printf("%c%u %-16s: %-6s IP %u.%u.%u.%u\r\n",
+                      i == netMgr.getActiveLink() ? '*' : ' ', i,
+                      NetworkManager::typeName(netMgr.getDriver(i)->getType()),
+                      NetworkManager::healthName(netMgr.getLinkHealth(i)),
+                      ip[0], ip[1], ip[2], ip[3]);
+        Serial.printf("    %lu sent (%lu probes), %lu read, %lu host answers",
+                      (unsigned long)ls.txPackets, (unsigned long)ls.probes,
+                      (unsigned long)ls.rxPackets, (unsigned long)ls.confirms);
+        if (ls.confirms)
+          Serial.printf(" (last %lu ms ago)",
+                        (unsigned long)(now - ls.lastConfirmMs));
+        Serial.printf(", %lu downs, %lu activations\r\n",
+                      (unsigned long)ls.downs, (unsigned long)ls.activations);
+      }
+      Serial.printf("Failovers : %lu", (unsigned long)netMgr.getFailovers());
+      if (netMgr.getFailovers())
+        Serial.printf(" (last %lu s ago)",
+                      (unsigned long)((now - netMgr.getLastFailoverMs()) / 1000));
+      Serial.println("\r");
+      Serial.print("> ");
+      break;
+    }
+    case '0':
+      // Takes effect at once
+      cfg.data.netBond = cfg.data.netBond == NET_BOND_DUPLICATE
+                             ? NET_BOND_FAILOVER
+                             : NET_BOND_DUPLICATE;
+      netMgr.setBondMode(cfg.data.netBond);
+      Serial.printf("\nLink Bonding: %s\n",
+                    cfg.data.netBond == NET_BOND_DUPLICATE
+                        ? "Duplicate (every packet on every link)"
+                        : "Failover (active link only)");
+      printMenu();
+      break;
+    case 'y':
+    case 'Y':
+      cfg.data.netLinks = (cfg.data.netLinks + 1) % 3;
+      Serial.printf("\nNetwork Links: %s (after Save & Reboot)\n",
+                    netLinksName(cfg.data.netLinks));
+      printMenu();
+      break;
+    case 'j':
+    case 'J':
+      cfg.data.ppsAlign = !cfg.data.ppsAlign;
+      voterFrames.setPpsAlign(cfg.data.ppsAlign);
+      Serial.printf("\nPPS Frame Align: %s\n", cfg.data.ppsAlign ? "ON" : "OFF");
+      printMenu();
+      break;
+    case 'x':
+    case 'X': {
+      Serial.printf("\nEnter TX Delay (20-%u ms, same on every site): ",
+                    TX_DELAY_MAX_MS);
+      String val = readStringEcho();
+      int ms = val.toInt();
+      if (ms >= 20 && ms <= TX_DELAY_MAX_MS) {
+        cfg.data.txDelayMs = (uint16_t)ms;
+        txAudio.setDelay(cfg.data.txDelayMs);
+        txAudio.clear();
+        Serial.printf("\nTX Delay: %d ms\n", ms);
+      } else {
+        Serial.println("\nInvalid Value.");
+      }
+      printMenu();
+      break;
+    }
+    case 'u':
+    case 'U': {
+      cfg.data.codec =
+          (cfg.data.codec == CODEC_ADPCM) ? CODEC_ULAW : CODEC_ADPCM;
+      resetAudioState(); // Drop any half-built ADPCM packet
+      Serial.printf("\nUplink Codec: %s\n",
+                    cfg.data.codec == CODEC_ADPCM ? "ADPCM" : "uLaw");
+      printMenu();
+      break;
+    }
+    case 'p':
+    case 'P': {
+      Serial.print("\nEnter CTCSS Tone (Hz, e.g. 100.0): ");
+      String val = readStringEcho();
+      int tone = CtcssDecoder::findTone(val.toFloat());
+      if (tone < 0) {
+        Serial.println("\nNot a standard CTCSS tone.");
+        printMenu();
+        break;
+      }
+      Serial.printf("\nEnter Detect Time (%u-%u frames of 20ms, longer = "
+                    "fewer falses, 10+ to reject adjacent tones): ",
+                    CTCSS_WINDOW_MIN, CTCSS_WINDOW_MAX);
+      val = readStringEcho();
+      int window = val.toInt();
+      if (window < CTCSS_WINDOW_MIN || window > CTCSS_WINDOW_MAX) {
+        Serial.println("\nInvalid Value, keeping current detect time.");
+        window = cfg.data.ctcssWindow;
+      }
+      cfg.data.ctcssTone = (uint8_t)tone;
+      cfg.data.ctcssWindow = (uint8_t)window;
+      ctcss.begin(cfg.data.ctcssTone, cfg.data.ctcssWindow);
+      Serial.printf("\nCTCSS %.1f Hz, %d ms detect\n",
+                    CtcssDecoder::toneHz(cfg.data.ctcssTone), window * 20);
+      printMenu();
+      break;
+    }
+    case 'a':
+    case 'A':
+      Serial.println("\r\n--- Audio Status ---");
+      Serial.printf("Frames    : %lu\r\n",
+                    (unsigned long)voterFrames.getFramesProduced());
+      Serial.printf("Queue     : %u / %u (Max %u)\r\n", voterFrames.getDepth(),
+                    VOTER_FRAME_QUEUE_DEPTH, voterFrames.getMaxDepth());
+      Serial.printf("Overruns  : %lu\r\n",
+                    (unsigned long)voterFrames.getOverruns());
+      Serial.printf("Underflows: %lu\r\n",
+                    (unsigned long)voterFrames.getUnderflows());
+      Serial.printf("TX Buffer : %u / %u (Max %u), %s\r\n", txAudio.getDepth(),
+                    TX_JITTER_SLOTS, txAudio.getMaxDepth(),
+                    txAudio.isKeyed() ? "KEYED" : "idle");
+      Serial.printf("TX Frames : %lu played, %lu late, %lu early, %lu lost, "
+                    "%lu underruns\r\n",
+                    (unsigned long)txAudio.getFramesPlayed(),
+                    (unsigned long)txAudio.getLate(),
+                    (unsigned long)txAudio.getEarly(),
+                    (unsigned long)txAudio.getLost(),
+                    (unsigned long)txAudio.getUnderruns());
+      Serial.printf("Pkt Copies: %.1f bytes/packet (%lu packets)\r\n",
+                    voter.getAudioPackets()
+                        ? (float)voter.getBytesCopied() /
+                              voter.getAudioPackets()
+                        : 0.0f,
+                    (unsigned long)voter.getAudioPackets());
+      Serial.println("--------------------\r");
+      Serial.print("> ");
+      break;
+    case 'q':
+    case 'Q': {
+      // Results so far, then a new burst if the last one is done
+      Serial.println("\r\n--- Host Ping ---");
+      for (uint8_t h = 0; h < voter.getHostCount(); h++) {
+        const LatencyHistogram &rtt = voter.getPingStats(h);
+        Serial.printf("Host %u    : %lu sent, %lu replies, %lu lost\r\n", h,
+                      (unsigned long)voter.getPingsSent(h),
+                      (unsigned long)rtt.getCount(),
+                      (unsigned long)voter.getPingsLost(h));
+        if (rtt.getCount()) {
+          Serial.printf("  RTT     : min %.2f / avg %.2f / max %.2f ms\r\n",
+                        rtt.getMin() / 1000.0f, rtt.getMean() / 1000.0f,
+                        rtt.getMax() / 1000.0f);
+          Serial.printf("  Pctl    : p50 %.2f / p90 %.2f / p99 %.2f ms\r\n",
+                        rtt.getPercentile(50) / 1000.0f,
+                        rtt.getPercentile(90) / 1000.0f,
+                        rtt.getPercentile(99) / 1000.0f);
+        }
+      }
+      Serial.printf("Host Pings: %lu echoed\r\n",
+                    (unsigned long)voter.getPingsEchoed());
+      if (voter.isPinging()) {
+        Serial.println("Running... press Q again for results.");
+      } else if (!voter.isConnected()) {
+        Serial.println("Not connected to host.");
+      } else {
+        voter.startPing(VOTER_PING_COUNT, VOTER_PING_INTERVAL_MS);
+        Serial.printf("Pinging host: %u x %u ms, press Q for results.\r\n",
+                      VOTER_PING_COUNT, VOTER_PING_INTERVAL_MS);
+      }
+      Serial.println("-----------------\r");
+      Serial.print("> ");
+      break;
+    }
+    case 'v':
+    case 'V':
+      Serial.println("\r\n--- Voter Hosts ---");
+      for (uint8_t h = 0; h < voter.getHostCount(); h++) {
+        const VoterHostSession &s = voter.getHost(h);
+        Serial.printf("Host %u    : %u.%u.%u.%u:%u %s\r\n", h, s.ip[0], s.ip[1],
+                      s.ip[2], s.ip[3], s.port,
+                      s.state != VOTER_CONNECTED ? "DISCONNECTED"
+                      : s.silent                 ? "CONNECTED (silent)"
+                                                 : "CONNECTED");
+        Serial.printf("  Session : %lu connects, %lu challenges, %lu auth "
+                      "sent, %lu timeouts\r\n",
+                      (unsigned long)s.stats.connects,
+                      (unsigned long)s.stats.challenges,
+                      (unsigned long)s.stats.authSent,
+                      (unsigned long)s.stats.timeouts);
+        Serial.printf("  Audio   : %lu sent, %lu missed (%.2f%%)\r\n",
+                      (unsigned long)s.stats.audioSent,
+                      (unsigned long)s.stats.audioMissed,
+                      s.stats.audioSent + s.stats.audioMissed
+                          ? 100.0f * s.stats.audioMissed /
+                                (s.stats.audioSent + s.stats.audioMissed)
+                          : 0.0f);
+        if (s.stats.packetsRx)
+          Serial.printf("  RX      : %lu packets, last %lu ms ago\r\n",
+                        (unsigned long)s.stats.packetsRx,
+                        (unsigned long)(millis() - s.stats.lastRxMs));
+        else
+          Serial.println("  RX      : nothing yet");
+      }
+      {
+        const VoterRxStats &r = voter.getRxStats();
+        Serial.printf("Receive   : %lu packets (%lu/s), %lu bytes\r\n",
+                      (unsigned long)r.packets,
+                      (unsigned long)voter.getRxRate(),
+                      (unsigned long)r.bytes);
+        Serial.printf("  Types   : AUTH %lu ULAW %lu GPS %lu PING %lu\r\n",
+                      (unsigned long)r.byType[PAYLOAD_AUTH],
+                      (unsigned long)r.byType[PAYLOAD_ULAW],
+                      (unsigned long)r.byType[PAYLOAD_GPS],
+                      (unsigned long)r.byType[PAYLOAD_PING]);
+        Serial.printf("  Drops   : %lu short, %lu long, %lu no host, %lu "
+                      "digest, %lu type\r\n",
+                      (unsigned long)r.dropShort, (unsigned long)r.dropLong,
+                      (unsigned long)r.dropNoHost,
+                      (unsigned long)r.dropDigest, (unsigned long)r.dropType);
+        Serial.printf("  Batches : %lu passes, %lu full (%u max), %.1f us "
+                      "avg, %lu us max\r\n",
+                      (unsigned long)r.passes, (unsigned long)r.fullPasses,
+                      r.maxBatch,
+                      r.passes ? (float)r.procUsTotal / r.passes : 0.0f,
+                      (unsigned long)r.procUsMax);
+      }
+      Serial.println("-------------------\r");
+      Serial.print("> ");
+      break;
+    case 'b':
+    case 'B':
+      runDspBenchmark();
+      Serial.print("> ");
+      break;
     case 'd':
     case 'D': {
       Serial.println("\n--- Signal Monitor (Press any key to exit) ---");
@@ -430,6 +1266,8 @@ void handleSerialCLI() {
           if (mapped > 255)
             mapped = 255;
           finalRSSI = (uint8_t)mapped;
+        } else if (cfg.data.cosMode == COS_MODE_SPECTRAL) {
+          finalRSSI = dsp.getSpectralRSSI();
         } else {
           finalRSSI = (255 - noise);
         }
@@ -437,9 +1275,12 @@ void handleSerialCLI() {
         // 2. COS
         bool hwCosActive = (digitalRead(COS_PIN) == LOW);
         bool dspCosActive = (noise < cfg.data.dspSquelchThresh);
-        bool finalCos = (cfg.data.cosMode == COS_MODE_HARDWARE) ? hwCosActive
-                        : (cfg.data.cosMode == COS_MODE_DSP)    ? dspCosActive
-                                                                : true;
+        bool finalCos =
+            (cfg.data.cosMode == COS_MODE_HARDWARE)   ? hwCosActive
+            : (cfg.data.cosMode == COS_MODE_DSP)      ? dspCosActive
+            : (cfg.data.cosMode == COS_MODE_SPECTRAL) ? dsp.isSpectralOpen()
+            : (cfg.data.cosMode == COS_MODE_CTCSS)    ? ctcss.isDetected()
+                                                      : true;
 
         // 3. GPS
         long ppsJitter = gpsMgr.getPpsJitter();
@@ -479,6 +1320,10 @@ void setup() {
   // COS Input Pin
   pinMode(COS_PIN, INPUT_PULLUP);
 
+  // PTT Output (unkeyed)
+  pinMode(PTT_PIN, OUTPUT);
+  digitalWrite(PTT_PIN, LOW);
+
   // 0. Config (MUST BE FIRST)
   cfg.begin();
 
@@ -499,19 +1344,16 @@ void setup() {
           : AUDIO_INPUT_MIC); // for radio discriminator/audio output
   sgtl5000_1.lineInLevel(cfg.data.rxGain); // Line input level (0-15)
 
-  // Start Recording
-  mixer1.gain(0, 0.5); // Left Channel
-  mixer1.gain(1, 0.5); // Right Channel
-  recordQueue.begin();
+  // Mixer: Radio on input 0, Test Tone on input 1 (muted)
+  applyTestTone();
 
-  // Test Tone (Disabled - connection commented out at line 65)
-  // sine1.frequency(440);
-  // sine1.amplitude(0.5);
+  // Start Framing & TX Playout
+  voterFrames.begin(&resampleTable);
+  voterFrames.setPpsAlign(cfg.data.ppsAlign);
+  txAudio.setDelay(cfg.data.txDelayMs);
+  txAudio.begin(&upsampleTable);
 
-  // Initialize audio state
-  // resetAudioState();
-
-  Serial.println("[Audio] SGTL5000 & Queue Initialized");
+  Serial.println("[Audio] SGTL5000 & Frame Queue Initialized");
 
   Serial.printf("[Audio] Applied RX Gain: %u\r\n", cfg.data.rxGain);
 
@@ -528,19 +1370,31 @@ void setup() {
 
   Serial.println("[System] Boot Complete: Audio + Network + GPS");
 
-  // 3. Network
-  Serial.println("[System] Initializing Network Driver...");
-  // netMgr.begin(&ethDriver, mac);
-  netMgr.begin(&spiDriver, mac);
+  // 3. Network (links in priority order)
+  Serial.printf("[System] Initializing Network: %s\r\n",
+                netLinksName(cfg.data.netLinks));
+  if (cfg.data.netLinks == NET_LINKS_WIFI) {
+    netMgr.begin(&spiDriver, mac);
+  } else {
+    netMgr.begin(&ethDriver, mac);
+    if (cfg.data.netLinks == NET_LINKS_ETH_WIFI)
+      netMgr.addLink(&spiDriver);
+  }
+  netMgr.setBondMode(cfg.data.netBond);
+  g_netLinks = cfg.data.netLinks;
+
+  if (wifiLinkInUse()) {
+    spiDriver.setAsync(cfg.data.spiAsync);
 
-  // Give ESP32 time to boot before sending credentials
-  Serial.println("[System] Waiting for ESP32 Boot (5s)...");
-  delay(5000); // Increased to 5s to match Spirit.ino startup delay
+    // Give ESP32 time to boot before sending credentials
+    Serial.println("[System] Waiting for ESP32 Boot (5s)...");
+    delay(5000); // Increased to 5s to match Spirit.ino startup delay
 
-  // Send WiFi Credentials (HARDCODED - TODO: Move to Config)
-  Serial.println("[System] Sending WiFi Credentials...");
-  spiDriver.setCredentials("ImWatchinYou", "n0Password");
-  delay(100);
+    // Send WiFi Credentials (HARDCODED - TODO: Move to Config)
+    Serial.println("[System] Sending WiFi Credentials...");
+    spiDriver.setCredentials("ImWatchinYou", "n0Password");
+    delay(100);
+  }
 
   // 7. Voter Client
   Serial.println("[Voter] Initializing Protocol Client...");
@@ -552,6 +1406,7 @@ void setup() {
 
   Serial.println("[GPS] Initializing GPS...");
   gpsMgr.begin(&GPS_SERIAL, PPS_PIN);
+  gpsMgr.onPps(handlePps);
 
   // 4.1 Config (Moved to top)
   // cfg.begin();
@@ -569,27 +1424,21 @@ void setup() {
   // Serial.println("[Voter] Initializing Protocol Client...");
   voter.begin(&netMgr, &gpsMgr, cfg.getHostIP(), cfg.data.hostPort,
               cfg.data.clientPwd, cfg.data.hostPwd);
+  if (cfg.data.backupHostIP) {
+    IPAddress backup(cfg.data.backupHostIP);
+    voter.addHost(backup, cfg.data.backupHostPort);
+    Serial.print("[System] Backup Target: ");
+    Serial.print(backup);
+    Serial.printf(":%u\r\n", cfg.data.backupHostPort);
+  }
+  voter.onTxAudio(handleTxAudio);
+  frameClock.begin(cfg.data.timingMode);
 
   // 6. DSP
   dsp.begin();
-
-  // Initialize Decimator
-  // Coeffs: Simple averaging for now (1/48).
-  // TODO: Replace with proper Low-Pass Sinc coefficients for better
-  // anti-aliasing
-  for (int i = 0; i < DECIMATOR_NUM_TAPS; i++) {
-    decimatorCoeffs[i] = 1.0f / (float)DECIMATOR_NUM_TAPS;
-  }
-
-  // Use a safe input block size (multiple of M=6) for Init check. 120 is safe.
-  arm_status status = arm_fir_decimate_init_f32(
-      &decimator, DECIMATOR_NUM_TAPS, DECIMATION_FACTOR, decimatorCoeffs,
-      decimatorState, 120);
-
-  if (status != ARM_MATH_SUCCESS) {
-    Serial.print("ERROR: Decimator Init Failed! Code: ");
-    Serial.println(status);
-  }
+  dsp.setEngine(cfg.data.dspEngine);
+  dsp.setSpectralSquelch(cfg.data.cosMode == COS_MODE_SPECTRAL);
+  ctcss.begin(cfg.data.ctcssTone, cfg.data.ctcssWindow);
 
   // 7. Web
   web.begin(&cfg, &gpsMgr, &voter);
@@ -607,213 +1456,139 @@ void loop() {
   netMgr.update();
   voter.update();
 
-  // 2. Audio Processing Loop
-  // Changed to 'if' to prevent starvation of GPS/Network if DSP is slow
-  // We process up to 2 blocks per loop to catch up if needed, but yield to
-  // other tasks
-  int blocksProcessed = 0;
-  while (recordQueue.available() >= 1 && blocksProcessed < 2) {
-    blocksProcessed++;
-    int16_t *buff = recordQueue.readBuffer();
-    if (!buff)
-      continue; // Should not happen given check above, but safer than return
-
-    // 1. DSP Moved to Frame Processing Loop (Lines ~690)
-    // We only process Decimated 8kHz Audio (160 Samples).
-    // Processing here caused 44.1kHz aliasing issues.
-
-    if (g_testToneMode) {
-      // Use global phase for consistency across blocks & reset capability
-      const float freq = 1000.0f;                       // 1kHz
-      const float sampleRate = AUDIO_SAMPLE_RATE_EXACT; // 44117.6Hz
-      const float amplitude = 5000.0f;
-      const float phaseIncrement = 2.0f * 3.14159265f * freq / sampleRate;
-
-      for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-        buff[i] = (int16_t)(amplitude * sinf(g_testTonePhase));
-        g_testTonePhase += phaseIncrement;
-        if (g_testTonePhase >= 2.0f * 3.14159265f)
-          g_testTonePhase -= 2.0f * 3.14159265f;
-      }
+  // 2. TX Audio: release jitter-buffered frames on GPS time, drive PTT
+  if (gpsMgr.isLocked()) {
+    VTIME txNow;
+    gpsMgr.getNetworkTime(&txNow);
+    txAudio.service(&txNow);
+  } else {
+    txAudio.service(nullptr);
+  }
+  digitalWrite(PTT_PIN, txAudio.isKeyed() ? HIGH : LOW);
+
+  // 3. Audio Frame Loop
+  // Resampling and 20ms framing run in the audio ISR (voterFrames), so here
+  // we only filter, encode and packetize whatever complete frames are queued.
+  while (voterFrames.available() > 0) {
+    VoterFrame *vf = voterFrames.readFrame();
+    int16_t *frame = vf->samples;
+
+    // VOTER2 TIMING: Stamp the frame exactly once, with the GPS time its
+    // first sample was captured (recorded in the audio ISR), so loop()
+    // latency does not reach the timestamp. PPS-aligned frames start on a
+    // 20ms boundary, so their stamp is exactly that boundary. Local holdover
+    // or mix mode while GPS is not locked. This timestamp is used for
+    // transmission.
+    VTIME frameTime;
+    if (gpsMgr.isLocked()) {
+      VTIME gpsCapture;
+      gpsMgr.getTimeAt(vf->captureMicros, &gpsCapture);
+      if (vf->ppsAligned)
+        FrameClock::roundToFrame(&gpsCapture);
+      frameClock.stamp(&frameTime, &gpsCapture);
+      g_captureLag.add(micros() - vf->captureMicros);
+    } else {
+      frameClock.stamp(&frameTime, nullptr);
     }
 
+    // CTCSS decode needs the raw frame (the voice filter strips < 300Hz)
+    if (cfg.data.cosMode == COS_MODE_CTCSS)
+      ctcss.process(frame, FRAME_SIZE);
+
+    // CRITICAL: Process Audio (Filter, De-emphasis, RSSI, uLaw)
+    // DSP runs on the full 160-sample frame, in place in the queue slot, and
+    // encodes uLaw in the same pass straight into the outgoing packet
+    // (ADPCM is encoded below instead).
+    bool useAdpcm = (cfg.data.codec == CODEC_ADPCM);
+    uint8_t *ulawFrame = voter.getAudioPayload();
+    uint8_t measuredNoise =
+        dsp.process(frame, cfg.data.enablePLFilter, cfg.data.enableDeemp,
+                    useAdpcm ? nullptr : ulawFrame);
+
+    uint8_t baseRSSI;
     if (cfg.data.useHwRSSI) {
-      // Just mapping code, no side effects
-      int analogVal = analogRead(RSSI_PIN);
-      (void)analogVal;
+      // Hardware RSSI Mode: Read ADC and Map
+      int rawRSSI = analogRead(RSSI_PIN);
+      // Constrain to calibrated range
+      if (rawRSSI < cfg.data.rssiMin)
+        rawRSSI = cfg.data.rssiMin;
+      if (rawRSSI > cfg.data.rssiMax)
+        rawRSSI = cfg.data.rssiMax;
+
+      // Map to 0-255 (Simple linear map)
+      // Note: map() uses integer math.
+      long mapped = map(rawRSSI, cfg.data.rssiMin, cfg.data.rssiMax, 0, 255);
+      baseRSSI = (uint8_t)mapped;
+    } else if (cfg.data.cosMode == COS_MODE_SPECTRAL) {
+      // Spectral RSSI Mode (voice/noise SNR)
+      baseRSSI = dsp.getSpectralRSSI();
+    } else {
+      // DSP RSSI Mode
+      baseRSSI = 255 - measuredNoise;
     }
 
-    // 2. Fractional Resampling (44.1kHz -> 8000Hz)
-    // Fixes timing drift (Pulsing) caused by integer decimation
-    const float RESAMPLE_RATIO = AUDIO_SAMPLE_RATE_EXACT / 8000.0f; // ~5.5147
-
-    // State variables (static to persist across blocks)
-    static float resamplePos =
-        0.0f; // Next output time relative to current block start
-    static float lastFilteredSample =
-        0.0f; // Previous input sample (y[i-1]) for interpolation
-
-    // Simple Anti-Aliasing Filter State
-    static float lpfState = 0.0f;
-    const float lpfAlpha =
-        0.42f; // ~3kHz cutoff (fc = 3000, fs = 44100 -> alpha ~ 0.42)
-
-    // Process all 128 input samples
-    for (int i = 0; i < 128; i++) {
-      // A. Anti-Aliasing (IIR LPF)
-      float in = (float)buff[i];
-      lpfState += lpfAlpha * (in - lpfState);
-      float currentSample = lpfState;
-
-      // B. Generate Output Samples via Linear Interpolation
-      // We generate an output whenever 'resamplePos' falls within the interval
-      // (i-1, i] i.e., while resamplePos < i
-
-      while (resamplePos < (float)i) {
-        // Calculate interpolation fraction
-        // Interval is [i-1, i]. currentSample is at i. lastFilteredSample is at
-        // i-1. Fraction from i-1:
-        float frac = resamplePos - ((float)i - 1.0f);
-
-        float out =
-            lastFilteredSample + frac * (currentSample - lastFilteredSample);
-
-        // Clip and Store to Accumulation Buffer
-        if (out > 32760.0f)
-          out = 32760.0f;
-        if (out < -32760.0f)
-          out = -32760.0f;
-
-        if (accHead < 512) {
-          accumulationBuf[accHead++] = (int16_t)out;
-        }
-
-        // Advance target time for next output
-        resamplePos += RESAMPLE_RATIO;
-      }
-
-      lastFilteredSample = currentSample;
-    }
-
-    // Adjust resamplePos for next block (subtract 128 input samples)
-    resamplePos -= 128.0f;
-
-    // Free the Audio Library buffer
-    recordQueue.freeBuffer();
-
-    // 3. Check if we have enough for a Frame (160 samples)
-    // 3. Check if we have enough for a Frame (160 samples)
-    if (accHead >= 160) {
-
-      // VOTER2 TIMING: Capture GPS timestamp NOW (at frame assembly)
-      // This timestamp will be used for packet transmission
-      VTIME frameTime;
-      gpsMgr.getNetworkTime(&frameTime);
-
-      // CRITICAL: Process Audio (Filter, De-emphasis, RSSI)
-      // Note: accumulationBuf is 160 samples of int16_t.
-      // DSP process takes int16_t* and modifies in-place (or uses internal
-      // buffers). Wait, DSP process takes BLOCK_SIZE (128). We have 160. We
-      // need to process in chunks or update DSP to handle count. But for now,
-      // let's process the first 128? No, that leaves 32 unfiltered. Let's
-      // modify DSP to take count? Or just loop. actually standard ARM functions
-      // often work on blocks. Let's update dsp.process to take 'count'. But for
-      // this quick fix, I need to check DSPProcessor.h signature. Signature:
-      // uint8_t process(int16_t *samples, bool enablePLFilter, bool
-      // enableDeemp); It assumes AUDIO_BLOCK_SAMPLES inside.
-
-      // We can't easily change the block size of the DSP class without breaking
-      // internal buffers. So we will process the first 128 samples to update
-      // RSSI. The Remaining 32 samples will be unfiltered... that causes
-      // Jitter/Artifacts!
-
-      // FIX: We need to process ALL 160 samples.
-      // Since DSP buffers are 128... this is tricky.
-      // The "Voter" standard is 160 samples.
-      // The "Teensy Audio" standard is 128 samples.
-
-      // Hack: Process in two chunks?
-      // Or just resize DSP buffers to 160?
-      // 160 > 128. So we need to increase AUDIO_BLOCK_SAMPLES in DSPProcessor.h
-      // to 160.
-
-      // For now, I will assume I can update DSPProcessor.h to 160.
-
-      // Let's call process anyway for now to get SOME filtering.
-      // But this confirms why "Mechanical" - Mismatched block sizes!
-
-      uint8_t measuredNoise = dsp.process(
-          accumulationBuf, cfg.data.enablePLFilter, cfg.data.enableDeemp);
-
-      uint8_t baseRSSI;
-      if (cfg.data.useHwRSSI) {
-        // Hardware RSSI Mode: Read ADC and Map
-        int rawRSSI = analogRead(RSSI_PIN);
-        // Constrain to calibrated range
-        if (rawRSSI < cfg.data.rssiMin)
-          rawRSSI = cfg.data.rssiMin;
-        if (rawRSSI > cfg.data.rssiMax)
-          rawRSSI = cfg.data.rssiMax;
-
-        // Map to 0-255 (Simple linear map)
-        // Note: map() uses integer math.
-        long mapped = map(rawRSSI, cfg.data.rssiMin, cfg.data.rssiMax, 0, 255);
-        baseRSSI = (uint8_t)mapped;
+    // Calculate Final RSSI for protocol
+    // (This logic was inside the loop in original, but we can compute it once
+    // per frame or use latest) For simplicity, we use the baseRSSI computed
+    // for the last block (approximate is fine for 20ms frame)
+
+    uint8_t finalRSSI = baseRSSI;
+    switch (cfg.data.cosMode) {
+    case COS_MODE_HARDWARE:
+      // Hardware COS: PIN LOW = Carrier Present (Active)
+      if (digitalRead(COS_PIN) == HIGH) {
+        finalRSSI = 0; // Squelch Closed (Inactive)
       } else {
-        // DSP RSSI Mode
-        baseRSSI = 255 - measuredNoise;
-      }
-
-      uint8_t ulawFrame[160];
-      dsp.encodeULaw(accumulationBuf, ulawFrame, 160);
-
-      // Calculate Final RSSI for protocol
-      // (This logic was inside the loop in original, but we can compute it once
-      // per frame or use latest) For simplicity, we use the baseRSSI computed
-      // for the last block (approximate is fine for 20ms frame)
-
-      uint8_t finalRSSI = baseRSSI;
-      switch (cfg.data.cosMode) {
-      case COS_MODE_HARDWARE:
-        // Hardware COS: PIN LOW = Carrier Present (Active)
-        if (digitalRead(COS_PIN) == HIGH) {
-          finalRSSI = 0; // Squelch Closed (Inactive)
-        } else {
-          // Squelch Open (Active)
-          // Pass the Software RSSI (baseRSSI) through.
-          // User Request: "hardware cos and software rssi"
-        }
-        break;
-      case COS_MODE_DSP:
-        if (dsp.getNoiseLevel() >= cfg.data.dspSquelchThresh)
-          finalRSSI = 0;
-        break;
+        // Squelch Open (Active)
+        // Pass the Software RSSI (baseRSSI) through.
+        // User Request: "hardware cos and software rssi"
       }
-
-      if (g_noSignalMode)
+      break;
+    case COS_MODE_DSP:
+      if (dsp.getNoiseLevel() >= cfg.data.dspSquelchThresh)
         finalRSSI = 0;
+      break;
+    case COS_MODE_SPECTRAL:
+      if (!dsp.isSpectralOpen())
+        finalRSSI = 0;
+      break;
+    case COS_MODE_CTCSS:
+      if (!ctcss.isDetected())
+        finalRSSI = 0;
+      break;
+    }
 
-      bool shouldSend = (finalRSSI > 0);
-      if (shouldSend) {
-        // Use the proper client method which handles sequence, timestamp, and
-        // sending
-        VTIME frameTime = {0, 0};
-        if (gpsMgr.isLocked()) {
-          gpsMgr.getNetworkTime(&frameTime);
-        }
-        voter.processAudioFrame(ulawFrame, finalRSSI, frameTime);
-        // Serial.println("[Test] Generated Audio Frame (Not Sent)");
-      }
-
-      // Move remaining
-      int remaining = accHead - 160;
-      if (remaining > 0) {
-        memmove(accumulationBuf, &accumulationBuf[160],
-                remaining * sizeof(int16_t));
-        accHead = remaining;
+    if (g_noSignalMode)
+      finalRSSI = 0;
+
+    if (useAdpcm) {
+      // Encode every frame so the predictor tracks the audio, even while
+      // squelched. Packet = state at its first sample + 2 frames of codes.
+      uint8_t *adpcmPayload = voter.getAdpcmPayload();
+      if (!g_adpcmHalf) {
+        dsp.getADPCMState(adpcmPayload);
+        dsp.encodeADPCM(frame, &adpcmPayload[ADPCM_STATE_BYTES], FRAME_SIZE);
+        g_adpcmTime = frameTime;
+        g_adpcmRSSI = finalRSSI;
+        g_adpcmHalf = true;
       } else {
-        accHead = 0;
+        dsp.encodeADPCM(frame,
+                        &adpcmPayload[ADPCM_STATE_BYTES + FRAME_SIZE / 2],
+                        FRAME_SIZE);
+        g_adpcmHalf = false;
+        // Send only if squelch was open for both halves
+        uint8_t pktRSSI =
+            (g_adpcmRSSI < finalRSSI) ? g_adpcmRSSI : finalRSSI;
+        if (pktRSSI > 0)
+          voter.processAdpcmFrame(adpcmPayload, pktRSSI, g_adpcmTime);
       }
+    } else if (finalRSSI > 0) {
+      // Use the proper client method which handles sequence, timestamp, and
+      // sending
+      voter.processAudioFrame(ulawFrame, finalRSSI, frameTime);
+      // Serial.println("[Test] Generated Audio Frame (Not Sent)");
     }
+
+    voterFrames.freeFrame();
   }
 }
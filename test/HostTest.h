@@ -0,0 +1,24 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+// Host tests: plain executables run by ctest (see CMakeLists.txt). CHECK()
+// prints and counts each failure without stopping, so one run shows every
+// broken property; main() returns hostTestResult().
+inline int hostTestFailures = 0;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);          \
+      hostTestFailures++;                                                      \
+    }                                                                          \
+  } while (0)
+
+inline int hostTestResult() {
+  printf("%s\n", hostTestFailures ? "FAILED" : "OK");
+  return hostTestFailures ? 1 : 0;
+}
+
+#endif
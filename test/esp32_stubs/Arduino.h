@@ -0,0 +1,60 @@
+#ifndef HOST_ESP32_ARDUINO_H
+#define HOST_ESP32_ARDUINO_H
+
+// Host stand-in for the arduino-esp32 core and FreeRTOS, for the ESP32
+// bridge firmware (esp32_firmware/Spirit): just what it uses. Serial output
+// is discarded, tasks are never started (the test calls into the firmware),
+// and pins are plain variables.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../stubs/IPAddress.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+class HardwareSerial {
+public:
+  void begin(long) {}
+  template <class T> size_t print(const T &) { return 0; }
+  template <class T> size_t println(const T &) { return 0; }
+  size_t println() { return 0; }
+  int printf(const char *, ...) __attribute__((format(printf, 2, 3))) {
+    return 0;
+  }
+};
+extern HardwareSerial Serial;
+
+uint32_t millis();
+void delay(uint32_t ms);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// --- FreeRTOS ---
+
+typedef void *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *name,
+                                   uint32_t stack, void *arg,
+                                   unsigned priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+#endif
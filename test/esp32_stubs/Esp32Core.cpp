@@ -0,0 +1,100 @@
+// Host stand-in for the arduino-esp32 core, WiFi and FreeRTOS (see Arduino.h)
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <deque>
+#include <driver/spi_slave.h>
+#include <vector>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+
+uint32_t millis() { return 0; }
+void delay(uint32_t) {}
+
+static uint8_t pinLevel[40];
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < 40)
+    pinLevel[pin] = value ? HIGH : LOW;
+}
+int digitalRead(uint8_t pin) { return pin < 40 ? pinLevel[pin] : LOW; }
+
+BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t,
+                                   void *, unsigned, TaskHandle_t *,
+                                   BaseType_t) {
+  return pdPASS;
+}
+void vTaskDelete(TaskHandle_t) {}
+void vTaskDelay(TickType_t) {}
+void xTaskNotifyGive(TaskHandle_t) {}
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+esp_err_t spi_slave_initialize(int, const spi_bus_config_t *,
+                               const spi_slave_interface_config_t *, int) {
+  return ESP_FAIL;
+}
+esp_err_t spi_slave_queue_trans(int, const spi_slave_transaction_t *,
+                                TickType_t) {
+  return ESP_FAIL;
+}
+esp_err_t spi_slave_get_trans_result(int, spi_slave_transaction_t **,
+                                     TickType_t) {
+  return ESP_FAIL;
+}
+
+// --- WiFiUDP ---
+
+struct Arrival {
+  IPAddress from;
+  uint16_t port;
+  std::vector<uint8_t> data;
+};
+static std::deque<Arrival> socketQueue;
+bool hostUdpReadFails = false;
+
+void hostUdpArrive(IPAddress from, uint16_t port, const uint8_t *data,
+                   size_t len) {
+  if (socketQueue.size() < 16) // lwIP receive mailbox
+    socketQueue.push_back({from, port, std::vector<uint8_t>(data, data + len)});
+}
+
+size_t hostUdpQueued() { return socketQueue.size(); }
+
+int WiFiUDP::parsePacket() {
+  if (_held || socketQueue.empty())
+    return 0;
+  Arrival &a = socketQueue.front();
+  _rxLen = a.data.size() < sizeof(_rx) ? a.data.size() : sizeof(_rx);
+  memcpy(_rx, a.data.data(), _rxLen);
+  _rxPos = 0;
+  _remoteIP = a.from;
+  _remotePort = a.port;
+  _held = _rxLen > 0;
+  socketQueue.pop_front();
+  return (int)_rxLen;
+}
+
+int WiFiUDP::available() { return _held ? (int)(_rxLen - _rxPos) : 0; }
+
+int WiFiUDP::read(uint8_t *buffer, size_t len) {
+  if (!_held)
+    return 0;
+  if (hostUdpReadFails) {
+    hostUdpReadFails = false;
+    return 0;
+  }
+  size_t n = _rxLen - _rxPos < len ? _rxLen - _rxPos : len;
+  memcpy(buffer, _rx + _rxPos, n);
+  _rxPos += n;
+  if (_rxPos == _rxLen)
+    _held = false;
+  return (int)n;
+}
+
+void WiFiUDP::flush() { _held = false; }
+
+int WiFiUDP::beginPacket(IPAddress, uint16_t) { return 1; }
+size_t WiFiUDP::write(const uint8_t *, size_t len) { return len; }
+int WiFiUDP::endPacket() { return 1; }
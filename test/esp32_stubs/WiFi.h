@@ -0,0 +1,20 @@
+#ifndef HOST_ESP32_WIFI_H
+#define HOST_ESP32_WIFI_H
+
+#include <Arduino.h>
+
+#define WIFI_STA 1
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+class WiFiClass {
+public:
+  void mode(int) {}
+  void begin(const char *ssid, const char *pass) {}
+  void disconnect() {}
+  int status() { return WL_CONNECTED; }
+  IPAddress localIP() { return IPAddress(192, 168, 1, 77); }
+};
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef HOST_ESP32_WIFIUDP_H
+#define HOST_ESP32_WIFIUDP_H
+
+#include <Arduino.h>
+
+// As arduino-esp32's WiFiUDP: parsePacket() takes one datagram off the
+// socket into a receive buffer and returns its size, but returns 0 while a
+// buffer is still held. The buffer goes when read() has emptied it, or on
+// flush(). Sends go nowhere.
+class WiFiUDP {
+public:
+  int parsePacket();
+  int available();
+  int read(uint8_t *buffer, size_t len);
+  void flush();
+  IPAddress remoteIP() { return _remoteIP; }
+  uint16_t remotePort() { return _remotePort; }
+
+  int beginPacket(IPAddress ip, uint16_t port);
+  size_t write(const uint8_t *data, size_t len);
+  int endPacket();
+
+private:
+  IPAddress _remoteIP;
+  uint16_t _remotePort = 0;
+  bool _held = false;
+  uint8_t _rx[1460];
+  size_t _rxLen = 0, _rxPos = 0;
+};
+
+// --- Host test controls ---
+
+// A datagram arrives at the socket (queued, up to 16)
+void hostUdpArrive(IPAddress from, uint16_t port, const uint8_t *data,
+                   size_t len);
+size_t hostUdpQueued();
+// The next read() returns 0 (copies nothing)
+extern bool hostUdpReadFails;
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef HOST_ESP32_SPI_SLAVE_H
+#define HOST_ESP32_SPI_SLAVE_H
+
+#include <Arduino.h>
+
+// ESP-IDF SPI slave driver, declarations only: the test does not start the
+// SPI task
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define VSPI_HOST 2
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+typedef struct {
+  int mosi_io_num;
+  int miso_io_num;
+  int sclk_io_num;
+  int quadwp_io_num;
+  int quadhd_io_num;
+  int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct {
+  int spics_io_num;
+  uint32_t flags;
+  int queue_size;
+  uint8_t mode;
+  void (*post_setup_cb)(void *trans);
+  void (*post_trans_cb)(void *trans);
+} spi_slave_interface_config_t;
+
+typedef struct {
+  size_t length;
+  size_t trans_len;
+  const void *tx_buffer;
+  void *rx_buffer;
+  void *user;
+} spi_slave_transaction_t;
+
+esp_err_t spi_slave_initialize(int host, const spi_bus_config_t *bus,
+                               const spi_slave_interface_config_t *slave,
+                               int dma);
+esp_err_t spi_slave_queue_trans(int host, const spi_slave_transaction_t *trans,
+                                TickType_t wait);
+esp_err_t spi_slave_get_trans_result(int host, spi_slave_transaction_t **trans,
+                                     TickType_t wait);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the Teensy core: just what the host-tested sources use.
+// Time is simulated (the test moves it), Serial output is discarded, and
+// pins are plain variables whose interrupts the test can fire.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 3
+#define FALLING 4
+#define CHANGE 5
+#define PI 3.14159265358979f
+
+#define F(x) x
+#define FLASHMEM
+#define PROGMEM
+#define DMAMEM
+#define FASTRUN
+
+// Cycle counter: the host has none (cycle figures read 0)
+#define ARM_DWT_CYCCNT 0u
+#define F_CPU_ACTUAL 600000000u
+
+class Print {
+public:
+  size_t print(const char *) { return 0; }
+  size_t print(char) { return 0; }
+  size_t print(int, int = 10) { return 0; }
+  size_t print(unsigned, int = 10) { return 0; }
+  size_t print(long, int = 10) { return 0; }
+  size_t print(unsigned long, int = 10) { return 0; }
+  size_t print(double, int = 2) { return 0; }
+  size_t println() { return 0; }
+  template <class T> size_t println(const T &) { return 0; }
+  int printf(const char *, ...) __attribute__((format(printf, 2, 3))) {
+    return 0;
+  }
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t n) { return n; }
+};
+
+class Stream : public Print {
+public:
+  int available() { return 0; }
+  int read() { return -1; }
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(long) {}
+  operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+long random(long min, long max);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+inline int digitalReadFast(uint8_t pin) { return digitalRead(pin); }
+inline void digitalWriteFast(uint8_t pin, uint8_t value) {
+  digitalWrite(pin, value);
+}
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+inline void yield() {}
+#define __DMB() __sync_synchronize()
+
+template <class T> T constrain(T x, T lo, T hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+#include "IPAddress.h"
+
+// --- Host test controls ---
+
+// Simulated time: millis()/micros() follow it, delay() and
+// delayMicroseconds() advance it (and run hostDelayHook, if set, first).
+// With hostMicrosStepUs set, each micros() call also advances it by that
+// much, so code that spins on micros() gets out.
+void hostSetUs(uint64_t us);
+uint64_t hostNowUs();
+extern void (*hostDelayHook)(uint32_t us);
+extern uint32_t hostMicrosStepUs;
+
+// Drive an input pin from outside; attached interrupts fire on its edges
+void hostSetPin(uint8_t pin, int level);
+// Called on every digitalWrite() (a device watching a chip select)
+extern void (*hostWriteHook)(uint8_t pin, uint8_t value);
+
+#endif
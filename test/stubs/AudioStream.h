@@ -0,0 +1,45 @@
+#ifndef HOST_AUDIO_STREAM_H
+#define HOST_AUDIO_STREAM_H
+
+#include <Arduino.h>
+
+// Teensy Audio library node base, host side. The test plays the audio ISR:
+// it calls update() itself, feeds inputs through hostAudioInput and sees
+// outputs through hostAudioTransmit.
+#define AUDIO_BLOCK_SAMPLES 128
+#define AUDIO_SAMPLE_RATE_EXACT 44117.64706f
+
+typedef struct audio_block_struct {
+  uint8_t ref_count;
+  uint8_t reserved1;
+  uint16_t memory_pool_index;
+  int16_t data[AUDIO_BLOCK_SAMPLES];
+} audio_block_t;
+
+class AudioStream {
+public:
+  AudioStream(unsigned char ninput, audio_block_t **iqueue) {}
+  virtual ~AudioStream() {}
+  virtual void update(void) = 0;
+
+protected:
+  audio_block_t *receiveReadOnly(unsigned int index = 0);
+  audio_block_t *receiveWritable(unsigned int index = 0);
+  static audio_block_t *allocate(void);
+  static void release(audio_block_t *block);
+  void transmit(audio_block_t *block, unsigned char index = 0);
+};
+
+#define AudioNoInterrupts() ((void)0)
+#define AudioInterrupts() ((void)0)
+
+// --- Host test controls ---
+
+// Block handed to the next receiveReadOnly()/receiveWritable() (then
+// cleared), or nullptr for none
+extern audio_block_t *hostAudioInput;
+
+// Called with every transmitted block
+extern void (*hostAudioTransmit)(const audio_block_t *block);
+
+#endif
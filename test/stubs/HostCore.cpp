@@ -0,0 +1,111 @@
+// Host stand-in for the Teensy core and audio library (see Arduino.h)
+#include <Arduino.h>
+#include <AudioStream.h>
+
+HardwareSerial Serial;
+
+// --- Time ---
+
+static uint64_t nowUs = 0;
+void (*hostDelayHook)(uint32_t us) = nullptr;
+uint32_t hostMicrosStepUs = 0;
+
+void hostSetUs(uint64_t us) { nowUs = us; }
+uint64_t hostNowUs() { return nowUs; }
+
+uint32_t micros() {
+  if (hostMicrosStepUs)
+    delayMicroseconds(hostMicrosStepUs);
+  return (uint32_t)nowUs;
+}
+uint32_t millis() { return (uint32_t)(nowUs / 1000); }
+
+void delayMicroseconds(uint32_t us) {
+  // Not re-entered: what the hook runs may read the time too
+  static bool inHook = false;
+  if (hostDelayHook && !inHook) {
+    inHook = true;
+    hostDelayHook(us);
+    inHook = false;
+  }
+  nowUs += us;
+}
+
+void delay(uint32_t ms) { delayMicroseconds(ms * 1000); }
+
+long random(long min, long max) {
+  return max > min ? min + rand() % (max - min) : min;
+}
+
+// --- Pins ---
+
+static uint8_t pinLevel[64];
+static void (*pinIsr[64])();
+static int pinIsrMode[64];
+void (*hostWriteHook)(uint8_t pin, uint8_t value) = nullptr;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (mode == INPUT_PULLUP && pin < 64)
+    pinLevel[pin] = HIGH;
+}
+
+int digitalRead(uint8_t pin) { return pin < 64 ? pinLevel[pin] : LOW; }
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < 64)
+    pinLevel[pin] = value ? HIGH : LOW;
+  if (hostWriteHook)
+    hostWriteHook(pin, value ? HIGH : LOW);
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  if (pin < 64) {
+    pinIsr[pin] = isr;
+    pinIsrMode[pin] = mode;
+  }
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < 64)
+    pinIsr[pin] = nullptr;
+}
+
+void hostSetPin(uint8_t pin, int level) {
+  if (pin >= 64)
+    return;
+  int old = pinLevel[pin];
+  pinLevel[pin] = level ? HIGH : LOW;
+  if (!pinIsr[pin] || old == pinLevel[pin])
+    return;
+  int mode = pinIsrMode[pin];
+  if (mode == CHANGE || (mode == RISING && level) ||
+      (mode == FALLING && !level))
+    pinIsr[pin]();
+}
+
+// --- Audio library ---
+
+audio_block_t *hostAudioInput = nullptr;
+void (*hostAudioTransmit)(const audio_block_t *block) = nullptr;
+
+audio_block_t *AudioStream::receiveReadOnly(unsigned int) {
+  audio_block_t *block = hostAudioInput;
+  hostAudioInput = nullptr;
+  return block;
+}
+
+audio_block_t *AudioStream::receiveWritable(unsigned int index) {
+  return receiveReadOnly(index);
+}
+
+audio_block_t *AudioStream::allocate(void) {
+  static audio_block_t block;
+  return &block;
+}
+
+void AudioStream::release(audio_block_t *) {}
+
+void AudioStream::transmit(audio_block_t *block, unsigned char) {
+  if (hostAudioTransmit)
+    hostAudioTransmit(block);
+}
@@ -0,0 +1,36 @@
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <stdint.h>
+#include <string.h>
+
+// As the Teensy core: four bytes, converting to/from uint32_t in memory
+// (network) order
+class IPAddress {
+public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    _b[0] = a;
+    _b[1] = b;
+    _b[2] = c;
+    _b[3] = d;
+  }
+  IPAddress(uint32_t v) { memcpy(_b, &v, 4); }
+
+  operator uint32_t() const {
+    uint32_t v;
+    memcpy(&v, _b, 4);
+    return v;
+  }
+  uint8_t operator[](int i) const { return _b[i]; }
+  uint8_t &operator[](int i) { return _b[i]; }
+  bool operator==(const IPAddress &o) const {
+    return memcmp(_b, o._b, 4) == 0;
+  }
+  bool operator!=(const IPAddress &o) const { return !(*this == o); }
+
+private:
+  uint8_t _b[4] = {0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,77 @@
+// Host stand-in for NativeEthernet and FNET (see NativeEthernet.h, fnet.h)
+#include <NativeEthernet.h>
+#include <fnet.h>
+
+EthernetClass Ethernet;
+EthernetLinkStatus hostEthLink = LinkON;
+uint32_t hostEthDhcpMs = 0;
+uint32_t hostEthBegins = 0, hostEthDhcpStarts = 0;
+
+static int netif;      // The default interface, once begin() has run
+static int dhcpClient; // Its DHCP client
+static bool stackUp = false, dhcpRunning = false, bound = false;
+static uint32_t dhcpStartMs;
+
+static fnet_dhcp_cln_desc_t startDhcp() {
+  hostEthDhcpStarts++;
+  dhcpRunning = true;
+  bound = false;
+  dhcpStartMs = millis();
+  return &dhcpClient;
+}
+
+// The server answers hostEthDhcpMs after the client started, cable in
+static bool isBound() {
+  if (dhcpRunning && !bound && hostEthLink == LinkON && hostEthDhcpMs &&
+      millis() - dhcpStartMs >= hostEthDhcpMs)
+    bound = true;
+  return bound;
+}
+
+// Brings the stack up and starts a client, then waits for it; one that has
+// not bound by the timeout is released
+int EthernetClass::begin(uint8_t *mac, unsigned long timeout,
+                         unsigned long responseTimeout) {
+  hostEthBegins++;
+  stackUp = true;
+  startDhcp();
+  bool answers = hostEthLink == LinkON && hostEthDhcpMs &&
+                 hostEthDhcpMs <= timeout;
+  delay(answers ? hostEthDhcpMs : timeout);
+  if (!isBound())
+    dhcpRunning = false;
+  return bound ? 1 : 0;
+}
+
+EthernetLinkStatus EthernetClass::linkStatus() { return hostEthLink; }
+
+IPAddress EthernetClass::localIP() {
+  return isBound() ? IPAddress(192, 168, 1, 60) : IPAddress(0, 0, 0, 0);
+}
+
+fnet_netif_desc_t fnet_netif_get_default(void) {
+  return stackUp ? &netif : nullptr;
+}
+
+fnet_ip4_addr_t fnet_netif_get_ip4_addr(fnet_netif_desc_t) {
+  return isBound() ? 0x3C01A8C0 : 0; // 192.168.1.60
+}
+
+fnet_dhcp_cln_desc_t fnet_dhcp_cln_init(struct fnet_dhcp_cln_params_t *params) {
+  if (!params->netif || dhcpRunning)
+    return nullptr;
+  return startDhcp();
+}
+
+void fnet_dhcp_cln_release(fnet_dhcp_cln_desc_t) {
+  dhcpRunning = false;
+  bound = false;
+}
+
+fnet_bool_t fnet_dhcp_cln_is_enabled(fnet_dhcp_cln_desc_t desc) {
+  return desc == &dhcpClient && dhcpRunning;
+}
+
+fnet_dhcp_cln_desc_t fnet_dhcp_cln_get_by_netif(fnet_netif_desc_t netif) {
+  return netif && dhcpRunning ? &dhcpClient : nullptr;
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_NATIVE_ETHERNET_H
+#define HOST_NATIVE_ETHERNET_H
+
+#include <Arduino.h>
+
+// NativeEthernet, host side: DHCP and the link only. begin() blocks on the
+// simulated clock as the library does: for hostEthDhcpMs when the server
+// answers in time, else for the whole timeout. The DHCP client itself is in
+// fnet.h.
+enum EthernetLinkStatus { Unknown, LinkON, LinkOFF };
+
+class EthernetClass {
+public:
+  int begin(uint8_t *mac, unsigned long timeout = 60000,
+            unsigned long responseTimeout = 4000);
+  int maintain() { return 0; }
+  EthernetLinkStatus linkStatus();
+  IPAddress localIP();
+};
+extern EthernetClass Ethernet;
+
+// --- Host test controls ---
+
+extern EthernetLinkStatus hostEthLink;
+// DHCP server answer time; 0: no server
+extern uint32_t hostEthDhcpMs;
+// begin() calls, and DHCP clients started (by begin() or fnet_dhcp_cln_init())
+extern uint32_t hostEthBegins, hostEthDhcpStarts;
+
+#endif
@@ -0,0 +1,65 @@
+// Host stand-in for the Teensy SPI library (see SPI.h)
+#include <SPI.h>
+
+SPIClass SPI;
+uint8_t (*hostSpiDevice)(uint8_t mosi) = nullptr;
+bool hostSpiDmaFail = false;
+
+static uint32_t clockHz = 4000000;
+static EventResponder *dmaEvent = nullptr;
+static uint64_t dmaDoneUs = 0;
+
+static uint8_t exchange(uint8_t mosi) {
+  return hostSpiDevice ? hostSpiDevice(mosi) : 0;
+}
+
+static uint32_t wireUs(size_t count) {
+  return (uint32_t)((count * 8ULL * 1000000ULL + clockHz - 1) / clockHz);
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  clockHz = settings.clock;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  uint8_t in = exchange(data);
+  delayMicroseconds(wireUs(1));
+  return in;
+}
+
+void SPIClass::transfer(const void *txBuffer, void *rxBuffer, size_t count) {
+  const uint8_t *tx = (const uint8_t *)txBuffer;
+  uint8_t *rx = (uint8_t *)rxBuffer;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t in = exchange(tx ? tx[i] : 0);
+    if (rx)
+      rx[i] = in;
+  }
+  delayMicroseconds(wireUs(count));
+}
+
+bool SPIClass::transfer(const void *txBuffer, void *rxBuffer, size_t count,
+                        EventResponderRef event) {
+  if (hostSpiDmaFail || dmaEvent)
+    return false;
+  const uint8_t *tx = (const uint8_t *)txBuffer;
+  uint8_t *rx = (uint8_t *)rxBuffer;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t in = exchange(tx ? tx[i] : 0);
+    if (rx)
+      rx[i] = in;
+  }
+  dmaEvent = &event;
+  dmaDoneUs = hostNowUs() + wireUs(count);
+  return true;
+}
+
+void hostSpiPoll() {
+  if (!dmaEvent || hostNowUs() < dmaDoneUs)
+    return;
+  EventResponder *event = dmaEvent;
+  dmaEvent = nullptr;
+  event->triggerEvent();
+}
+
+uint32_t hostSpiClock() { return clockHz; }
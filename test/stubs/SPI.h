@@ -0,0 +1,69 @@
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+// Host stand-in for the Teensy SPI library and EventResponder: a master whose
+// bytes go to a device the test plugs in (hostSpiDevice). Blocking transfers
+// take their wire time (8 bits per clock) of simulated time; a DMA transfer
+// moves its bytes at once and its event fires from the first hostSpiPoll()
+// once the wire time has passed.
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST,
+              uint8_t dataMode = SPI_MODE0)
+      : clock(clock) {}
+  uint32_t clock;
+};
+
+class EventResponder;
+typedef EventResponder &EventResponderRef;
+typedef void (*EventResponderFunction)(EventResponderRef);
+
+class EventResponder {
+public:
+  void setContext(void *context) { _context = context; }
+  void *getContext() { return _context; }
+  void attachImmediate(EventResponderFunction function) {
+    _function = function;
+  }
+  void triggerEvent(int status = 0, void *data = nullptr) {
+    if (_function)
+      _function(*this);
+  }
+
+private:
+  void *_context = nullptr;
+  EventResponderFunction _function = nullptr;
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void beginTransaction(SPISettings settings);
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data);
+  void transfer(void *buf, size_t count) { transfer(buf, buf, count); }
+  void transfer(const void *txBuffer, void *rxBuffer, size_t count);
+  bool transfer(const void *txBuffer, void *rxBuffer, size_t count,
+                EventResponderRef event);
+};
+extern SPIClass SPI;
+
+// --- Host test controls ---
+
+// The device on the bus: one byte each way (MISO reads 0 without one)
+extern uint8_t (*hostSpiDevice)(uint8_t mosi);
+// DMA transfers are refused (the caller falls back to blocking)
+extern bool hostSpiDmaFail;
+// Fire the event of a DMA transfer whose wire time has passed
+void hostSpiPoll();
+// Clock of the current transaction
+uint32_t hostSpiClock();
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef HOST_TINYGPSPLUS_H
+#define HOST_TINYGPSPLUS_H
+
+// TinyGPSPlus, host side: the type only, for headers that hold one (tests
+// stand in for GPSManager rather than parse NMEA)
+class TinyGPSPlus {};
+
+#endif
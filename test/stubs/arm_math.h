@@ -0,0 +1,239 @@
+#ifndef HOST_ARM_MATH_H
+#define HOST_ARM_MATH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// CMSIS-DSP, host side: plain C versions of the kernels the host-tested
+// sources use. The Q15 ones follow the CMSIS arithmetic (accumulator width,
+// truncating shifts, saturation), so host results match the target bit for
+// bit; the float ones match up to summation order.
+typedef float float32_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+typedef enum { ARM_MATH_SUCCESS = 0, ARM_MATH_ARGUMENT_ERROR = -1 } arm_status;
+
+inline q15_t hostSat15(int32_t x) {
+  return (q15_t)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+}
+
+inline void arm_dot_prod_f32(const float32_t *a, const float32_t *b,
+                             uint32_t n, float32_t *result) {
+  float32_t sum = 0.0f;
+  for (uint32_t i = 0; i < n; i++)
+    sum += a[i] * b[i];
+  *result = sum;
+}
+
+inline void arm_mult_f32(const float32_t *a, const float32_t *b,
+                         float32_t *dst, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++)
+    dst[i] = a[i] * b[i];
+}
+
+inline void arm_cmplx_mag_squared_f32(const float32_t *src, float32_t *dst,
+                                      uint32_t n) {
+  for (uint32_t i = 0; i < n; i++)
+    dst[i] = src[2 * i] * src[2 * i] + src[2 * i + 1] * src[2 * i + 1];
+}
+
+inline void arm_q15_to_float(const q15_t *src, float32_t *dst, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++)
+    dst[i] = (float32_t)src[i] / 32768.0f;
+}
+
+// Truncating, as CMSIS without ARM_MATH_ROUNDING
+inline void arm_float_to_q15(const float32_t *src, q15_t *dst, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++)
+    dst[i] = hostSat15((q31_t)(src[i] * 32768.0f));
+}
+
+// --- FIR: state holds numTaps - 1 samples of history, then the block;
+// coefficients are time reversed (pCoeffs[numTaps - 1] meets the newest) ---
+
+struct arm_fir_instance_f32 {
+  uint16_t numTaps;
+  float32_t *pState;
+  const float32_t *pCoeffs;
+};
+
+inline void arm_fir_init_f32(arm_fir_instance_f32 *S, uint16_t numTaps,
+                             const float32_t *pCoeffs, float32_t *pState,
+                             uint32_t blockSize) {
+  S->numTaps = numTaps;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  memset(pState, 0, (numTaps + blockSize - 1) * sizeof(float32_t));
+}
+
+inline void arm_fir_f32(const arm_fir_instance_f32 *S, const float32_t *src,
+                        float32_t *dst, uint32_t blockSize) {
+  float32_t *x = S->pState;
+  memcpy(x + S->numTaps - 1, src, blockSize * sizeof(float32_t));
+  for (uint32_t n = 0; n < blockSize; n++) {
+    float32_t acc = 0.0f;
+    for (uint16_t k = 0; k < S->numTaps; k++)
+      acc += x[n + k] * S->pCoeffs[k];
+    dst[n] = acc;
+  }
+  memmove(x, x + blockSize, (S->numTaps - 1) * sizeof(float32_t));
+}
+
+struct arm_fir_instance_q15 {
+  uint16_t numTaps;
+  q15_t *pState;
+  const q15_t *pCoeffs;
+};
+
+inline arm_status arm_fir_init_q15(arm_fir_instance_q15 *S, uint16_t numTaps,
+                                   const q15_t *pCoeffs, q15_t *pState,
+                                   uint32_t blockSize) {
+  if (numTaps < 4 || (numTaps & 1))
+    return ARM_MATH_ARGUMENT_ERROR;
+  S->numTaps = numTaps;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  memset(pState, 0, (numTaps + blockSize) * sizeof(q15_t));
+  return ARM_MATH_SUCCESS;
+}
+
+// 2.30 products summed in a 32-bit accumulator (wraps on overflow), then
+// shifted down 15 and saturated
+inline void arm_fir_fast_q15(const arm_fir_instance_q15 *S, const q15_t *src,
+                             q15_t *dst, uint32_t blockSize) {
+  q15_t *x = S->pState;
+  memcpy(x + S->numTaps - 1, src, blockSize * sizeof(q15_t));
+  for (uint32_t n = 0; n < blockSize; n++) {
+    uint32_t acc = 0;
+    for (uint16_t k = 0; k < S->numTaps; k++)
+      acc += (uint32_t)((q31_t)x[n + k] * S->pCoeffs[k]);
+    dst[n] = hostSat15((q31_t)acc >> 15);
+  }
+  memmove(x, x + blockSize, (S->numTaps - 1) * sizeof(q15_t));
+}
+
+// Sum of squares in 34.30
+inline void arm_power_q15(const q15_t *src, uint32_t n, q63_t *result) {
+  q63_t sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    sum += (q31_t)src[i] * src[i];
+  *result = sum;
+}
+
+// --- Biquad DF1: state {x[n-1], x[n-2], y[n-1], y[n-2]} per stage ---
+
+struct arm_biquad_casd_df1_inst_f32 {
+  uint32_t numStages;
+  float32_t *pState;
+  const float32_t *pCoeffs; // {b0, b1, b2, a1, a2} per stage
+};
+
+inline void arm_biquad_cascade_df1_init_f32(arm_biquad_casd_df1_inst_f32 *S,
+                                            uint8_t numStages,
+                                            const float32_t *pCoeffs,
+                                            float32_t *pState) {
+  S->numStages = numStages;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  memset(pState, 0, 4u * numStages * sizeof(float32_t));
+}
+
+inline void arm_biquad_cascade_df1_f32(const arm_biquad_casd_df1_inst_f32 *S,
+                                       const float32_t *src, float32_t *dst,
+                                       uint32_t blockSize) {
+  for (uint32_t s = 0; s < S->numStages; s++) {
+    const float32_t *c = S->pCoeffs + 5 * s;
+    float32_t *st = S->pState + 4 * s;
+    for (uint32_t n = 0; n < blockSize; n++) {
+      float32_t x = src[n];
+      float32_t y = c[0] * x + c[1] * st[0] + c[2] * st[1] + c[3] * st[2] +
+                    c[4] * st[3];
+      st[1] = st[0], st[0] = x, st[3] = st[2], st[2] = y;
+      dst[n] = y;
+    }
+    src = dst;
+  }
+}
+
+struct arm_biquad_casd_df1_inst_q15 {
+  int8_t numStages;
+  q15_t *pState;
+  const q15_t *pCoeffs; // {b0, 0, b1, b2, a1, a2} per stage
+  int8_t postShift;
+};
+
+inline void arm_biquad_cascade_df1_init_q15(arm_biquad_casd_df1_inst_q15 *S,
+                                            uint8_t numStages,
+                                            const q15_t *pCoeffs,
+                                            q15_t *pState, int8_t postShift) {
+  S->numStages = (int8_t)numStages;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  S->postShift = postShift;
+  memset(pState, 0, 4u * numStages * sizeof(q15_t));
+}
+
+// 32-bit accumulator (wraps), shifted down by 15 - postShift, saturated
+inline void
+arm_biquad_cascade_df1_fast_q15(const arm_biquad_casd_df1_inst_q15 *S,
+                                const q15_t *src, q15_t *dst,
+                                uint32_t blockSize) {
+  const int shift = 15 - S->postShift;
+  for (int s = 0; s < S->numStages; s++) {
+    const q15_t *c = S->pCoeffs + 6 * s;
+    q15_t *st = S->pState + 4 * s;
+    for (uint32_t n = 0; n < blockSize; n++) {
+      q15_t x = src[n];
+      uint32_t acc = (uint32_t)((q31_t)c[0] * x);
+      acc += (uint32_t)((q31_t)c[2] * st[0]);
+      acc += (uint32_t)((q31_t)c[3] * st[1]);
+      acc += (uint32_t)((q31_t)c[4] * st[2]);
+      acc += (uint32_t)((q31_t)c[5] * st[3]);
+      q15_t y = hostSat15((q31_t)acc >> shift);
+      st[1] = st[0], st[0] = x, st[3] = st[2], st[2] = y;
+      dst[n] = y;
+    }
+    src = dst;
+  }
+}
+
+// --- Real FFT (direct DFT; same packed output as CMSIS: {X[0].re,
+// X[N/2].re, X[1].re, X[1].im, ...}) ---
+
+struct arm_rfft_fast_instance_f32 {
+  uint16_t fftLenRFFT;
+  float32_t cosTable[4096]; // cos(2 pi i / N), i < N
+};
+
+inline arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S,
+                                         uint16_t fftLen) {
+  if (fftLen > 4096)
+    return ARM_MATH_ARGUMENT_ERROR;
+  S->fftLenRFFT = fftLen;
+  for (int i = 0; i < fftLen; i++)
+    S->cosTable[i] = (float32_t)cos(2.0 * M_PI * i / fftLen);
+  return ARM_MATH_SUCCESS;
+}
+
+inline void arm_rfft_fast_f32(const arm_rfft_fast_instance_f32 *S,
+                              float32_t *src, float32_t *dst, uint8_t ifft) {
+  const int n = S->fftLenRFFT;
+  for (int k = 0; k <= n / 2; k++) {
+    double re = 0.0, im = 0.0;
+    for (int i = 0, a = 0; i < n; i++, a = (a + k) % n) {
+      re += src[i] * S->cosTable[a];
+      im -= src[i] * S->cosTable[(a + 3 * n / 4) % n]; // sin
+    }
+    if (k == 0)
+      dst[0] = (float32_t)re;
+    else if (k == n / 2)
+      dst[1] = (float32_t)re;
+    else
+      dst[2 * k] = (float32_t)re, dst[2 * k + 1] = (float32_t)im;
+  }
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef HOST_FNET_H
+#define HOST_FNET_H
+
+#include <stdint.h>
+
+// FNET (the stack under NativeEthernet), host side: the default interface
+// and its DHCP client only. The interface exists once Ethernet.begin() has
+// run; a client's address comes hostEthDhcpMs after it started (see
+// NativeEthernet.h).
+typedef void *fnet_netif_desc_t;
+typedef void *fnet_dhcp_cln_desc_t;
+typedef uint32_t fnet_ip4_addr_t;
+typedef int fnet_bool_t;
+
+struct fnet_in_addr {
+  fnet_ip4_addr_t s_addr;
+};
+
+struct fnet_dhcp_cln_params_t {
+  fnet_netif_desc_t netif;
+  struct fnet_in_addr requested_ip_address;
+  uint32_t requested_lease_time;
+  fnet_bool_t probe_addr;
+};
+
+fnet_netif_desc_t fnet_netif_get_default(void);
+fnet_ip4_addr_t fnet_netif_get_ip4_addr(fnet_netif_desc_t netif);
+fnet_dhcp_cln_desc_t fnet_dhcp_cln_init(struct fnet_dhcp_cln_params_t *params);
+void fnet_dhcp_cln_release(fnet_dhcp_cln_desc_t desc);
+fnet_bool_t fnet_dhcp_cln_is_enabled(fnet_dhcp_cln_desc_t desc);
+fnet_dhcp_cln_desc_t fnet_dhcp_cln_get_by_netif(fnet_netif_desc_t netif);
+
+#endif
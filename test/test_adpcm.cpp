@@ -0,0 +1,242 @@
+// IMA ADPCM (PAYLOAD_ADPCM): the round trip, step index and predictor
+// clamps, and the packed two-frame payload as loop() builds it, checked
+// against Jansen's public-domain adpcm.c (the IMA/DVI reference coder) and
+// pinned by a fixed vector.
+#include "Adpcm.h"
+#include "ConfigManager.h"
+#include "DSPProcessor.h"
+#include "HostTest.h"
+#include "ULaw.h"
+
+ConfigManager::ConfigManager() {}
+ConfigManager cfg;
+
+// Jack Jansen's adpcm_coder() (CWI, 1992), as published
+static const int kIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                    -1, -1, -1, -1, 2, 4, 6, 8};
+static const int kStepsizeTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+struct JansenState {
+  short valprev;
+  char index;
+};
+
+static void jansenCoder(const short *indata, uint8_t *outdata, int len,
+                        JansenState *state) {
+  int valpred = state->valprev, index = state->index;
+  int step = kStepsizeTable[index], outputbuffer = 0, bufferstep = 1;
+  for (; len > 0; len--) {
+    int val = *indata++;
+    int diff = val - valpred;
+    int sign = (diff < 0) ? 8 : 0;
+    if (sign)
+      diff = -diff;
+    int delta = 0, vpdiff = step >> 3;
+    if (diff >= step) {
+      delta = 4;
+      diff -= step;
+      vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+      delta |= 2;
+      diff -= step;
+      vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+      delta |= 1;
+      vpdiff += step;
+    }
+    if (sign)
+      valpred -= vpdiff;
+    else
+      valpred += vpdiff;
+    if (valpred > 32767)
+      valpred = 32767;
+    else if (valpred < -32768)
+      valpred = -32768;
+    delta |= sign;
+    index += kIndexTable[delta];
+    if (index < 0)
+      index = 0;
+    if (index > 88)
+      index = 88;
+    step = kStepsizeTable[index];
+    if (bufferstep)
+      outputbuffer = (delta << 4) & 0xf0;
+    else
+      *outdata++ = (uint8_t)((delta & 0x0f) | outputbuffer);
+    bufferstep = !bufferstep;
+  }
+  state->valprev = (short)valpred;
+  state->index = (char)index;
+}
+
+// The [B] benchmark signal: 700Hz, its 3.3x overtone and white noise
+static void makeFrame(int16_t *frame, uint32_t *noise, float *phase) {
+  const float inc = 2.0f * PI * 700.0f / 8000.0f;
+  for (int i = 0; i < FRAME_SIZE; i++) {
+    *noise = *noise * 1664525u + 1013904223u; // LCG
+    frame[i] = (int16_t)(8000.0f * sinf(*phase) + 3000.0f * sinf(3.3f * *phase) +
+                         (float)((int32_t)(*noise >> 22) - 512));
+    *phase += inc;
+    if (*phase >= 2.0f * PI)
+      *phase -= 2.0f * PI;
+  }
+}
+
+// One PAYLOAD_ADPCM payload, as loop() builds it from two frames
+static void buildPayload(VoterFrameDSP &dsp, const int16_t *first,
+                         const int16_t *second, uint8_t *payload) {
+  dsp.getADPCMState(payload);
+  dsp.encodeADPCM(first, &payload[ADPCM_STATE_BYTES], FRAME_SIZE);
+  dsp.encodeADPCM(second, &payload[ADPCM_STATE_BYTES + FRAME_SIZE / 2],
+                  FRAME_SIZE);
+}
+
+// Decode a payload from its own header, as the host does
+static void decodePayload(const uint8_t *payload, int16_t *out) {
+  AdpcmState s;
+  s.predictor = (int16_t)((payload[0] << 8) | payload[1]);
+  s.index = payload[2];
+  for (int i = 0; i < ADPCM_SAMPLES; i++) {
+    uint8_t b = payload[ADPCM_STATE_BYTES + i / 2];
+    out[i] = adpcmDecodeSample(&s, (i & 1) ? (b & 0x0F) : (b >> 4));
+  }
+}
+
+static double snrDb(double sig, double err) {
+  return err > 0.0 ? 10.0 * log10(sig / err) : 120.0;
+}
+
+// 10s of the benchmark signal in payloads, each decoded on its own; uLaw on
+// the same frames for comparison
+static void testRoundTrip() {
+  static VoterFrameDSP dsp;
+  dsp.reset();
+  int16_t a[FRAME_SIZE], b[FRAME_SIZE], out[ADPCM_SAMPLES];
+  uint8_t payload[ADPCM_FRAME_SIZE];
+  uint32_t noise = 12345;
+  float phase = 0.0f;
+  double sig = 0.0, errAdpcm = 0.0, errULaw = 0.0;
+  for (int p = 0; p < 250; p++) {
+    makeFrame(a, &noise, &phase);
+    makeFrame(b, &noise, &phase);
+    buildPayload(dsp, a, b, payload);
+    decodePayload(payload, out);
+    if (p == 0)
+      continue; // Predictor and step settling from rest
+    for (int i = 0; i < ADPCM_SAMPLES; i++) {
+      int16_t x = (i < FRAME_SIZE) ? a[i] : b[i - FRAME_SIZE];
+      double da = (double)x - out[i];
+      double du = (double)x - ulawDecode(ulawEncode(x));
+      sig += (double)x * x;
+      errAdpcm += da * da;
+      errULaw += du * du;
+    }
+  }
+  printf("Round trip SNR on the [B] signal: ADPCM %.1f dB, uLaw %.1f dB\n",
+         snrDb(sig, errAdpcm), snrDb(sig, errULaw));
+  CHECK(snrDb(sig, errAdpcm) > 20.0);
+  CHECK(snrDb(sig, errULaw) > 35.0);
+}
+
+// The step index stays in 0..88 and the predictor saturates, never wraps
+static void testClamps() {
+  AdpcmState s = {0, 88};
+  adpcmStep(&s, 7); // Largest step up at the top of the table
+  CHECK(s.index == 88);
+  s = {0, 0};
+  adpcmStep(&s, 0); // Smallest step down at the bottom
+  CHECK(s.index == 0);
+  s = {32000, 88};
+  CHECK(adpcmStep(&s, 7) == 32767);
+  s = {-32000, 88};
+  CHECK(adpcmStep(&s, 15) == -32768);
+
+  // Full-scale square wave, then silence: the index runs to both ends, and
+  // the predictor never moves against the code's sign (a wrap would)
+  AdpcmState e = {0, 0};
+  int hi = 0, lo = 88, wraps = 0;
+  for (int i = 0; i < 4000; i++) {
+    int16_t x = (i < 2000) ? ((i / 4) & 1 ? 32767 : -32768) : 0;
+    int16_t before = e.predictor;
+    uint8_t code = adpcmEncodeSample(&e, x);
+    hi = std::max(hi, (int)e.index);
+    if (i >= 2000)
+      lo = std::min(lo, (int)e.index);
+    if ((code & 8) ? e.predictor > before : e.predictor < before)
+      wraps++;
+  }
+  printf("Step index over a full-scale square then silence: %d to %d, "
+         "%d predictor wraps\n",
+         lo, hi, wraps);
+  CHECK(hi == 88 && lo == 0);
+  CHECK(wraps == 0);
+}
+
+// The payload matches Jansen's coder fed the same samples from the state in
+// its header, and a fixed vector pins the layout: big-endian predictor,
+// step index, then the first frame's codes and the second's, first sample
+// of each byte in the high nibble
+static void testPayloadLayout() {
+  static VoterFrameDSP dsp;
+  dsp.reset();
+  int16_t a[FRAME_SIZE], b[FRAME_SIZE];
+  uint8_t payload[ADPCM_FRAME_SIZE];
+  uint32_t noise = 1;
+  float phase = 0.0f;
+  // Skip ahead to a payload that starts mid-stream with a negative
+  // predictor, so the header's sign is covered
+  for (int p = 0; p < 2 || !(payload[0] & 0x80); p++) {
+    makeFrame(a, &noise, &phase);
+    makeFrame(b, &noise, &phase);
+    // Move the second frame off the first (so a swap of halves shows)
+    for (int i = 0; i < FRAME_SIZE; i++)
+      b[i] = (int16_t)(b[i] / 2 + 5000);
+    buildPayload(dsp, a, b, payload);
+  }
+
+  JansenState js;
+  js.valprev = (short)((payload[0] << 8) | payload[1]);
+  js.index = (char)payload[2];
+  short both[ADPCM_SAMPLES];
+  memcpy(both, a, sizeof(a));
+  memcpy(both + FRAME_SIZE, b, sizeof(b));
+  uint8_t ref[ADPCM_SAMPLES / 2];
+  jansenCoder(both, ref, ADPCM_SAMPLES, &js);
+  CHECK(memcmp(ref, &payload[ADPCM_STATE_BYTES], sizeof(ref)) == 0);
+
+  // Predictor -24, index 65, codes
+  static const uint8_t kHead[] = {0xFF, 0xE8, 0x41, 0xF3, 0x21,
+                                  0x91, 0x1F, 0xA0, 0x99, 0x34};
+  static const uint8_t kSecond[] = {0x61, 0x00, 0x80, 0x0A, 0x90};
+  printf("Payload: %d bytes, head", ADPCM_FRAME_SIZE);
+  for (int i = 0; i < (int)sizeof(kHead); i++)
+    printf(" %02X", payload[i]);
+  printf(", second frame");
+  for (int i = 0; i < (int)sizeof(kSecond); i++)
+    printf(" %02X", payload[ADPCM_STATE_BYTES + FRAME_SIZE / 2 + i]);
+  printf("\n");
+  CHECK(ADPCM_FRAME_SIZE == 163);
+  CHECK(memcmp(payload, kHead, sizeof(kHead)) == 0);
+  CHECK(memcmp(&payload[ADPCM_STATE_BYTES + FRAME_SIZE / 2], kSecond,
+               sizeof(kSecond)) == 0);
+}
+
+int main() {
+  testRoundTrip();
+  testClamps();
+  testPayloadLayout();
+  return hostTestResult();
+}
@@ -0,0 +1,198 @@
+// Link bonding: NetworkManager over two mock links (Ethernet primary, WiFi
+// backup), with 20ms frames on the simulated clock. The mock "host" answers
+// every keepalive on the link it went out on, unless its upstream is dead.
+// Links are dropped and restored between frames; a frame handed to a link
+// that is down is lost.
+#include "ConfigManager.h"
+#include "HostTest.h"
+#include "NetworkManager.h"
+
+struct MockLink : NetworkDriver {
+  DriverType type;
+  bool up = true;
+  bool answering = true; // Upstream alive
+  uint32_t frames = 0, lost = 0, keepalives = 0;
+  uint8_t answers = 0; // Waiting to be read
+
+  explicit MockLink(DriverType t) : type(t) {}
+  bool begin(uint8_t *) override { return true; }
+  void update() override {}
+  bool isConnected() override { return up; }
+  IPAddress getLocalIP() override { return IPAddress(10, 0, 0, 2); }
+  DriverType getType() override { return type; }
+  void setTarget(IPAddress, uint16_t) override {}
+  void sendPacket(const uint8_t *, uint16_t) override {}
+  void sendPacketTo(const uint8_t *data, uint16_t, IPAddress,
+                    uint16_t) override {
+    if (data[0] == 'K') {
+      keepalives++;
+      if (up && answering)
+        answers++;
+    } else if (up) {
+      frames++;
+    } else {
+      lost++;
+    }
+  }
+  int parsePacket() override { return answers ? 1 : 0; }
+  int read(uint8_t *buffer, size_t) override {
+    if (!answers)
+      return 0;
+    answers--;
+    buffer[0] = 'K';
+    return 1;
+  }
+};
+
+static MockLink eth(DRIVER_ETHERNET), wifi(DRIVER_WIFI_SPI);
+static NetworkManager net;
+static uint8_t mac[6];
+static int frame;
+
+static void start(uint8_t mode) {
+  eth = MockLink(DRIVER_ETHERNET);
+  wifi = MockLink(DRIVER_WIFI_SPI);
+  hostSetUs(1000000);
+  net = NetworkManager();
+  net.begin(&eth, mac);
+  net.addLink(&wifi);
+  net.setBondMode(mode);
+  frame = 0;
+}
+
+// One 20ms frame: receive (answers confirm their link), a keepalive every
+// 25th, then the frame
+static void step() {
+  const uint8_t audio[1] = {'A'}, keepalive[1] = {'K'};
+  uint8_t buf[1];
+  hostSetUs(hostNowUs() + 20000);
+  net.update();
+  while (net.parsePacket() > 0) {
+    net.read(buf, sizeof(buf));
+    net.confirmLink(net.getRxLink());
+  }
+  if (frame % 25 == 0)
+    net.sendKeepaliveTo(keepalive, 1, IPAddress(10, 0, 0, 1), 1667);
+  net.sendPacketTo(audio, 1, IPAddress(10, 0, 0, 1), 1667);
+  frame++;
+}
+
+static void steps(int n) {
+  for (int i = 0; i < n; i++)
+    step();
+}
+
+// Frames until the frame goes out on link (at most limit)
+static int framesUntil(MockLink &link, int limit) {
+  for (int n = 1; n <= limit; n++) {
+    uint32_t before = link.frames;
+    step();
+    if (link.frames != before)
+      return n;
+  }
+  return -1;
+}
+
+// Each drop moves the next frame to the other link; nothing is lost
+static void testFailover() {
+  start(NET_BOND_FAILOVER);
+  steps(50);
+  eth.up = false;
+  step();
+  CHECK(wifi.frames == 1);
+  steps(49);
+  eth.up = true;
+  steps(50);
+  uint32_t held = wifi.frames - 50; // Failback held off
+  wifi.up = false;
+  step();
+  CHECK(eth.frames == 51);
+  steps(49);
+  printf("Failover: Ethernet drop -> WiFi on the next frame, WiFi drop -> "
+         "Ethernet on the next frame, %lu lost; failback held %lu/50 "
+         "frames\n",
+         (unsigned long)(eth.lost + wifi.lost), (unsigned long)held);
+  CHECK(eth.lost + wifi.lost == 0);
+  CHECK(held == 50);
+  CHECK(net.getLinkStats(1).probes > 0); // WiFi probed while standby
+}
+
+// Cable pull and back: failback after NET_FAILBACK_MS of health
+static void testFailback() {
+  start(NET_BOND_FAILOVER);
+  steps(50);
+  eth.up = false;
+  step();
+  steps(99);
+  eth.up = true;
+  int n = framesUntil(eth, 1000);
+  printf("Failback: back on Ethernet %d frames (%d ms) after it returned\n", n,
+         n * 20);
+  CHECK(n * 20 >= NET_FAILBACK_MS && n * 20 <= NET_FAILBACK_MS + 40);
+  CHECK(eth.lost + wifi.lost == 0);
+}
+
+// Ethernet stays connected but its upstream is dead: once something sent on
+// it has gone unanswered for NET_SILENT_MS it is silent, and WiFi takes over
+static void testDeadUpstream() {
+  start(NET_BOND_FAILOVER);
+  steps(50);
+  eth.answering = false;
+  int n = framesUntil(wifi, 1000);
+  uint32_t sinceAnswer = millis() - net.getLinkStats(0).lastConfirmMs;
+  printf("Dead upstream: on WiFi %lu ms after the last answer\n",
+         (unsigned long)sinceAnswer);
+  CHECK(n > 0);
+  CHECK(sinceAnswer >= NET_SILENT_MS && sinceAnswer <= NET_SILENT_MS + 40);
+  CHECK(net.getLinkHealth(0) == NET_LINK_SILENT);
+}
+
+// Ten one-frame drops 0.8s apart: one switch to WiFi and one back, 5s after
+// the last drop
+static void testFlapping() {
+  start(NET_BOND_FAILOVER);
+  steps(50);
+  uint32_t failovers = net.getFailovers();
+  for (int i = 0; i < 10; i++) {
+    eth.up = false;
+    step();
+    eth.up = true;
+    steps(39);
+  }
+  int n = framesUntil(eth, 1000) + 39;
+  printf("Flapping: 10 drops 0.8 s apart, %lu link changes, back on Ethernet "
+         "%d ms after the last drop\n",
+         (unsigned long)(net.getFailovers() - failovers), n * 20);
+  CHECK(net.getFailovers() - failovers == 2);
+  CHECK(n * 20 >= NET_FAILBACK_MS && n * 20 <= NET_FAILBACK_MS + 40);
+}
+
+// Both down: frames are lost; the first link back takes the next frame
+static void testBothDown() {
+  start(NET_BOND_FAILOVER);
+  steps(50);
+  eth.up = wifi.up = false;
+  steps(10);
+  CHECK(eth.lost + wifi.lost == 10);
+  wifi.up = true;
+  step();
+  CHECK(wifi.frames == 1);
+}
+
+static void testDuplicate() {
+  start(NET_BOND_DUPLICATE);
+  steps(50);
+  printf("Duplicate: %lu/50 on Ethernet, %lu/50 on WiFi\n",
+         (unsigned long)eth.frames, (unsigned long)wifi.frames);
+  CHECK(eth.frames == 50 && wifi.frames == 50);
+}
+
+int main() {
+  testFailover();
+  testFailback();
+  testDeadUpstream();
+  testFlapping();
+  testBothDown();
+  testDuplicate();
+  return hostTestResult();
+}
@@ -0,0 +1,283 @@
+// Capture timestamps. First the resampler alone: a tone through the
+// downsampler, with each output placed at the time it reports for it (block
+// offset + k * ratio); the tone's phase at those times must match the
+// output, so any residual is a timing error of the frame stamps. Then the
+// frame queue, with the audio ISR dispatched 0-30us late and loop()
+// draining frames in bursts: stamps must stay on the 20ms grid. Last, the
+// stamps through loop()'s chain (GPS time at capture, FrameClock,
+// VoterClient) to the wire: the VTIME sent must be the capture time.
+#include "AudioVoterFrameQueue.h"
+#include "ConfigManager.h"
+#include "FrameClock.h"
+#include "HostTest.h"
+#include "VoterClient.h"
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+// GPSManager stand-in: locked, GPS time = kEpochUs + micros()
+static const uint64_t kEpochUs = 1700000000ULL * 1000000ULL;
+static VTIME toVtime(uint64_t us) {
+  return {(uint32_t)(us / 1000000), (uint32_t)(us % 1000000 * 1000)};
+}
+GPSManager::GPSManager() {}
+bool GPSManager::isLocked() { return true; }
+void GPSManager::getNetworkTime(VTIME *t) { *t = toVtime(kEpochUs + micros()); }
+void GPSManager::getTimeAt(uint32_t atMicros, VTIME *t) {
+  *t = toVtime(kEpochUs + atMicros);
+}
+void GPSManager::getGPSStrings(char *lat, char *lon, char *elev) {}
+
+static constexpr DownsampleTable resampleTable = DownsampleTable::design(
+    RESAMPLER_CUTOFF / AUDIO_SAMPLE_RATE_EXACT, RESAMPLER_BETA);
+
+static void testBlockOffset() {
+  static Downsampler d;
+  const double ratio = AUDIO_SAMPLE_RATE_EXACT / 8000.0;
+  const double freqs[] = {1000.0, 2500.0};
+
+  for (double f : freqs) {
+    double worst = 0.0;
+    for (int trial = 0; trial < 4; trial++) {
+      d.begin(&resampleTable, ratio);
+      double w = 2.0 * M_PI * f / AUDIO_SAMPLE_RATE_EXACT, ph = trial * 0.7;
+      double I = 0.0, Q = 0.0;
+      int16_t in[AUDIO_BLOCK_SAMPLES];
+      int16_t out[Downsampler::maxOutput(AUDIO_SAMPLE_RATE_EXACT / 8000.0)];
+      for (int b = 0; b < 60; b++) {
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+          in[i] = (int16_t)(10000.0 * sin(w * (b * AUDIO_BLOCK_SAMPLES + i) +
+                                          ph));
+        int n = d.process(in, AUDIO_BLOCK_SAMPLES, out,
+                          (int)(sizeof(out) / sizeof(out[0])));
+        if (b < 4)
+          continue; // Filter settling
+        for (int k = 0; k < n; k++) {
+          double t = b * AUDIO_BLOCK_SAMPLES + d.getBlockOffset() + k * ratio;
+          I += out[k] * cos(w * t + ph);
+          Q += out[k] * sin(w * t + ph);
+        }
+      }
+      double errUs = atan2(-I, Q) / (2.0 * M_PI * f) * 1e6;
+      worst = std::max(worst, fabs(errUs));
+    }
+    printf("Block offset: %.0f Hz output timing within %.3f us\n", f, worst);
+    CHECK(worst < 0.1);
+  }
+}
+
+static void testFrameStamps() {
+  static AudioVoterFrameQueue q;
+  static audio_block_t block;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> dispatch(0.0, 30.0);
+  std::uniform_int_distribution<int> drainEvery(1, 12);
+  const double t0 = 1e6; // First sample of block 0 at the ADC
+  std::vector<int32_t> stamps;
+
+  memset(&block, 0, sizeof(block));
+  q.begin(&resampleTable);
+  int nextDrain = 0;
+  for (int b = 0; b < 3000; b++) {
+    // update() runs one block + the ADC delay after the block's first
+    // sample, plus the dispatch delay
+    hostSetUs((uint64_t)(t0 + (b + 1) * FRAMEQ_BLOCK_US + FRAMEQ_ADC_DELAY_US +
+                         dispatch(rng)));
+    hostAudioInput = &block;
+    q.update();
+    if (b >= nextDrain) {
+      nextDrain = b + drainEvery(rng);
+      while (q.available()) {
+        stamps.push_back((int32_t)(q.readFrame()->captureMicros - (uint32_t)t0));
+        q.freeFrame();
+      }
+    }
+  }
+
+  // Frame k's first sample is ideally at c + k * 20ms (c: where the
+  // resampler starts). Skip the first second while the block clock settles.
+  const size_t skip = 50;
+  double c = 0.0;
+  for (size_t k = skip; k < stamps.size(); k++)
+    c += stamps[k] - k * 20000.0;
+  c /= stamps.size() - skip;
+  double worst = 0.0, rms = 0.0;
+  for (size_t k = skip; k < stamps.size(); k++) {
+    double e = stamps[k] - k * 20000.0 - c;
+    worst = std::max(worst, fabs(e));
+    rms += e * e;
+  }
+  rms = sqrt(rms / (stamps.size() - skip));
+  printf("Frame stamps: %zu frames, 0-30us ISR dispatch delay: %.1f us max "
+         "(%.1f us rms) off the 20ms grid, overruns %lu\n",
+         stamps.size() - skip, worst, rms, (unsigned long)q.getOverruns());
+  CHECK(stamps.size() > 400);
+  CHECK(q.getOverruns() == 0);
+  CHECK(worst < 30.0); // Within the dispatch delay
+  q.end();
+}
+
+static const char *kClientPwd = "pinky";
+static const char *kHostPwd = "bloodhound";
+static const char kHostChallenge[] = "0123456789";
+
+static inline uint32_t my_htonl(uint32_t x) { return __builtin_bswap32(x); }
+static inline uint16_t my_htons(uint16_t x) { return __builtin_bswap16(x); }
+static inline uint32_t my_ntohl(uint32_t x) { return __builtin_bswap32(x); }
+static inline uint16_t my_ntohs(uint16_t x) { return __builtin_bswap16(x); }
+
+// CRC32(a + b), C strings, as chan_voter signs
+static uint32_t voterCrc(const char *a, const char *b) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (const char *s : {a, b}) {
+    for (; *s; s++) {
+      crc ^= (uint8_t)*s;
+      for (int k = 0; k < 8; k++)
+        crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// A link to a host that answers every auth request with its challenge and
+// a signed keepalive (which connects the client), and keeps the audio
+class WireNet : public NetworkDriver {
+public:
+  std::vector<std::vector<uint8_t>> audio; // ULAW and ADPCM packets sent
+
+  bool begin(uint8_t *mac) override { return true; }
+  void update() override {}
+  bool isConnected() override { return true; }
+  IPAddress getLocalIP() override { return IPAddress(10, 0, 0, 2); }
+  DriverType getType() override { return DRIVER_ETHERNET; }
+  void setTarget(IPAddress ip, uint16_t port) override {}
+
+  void sendPacket(const uint8_t *data, uint16_t len) override {
+    const VOTER_PACKET_HEADER *hdr = (const VOTER_PACKET_HEADER *)data;
+    uint16_t type = my_ntohs(hdr->payload_type);
+    if (type == PAYLOAD_ULAW || type == PAYLOAD_ADPCM) {
+      audio.emplace_back(data, data + len);
+    } else if (type == PAYLOAD_AUTH) {
+      char client[VOTER_CHALLENGE_LEN + 1] = {0};
+      memcpy(client, hdr->challenge, VOTER_CHALLENGE_LEN);
+      _reply(PAYLOAD_AUTH, client);
+      _reply(PAYLOAD_GPS, client);
+    }
+  }
+  int parsePacket() override {
+    if (_queue.empty())
+      return 0;
+    _current = _queue.front();
+    _queue.pop_front();
+    return (int)_current.size();
+  }
+  int read(uint8_t *buffer, size_t maxLen) override {
+    size_t n = std::min(maxLen, _current.size());
+    memcpy(buffer, _current.data(), n);
+    return (int)n;
+  }
+
+private:
+  std::deque<std::vector<uint8_t>> _queue;
+  std::vector<uint8_t> _current;
+
+  void _reply(uint16_t type, const char *clientChallenge) {
+    std::vector<uint8_t> d(sizeof(VOTER_PACKET_HEADER), 0);
+    VOTER_PACKET_HEADER *hdr = (VOTER_PACKET_HEADER *)d.data();
+    memcpy(hdr->challenge, kHostChallenge, VOTER_CHALLENGE_LEN);
+    hdr->digest = my_htonl(voterCrc(clientChallenge, kHostPwd));
+    hdr->payload_type = my_htons(type);
+    _queue.push_back(d);
+  }
+};
+
+static uint64_t wireUs(const std::vector<uint8_t> &pkt) {
+  const VOTER_PACKET_HEADER *hdr = (const VOTER_PACKET_HEADER *)pkt.data();
+  return (uint64_t)my_ntohl(hdr->curtime.vtime_sec) * 1000000ULL +
+         my_ntohl(hdr->curtime.vtime_nsec) / 1000;
+}
+
+// 10s of frames from the queue, stamped and sent as loop() does (uLaw, then
+// ADPCM with one packet per two frames): every VTIME on the wire is the GPS
+// time of the frame's first sample, to the microsecond
+static void testWireTime() {
+  static AudioVoterFrameQueue q;
+  static audio_block_t block;
+  static WireNet link;
+  static NetworkManager net;
+  static GPSManager gps;
+  static VoterClient client;
+  static FrameClock clock;
+
+  hostSetUs(1000000);
+  uint8_t mac[6] = {0};
+  net.begin(&link, mac);
+  client.begin(&net, &gps, IPAddress(10, 0, 0, 1), 1667, kClientPwd,
+               kHostPwd);
+  for (int i = 0; i < 4 && !client.isConnected(); i++) {
+    hostSetUs(hostNowUs() + 250000);
+    net.update();
+    client.update();
+  }
+  CHECK(client.isConnected());
+
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> dispatch(0.0, 30.0);
+  memset(&block, 0, sizeof(block));
+  q.begin(&resampleTable);
+  clock.begin(TIMING_GPS);
+  const double t0 = (double)hostNowUs();
+  std::vector<uint64_t> captured; // GPS time of each sent packet's frame
+  bool adpcmHalf = false;
+  for (int b = 0; b < 3445; b++) { // 10s
+    hostSetUs((uint64_t)(t0 + (b + 1) * FRAMEQ_BLOCK_US + FRAMEQ_ADC_DELAY_US +
+                         dispatch(rng)));
+    hostAudioInput = &block;
+    q.update();
+    while (q.available()) {
+      VoterFrame *vf = q.readFrame();
+      VTIME capture, frameTime;
+      gps.getTimeAt(vf->captureMicros, &capture);
+      clock.stamp(&frameTime, &capture);
+      bool adpcm = b >= 3445 / 2;
+      if (!adpcm) {
+        client.processAudioFrame(client.getAudioPayload(), 128, frameTime);
+        captured.push_back(kEpochUs + vf->captureMicros);
+      } else if (!adpcmHalf) {
+        captured.push_back(kEpochUs + vf->captureMicros);
+        client.processAdpcmFrame(client.getAdpcmPayload(), 128, frameTime);
+      }
+      adpcmHalf = adpcm && !adpcmHalf;
+      q.freeFrame();
+    }
+  }
+
+  size_t off = 0, ulaw = 0;
+  int64_t worst = 0;
+  for (size_t i = 0; i < link.audio.size() && i < captured.size(); i++) {
+    int64_t d = (int64_t)wireUs(link.audio[i]) - (int64_t)captured[i];
+    if (d)
+      off++;
+    worst = std::max(worst, d < 0 ? -d : d);
+    const VOTER_PACKET_HEADER *hdr =
+        (const VOTER_PACKET_HEADER *)link.audio[i].data();
+    if (my_ntohs(hdr->payload_type) == PAYLOAD_ULAW)
+      ulaw++;
+  }
+  printf("Wire time: %zu packets (%zu uLaw, %zu ADPCM), %zu off the capture "
+         "time, %lld us at worst\n",
+         link.audio.size(), ulaw, link.audio.size() - ulaw, off,
+         (long long)worst);
+  CHECK(link.audio.size() == captured.size());
+  CHECK(ulaw > 200 && link.audio.size() - ulaw > 100);
+  CHECK(off == 0);
+  q.end();
+}
+
+int main() {
+  testBlockOffset();
+  testFrameStamps();
+  testWireTime();
+  return hostTestResult();
+}
@@ -0,0 +1,170 @@
+// CTCSS decoder decisions at every block length. Synthetic receiver audio is
+// fed in 160-sample frames, as in loop():
+// - 100.0Hz PL under voice (a gliding 110-160Hz harmonic series with a 4Hz
+//   syllable envelope) and weak noise: must be detected
+// - the adjacent 97.4Hz tone, with the decoder set to 100.0Hz: must not,
+//   from 200ms blocks
+// - voice alone and flat noise alone: must not
+// Then the host time per frame (the Teensy figure is [B]).
+#include "CtcssDecoder.h"
+#include "HostTest.h"
+#include "VoterProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+struct Receiver {
+  double toneHz = 0.0, toneAmp = 0.0; // PL
+  double voice = 0.0;                 // Peak voice level
+  double noiseRms = 0.0;
+
+  std::mt19937 rng{11};
+  std::normal_distribution<double> gauss{0.0, 1.0};
+  double tonePhase = 0.0, pitchPhase = 0.0;
+  uint64_t n = 0;
+
+  double next() {
+    double t = (double)n++ / 8000.0;
+    tonePhase += 2.0 * M_PI * toneHz / 8000.0;
+    double v = 0.0;
+    if (voice > 0.0) {
+      // Pitch glides 110-160Hz every 1.5s, so it crosses many PL bins
+      double pitch = 135.0 + 25.0 * sin(2.0 * M_PI * t / 1.5);
+      pitchPhase += 2.0 * M_PI * pitch / 8000.0;
+      for (int k = 1; k * pitch < 3000.0; k++)
+        v += sin(k * pitchPhase + k) / k;
+      v *= voice * (0.65 + 0.35 * sin(2.0 * M_PI * 4.0 * t)) / 2.5;
+    }
+    return toneAmp * sin(tonePhase) + v + noiseRms * gauss(rng);
+  }
+};
+
+struct Run {
+  int firstDetect = -1; // Frame index
+  int detected = 0;     // Frames detected
+};
+
+static const uint8_t kWindows[] = {CTCSS_WINDOW_MIN, 10, CTCSS_WINDOW_MAX};
+
+static Run run(CtcssDecoder &dec, Receiver &rx, int frames) {
+  Run r;
+  int16_t frame[FRAME_SIZE];
+  for (int f = 0; f < frames; f++) {
+    for (int i = 0; i < FRAME_SIZE; i++)
+      frame[i] = (int16_t)(rx.next() * 32767.0);
+    dec.process(frame, FRAME_SIZE);
+    if (dec.isDetected()) {
+      r.detected++;
+      if (r.firstDetect < 0)
+        r.firstDetect = f;
+    }
+  }
+  return r;
+}
+
+static void testTones() {
+  CHECK(CtcssDecoder::findTone(100.0f) == 12);
+  CHECK(CtcssDecoder::findTone(97.4f) == 11);
+  CHECK(CtcssDecoder::findTone(99.0f) == -1);
+  CHECK(CtcssDecoder::toneHz(12) == 100.0f);
+}
+
+// PL at 10% of the voice peak (-20dB) is picked up after one block and held
+// through the voice. 100ms blocks have 10Hz wide bins, so a voice harmonic
+// passing near 100Hz can outweigh a neighbour test for longer than the hang
+static void testOnTone() {
+  for (uint8_t w : kWindows) {
+    CtcssDecoder dec;
+    dec.begin(12, w);
+    Receiver rx;
+    rx.toneHz = 100.0;
+    rx.toneAmp = 0.05;
+    rx.voice = 0.5;
+    rx.noiseRms = 0.01;
+    const int frames = 1500; // 30s
+    Run r = run(dec, rx, frames);
+    int after = frames - r.firstDetect;
+    printf("100.0Hz under voice, %dms blocks: detected after %dms, %d/%d "
+           "frames after that\n",
+           w * 20, (r.firstDetect + 1) * 20, r.detected, after);
+    CHECK(r.firstDetect + 1 == w);
+    if (w == CTCSS_WINDOW_MIN)
+      CHECK(r.detected * 10 >= after * 8);
+    else
+      CHECK(r.detected == after);
+  }
+}
+
+// 97.4Hz is 2.6Hz away. From 200ms blocks (5Hz bins) it wins its own bin, so
+// 100.0Hz never peaks; 100ms bins cannot tell the two apart (reported only)
+static void testAdjacent() {
+  for (uint8_t w : kWindows) {
+    CtcssDecoder dec;
+    dec.begin(12, w);
+    Receiver rx;
+    rx.toneHz = 97.4;
+    rx.toneAmp = 0.05;
+    rx.voice = 0.5;
+    rx.noiseRms = 0.01;
+    Run r = run(dec, rx, 1500);
+    printf("97.4Hz under voice, decoder on 100.0Hz, %dms blocks: %d/1500 "
+           "frames detected\n",
+           w * 20, r.detected);
+    if (w > CTCSS_WINDOW_MIN)
+      CHECK(r.detected == 0);
+  }
+}
+
+// No PL: voice alone and flat noise alone, 60s each
+static void testNoTone() {
+  for (uint8_t w : kWindows) {
+    CtcssDecoder dec;
+    dec.begin(12, w);
+    Receiver voice;
+    voice.voice = 0.5;
+    voice.noiseRms = 0.01;
+    Run a = run(dec, voice, 3000);
+    dec.reset();
+    Receiver noise;
+    noise.noiseRms = 0.3;
+    Run b = run(dec, noise, 3000);
+    printf("No PL, %dms blocks: voice %d/3000 frames detected, noise "
+           "%d/3000\n",
+           w * 20, a.detected, b.detected);
+    CHECK(a.detected == 0);
+    CHECK(b.detected == 0);
+  }
+}
+
+// Best host time per 160-sample frame, 500ms blocks
+static void benchDecoder() {
+  CtcssDecoder dec;
+  dec.begin(12, CTCSS_WINDOW_MAX);
+  Receiver rx;
+  rx.toneHz = 100.0;
+  rx.toneAmp = 0.05;
+  int16_t frame[FRAME_SIZE];
+  for (int i = 0; i < FRAME_SIZE; i++)
+    frame[i] = (int16_t)(rx.next() * 32767.0);
+  double best = 1e30;
+  for (int round = 0; round < 200; round++) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < 10; f++)
+      dec.process(frame, FRAME_SIZE);
+    double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count() /
+                10;
+    best = std::min(best, ns);
+  }
+  printf("Host: %.0f ns per frame\n", best);
+}
+
+int main() {
+  testTones();
+  testOnTone();
+  testAdjacent();
+  testNoTone();
+  benchDecoder();
+  return hostTestResult();
+}
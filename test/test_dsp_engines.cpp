@@ -0,0 +1,158 @@
+// DSP engines against the float reference: the same frames (a 700Hz tone,
+// its 3.3x overtone and white noise) through DSP_ENGINE_FLOAT and the
+// engine under test, in every PL filter / de-emphasis combination. The
+// CMSIS kernels are the host stand-ins in stubs/arm_math.h. Then the host
+// time per frame of each engine (the Teensy figures are [B]).
+#include "ConfigManager.h"
+#include "DSPProcessor.h"
+#include "HostTest.h"
+#include "ULaw.h"
+#include <algorithm>
+#include <chrono>
+
+ConfigManager::ConfigManager() {}
+ConfigManager cfg;
+
+struct Compare {
+  int maxDiff = 0;     // LSB
+  double snr = 0.0;    // Reference power over difference power, dB
+  int maxRssiDiff = 0;
+  int ulawMismatches = 0; // Engine's u-Law against encoding the reference
+};
+
+static void makeFrame(int16_t *frame, float amp, uint32_t *noise,
+                      float *phase) {
+  const float inc = 2.0f * PI * 700.0f / 8000.0f;
+  for (int i = 0; i < FRAME_SIZE; i++) {
+    *noise = *noise * 1664525u + 1013904223u; // LCG
+    frame[i] = (int16_t)(amp * (sinf(*phase) + 0.375f * sinf(3.3f * *phase)) +
+                         (float)((int32_t)(*noise >> 22) - 512));
+    *phase += inc;
+    if (*phase >= 2.0f * PI)
+      *phase -= 2.0f * PI;
+  }
+}
+
+// frames frames through both engines; the first few only fill the filters
+static Compare compare(uint8_t engine, bool pl, bool deemp, float amp,
+                       int frames = 500) {
+  static VoterFrameDSP ref, dut;
+  static int16_t a[FRAME_SIZE], b[FRAME_SIZE];
+  static uint8_t ulaw[FRAME_SIZE];
+  const int warmup = 5;
+  ref.begin();
+  ref.setEngine(DSP_ENGINE_FLOAT);
+  ref.reset();
+  dut.begin();
+  dut.setEngine(engine);
+  dut.reset();
+
+  Compare c;
+  double sig = 0.0, err = 0.0;
+  uint32_t noise = 12345;
+  float phase = 0.0f;
+  for (int f = 0; f < frames; f++) {
+    makeFrame(a, amp, &noise, &phase);
+    memcpy(b, a, sizeof(a));
+    int ra = ref.process(a, pl, deemp);
+    int rb = dut.process(b, pl, deemp, ulaw);
+    if (f < warmup)
+      continue;
+    c.maxRssiDiff = std::max(c.maxRssiDiff, abs(ra - rb));
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      if (ulaw[i] != ulawEncode(a[i]))
+        c.ulawMismatches++;
+      int d = abs((int)a[i] - (int)b[i]);
+      c.maxDiff = std::max(c.maxDiff, d);
+      sig += (double)a[i] * a[i];
+      err += (double)d * d;
+    }
+  }
+  c.snr = err > 0.0 ? 10.0 * log10(sig / err) : 120.0;
+  return c;
+}
+
+// Q15 fast kernels truncate in a 32-bit accumulator, so they differ from
+// float by a few LSB; RSSI comes from the same filter, so it must agree
+static void testQ15() {
+  for (int mode = 0; mode < 4; mode++) {
+    bool pl = mode & 1, deemp = mode & 2;
+    Compare c = compare(DSP_ENGINE_Q15, pl, deemp, 8000.0f);
+    printf("Q15 vs FLOAT, PL %-3s de-emphasis %-3s: max %d LSB, SNR %.1f dB, "
+           "RSSI diff %d\n",
+           pl ? "on" : "off", deemp ? "on" : "off", c.maxDiff, c.snr,
+           c.maxRssiDiff);
+    CHECK(c.maxDiff <= 6);
+    CHECK(c.snr > 55.0);
+    CHECK(c.maxRssiDiff <= 1);
+  }
+  // Near full scale (peaks about 30000): the 32-bit accumulators must not wrap
+  Compare loud = compare(DSP_ENGINE_Q15, true, true, 22000.0f);
+  printf("Q15 vs FLOAT, near full scale: max %d LSB, SNR %.1f dB\n",
+         loud.maxDiff, loud.snr);
+  CHECK(loud.maxDiff <= 6);
+}
+
+// FUSED runs the float chain in one pass with the same arithmetic, so with
+// the host kernels summing in the same order it must match exactly (on the
+// target the CMSIS f32 kernels reorder the sums, so it is within 1 LSB);
+// its u-Law, written in the same pass, must be the reference's encoded
+static void testFused() {
+  for (int mode = 0; mode < 4; mode++) {
+    bool pl = mode & 1, deemp = mode & 2;
+    Compare c = compare(DSP_ENGINE_FUSED, pl, deemp, 8000.0f);
+    printf("FUSED vs FLOAT, PL %-3s de-emphasis %-3s: max %d LSB, RSSI diff "
+           "%d, %d u-Law mismatches\n",
+           pl ? "on" : "off", deemp ? "on" : "off", c.maxDiff, c.maxRssiDiff,
+           c.ulawMismatches);
+    CHECK(c.maxDiff == 0);
+    CHECK(c.maxRssiDiff == 0);
+    CHECK(c.ulawMismatches == 0);
+  }
+  Compare loud = compare(DSP_ENGINE_FUSED, true, true, 22000.0f);
+  CHECK(loud.maxDiff == 0);
+}
+
+// Best host time per 160-sample frame (PL and de-emphasis on, u-Law out).
+// The engines take turns, so clock and cache warm-up hit them alike.
+static void benchEngines() {
+  const uint8_t engines[] = {DSP_ENGINE_FLOAT, DSP_ENGINE_Q15,
+                             DSP_ENGINE_FUSED};
+  const char *names[] = {"FLOAT", "Q15", "FUSED"};
+  static VoterFrameDSP dsp[3];
+  static int16_t frame[FRAME_SIZE], work[FRAME_SIZE];
+  static uint8_t ulaw[FRAME_SIZE];
+  uint32_t noise = 1;
+  float phase = 0.0f;
+  makeFrame(frame, 8000.0f, &noise, &phase);
+  double best[3] = {1e30, 1e30, 1e30};
+  for (int e = 0; e < 3; e++) {
+    dsp[e].begin();
+    dsp[e].setEngine(engines[e]);
+  }
+  for (int round = 0; round < 200; round++) {
+    for (int e = 0; e < 3; e++) {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int f = 0; f < 10; f++) {
+        memcpy(work, frame, sizeof(frame));
+        dsp[e].process(work, true, true, ulaw);
+      }
+      double ns = std::chrono::duration<double, std::nano>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count() /
+                  10;
+      best[e] = std::min(best[e], ns);
+    }
+  }
+  for (int e = 0; e < 3; e++)
+    printf("Host %-5s: %.0f ns per frame (%.0f%% of FLOAT)\n", names[e],
+           best[e], 100.0 * best[e] / best[0]);
+}
+
+int main() {
+  cfg.data.dspCalib = 13.0f;
+  testQ15();
+  testFused();
+  benchEngines();
+  return hostTestResult();
+}
@@ -0,0 +1,471 @@
+// EspSpiDriver against a simulated ESP32. The ESP32 runs SpiLinkSlave as
+// Spirit.ino does: frames built into slot buffers and queued in its SPI slave
+// driver, READY high while a queued frame has data or datagrams wait, and a
+// task that handles each completed transaction (receive, build the next
+// frame) some time after CS rises. A transaction started while nothing is
+// queued clocks zeros, as on the wire. Traffic is 185-byte host packets
+// every 20ms plus bursts, and uplink to two hosts.
+#include "EspSpiDriver.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+#define PIN_CS 26
+#define PIN_READY 24
+#define PIN_RESET 25
+
+typedef std::vector<uint8_t> Bytes;
+
+// A datagram on the ESP32's network side: [ip4 port2 payload]
+static Bytes datagram(IPAddress ip, uint16_t port, const Bytes &payload) {
+  Bytes d(6 + payload.size());
+  for (int i = 0; i < 4; i++)
+    d[i] = ip[i];
+  d[4] = port >> 8;
+  d[5] = port & 0xFF;
+  std::copy(payload.begin(), payload.end(), d.begin() + 6);
+  return d;
+}
+
+struct EspSim : SpiLinkPort {
+  // Model
+  int queued = 1;           // Frames queued ahead in the slave driver
+  uint32_t reloadUs = 10;   // Slave interrupt loads the next queued one
+  uint32_t taskMinUs = 0;   // Task time per completed transaction
+  uint32_t taskMaxUs = 140;
+  double cleanHz = 1e9;     // Bit errors above this clock...
+  double berPerMHz = 0.0;   // ...rising by this much per MHz
+  double berFloor = 0.0;
+  uint8_t ip[4] = {192, 168, 1, 77};
+
+  // Network side
+  std::deque<Bytes> toSpi;  // Received from the network, for the Teensy
+  std::vector<Bytes> netOut;
+  uint32_t netRxPackets = 0, netRxBytes = 0;
+  uint32_t configs = 0;
+
+  // Bus side
+  SpiLinkSlave link;
+  uint32_t transactions = 0, notArmed = 0, csOverlap = 0, bitFlips = 0;
+  uint32_t minGapUs = UINT32_MAX;
+
+  std::mt19937 rng{5};
+
+  void boot(uint64_t atUs) { _bootUs = atUs; }
+
+  // UDP task: a datagram from the network, READY raised
+  void fromNet(const Bytes &d) {
+    toSpi.push_back(d);
+    netRxPackets++;
+    netRxBytes += d.size() - 6;
+    if (_running)
+      hostSetPin(PIN_READY, HIGH);
+  }
+
+  // Boot, and completed transactions handled by the task, once due
+  void poll() {
+    uint64_t now = hostNowUs();
+    if (!_running && now >= _bootUs) {
+      _running = true;
+      link.setAddress(ip);
+      link.setLinkUp(true);
+      for (int i = 0; i < queued; i++)
+        _queueFrame(i);
+      _headUs = now;
+      _updateReady();
+    }
+    while (!_done.empty() && _done.front().atUs <= now) {
+      int i = _done.front().slot;
+      uint16_t len = _done.front().len;
+      _done.pop_front();
+      _slots[i].hasData = false;
+      hostSetPin(PIN_READY, LOW);
+      link.receive(_slots[i].rx, len, *this);
+      _queueFrame(i);
+      _updateReady();
+    }
+  }
+
+  void chipSelect(uint8_t level) {
+    uint64_t now = hostNowUs();
+    if (level == LOW) {
+      if (_selected)
+        csOverlap++;
+      if (_csHighUs && now - _csHighUs < minGapUs)
+        minGapUs = (uint32_t)(now - _csHighUs);
+      _selected = true;
+      _pos = 0;
+      _cur = (_armed.empty() || now < _headUs) ? -1 : _armed.front();
+      if (_cur < 0)
+        notArmed++;
+    } else if (_selected) {
+      _selected = false;
+      _csHighUs = now;
+      transactions++;
+      if (_cur < 0)
+        return;
+      _armed.pop_front();
+      _headUs = now + reloadUs;
+      uint64_t start = _done.empty() ? now : std::max(now, _done.back().atUs);
+      std::uniform_int_distribution<uint32_t> task(taskMinUs, taskMaxUs);
+      _done.push_back({start + task(rng), _cur, (uint16_t)_pos});
+    }
+  }
+
+  uint8_t exchange(uint8_t mosi) {
+    if (!_selected || _cur < 0)
+      return 0;
+    Slot &s = _slots[_cur];
+    uint8_t miso = 0;
+    if (_pos < SPILINK_BUFFER) {
+      s.rx[_pos] = _noisy(mosi);
+      miso = _noisy(s.tx[_pos]);
+    }
+    _pos++;
+    return miso;
+  }
+
+  // SpiLinkPort
+  uint16_t nextDatagram(uint8_t *dip, uint16_t *port, uint8_t *data,
+                        uint16_t maxLen) override {
+    if (toSpi.empty() || toSpi.front().size() - 6 > maxLen)
+      return 0;
+    const Bytes &d = toSpi.front();
+    memcpy(dip, d.data(), 4);
+    *port = (d[4] << 8) | d[5];
+    uint16_t len = d.size() - 6;
+    memcpy(data, d.data() + 6, len);
+    toSpi.pop_front();
+    return len;
+  }
+  bool hasDatagram() override { return !toSpi.empty(); }
+  bool onDatagram(const uint8_t *dip, uint16_t port, const uint8_t *data,
+                  uint16_t len) override {
+    netOut.push_back(datagram(IPAddress(dip[0], dip[1], dip[2], dip[3]), port,
+                              Bytes(data, data + len)));
+    return true;
+  }
+  uint8_t credits() override { return 32; } // toNet drains at once
+  void onConfig(const uint8_t *data, uint16_t len) override { configs++; }
+  bool getBridgeStats(SpiLinkBridgeStats *s) override {
+    memset(s, 0, sizeof(*s));
+    s->uptimeMs = (uint32_t)((hostNowUs() - _bootUs) / 1000);
+    s->netRxPackets = netRxPackets;
+    s->netRxBytes = netRxBytes;
+    s->netTxPackets = netOut.size();
+    for (const Bytes &d : netOut)
+      s->netTxBytes += d.size() - 6;
+    return true;
+  }
+
+private:
+  struct Slot {
+    uint8_t tx[SPILINK_BUFFER];
+    uint8_t rx[SPILINK_BUFFER];
+    bool hasData;
+  };
+  struct Done {
+    uint64_t atUs;
+    int slot;
+    uint16_t len;
+  };
+  Slot _slots[2];
+  std::deque<int> _armed;   // Queued in the slave driver, head first
+  std::deque<Done> _done;   // Completed, waiting for the task
+  uint64_t _bootUs = 0, _headUs = 0, _csHighUs = 0;
+  bool _running = false, _selected = false;
+  int _cur = -1;
+  size_t _pos = 0;
+
+  void _queueFrame(int i) {
+    uint16_t len = link.build(_slots[i].tx, *this);
+    memset(_slots[i].tx + len, 0, SPILINK_BUFFER - len);
+    _slots[i].hasData = len > SPILINK_HEADER + SPILINK_CRC;
+    _armed.push_back(i);
+  }
+
+  void _updateReady() {
+    bool ready = !toSpi.empty();
+    for (int i = 0; i < queued; i++)
+      ready = ready || _slots[i].hasData;
+    hostSetPin(PIN_READY, ready ? HIGH : LOW);
+  }
+
+  uint8_t _noisy(uint8_t b) {
+    double clock = hostSpiClock();
+    double ber = berFloor;
+    if (clock > cleanHz)
+      ber += (clock - cleanHz) / 1e6 * berPerMHz;
+    if (ber <= 0.0)
+      return b;
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (int bit = 0; bit < 8; bit++)
+      if (u(rng) < ber) {
+        b ^= 1 << bit;
+        bitFlips++;
+      }
+    return b;
+  }
+};
+
+static EspSim *esp;
+static void espTick(uint32_t) {
+  hostSpiPoll();
+  esp->poll();
+}
+static void espCs(uint8_t pin, uint8_t level) {
+  if (pin == PIN_CS)
+    esp->chipSelect(level);
+}
+static uint8_t espByte(uint8_t mosi) { return esp->exchange(mosi); }
+
+struct Run {
+  bool async = true;
+  int seconds = 60;
+  int burstEvery = 50; // Frames
+  int burst = 6;
+};
+
+struct Result {
+  uint32_t upMs, clock;
+  size_t rxExpected, rxGot, rxBad;
+  size_t txExpected, txBad;
+  bool configured, ipKnown, connected;
+  uint32_t retrains;
+  bool haveRates;
+  EspSpiBridgeRates rates;
+  EspSpiTxStats tx;
+  SpiLinkStats link;
+};
+
+static Result run(EspSim &sim, const Run &r) {
+  Result res;
+  std::mt19937 rng(9);
+  std::vector<Bytes> expectIn, expectOut;
+
+  esp = &sim;
+  hostSetUs(0);
+  hostMicrosStepUs = 1; // The driver's busy-waits on micros() get out
+  hostDelayHook = espTick;
+  hostWriteHook = espCs;
+  hostSpiDevice = espByte;
+  sim.boot(2000);
+
+  EspSpiDriver *d = new EspSpiDriver(PIN_CS, PIN_READY, PIN_RESET);
+  uint8_t mac[6] = {0};
+  d->begin(mac);
+  d->setAsync(r.async);
+  d->setCredentials("ssid", "pass");
+  while (!d->getLink().isUp() && hostNowUs() < 2000000) {
+    d->update();
+    delayMicroseconds(50);
+  }
+  res.upMs = hostNowUs() / 1000;
+  res.clock = d->getLink().getClock();
+
+  size_t gotIn = 0, badIn = 0;
+  auto payload = [&rng]() {
+    Bytes p(185);
+    for (uint8_t &b : p)
+      b = rng();
+    return p;
+  };
+  for (int frame = 0; frame < r.seconds * 50; frame++) {
+    int n = 1 + (frame % r.burstEvery == 7 ? r.burst : 0);
+    for (int k = 0; k < n; k++) {
+      Bytes p = datagram(IPAddress(10, 0, 0, 9), 1667, payload());
+      sim.fromNet(p);
+      expectIn.push_back(p);
+    }
+    for (int h = 0; h < 2; h++) {
+      Bytes p = payload();
+      IPAddress to(10, 0, 0, 1 + h);
+      d->sendPacketTo(p.data(), p.size(), to, 1667);
+      expectOut.push_back(datagram(to, 1667, p));
+    }
+    if (frame % 100 == 3) {
+      d->getLocalIP();
+      d->isConnected();
+    }
+
+    uint64_t end = (uint64_t)res.upMs * 1000 + (frame + 1) * 20000ULL;
+    while (hostNowUs() < end) {
+      d->update();
+      uint8_t buf[SPILINK_MAX_DATAGRAM];
+      for (int k = 0; k < 8 && d->parsePacket() > 0; k++) {
+        int len = d->read(buf, sizeof(buf));
+        Bytes got = datagram(d->remoteIP(), d->remotePort(),
+                             Bytes(buf, buf + len));
+        if (gotIn >= expectIn.size() || got != expectIn[gotIn])
+          badIn++;
+        gotIn++;
+      }
+      delayMicroseconds(50);
+    }
+  }
+  // A frame that found the ESP32 not armed goes again with the next
+  // transaction: at the latest the keepalive
+  d->flush();
+  for (int i = 0; i < 2000; i++) {
+    d->update();
+    delayMicroseconds(50);
+  }
+
+  size_t badOut = 0;
+  for (size_t i = 0; i < expectOut.size(); i++)
+    if (i >= sim.netOut.size() || sim.netOut[i] != expectOut[i])
+      badOut++;
+  IPAddress ip = d->getLocalIP();
+  res.rxExpected = expectIn.size();
+  res.rxGot = gotIn;
+  res.rxBad = badIn;
+  res.txExpected = expectOut.size();
+  res.txBad = badOut + (sim.netOut.size() - std::min(sim.netOut.size(),
+                                                     expectOut.size()));
+  res.configured = !d->getLink().isConfigPending() && sim.configs == 1;
+  res.ipKnown = ip == IPAddress(sim.ip[0], sim.ip[1], sim.ip[2], sim.ip[3]);
+  res.connected = d->isConnected();
+  res.tx = d->getTxStats();
+  res.link = d->getLink().getStats();
+  res.retrains = d->getLink().getRetrains();
+  res.haveRates = d->getBridgeRates(&res.rates);
+  delete d;
+
+  hostDelayHook = nullptr;
+  hostWriteHook = nullptr;
+  hostSpiDevice = nullptr;
+  hostMicrosStepUs = 0;
+  return res;
+}
+
+static void checkDelivery(const EspSim &sim, const Result &res) {
+  CHECK(res.rxGot == res.rxExpected && res.rxBad == 0);
+  CHECK(res.txBad == 0 && sim.netOut.size() == res.txExpected);
+  CHECK(res.tx.queueDrops == 0 && res.tx.linkDown == 0);
+  CHECK(res.tx.dmaTimeouts == 0);
+  CHECK(sim.csOverlap == 0);
+  CHECK(sim.minGapUs >= ESPSPI_CS_GAP_US);
+  CHECK(res.configured && res.ipKnown && res.connected);
+}
+
+// A slave that re-arms only after handling each transaction (0-140us):
+// transactions that find it not armed are resent, nothing is lost
+static void testReArm() {
+  static EspSim sim;
+  Result res = run(sim, Run());
+  printf("Re-arm after 0-140us: up at %lu ms, %lu MHz; RX %zu/%zu, TX "
+         "%zu/%zu intact; %lu transactions, %lu found the ESP32 not armed, "
+         "%lu frames resent; CS gap >= %lu us\n",
+         (unsigned long)res.upMs, (unsigned long)(res.clock / 1000000),
+         res.rxGot - res.rxBad, res.rxExpected,
+         res.txExpected - res.txBad, res.txExpected,
+         (unsigned long)sim.transactions, (unsigned long)sim.notArmed,
+         (unsigned long)res.link.resent, (unsigned long)sim.minGapUs);
+  checkDelivery(sim, res);
+  CHECK(res.clock == 30000000); // Clean wire: the top step
+}
+
+// Wire clean to 20MHz with 2e-4 bit errors per MHz above it, bursts of 12:
+// training settles at 20MHz and everything arrives
+static void testTraining() {
+  static EspSim sim;
+  sim.cleanHz = 20e6;
+  sim.berPerMHz = 2e-4;
+  Run r;
+  r.burst = 12;
+  Result res = run(sim, r);
+  printf("Wire limit 20 MHz: up at %lu ms, %lu MHz; RX %zu/%zu, TX %zu/%zu "
+         "intact; %lu bad frames, %lu retrains\n",
+         (unsigned long)res.upMs, (unsigned long)(res.clock / 1000000),
+         res.rxGot - res.rxBad, res.rxExpected, res.txExpected - res.txBad,
+         res.txExpected, (unsigned long)res.link.badFrames,
+         (unsigned long)res.retrains);
+  checkDelivery(sim, res);
+  CHECK(res.clock == 20000000);
+}
+
+// A single-buffer ESP32 taking up to 300us per transaction, far past the CS
+// gap: frames that find it not armed are resent and nothing is lost, but
+// past a step's allowance they count against the training clock
+static void testSlowSlave() {
+  static EspSim sim;
+  sim.cleanHz = 20e6;
+  sim.berPerMHz = 2e-4;
+  sim.taskMaxUs = 300;
+  Run r;
+  r.burst = 12;
+  Result res = run(sim, r);
+  printf("Task time 0-300us: %lu MHz; RX %zu/%zu, TX %zu/%zu intact; %lu of "
+         "%lu transactions not armed, %lu frames resent\n",
+         (unsigned long)(res.clock / 1000000), res.rxGot - res.rxBad,
+         res.rxExpected, res.txExpected - res.txBad, res.txExpected,
+         (unsigned long)sim.notArmed, (unsigned long)sim.transactions,
+         (unsigned long)res.link.resent);
+  checkDelivery(sim, res);
+  CHECK(res.clock >= 8000000);
+}
+
+// Blocking mode: each sendPacket() runs its own transaction and waits for
+// it. Call times are model time (wire time, and 1us per micros() read), not
+// Teensy time.
+static void testBlocking() {
+  static EspSim simDma, simBlocking;
+  simDma.cleanHz = simBlocking.cleanHz = 20e6;
+  simDma.berPerMHz = simBlocking.berPerMHz = 2e-4;
+  Run r;
+  r.seconds = 10;
+  Result dma = run(simDma, r);
+  r.async = false;
+  Result blocking = run(simBlocking, r);
+  printf("sendPacket(): DMA %.1f us, blocking %.1f us on average (model "
+         "time); blocking TX %zu/%zu intact\n",
+         (double)dma.tx.callUsTotal / dma.tx.packets,
+         (double)blocking.tx.callUsTotal / blocking.tx.packets,
+         blocking.txExpected - blocking.txBad, blocking.txExpected);
+  checkDelivery(simBlocking, blocking);
+  uint32_t wireUs = 185 * 8 / 20; // One datagram at 20MHz
+  CHECK(dma.tx.callUsTotal / dma.tx.packets < wireUs);
+  CHECK(blocking.tx.callUsTotal / blocking.tx.packets > wireUs);
+}
+
+// Spirit.ino as it is: two transactions queued, the next loaded 10us after
+// CS rises, then 80us (or 300us) of task time per transaction. The bridge
+// rates from the STATS answers match the traffic.
+static void testQueued() {
+  const uint32_t taskUs[] = {80, 300};
+  for (uint32_t us : taskUs) {
+    EspSim *sim = new EspSim;
+    sim->queued = 2;
+    sim->taskMinUs = sim->taskMaxUs = us;
+    sim->cleanHz = 20e6;
+    sim->berPerMHz = 2e-4;
+    Run r;
+    r.burst = 12;
+    Result res = run(*sim, r);
+    printf("Two queued, %luus task: %lu MHz; RX %zu/%zu, TX %zu/%zu intact; "
+           "%lu of %lu transactions not armed, %lu frames resent; bridge "
+           "%.1f pkt/s in, %.1f pkt/s out\n",
+           (unsigned long)us, (unsigned long)(res.clock / 1000000),
+           res.rxGot - res.rxBad, res.rxExpected, res.txExpected - res.txBad,
+           res.txExpected, (unsigned long)sim->notArmed,
+           (unsigned long)sim->transactions, (unsigned long)res.link.resent,
+           res.rates.netRxPps, res.rates.netTxPps);
+    checkDelivery(*sim, res);
+    CHECK(res.clock == 20000000);
+    CHECK(res.haveRates);
+    CHECK(fabs(res.rates.netRxPps - 62.0f) < 1.0f); // 50 + a burst of 12
+    CHECK(fabs(res.rates.netTxPps - 100.0f) < 1.0f);
+    delete sim;
+  }
+}
+
+int main() {
+  testReArm();
+  testTraining();
+  testSlowSlave();
+  testBlocking();
+  testQueued();
+  return hostTestResult();
+}
@@ -0,0 +1,111 @@
+// EthernetDriver DHCP: a boot with no server, then update() (called every
+// 20ms, as the main loop does) with the simulated DHCP server off, on, and
+// slower than the boot timeout, and with the cable out. update() must never
+// hold the loop or call Ethernet.begin() again.
+#include "EthernetDriver.h"
+#include "HostTest.h"
+
+static uint8_t mac[6] = {0x04, 0xE9, 0xE5, 0, 0, 1};
+static EthernetDriver eth;
+static uint32_t longestUpdateMs;
+
+// Loop passes for ms
+static void run(uint32_t ms) {
+  uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) {
+    hostSetUs(hostNowUs() + 20000);
+    uint32_t t = millis();
+    eth.update();
+    if (millis() - t > longestUpdateMs)
+      longestUpdateMs = millis() - t;
+  }
+}
+
+// Loop passes until the link is up (at most 60s); the time it took
+static uint32_t runUntilUp() {
+  uint32_t start = millis();
+  while (!eth.isConnected() && millis() - start < 60000)
+    run(20);
+  return millis() - start;
+}
+
+static void boot(uint32_t dhcpMs) {
+  hostSetUs(1000000);
+  hostEthLink = LinkON;
+  hostEthDhcpMs = dhcpMs;
+  longestUpdateMs = 0;
+  uint32_t t = millis();
+  CHECK(!eth.begin(mac));
+  CHECK(millis() - t == ETH_DHCP_TIMEOUT_MS);
+  CHECK(!eth.isConnected());
+}
+
+// No server for 120s: one client is started and kept; the server comes back
+// and answers it
+static void testLateServer() {
+  boot(0);
+  uint32_t begins = hostEthBegins, starts = hostEthDhcpStarts;
+  run(120000);
+  printf("No server for 120 s: DHCP clients started %lu, loop held %lu ms "
+         "at most\n",
+         (unsigned long)(hostEthDhcpStarts - starts),
+         (unsigned long)longestUpdateMs);
+  CHECK(hostEthDhcpStarts - starts == 1);
+  CHECK(!eth.isConnected());
+
+  hostEthDhcpMs = 30;
+  uint32_t ms = runUntilUp();
+  printf("Server back: up %lu ms later\n", (unsigned long)ms);
+  CHECK(eth.isConnected());
+  CHECK(ms <= 20);
+  starts = hostEthDhcpStarts;
+  run(60000);
+  CHECK(hostEthDhcpStarts == starts);
+  CHECK(hostEthBegins == begins);
+  CHECK(longestUpdateMs == 0);
+}
+
+// Cable out: the client is dropped; plugged in again, a new one starts on
+// the next pass
+static void testCable() {
+  boot(0);
+  run(30000);
+  hostEthLink = LinkOFF;
+  run(20);
+  CHECK(!fnet_dhcp_cln_get_by_netif(fnet_netif_get_default()));
+  uint32_t starts = hostEthDhcpStarts;
+  run(30000);
+  CHECK(hostEthDhcpStarts == starts);
+  hostEthLink = LinkON;
+  hostEthDhcpMs = 30;
+  uint32_t ms = runUntilUp();
+  printf("Cable back in: up %lu ms later\n", (unsigned long)ms);
+  CHECK(eth.isConnected());
+  CHECK(hostEthDhcpStarts == starts + 1);
+  CHECK(ms <= 20 + 30 + 20);
+  CHECK(longestUpdateMs == 0);
+}
+
+// A server slower than the boot timeout: up once it answers the client
+// update() started
+static void testSlowServer() {
+  const uint32_t slowMs = 15000;
+  boot(slowMs);
+  uint32_t begins = hostEthBegins;
+  uint32_t ms = runUntilUp();
+  printf("Server answering in %lu ms: up %lu ms after boot gave up, loop "
+         "held %lu ms at most\n",
+         (unsigned long)slowMs, (unsigned long)ms,
+         (unsigned long)longestUpdateMs);
+  CHECK(eth.isConnected());
+  CHECK(ms >= slowMs && ms <= 20 + slowMs + 20);
+  CHECK(hostEthBegins == begins);
+  CHECK(longestUpdateMs == 0);
+}
+
+int main() {
+  testLateServer();
+  testCable();
+  testSlowServer();
+  return hostTestResult();
+}
@@ -0,0 +1,119 @@
+// FrameClock: 4s locked, 10s GPS loss, 6s recovered. The frame (codec)
+// clock runs 100ppm fast against GPS and each GPS capture lands 0-2ms late,
+// as frames are drained in bursts by loop(). Stamp spacing must stay within
+// 20ms +- FRAMECLOCK_SLEW_US throughout. Then mix mode, and the cases that
+// step instead of slewing.
+#include "ConfigManager.h"
+#include "FrameClock.h"
+#include "HostTest.h"
+#include <stdlib.h>
+
+static uint64_t toUs(const VTIME &t) {
+  return (uint64_t)t.vtime_sec * 1000000ULL + t.vtime_nsec / 1000;
+}
+
+static VTIME toVtime(double us) {
+  VTIME t = {(uint32_t)(us / 1e6), (uint32_t)(fmod(us, 1e6) * 1000.0)};
+  return t;
+}
+
+static void testGpsLoss() {
+  static FrameClock clk;
+  const int lossStart = 200, lossEnd = 700, frames = 1000;
+  const double t0 = 1700000000.0 * 1e6; // GPS epoch (us)
+  uint32_t noise = 12345;
+  uint64_t prevUs = 0;
+  int32_t minGap = INT32_MAX, maxGap = 0, maxErrAfter = 0;
+  int reconverged = -1;
+
+  // Nothing to hold over from before the first lock
+  VTIME t;
+  clk.begin(TIMING_GPS);
+  clk.stamp(&t, nullptr);
+  CHECK(t.vtime_sec == 0 && t.vtime_nsec == 0);
+
+  clk.begin(TIMING_GPS);
+  for (int k = 0; k < frames; k++) {
+    noise = noise * 1664525u + 1013904223u; // LCG
+    VTIME gps = toVtime(t0 + k * 20000.0 * (1.0 - 100e-6) + (noise >> 21));
+    bool locked = (k < lossStart || k >= lossEnd);
+    clk.stamp(&t, locked ? &gps : nullptr);
+    CHECK(clk.isHoldover() == !locked);
+
+    uint64_t us = toUs(t);
+    if (k > 0) {
+      int32_t gap = (int32_t)(us - prevUs);
+      if (gap < minGap)
+        minGap = gap;
+      if (gap > maxGap)
+        maxGap = gap;
+    }
+    prevUs = us;
+
+    if (k >= lossEnd) {
+      int32_t err = abs(clk.getLastError());
+      if (reconverged < 0 && err <= FRAMECLOCK_SLEW_US)
+        reconverged = k - lossEnd;
+      if (reconverged >= 0 && err > maxErrAfter)
+        maxErrAfter = err;
+    }
+  }
+
+  printf("GPS loss: spacing %ld..%ld us (%lu holdover frames, %lu resyncs), "
+         "relock within %d us after %d frames, max %ld us after\n",
+         (long)minGap, (long)maxGap, (unsigned long)clk.getHoldoverFrames(),
+         (unsigned long)clk.getResyncs(), FRAMECLOCK_SLEW_US, reconverged,
+         (long)maxErrAfter);
+  CHECK(minGap >= FRAMECLOCK_FRAME_US - FRAMECLOCK_SLEW_US);
+  CHECK(maxGap <= FRAMECLOCK_FRAME_US + FRAMECLOCK_SLEW_US);
+  CHECK(clk.getHoldoverFrames() == (uint32_t)(lossEnd - lossStart));
+  CHECK(clk.getResyncs() == 0);
+  CHECK(reconverged >= 0 && reconverged <= 3);
+  CHECK(maxErrAfter < 2048); // The capture jitter, nothing left over
+  CHECK(clk.getSequence() == (uint32_t)frames);
+}
+
+// A GPS jump beyond FRAMECLOCK_RESYNC_US (new epoch) is one step
+static void testResync() {
+  static FrameClock clk;
+  VTIME t, gps = {1700000000, 0};
+  clk.begin(TIMING_GPS);
+  clk.stamp(&t, &gps);
+  gps.vtime_sec += 10;
+  clk.stamp(&t, &gps);
+  CHECK(toUs(t) == toUs(gps));
+  CHECK(clk.getResyncs() == 1);
+}
+
+// Mix mode: local seconds and the frame sequence, with or without GPS
+static void testMixMode() {
+  static FrameClock clk;
+  VTIME t, gps = {1700000000, 123456789};
+  bool ok = true;
+  clk.begin(TIMING_MIX);
+  for (uint32_t k = 1; k <= 500; k++) {
+    clk.stamp(&t, (k % 2) ? &gps : nullptr);
+    ok = ok && t.vtime_nsec == k && t.vtime_sec == k * 20000 / 1000000;
+  }
+  printf("Mix mode: 500 frames, sequence and local seconds %s\n",
+         ok ? "exact" : "WRONG");
+  CHECK(ok);
+  CHECK(!clk.isHoldover());
+}
+
+static void testRoundToFrame() {
+  VTIME t = {100, 999990000}; // 10us before the second
+  FrameClock::roundToFrame(&t);
+  CHECK(t.vtime_sec == 101 && t.vtime_nsec == 0);
+  t = {100, 30004000};
+  FrameClock::roundToFrame(&t);
+  CHECK(t.vtime_sec == 100 && t.vtime_nsec == 40000000);
+}
+
+int main() {
+  testGpsLoss();
+  testResync();
+  testMixMode();
+  testRoundToFrame();
+  return hostTestResult();
+}
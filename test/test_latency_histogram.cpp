@@ -0,0 +1,64 @@
+// LatencyHistogram: bin mapping, and percentiles from the bins against exact
+// ones from a sorted copy, on a LAN-like RTT spread (0.3-2ms) with a 5% WAN
+// tail (20-120ms).
+#include "HostTest.h"
+#include "LatencyHistogram.h"
+#include <algorithm>
+
+static void testBins() {
+  bool ok = true;
+  for (uint32_t us = 0; us < 5000000; us += 7) {
+    uint8_t b = LatencyHistogram::binOf(us);
+    if (LatencyHistogram::binLow(b) > us ||
+        (b < LATHIST_BINS - 1 && LatencyHistogram::binLow(b + 1) <= us))
+      ok = false;
+  }
+  CHECK(ok);
+  CHECK(LatencyHistogram::binOf(0) == 0);
+  CHECK(LatencyHistogram::binOf(UINT32_MAX) == LATHIST_BINS - 1);
+}
+
+static void testEmpty() {
+  LatencyHistogram hist;
+  CHECK(hist.getCount() == 0);
+  CHECK(hist.getMin() == 0 && hist.getMax() == 0 && hist.getMean() == 0);
+  CHECK(hist.getPercentile(50) == 0);
+}
+
+static void testPercentiles() {
+  static LatencyHistogram hist;
+  static uint32_t samples[2000];
+  const int n = sizeof(samples) / sizeof(samples[0]);
+  uint32_t noise = 4242;
+  uint64_t sum = 0;
+
+  for (int i = 0; i < n; i++) {
+    noise = noise * 1664525u + 1013904223u; // LCG
+    uint32_t r = noise >> 8;
+    samples[i] = (r % 100 < 5) ? 20000 + r % 100000 : 300 + r % 1700;
+    sum += samples[i];
+    hist.add(samples[i]);
+  }
+  std::sort(samples, samples + n);
+
+  const uint8_t pcts[] = {50, 90, 95, 99};
+  double worst = 0.0;
+  for (uint8_t p : pcts) {
+    uint32_t exact = samples[(n * p + 99) / 100 - 1];
+    double err = 100.0 * fabs((double)hist.getPercentile(p) - exact) / exact;
+    worst = std::max(worst, err);
+  }
+  printf("p50/p90/p95/p99 within %.1f%% of exact (%d samples, %u bins)\n",
+         worst, n, LATHIST_BINS);
+  CHECK(worst < 6.25); // Half a bin (12.5%)
+  CHECK(hist.getCount() == (uint32_t)n);
+  CHECK(hist.getMin() == samples[0] && hist.getMax() == samples[n - 1]);
+  CHECK(hist.getMean() == (uint32_t)(sum / n));
+}
+
+int main() {
+  testBins();
+  testEmpty();
+  testPercentiles();
+  return hostTestResult();
+}
@@ -0,0 +1,275 @@
+// PPS alignment of the 8kHz frame grid, with a codec clock that is off by
+// some ppm against GPS. Each aligned frame's 1kHz tone phase gives how far
+// its first sample is from its 20ms boundary, and consecutive frames must
+// be exactly 20ms apart (no dropped or repeated frames).
+#include "AudioVoterFrameQueue.h"
+#include "HostTest.h"
+#include <algorithm>
+#include <random>
+
+static constexpr DownsampleTable resampleTable = DownsampleTable::design(
+    RESAMPLER_CUTOFF / AUDIO_SAMPLE_RATE_EXACT, RESAMPLER_BETA);
+
+static const double kToneW = 2.0 * M_PI * 1000.0;
+
+// Offset (us) of a frame's tone from the 1kHz tone started at T (s)
+static double toneErrorUs(const int16_t *frame, double T) {
+  double I = 0.0, Q = 0.0;
+  for (int i = 0; i < FRAME_SIZE; i++) {
+    double ph = kToneW * fmod(T + i / 8000.0, 0.001);
+    I += frame[i] * cos(ph);
+    Q += frame[i] * sin(ph);
+  }
+  return atan2(I, Q) / kToneW * 1e6;
+}
+
+// The resampler and PpsDiscipline alone, aligned at each edge as the audio
+// ISR does (AudioVoterFrameQueue::_alignToPps(), and _measureRate() when
+// rate is set), against whole-second edges each seen up to +-ppsJitterUs
+// late or early. Frames are measured over the last 10 of 20s.
+static double alignRun(PpsDiscipline &pps, double ppm, double ppsJitterUs,
+                       bool rate, int *frames, int *breaks) {
+  static Downsampler d;
+  static int16_t frame[FRAME_SIZE];
+  const double ratio = AUDIO_SAMPLE_RATE_EXACT / 8000.0;
+  const float usPerIn = 1000000.0f / AUDIO_SAMPLE_RATE_EXACT;
+  const double fs = AUDIO_SAMPLE_RATE_EXACT * (1.0 + ppm * 1e-6);
+  const double t0 = 0.4173; // First sample, seconds after a PPS edge
+  const int blocks = (int)(20.0 * fs / AUDIO_BLOCK_SAMPLES);
+  int16_t in[AUDIO_BLOCK_SAMPLES];
+  int16_t out[Downsampler::maxOutput(AUDIO_SAMPLE_RATE_EXACT / 8000.0)];
+  uint32_t noise = 777;
+  int fill = 0;
+  bool measure = false, haveEdge = false;
+  double frameT = 0.0, lastT = 0.0, nextPps = 1.0, lastEdge = 0.0;
+  double worst = 0.0;
+
+  d.begin(&resampleTable, ratio);
+  pps.reset();
+  pps.resetRate();
+  *frames = 0;
+  *breaks = 0;
+  for (int b = 0; b < blocks; b++) {
+    double tb = t0 + (double)b * AUDIO_BLOCK_SAMPLES / fs;
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+      in[i] = (int16_t)(10000.0 * sin(kToneW * fmod(tb + i / fs, 0.001)));
+
+    if (tb >= nextPps) {
+      // First block after the edge (edge time as the PPS ISR sees it)
+      noise = noise * 1664525u + 1013904223u; // LCG
+      double edge =
+          nextPps + ppsJitterUs * 1e-6 * ((noise >> 8) / 8388608.0 - 1.0);
+      if (rate) {
+        // Codec samples since the previous edge
+        double edgePos = (edge - t0) * fs;
+        double r;
+        if (haveEdge && pps.onInterval(edgePos - lastEdge, &r))
+          d.setRatio(r);
+        lastEdge = edgePos;
+        haveEdge = true;
+      }
+      // Frame content around the acquire does not matter here, so the
+      // frame position simply jumps
+      float nextUs = (float)((tb - edge) * 1e6) + d.getNextOffset() * usPerIn;
+      int target;
+      d.adjustPhase(pps.onPps(nextUs, fill, &target) / usPerIn);
+      if (target != fill) {
+        fill = target;
+        measure = false; // Next whole frame is the first aligned one
+      }
+      nextPps += 1.0;
+    }
+
+    int n = d.process(in, AUDIO_BLOCK_SAMPLES, out,
+                      (int)(sizeof(out) / sizeof(out[0])));
+    for (int k = 0; k < n; k++) {
+      if (fill == 0)
+        frameT = tb + (d.getBlockOffset() + k * d.getRatio()) / fs;
+      frame[fill++] = out[k];
+      if (fill < FRAME_SIZE)
+        continue;
+      fill = 0;
+      if (!pps.isLocked())
+        continue;
+      if (!measure) {
+        measure = true; // Starts on the grid from here on
+        lastT = 0.0;
+        continue;
+      }
+
+      // Nearest 20ms boundary, and the tone's time offset from it
+      double T = floor(frameT / 0.02 + 0.5) * 0.02;
+      if (lastT > 0.0 && fabs(T - lastT - 0.02) > 1e-6)
+        (*breaks)++;
+      lastT = T;
+      if (T < 10.0)
+        continue; // Let the rate loop settle
+      worst = std::max(worst, fabs(toneErrorUs(frame, T)));
+      (*frames)++;
+    }
+  }
+  return worst;
+}
+
+// Phase steps only: frames drift by the codec error between edges
+static void testPhaseOnly() {
+  static PpsDiscipline pps;
+  const double ppms[] = {40.0, -40.0, 0.0};
+  for (double ppm : ppms) {
+    uint32_t acquires = pps.getAcquires();
+    int frames, breaks;
+    double worst = alignRun(pps, ppm, 0.0, false, &frames, &breaks);
+    printf("Phase only, %+3.0f ppm codec: %d frames within %.1f us, %d "
+           "breaks, %lu acquires\n",
+           ppm, frames, worst, breaks,
+           (unsigned long)(pps.getAcquires() - acquires));
+    CHECK(frames >= 450);
+    CHECK(breaks == 0);
+    CHECK(pps.getAcquires() - acquires == 1);
+    CHECK(worst <= fabs(ppm) + 1.0); // One second of drift
+  }
+}
+
+// With the rate loop the output runs at the GPS rate, so only the PPS
+// jitter is left for the phase steps
+static void testRateLoop() {
+  static PpsDiscipline pps;
+  const double ppms[] = {40.0, -40.0};
+  for (double ppm : ppms) {
+    int frames, breaks, rateBreaks;
+    double phaseOnly = alignRun(pps, ppm, 1.0, false, &frames, &breaks);
+    double withRate = alignRun(pps, ppm, 1.0, true, &frames, &rateBreaks);
+    printf("%+.0f ppm codec, 1us PPS jitter: frames within %.1f us (phase "
+           "only) / %.2f us (with rate), %d breaks, measured %+.3f ppm, %s\n",
+           ppm, phaseOnly, withRate, breaks + rateBreaks, pps.getPpm(),
+           PpsDiscipline::rateStateName(pps.getRateState()));
+    CHECK(breaks == 0 && rateBreaks == 0);
+    CHECK(withRate < 2.0);
+    CHECK(pps.getRateState() == PPSDISC_RATE_LOCKED);
+    CHECK(fabs(pps.getPpm() - ppm) < 0.1);
+  }
+}
+
+// The whole frame queue, as the audio and PPS ISRs drive it. micros() runs
+// off the codec crystal (as on the Teensy 4), the audio ISR is dispatched
+// 0-dispatchUs late, and each PPS edge is seen +-ppsJitterUs off.
+struct QueueRun {
+  double codecPpm, dispatchUs, ppsJitterUs;
+  int frames = 0, aligned = 0, breaks = 0; // Aligned/breaks: second half
+  double worstUs = 0.0;                     // Aligned frames, second half
+};
+
+static double simPpm;
+
+// micros() at a true (GPS) time
+static void setTrueUs(double us) {
+  hostSetUs((uint64_t)(us * (1.0 + simPpm * 1e-6)));
+}
+
+static void queueRun(AudioVoterFrameQueue &q, QueueRun &r, int seconds) {
+  static audio_block_t block;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> dispatch(0.0, r.dispatchUs);
+  std::uniform_real_distribution<double> ppsJitter(-r.ppsJitterUs,
+                                                   r.ppsJitterUs);
+  const double fs = AUDIO_SAMPLE_RATE_EXACT * (1.0 + r.codecPpm * 1e-6);
+  const double t0 = 0.3771; // First sample (s)
+  double nextPps = 1.0, lastT = 0.0;
+
+  simPpm = r.codecPpm;
+  setTrueUs(0.0);
+  q.begin(&resampleTable);
+  q.setPpsAlign(true);
+  r.frames = r.aligned = r.breaks = 0;
+  r.worstUs = 0.0;
+  uint32_t lastPpsMicros = 0;
+  for (int b = 0; b < (int)(seconds * fs / AUDIO_BLOCK_SAMPLES); b++) {
+    double tb = t0 + (double)b * AUDIO_BLOCK_SAMPLES / fs;
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+      block.data[i] =
+          (int16_t)(10000.0 * sin(kToneW * fmod(tb + i / fs, 0.001)));
+
+    // update(): the block's last sample, the ADC delay, the dispatch delay
+    double tu = tb + AUDIO_BLOCK_SAMPLES / fs +
+                (FRAMEQ_ADC_DELAY_US + dispatch(rng)) * 1e-6;
+    while (nextPps <= tu) {
+      setTrueUs((nextPps + ppsJitter(rng) * 1e-6) * 1e6);
+      lastPpsMicros = micros();
+      q.ppsEdge(lastPpsMicros);
+      nextPps += 1.0;
+    }
+    setTrueUs(tu * 1e6);
+    hostAudioInput = &block;
+    q.update();
+
+    while (q.available()) {
+      VoterFrame *f = q.readFrame();
+      r.frames++;
+      if (f->ppsAligned && tu > seconds / 2.0) {
+        // First sample in GPS time, from the last edge (as getTimeAt())
+        double ts = (nextPps - 1.0) +
+                    (int32_t)(f->captureMicros - lastPpsMicros) * 1e-6;
+        double T = floor(ts / 0.02 + 0.5) * 0.02;
+        if (lastT > 0.0 && fabs(T - lastT - 0.02) > 1e-6)
+          r.breaks++;
+        lastT = T;
+        r.worstUs = std::max(r.worstUs, fabs(toneErrorUs(f->samples, T)));
+        r.aligned++;
+      }
+      q.freeFrame();
+    }
+  }
+  q.end();
+}
+
+static void testQueue() {
+  static AudioVoterFrameQueue q;
+  QueueRun r = {30.0, 30.0, 0.0};
+  queueRun(q, r, 20);
+  const PpsDiscipline &pps = q.getPpsDiscipline();
+  printf("Frame queue, %+.0f ppm codec, 0-%.0f us ISR dispatch: %d frames, "
+         "%lu acquires, %d aligned in the last 10s within %.1f us, %d "
+         "breaks, %lu overruns\n",
+         r.codecPpm, r.dispatchUs, r.frames,
+         (unsigned long)pps.getAcquires(), r.aligned, r.worstUs, r.breaks,
+         (unsigned long)q.getOverruns());
+  CHECK(r.frames >= 980);
+  CHECK(pps.getAcquires() == 1);
+  CHECK(r.aligned >= 495);
+  CHECK(r.breaks == 0);
+  CHECK(r.worstUs < 50.0);
+  CHECK(q.getOverruns() == 0);
+}
+
+// Codec offsets across the crystal's range, with ISR dispatch and PPS
+// jitter: the rate is measured, and the aligned audio holds the grid
+static void testQueueRate() {
+  static AudioVoterFrameQueue q;
+  const QueueRun runs[] = {
+      {-60.0, 30.0, 5.0}, {-20.0, 30.0, 1.0}, {30.0, 30.0, 5.0},
+      {100.0, 30.0, 5.0}, {30.0, 0.0, 0.0},
+  };
+  for (QueueRun r : runs) {
+    queueRun(q, r, 30);
+    const PpsDiscipline &pps = q.getPpsDiscipline();
+    double ppmErr = pps.getPpm() - r.codecPpm;
+    printf("Frame queue, %+4.0f ppm codec, 0-%2.0f us ISR dispatch, +-%.0f us "
+           "PPS: measured %+.3f ppm (%s), aligned within %.1f us, %d breaks\n",
+           r.codecPpm, r.dispatchUs, r.ppsJitterUs, pps.getPpm(),
+           PpsDiscipline::rateStateName(pps.getRateState()), r.worstUs,
+           r.breaks);
+    CHECK(pps.getRateState() == PPSDISC_RATE_LOCKED);
+    // +-5us per edge is up to 10ppm per interval; the average leaves ~1ppm
+    CHECK(fabs(ppmErr) < 2.0);
+    CHECK(r.breaks == 0);
+    CHECK(r.worstUs < (r.dispatchUs > 0.0 ? 30.0 : 1.0));
+  }
+}
+
+int main() {
+  testPhaseOnly();
+  testRateLoop();
+  testQueue();
+  testQueueRate();
+  return hostTestResult();
+}
@@ -0,0 +1,143 @@
+// Resampler response: tones swept through the designed tables. The
+// downsampler (codec rate -> 8kHz) must be flat across the voice band and
+// reject everything that would fold back into it; the upsampler (8kHz ->
+// codec rate) must be flat and keep its images down. Amplitudes are read
+// by correlating the output against the expected frequency. The host time
+// per output sample is printed for scale (the Teensy figure is [B]).
+#include "HostTest.h"
+#include "Resampler.h"
+#include <AudioStream.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static constexpr DownsampleTable downTable = DownsampleTable::design(
+    RESAMPLER_CUTOFF / AUDIO_SAMPLE_RATE_EXACT, RESAMPLER_BETA);
+static constexpr UpsampleTable upTable =
+    UpsampleTable::design(UPSAMPLER_CUTOFF / 8000.0, UPSAMPLER_BETA);
+
+static const double kDown = AUDIO_SAMPLE_RATE_EXACT / 8000.0;
+static const double kAmp = 30000.0;
+
+// Amplitude of frequency f (Hz) in y, sampled at fs, skipping the settling
+static double amplitude(const std::vector<int16_t> &y, double f, double fs) {
+  const size_t skip = 400;
+  double c = 0.0, s = 0.0;
+  for (size_t i = skip; i < y.size(); i++) {
+    c += y[i] * cos(2.0 * M_PI * f * i / fs);
+    s += y[i] * sin(2.0 * M_PI * f * i / fs);
+  }
+  return 2.0 * sqrt(c * c + s * s) / (y.size() - skip);
+}
+
+static double dB(double a) { return 20.0 * log10(a / kAmp + 1e-12); }
+
+// A tone at f through the downsampler, 128-sample blocks
+static std::vector<int16_t> downsample(double f, double *nsPerOut = nullptr) {
+  static Downsampler d;
+  d.begin(&downTable, kDown);
+  std::vector<int16_t> y;
+  int16_t in[AUDIO_BLOCK_SAMPLES], out[Downsampler::maxOutput(kDown)];
+  double ph = 0.0, ns = 0.0;
+  for (int b = 0; b < 600; b++) {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+      in[i] = (int16_t)(kAmp * sin(ph));
+      ph += 2.0 * M_PI * f / AUDIO_SAMPLE_RATE_EXACT;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    int n = d.process(in, AUDIO_BLOCK_SAMPLES, out, (int)(sizeof(out) / 2));
+    ns += std::chrono::duration<double, std::nano>(
+              std::chrono::steady_clock::now() - t0)
+              .count();
+    y.insert(y.end(), out, out + n);
+  }
+  if (nsPerOut)
+    *nsPerOut = ns / y.size();
+  return y;
+}
+
+// Where f lands at 8kHz
+static double folded(double f) {
+  double a = fmod(f, 8000.0);
+  return a > 4000.0 ? 8000.0 - a : a;
+}
+
+static void testDownsampler() {
+  double ns;
+  downsample(1000.0, &ns);
+  printf("Downsampler: %d taps x 2 phases per output, %.0f ns per output "
+         "(host)\n",
+         RESAMPLER_TAPS, ns);
+
+  double lo = 0.0, hi = -100.0;
+  for (double f = 300.0; f <= 3000.0; f += 100.0) {
+    double g = dB(amplitude(downsample(f), f, 8000.0));
+    lo = std::min(lo, g);
+    hi = std::max(hi, g);
+  }
+  double at3300 = dB(amplitude(downsample(3300.0), 3300.0, 8000.0));
+  printf("Downsampler passband 300-3000 Hz: %.2f to %.2f dB (%.2f dB at "
+         "3300 Hz)\n",
+         lo, hi, at3300);
+  CHECK(lo > -0.2 && hi < 0.05);
+
+  // Every input from the stopband edge to the codec Nyquist frequency, at
+  // the frequency it folds to
+  double worst = -200.0, worstF = 0.0;
+  for (double f = RESAMPLER_STOPBAND; f < AUDIO_SAMPLE_RATE_EXACT / 2.0;
+       f += 100.0) {
+    double g = dB(amplitude(downsample(f), folded(f), 8000.0));
+    if (g > worst)
+      worst = g, worstF = f;
+  }
+  printf("Downsampler aliases, inputs %.0f-22000 Hz: %.1f dB at worst "
+         "(%.0f Hz -> %.0f Hz)\n",
+         (double)RESAMPLER_STOPBAND, worst, worstF, folded(worstF));
+  CHECK(worst < -70.0);
+}
+
+// A tone at f through the upsampler, UPSAMPLER_BLOCK-sample blocks
+static std::vector<int16_t> upsample(double f) {
+  static Upsampler u;
+  u.begin(&upTable, 1.0 / kDown);
+  std::vector<int16_t> y;
+  int16_t in[UPSAMPLER_BLOCK], out[Upsampler::maxOutput(1.0 / kDown)];
+  double ph = 0.0;
+  for (int b = 0; b < 1000; b++) {
+    for (int i = 0; i < UPSAMPLER_BLOCK; i++) {
+      in[i] = (int16_t)(kAmp * sin(ph));
+      ph += 2.0 * M_PI * f / 8000.0;
+    }
+    int n = u.process(in, UPSAMPLER_BLOCK, out, (int)(sizeof(out) / 2));
+    y.insert(y.end(), out, out + n);
+  }
+  return y;
+}
+
+static void testUpsampler() {
+  double lo = 0.0, hi = -100.0, image = -200.0, imageF = 0.0;
+  for (double f = 300.0; f <= 3300.0; f += 100.0) {
+    std::vector<int16_t> y = upsample(f);
+    double g = dB(amplitude(y, f, AUDIO_SAMPLE_RATE_EXACT));
+    if (f <= 3000.0) {
+      lo = std::min(lo, g);
+      hi = std::max(hi, g);
+    }
+    // First images, either side of 8kHz
+    double i1 = dB(amplitude(y, 8000.0 - f, AUDIO_SAMPLE_RATE_EXACT));
+    double i2 = dB(amplitude(y, 8000.0 + f, AUDIO_SAMPLE_RATE_EXACT));
+    if (std::max(i1, i2) - g > image)
+      image = std::max(i1, i2) - g, imageF = f;
+  }
+  printf("Upsampler passband 300-3000 Hz: %.2f to %.2f dB; images of "
+         "300-3300 Hz: %.1f dB at worst (%.0f Hz)\n",
+         lo, hi, image, imageF);
+  CHECK(lo > -0.5 && hi < 0.05);
+  CHECK(image < -60.0);
+}
+
+int main() {
+  testDownsampler();
+  testUpsampler();
+  return hostTestResult();
+}
@@ -0,0 +1,166 @@
+// Spectral squelch open/close decisions. Synthetic receiver audio is made at
+// the codec rate and goes through the real downsampler into 160-sample
+// frames, as in loop(), so the squelch sees the resampler's passband:
+// - FM discriminator noise (no carrier): white noise differentiated, so its
+//   power rises with frequency, loud
+// - voice: a 140Hz harmonic series with a 4Hz syllable envelope, over weak
+//   discriminator noise (a carrier that is mostly quieting)
+// - a fully quieted carrier: noise far below SPECTRAL_QUIET_DBFS
+// - flat white noise, which must read about 0dB SNR (both bands flat)
+#include "ConfigManager.h"
+#include "DSPProcessor.h"
+#include "HostTest.h"
+#include "Resampler.h"
+#include <random>
+#include <vector>
+
+ConfigManager::ConfigManager() {}
+ConfigManager cfg;
+
+static constexpr DownsampleTable resampleTable = DownsampleTable::design(
+    RESAMPLER_CUTOFF / AUDIO_SAMPLE_RATE_EXACT, RESAMPLER_BETA);
+
+struct Receiver {
+  double noiseRms = 0.0; // Discriminator noise (full scale 1.0)
+  bool rising = true;    // Differentiated (FM) or flat noise
+  double voice = 0.0;    // Peak voice level
+
+  std::mt19937 rng{7};
+  std::normal_distribution<double> gauss{0.0, 1.0};
+  double lastWhite = 0.0;
+  uint64_t n = 0;
+
+  double next() {
+    double t = (double)n++ / AUDIO_SAMPLE_RATE_EXACT;
+    double white = gauss(rng);
+    // Differencing doubles the variance at the top of the band: scale back
+    double noise = rising ? (white - lastWhite) / sqrt(2.0) : white;
+    lastWhite = white;
+    double v = 0.0;
+    if (voice > 0.0) {
+      for (int k = 1; k * 140.0 < 3000.0; k++)
+        v += sin(2.0 * M_PI * 140.0 * k * t + k) / k;
+      v *= voice * (0.65 + 0.35 * sin(2.0 * M_PI * 4.0 * t)) / 2.5;
+    }
+    return v + noiseRms * noise;
+  }
+};
+
+static Downsampler down;
+static VoterFrameDSP dsp;
+static std::vector<int16_t> pending;
+
+// The next 20ms frame of rx through the resampler and the squelch
+static bool frame(Receiver &rx) {
+  int16_t in[AUDIO_BLOCK_SAMPLES];
+  int16_t out[Downsampler::maxOutput(AUDIO_SAMPLE_RATE_EXACT / 8000.0)];
+  while (pending.size() < FRAME_SIZE) {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+      double x = rx.next() * 32768.0;
+      in[i] = (int16_t)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+    }
+    int n = down.process(in, AUDIO_BLOCK_SAMPLES, out, (int)(sizeof(out) / 2));
+    pending.insert(pending.end(), out, out + n);
+  }
+  int16_t f[FRAME_SIZE];
+  memcpy(f, pending.data(), sizeof(f));
+  pending.erase(pending.begin(), pending.begin() + FRAME_SIZE);
+  dsp.process(f, true, true);
+  return dsp.isSpectralOpen();
+}
+
+struct Run {
+  int open = 0;         // Frames open
+  int firstOpen = -1;   // Frame index
+  int lastOpen = -1;
+  float minSnr = 1e9f, maxSnr = -1e9f, meanSnr = 0.0f;
+};
+
+static Run run(Receiver &rx, int frames, int settle = 0) {
+  Run r;
+  for (int i = 0; i < frames; i++) {
+    bool open = frame(rx);
+    if (open) {
+      r.open++;
+      if (r.firstOpen < 0)
+        r.firstOpen = i;
+      r.lastOpen = i;
+    }
+    if (i >= settle) {
+      r.minSnr = std::min(r.minSnr, dsp.getSpectralSnr());
+      r.maxSnr = std::max(r.maxSnr, dsp.getSpectralSnr());
+      r.meanSnr += dsp.getSpectralSnr() / (frames - settle);
+    }
+  }
+  return r;
+}
+
+static void start() {
+  down.begin(&resampleTable, AUDIO_SAMPLE_RATE_EXACT / 8000.0);
+  pending.clear();
+  dsp.begin();
+  dsp.setEngine(DSP_ENGINE_FUSED);
+  dsp.setSpectralSquelch(false);
+  dsp.setSpectralSquelch(true);
+}
+
+// No carrier, then a carrier with voice, then no carrier again (5s each)
+static void testSequence() {
+  start();
+  Receiver noise;
+  noise.noiseRms = 0.3;
+  Receiver voice;
+  voice.noiseRms = 0.003;
+  voice.voice = 0.5;
+
+  Run a = run(noise, 250, 10);
+  Run b = run(voice, 250, 10);
+  Run c = run(noise, 250, 10);
+  printf("No carrier: open %d/250 frames, SNR %.1f to %.1f dB\n", a.open,
+         a.minSnr, a.maxSnr);
+  printf("Voice over weak noise: open after %d frames, %d/250 open, SNR %.1f "
+         "to %.1f dB\n",
+         b.firstOpen + 1, b.open, b.minSnr, b.maxSnr);
+  printf("No carrier again: closed after %d frames, %d/250 open\n",
+         c.lastOpen + 1, c.open);
+  CHECK(a.open == 0);
+  CHECK(a.maxSnr < (float)cfg.data.spectralSnrThresh - SPECTRAL_HYST_DB);
+  CHECK(b.firstOpen >= 0 && b.firstOpen <= 3);
+  CHECK(b.open == 250 - b.firstOpen);
+  CHECK(c.lastOpen <= 3 && c.open == c.lastOpen + 1);
+}
+
+// A quieted carrier (nothing in either band) counts as full SNR
+static void testQuieted() {
+  start();
+  Receiver quiet;
+  quiet.noiseRms = 1e-5;
+  Run r = run(quiet, 100, 10);
+  printf("Quieted carrier: open after %d frames, %d/100 open\n",
+         r.firstOpen + 1, r.open);
+  CHECK(r.firstOpen >= 0 && r.firstOpen <= 3);
+  CHECK(r.open == 100 - r.firstOpen);
+}
+
+// Flat noise reads about 0dB on average: the resampler does not tilt the
+// bands (single frames scatter, the noise band is only 13 bins)
+static void testFlatNoise() {
+  start();
+  Receiver flat;
+  flat.noiseRms = 0.1;
+  flat.rising = false;
+  Run r = run(flat, 250, 10);
+  printf("Flat noise: SNR %.2f dB mean (%.1f to %.1f), open %d/250\n",
+         r.meanSnr, r.minSnr, r.maxSnr, r.open);
+  CHECK(r.open == 0);
+  CHECK(fabsf(r.meanSnr) < 0.5f);
+}
+
+int main() {
+  cfg.data.dspCalib = 13.0f;
+  cfg.data.spectralSnrThresh = 6; // Default
+  testSequence();
+  testQuieted();
+  testFlatNoise();
+  return hostTestResult();
+}
@@ -0,0 +1,190 @@
+// SPI link codecs: master (Teensy) and slave (ESP32) against each other in
+// memory, one transaction as EspSpiDriver runs it. The modelled wire is clean
+// up to 20MHz and gains bit errors (2e-4 per MHz) above it; a noise floor can
+// be added on top. Each end queues numbered datagrams and checks the ones it
+// gets.
+#include "HostTest.h"
+#include "SpiLink.h"
+
+struct LinkLoopPort : SpiLinkPort {
+  uint32_t toSend = 0, nextId = 0;
+  uint32_t received = 0, corrupt = 0, missing = 0, lastId = 0;
+  uint8_t slots = 8, used = 0;
+
+  static uint16_t lenOf(uint32_t id) { return 24 + (id * 37) % 300; }
+
+  uint16_t nextDatagram(uint8_t *ip, uint16_t *port, uint8_t *data,
+                        uint16_t maxLen) override {
+    uint16_t len = lenOf(nextId);
+    if (!toSend || len > maxLen)
+      return 0;
+    ip[0] = 10, ip[1] = 0, ip[2] = 0, ip[3] = 1;
+    *port = 1667;
+    for (uint16_t i = 0; i < len; i++)
+      data[i] = (uint8_t)(nextId + i);
+    memcpy(data, &nextId, 4);
+    nextId++;
+    toSend--;
+    return len;
+  }
+  bool hasDatagram() override { return toSend > 0; }
+  bool onDatagram(const uint8_t *ip, uint16_t port, const uint8_t *data,
+                  uint16_t len) override {
+    if (used == slots)
+      return false;
+    used++;
+    uint32_t id;
+    memcpy(&id, data, 4);
+    bool ok = len == lenOf(id) && port == 1667 && ip[0] == 10;
+    for (uint16_t i = 4; ok && i < len; i++)
+      ok = data[i] == (uint8_t)(id + i);
+    if (!ok)
+      corrupt++;
+    else if (received && id != lastId + 1)
+      missing += id - lastId - 1;
+    lastId = id;
+    received++;
+    return true;
+  }
+  uint8_t credits() override { return slots - used; }
+  bool getBridgeStats(SpiLinkBridgeStats *s) override {
+    memset(s, 0, sizeof(*s));
+    s->uptimeMs = 0x01020304;
+    s->netRxPackets = received;
+    s->netTxPackets = nextId;
+    s->toSpiDrops = 0xFFFFFFFE;
+    s->toNetHigh = slots;
+    s->toNetSlots = 0xABCD;
+    return true;
+  }
+};
+
+static uint32_t noise = 1;
+
+static void corrupt(uint8_t *buf, uint16_t len, float ber) {
+  if (ber <= 0.0f)
+    return;
+  uint32_t threshold = (uint32_t)(ber * 4294967296.0f);
+  for (uint32_t bit = 0; bit < (uint32_t)len * 8; bit++) {
+    noise = noise * 1664525u + 1013904223u; // LCG
+    if (noise < threshold)
+      buf[bit >> 3] ^= 1 << (bit & 7);
+  }
+}
+
+// One transaction as EspSpiDriver runs it: headers first, then the longer
+// frame
+static void transaction(SpiLinkMaster &m, SpiLinkSlave &sl, LinkLoopPort &mp,
+                        LinkLoopPort &sp, float floorBer) {
+  static uint8_t mOut[SPILINK_BUFFER], sOut[SPILINK_BUFFER];
+  static uint8_t mIn[SPILINK_BUFFER], sIn[SPILINK_BUFFER];
+  uint16_t ours = m.build(mOut, mp);
+  uint16_t slaveLen = sl.build(sOut, sp);
+
+  float mhz = m.getClock() / 1e6f;
+  float ber = floorBer + (mhz > 20.0f ? (mhz - 20.0f) * 2e-4f : 0.0f);
+  memcpy(mIn, sOut, SPILINK_HEADER);
+  corrupt(mIn, SPILINK_HEADER, ber);
+  uint16_t theirs = SpiLinkReader::frameLength(mIn);
+  uint16_t n = ours > theirs ? ours : theirs;
+  memset(mOut + ours, 0, n - ours);
+  memset(sOut + slaveLen, 0, SPILINK_BUFFER - slaveLen);
+  memcpy(mIn + SPILINK_HEADER, sOut + SPILINK_HEADER, n - SPILINK_HEADER);
+  memcpy(sIn, mOut, n);
+  corrupt(mIn + SPILINK_HEADER, n - SPILINK_HEADER, ber);
+  corrupt(sIn, n, ber);
+
+  sl.receive(sIn, n, sp);
+  m.onTransaction(m.receive(mIn, n, mp));
+  mp.used = sp.used = 0; // Both consumers keep up
+}
+
+static SpiLinkMaster master;
+static SpiLinkSlave slave;
+static LinkLoopPort mp, sp;
+
+static void testTraining() {
+  const uint8_t ip[4] = {192, 168, 1, 50};
+  master.hello();
+  slave.setAddress(ip);
+  slave.setLinkUp(true);
+  master.setConfig("ssid", "password");
+  sp.slots = 16;
+
+  int frames = 0;
+  while (!master.isUp() && frames < 1000) {
+    transaction(master, slave, mp, sp, 0.0f);
+    frames++;
+  }
+  printf("Training: %lu MHz in %d frames (wire clean to 20 MHz)\n",
+         (unsigned long)(master.getClock() / 1000000), frames);
+  CHECK(master.isUp());
+  CHECK(master.getClock() == 20000000);
+}
+
+// 3 datagrams each way every other transaction. With a noise floor, bad
+// frames are dropped whole: nothing corrupt is delivered, and every datagram
+// lost is in a frame counted as a SEQ gap.
+static void testDelivery() {
+  const float floors[] = {0.0f, 1e-5f};
+  for (float floorBer : floors) {
+    SpiLinkStats m0 = master.getStats(), s0 = slave.getStats();
+    uint32_t mRx = mp.received, sRx = sp.received;
+    uint32_t bad = mp.corrupt + sp.corrupt, lost = mp.missing + sp.missing;
+    uint32_t sent = 0;
+    for (int t = 0; t < 2000; t++) {
+      if (t % 2 == 0) {
+        mp.toSend += 3;
+        sp.toSend += 3;
+        sent += 3;
+      }
+      transaction(master, slave, mp, sp, floorBer);
+    }
+    const SpiLinkStats &m1 = master.getStats(), &s1 = slave.getStats();
+    uint32_t toEsp = sp.received - sRx, toTeensy = mp.received - mRx;
+    uint32_t seqLost = (m1.seqLost - m0.seqLost) + (s1.seqLost - s0.seqLost);
+    printf("BER floor %.0e: %lu/%lu to the ESP32, %lu/%lu to the Teensy, %lu "
+           "corrupt, %lu missing; %lu+%lu bad frames, %lu SEQ lost, %lu "
+           "retrains\n",
+           floorBer, (unsigned long)toEsp, (unsigned long)sent,
+           (unsigned long)toTeensy, (unsigned long)sent,
+           (unsigned long)(mp.corrupt + sp.corrupt - bad),
+           (unsigned long)(mp.missing + sp.missing - lost),
+           (unsigned long)(m1.badFrames - m0.badFrames),
+           (unsigned long)(s1.badFrames - s0.badFrames),
+           (unsigned long)seqLost, (unsigned long)master.getRetrains());
+    CHECK(mp.corrupt + sp.corrupt == bad);
+    CHECK(master.isUp());
+    if (floorBer == 0.0f) {
+      CHECK(toEsp == sent && toTeensy == sent);
+      CHECK(seqLost == 0);
+    } else {
+      // Lost datagrams are all in missing frames
+      CHECK(toEsp + toTeensy + mp.missing + sp.missing - lost == 2 * sent);
+      CHECK(seqLost > 0);
+    }
+  }
+  const uint8_t *ip = master.getLocalIP();
+  CHECK(!master.isConfigPending());
+  CHECK(ip[0] == 192 && ip[1] == 168 && ip[2] == 1 && ip[3] == 50);
+}
+
+// Bridge counters: one STATS round trip, checked field by field
+static void testBridgeStats() {
+  SpiLinkBridgeStats want;
+  sp.getBridgeStats(&want);
+  uint32_t answers = master.getBridgeStatsCount();
+  master.requestBridgeStats();
+  for (int t = 0; t < 4 && master.getBridgeStatsCount() == answers; t++)
+    transaction(master, slave, mp, sp, 0.0f);
+  const SpiLinkBridgeStats &b = master.getBridgeStats();
+  CHECK(master.getBridgeStatsCount() == answers + 1);
+  CHECK(memcmp(&b, &want, sizeof(b)) == 0);
+}
+
+int main() {
+  testTraining();
+  testDelivery();
+  testBridgeStats();
+  return hostTestResult();
+}
@@ -0,0 +1,73 @@
+// ESP32 bridge, network side: the socket drain of Spirit.ino (pollSocket())
+// against a WiFiUDP that, like arduino-esp32's, parses nothing more while a
+// datagram is held. Every way a datagram can be dropped (too long, toSpi
+// full, read failing) must release it, or reception stops there.
+#include "HostTest.h"
+
+#include "Spirit.ino"
+
+static const IPAddress host(10, 0, 0, 1);
+
+static void arrive(size_t len, uint8_t fill) {
+  static uint8_t buf[1460];
+  memset(buf, fill, len);
+  hostUdpArrive(host, 1667, buf, len);
+}
+
+// Take what the UDP task queued for the SPI side; true if it is one
+// datagram of len bytes of fill from the host
+static bool takeOne(size_t len, uint8_t fill) {
+  if (toSpi.available() != 1)
+    return false;
+  Datagram *d = toSpi.peek();
+  bool ok = d->len == len && d->port == 1667 && d->ip[0] == 10 &&
+            d->ip[3] == 1 && d->data[0] == fill && d->data[len - 1] == fill;
+  toSpi.consume();
+  return ok;
+}
+
+static void testTooLong() {
+  arrive(SPILINK_MAX_DATAGRAM + 1, 0x11);
+  arrive(185, 0x22);
+  pollSocket();
+  CHECK(tooLong == 1);
+  CHECK(takeOne(185, 0x22));
+  CHECK(hostUdpQueued() == 0);
+}
+
+static void testToSpiFull() {
+  for (int i = 0; i < BRIDGE_SLOTS; i++) {
+    toSpi.reserve();
+    toSpi.commit();
+  }
+  uint32_t overflows = toSpi.getOverflows();
+  arrive(185, 0x33); // Dropped: toSpi full
+  pollSocket();
+  CHECK(toSpi.getOverflows() == overflows + 1);
+  while (toSpi.available())
+    toSpi.consume();
+
+  arrive(185, 0x44);
+  pollSocket();
+  CHECK(takeOne(185, 0x44));
+}
+
+static void testReadFails() {
+  hostUdpReadFails = true;
+  arrive(185, 0x55);
+  arrive(185, 0x66);
+  pollSocket();
+  CHECK(takeOne(185, 0x66));
+}
+
+int main() {
+  testTooLong();
+  testToSpiFull();
+  testReadFails();
+  printf("Socket drain: %lu too long, %lu toSpi full, 1 failed read; the "
+         "datagram after each arrived (%lu received)\n",
+         (unsigned long)tooLong, (unsigned long)toSpi.getOverflows(),
+         (unsigned long)netRxPackets);
+  CHECK(netRxPackets == 3);
+  return hostTestResult();
+}
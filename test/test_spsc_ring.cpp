@@ -0,0 +1,157 @@
+// SpscRing: single-threaded edge cases, then a producer and a consumer on
+// separate threads (as audio ISR / loop(), or the two ESP32 bridge tasks)
+// with every item's sequence number and payload checked.
+#include "HostTest.h"
+#include "SpscRing.h"
+#include <thread>
+
+struct Item {
+  uint32_t seq;
+  uint32_t data[40]; // Frame-sized, so a torn read shows
+};
+
+static void fill(Item &item, uint32_t seq) {
+  item.seq = seq;
+  for (uint32_t i = 0; i < 40; i++)
+    item.data[i] = seq * 2654435761u + i;
+}
+
+static bool intact(const Item &item, uint32_t seq) {
+  if (item.seq != seq)
+    return false;
+  for (uint32_t i = 0; i < 40; i++)
+    if (item.data[i] != seq * 2654435761u + i)
+      return false;
+  return true;
+}
+
+static void testSingleThread() {
+  static SpscRing<Item, 8> ring;
+  Item item;
+
+  // All 8 slots usable, the 9th overflows
+  for (uint32_t s = 0; s < 8; s++) {
+    fill(item, s);
+    CHECK(ring.push(item));
+  }
+  fill(item, 8);
+  CHECK(!ring.push(item));
+  CHECK(ring.reserve() == nullptr);
+  CHECK(ring.getOverflows() == 2);
+  CHECK(ring.available() == 8);
+  CHECK(ring.getHighWater() == 8);
+
+  // Consume 5, refill 5: the readable run stops at the end of the buffer
+  Item *first;
+  CHECK(ring.readView(&first) == 8);
+  ring.consume(5);
+  for (uint32_t s = 8; s < 13; s++) {
+    Item *slot = ring.reserve();
+    CHECK(slot != nullptr);
+    if (slot) {
+      fill(*slot, s);
+      ring.commit();
+    }
+  }
+  uint32_t n = ring.readView(&first);
+  CHECK(n == 3);
+  for (uint32_t i = 0; i < n; i++)
+    CHECK(intact(first[i], 5 + i));
+  ring.consume(n);
+  n = ring.readView(&first);
+  CHECK(n == 5);
+  for (uint32_t i = 0; i < n; i++)
+    CHECK(intact(first[i], 8 + i));
+
+  // consume() never passes the head
+  ring.consume(100);
+  CHECK(ring.available() == 0);
+  CHECK(!ring.pop(item));
+  CHECK(ring.peek() == nullptr);
+  CHECK(ring.getUnderflows() == 2);
+
+  // clear() drops what is queued
+  fill(item, 13);
+  ring.push(item);
+  ring.push(item);
+  ring.clear();
+  CHECK(ring.available() == 0);
+}
+
+// The producer alternates reserve()/commit() and push(); the consumer
+// alternates readView()/consume() batches and pop(). Both spin (yield) on a
+// full/empty ring, so overflows and underflows are expected, losses are not.
+static void testTwoThreads() {
+  static SpscRing<Item, 8> ring;
+  const uint32_t count = 500000;
+  uint32_t received = 0, bad = 0;
+
+  std::thread producer([&] {
+    Item item;
+    for (uint32_t s = 0; s < count;) {
+      if (s % 2) {
+        fill(item, s);
+        if (!ring.push(item)) {
+          std::this_thread::yield();
+          continue;
+        }
+      } else {
+        Item *slot = ring.reserve();
+        if (!slot) {
+          std::this_thread::yield();
+          continue;
+        }
+        fill(*slot, s);
+        ring.commit();
+      }
+      s++;
+    }
+  });
+
+  std::thread consumer([&] {
+    uint32_t expect = 0;
+    Item item;
+    while (expect < count) {
+      if (expect % 3 == 0) {
+        if (!ring.pop(item)) {
+          std::this_thread::yield();
+          continue;
+        }
+        if (!intact(item, expect))
+          bad++;
+        expect++;
+        continue;
+      }
+      Item *first;
+      uint32_t n = ring.readView(&first);
+      if (n == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      for (uint32_t i = 0; i < n; i++)
+        if (!intact(first[i], expect + i))
+          bad++;
+      ring.consume(n);
+      expect += n;
+    }
+    received = expect;
+  });
+
+  producer.join();
+  consumer.join();
+
+  printf("Two threads: %u/%u items, %u bad, %u overflows, %u underflows, "
+         "high water %u/%u\n",
+         received, count, bad, ring.getOverflows(), ring.getUnderflows(),
+         ring.getHighWater(), ring.capacity());
+  CHECK(received == count);
+  CHECK(bad == 0);
+  CHECK(ring.available() == 0);
+  CHECK(ring.getHighWater() <= ring.capacity());
+}
+
+int main() {
+  testSingleThread();
+  testTwoThreads();
+  return hostTestResult();
+}
@@ -0,0 +1,184 @@
+// AudioVoterTxQueue: timed host frames replayed into write()/service() as
+// loop() would run them, with the test playing the audio ISR (update()
+// every 128 samples on the codec clock). Each frame carries one click on
+// its first sample; every click must leave the DAC at timestamp + txDelay,
+// to within one output sample (the burst start is placed on the sample grid,
+// and the peak is found on it).
+#include "AudioVoterTxQueue.h"
+#include "HostTest.h"
+#include "ULaw.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+static constexpr UpsampleTable upsampleTable =
+    UpsampleTable::design(UPSAMPLER_CUTOFF / 8000.0, UPSAMPLER_BETA);
+
+static const double kSampleUs = 1e6 / AUDIO_SAMPLE_RATE_EXACT;
+static const double kBlockUs = AUDIO_BLOCK_SAMPLES * kSampleUs;
+static const uint64_t kEpochUs = 1700000000ULL * 1000000ULL; // GPS - local
+
+// Output samples and the time each one reaches the DAC (two blocks of I2S
+// buffering after the update() that produced it, as TX_OUTPUT_LATENCY_US)
+static std::vector<int16_t> outSamples;
+static std::vector<double> outUs;
+static double updateUs;
+
+static void onTransmit(const audio_block_t *block) {
+  for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+    outSamples.push_back(block->data[i]);
+    outUs.push_back(updateUs + 2 * kBlockUs + i * kSampleUs);
+  }
+}
+
+static VTIME toVtime(uint64_t us) {
+  VTIME t = {(uint32_t)(us / 1000000), (uint32_t)(us % 1000000 * 1000)};
+  return t;
+}
+
+// Upsampler alone: a 3.3kHz tone, and its first image at 4.7kHz
+static void testUpsamplerImages() {
+  static Upsampler up;
+  up.begin(&upsampleTable, 8000.0 / AUDIO_SAMPLE_RATE_EXACT);
+  std::vector<float> y;
+  int16_t in[UPSAMPLER_BLOCK];
+  int16_t out[Upsampler::maxOutput(8000.0 / AUDIO_SAMPLE_RATE_EXACT)];
+  double ph = 0.0;
+  for (int b = 0; b < 2000; b++) {
+    for (int i = 0; i < UPSAMPLER_BLOCK; i++) {
+      in[i] = (int16_t)(10000.0 * sin(ph));
+      ph += 2.0 * M_PI * 3300.0 / 8000.0;
+    }
+    int n = up.process(in, UPSAMPLER_BLOCK, out, (int)(sizeof(out) / 2));
+    y.insert(y.end(), out, out + n);
+  }
+  auto amplitude = [&](double f) {
+    double c = 0.0, s = 0.0;
+    for (size_t i = 2000; i < y.size(); i++) {
+      c += y[i] * cos(2.0 * M_PI * f * i / AUDIO_SAMPLE_RATE_EXACT);
+      s += y[i] * sin(2.0 * M_PI * f * i / AUDIO_SAMPLE_RATE_EXACT);
+    }
+    return sqrt(c * c + s * s);
+  };
+  double imageDb = 20.0 * log10(amplitude(4700.0) / amplitude(3300.0));
+  printf("Upsampler: 3.3kHz image at 4.7kHz %.1f dB\n", imageDb);
+  CHECK(imageDb < -60.0);
+}
+
+struct Packet {
+  double arriveUs; // Local time
+  VTIME t;         // Host stamp (GPS time)
+};
+
+struct Replay {
+  const char *name;
+  uint16_t delayMs;
+  double jitterUs; // Network delay spread (uniform), so frames reorder too
+  int dropEvery;   // Every n-th frame lost on the way (0 = none)
+};
+
+// 200 frames from t0, then 600ms more for the burst to end
+static void replay(const Replay &r) {
+  std::unique_ptr<AudioVoterTxQueue> queue(new AudioVoterTxQueue);
+  AudioVoterTxQueue &q = *queue; // Fresh counters each run
+  const int frames = 200;
+  const double t0 = 6e6 + 7321.0; // Burst start, local us (off the grid)
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> jitter(0.0, r.jitterUs);
+
+  hostSetUs(5000000);
+  q.setDelay(r.delayMs);
+  q.begin(&upsampleTable);
+  outSamples.clear();
+  outUs.clear();
+  hostAudioTransmit = onTransmit;
+
+  uint8_t click[FRAME_SIZE];
+  for (int i = 0; i < FRAME_SIZE; i++)
+    click[i] = ulawEncode(i == 0 ? 20000 : 0);
+
+  std::vector<Packet> packets;
+  int dropped = 0;
+  for (int k = 0; k < frames; k++) {
+    if (r.dropEvery && k % r.dropEvery == r.dropEvery / 2) {
+      dropped++;
+      continue;
+    }
+    Packet p;
+    p.t = toVtime(kEpochUs + (uint64_t)(t0 + k * 20000.0));
+    p.arriveUs = t0 + k * 20000.0 + 5000.0 + jitter(rng);
+    packets.push_back(p);
+  }
+  std::sort(packets.begin(), packets.end(),
+            [](const Packet &a, const Packet &b) {
+              return a.arriveUs < b.arriveUs;
+            });
+
+  // loop() every 250us (service() every 1ms), the ISR on the codec clock
+  size_t next = 0;
+  double isrUs = 5e6, endUs = t0 + frames * 20000.0 + 600000.0;
+  uint32_t keyedMs = 0;
+  for (double us = 5e6; us < endUs; us += 250.0) {
+    hostSetUs((uint64_t)us);
+    while (next < packets.size() && packets[next].arriveUs <= us)
+      q.write(packets[next++].t, click);
+    if ((uint64_t)us % 1000 == 0) {
+      VTIME gps = toVtime(kEpochUs + (uint64_t)us);
+      q.service(&gps);
+      if (q.isKeyed())
+        keyedMs++;
+    }
+    while (isrUs <= us) {
+      hostSetUs((uint64_t)isrUs);
+      updateUs = isrUs;
+      q.update();
+      isrUs += kBlockUs;
+    }
+  }
+
+  // Clicks: local peaks, each against the nearest frame's play time
+  double playUs = t0 + r.delayMs * 1000.0;
+  double worst = 0.0;
+  int clicks = 0;
+  for (size_t i = 1; i + 1 < outSamples.size(); i++) {
+    if (outSamples[i] > 8000 && outSamples[i] >= outSamples[i - 1] &&
+        outSamples[i] > outSamples[i + 1]) {
+      double k = floor((outUs[i] - playUs) / 20000.0 + 0.5);
+      double err = outUs[i] - (playUs + k * 20000.0);
+      worst = std::max(worst, fabs(err));
+      clicks++;
+    }
+  }
+
+  printf("%-22s: %d/%d clicks, worst %.1f us off timestamp + %u ms | played "
+         "%u late %u early %u lost %u underruns %u max depth %u, keyed %u "
+         "ms\n",
+         r.name, clicks, frames - dropped, worst, r.delayMs,
+         q.getFramesPlayed(), q.getLate(), q.getEarly(), q.getLost(),
+         q.getUnderruns(), q.getMaxDepth(), keyedMs);
+  CHECK(clicks == frames - dropped);
+  CHECK(worst <= kSampleUs);
+  CHECK(q.getLate() == 0);
+  CHECK(q.getEarly() == 0);
+  CHECK(q.getLost() == (uint32_t)dropped);
+  CHECK(q.getUnderruns() == 0);
+  CHECK(!q.isKeyed());
+  // Keyed from the first frame to the end of the hang frames
+  CHECK(keyedMs >= frames * 20u &&
+        keyedMs <= (frames + TX_HANG_FRAMES) * 20u + r.delayMs + 60u);
+  hostAudioTransmit = nullptr;
+  q.end();
+}
+
+int main() {
+  testUpsamplerImages();
+  const Replay replays[] = {
+      {"No jitter", 100, 0.0, 0},
+      {"60ms jitter, losses", 120, 60000.0, 37},
+      {"150ms jitter, losses", 220, 150000.0, 37},
+  };
+  for (const Replay &r : replays)
+    replay(r);
+  return hostTestResult();
+}
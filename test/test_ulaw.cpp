@@ -0,0 +1,115 @@
+// G.711 u-Law: the CLZ encoder against the table-search reference for all
+// 65536 inputs, both against Sun's g711.c, and the decoder's round trip.
+// Sun's later g711.c works on 14 bits: it shifts right by 2 before negating,
+// so a negative input is rounded away from zero to a multiple of 4 first
+// (-1 encodes as -4 would). The reference is the earlier 16-bit Sun code
+// (BIAS - pcm, no shift), which agrees with it on every multiple of 4.
+#include "HostTest.h"
+#include "ULaw.h"
+#include <stdlib.h>
+
+// Sun Microsystems g711.c linear2ulaw(), 14-bit revision, as published
+static uint8_t sunLinear2ulaw(int16_t pcmVal) {
+  static const int16_t segUend[8] = {0x3F,  0x7F,  0xFF,  0x1FF,
+                                     0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+  int16_t mask, seg;
+  pcmVal = pcmVal >> 2;
+  if (pcmVal < 0) {
+    pcmVal = -pcmVal;
+    mask = 0x7F;
+  } else {
+    mask = 0xFF;
+  }
+  if (pcmVal > 8159) // CLIP
+    pcmVal = 8159;
+  pcmVal += (ULAW_BIAS >> 2);
+  for (seg = 0; seg < 8; seg++)
+    if (pcmVal <= segUend[seg])
+      break;
+  if (seg >= 8)
+    return (uint8_t)(0x7F ^ mask);
+  uint8_t uval = (uint8_t)((seg << 4) | ((pcmVal >> (seg + 1)) & 0xF));
+  return uval ^ mask;
+}
+
+static void testExhaustive() {
+  uint32_t mismatches = 0, sunDiffer = 0, sunDifferNonNeg = 0;
+  uint32_t sunAfterRounding = 0;
+  for (int32_t x = -32768; x <= 32767; x++) {
+    int16_t pcm = (int16_t)x;
+    uint8_t ref = ulawEncodeRef(pcm);
+    if (ulawEncode(pcm) != ref)
+      mismatches++;
+    uint8_t sun = sunLinear2ulaw(pcm);
+    if (sun != ref) {
+      sunDiffer++;
+      if (x >= 0)
+        sunDifferNonNeg++;
+    }
+    // Sun's rounding made explicit: floor to a multiple of 4
+    if (sun != ulawEncodeRef((int16_t)(x & ~3)))
+      sunAfterRounding++;
+  }
+  printf("u-Law: CLZ vs reference %lu/65536 mismatches; reference vs Sun "
+         "14-bit g711.c %lu differ (%lu non-negative), %lu after rounding "
+         "to a multiple of 4\n",
+         (unsigned long)mismatches, (unsigned long)sunDiffer,
+         (unsigned long)sunDifferNonNeg, (unsigned long)sunAfterRounding);
+  CHECK(mismatches == 0);
+  CHECK(sunDifferNonNeg == 0);
+  CHECK(sunDiffer > 0);
+  CHECK(sunAfterRounding == 0);
+}
+
+// Fixed vectors, including the negative rounding case
+static void testVectors() {
+  struct {
+    int16_t pcm;
+    uint8_t ulaw, sun;
+  } const v[] = {
+      {0, 0xFF, 0xFF},       {-1, 0x7F, 0x7E},      {-4, 0x7E, 0x7E},
+      {-8, 0x7E, 0x7E},      {-9, 0x7E, 0x7D},      {8, 0xFE, 0xFE},
+      {-132, 0x6F, 0x6F},    {-137, 0x6F, 0x6E},    {1000, 0xCE, 0xCE},
+      {-1000, 0x4E, 0x4E},   {-1001, 0x4E, 0x4E},   {32767, 0x80, 0x80},
+      {-32768, 0x00, 0x00},
+  };
+  for (const auto &t : v) {
+    uint8_t u = ulawEncode(t.pcm), s = sunLinear2ulaw(t.pcm);
+    if (u != t.ulaw || s != t.sun)
+      printf("  %d: ulawEncode 0x%02X (want 0x%02X), Sun 0x%02X (want "
+             "0x%02X)\n",
+             t.pcm, u, t.ulaw, s, t.sun);
+    CHECK(u == t.ulaw);
+    CHECK(s == t.sun);
+  }
+}
+
+// Decoding gives the middle of the input's step, and every code but -0
+// survives decode -> encode
+static void testRoundTrip() {
+  int worstOver = 0; // Error beyond half a step (none allowed)
+  for (int32_t x = -ULAW_CLIP; x <= ULAW_CLIP; x++) {
+    uint8_t u = ulawEncode((int16_t)x);
+    int seg = ((uint8_t)~u >> 4) & 7;
+    int err = abs(ulawDecode(u) - x) - (4 << seg);
+    if (err > worstOver)
+      worstOver = err;
+  }
+  int codes = 0;
+  for (int c = 0; c < 256; c++)
+    if (ulawEncode(ulawDecode((uint8_t)c)) == c)
+      codes++;
+  printf("u-Law round trip: within half a step for every input to +-%d, "
+         "%d/256 codes survive decode -> encode\n",
+         ULAW_CLIP, codes);
+  CHECK(worstOver == 0);
+  CHECK(codes == 255);
+  CHECK(ulawDecode(0x7F) == 0 && ulawEncode(0) == 0xFF); // -0 becomes +0
+}
+
+int main() {
+  testExhaustive();
+  testVectors();
+  testRoundTrip();
+  return hostTestResult();
+}
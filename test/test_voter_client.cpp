@@ -0,0 +1,392 @@
+// VoterClient against simulated hosts, in process and on simulated time.
+// The network is a NetworkDriver that hands each packet the client sends to
+// the host it is addressed to. A host answers as tools/voter_ping_host.py
+// and tools/voter_multi_host.py do: auth, its own pings every second (which
+// also connect the client), echoes of the client's pings with an added
+// delay, jitter and drop, and audio frames counted per host. An outage
+// silences a host, which then restarts with a new challenge.
+#include "HostTest.h"
+#include "VoterClient.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+// GPSManager stand-in: never locked (zero times, default position)
+GPSManager::GPSManager() {}
+bool GPSManager::isLocked() { return false; }
+void GPSManager::getNetworkTime(VTIME *t) { memset(t, 0, sizeof(*t)); }
+void GPSManager::getGPSStrings(char *lat, char *lon, char *elev) {}
+
+// Network byte order, as VoterClient.cpp
+static inline uint32_t my_htonl(uint32_t x) { return __builtin_bswap32(x); }
+static inline uint16_t my_htons(uint16_t x) { return __builtin_bswap16(x); }
+static inline uint32_t my_ntohl(uint32_t x) { return __builtin_bswap32(x); }
+static inline uint16_t my_ntohs(uint16_t x) { return __builtin_bswap16(x); }
+
+static const char *kClientPwd = "pinky";
+static const char *kHostPwd = "bloodhound";
+
+// CRC32(a + b), C strings, as chan_voter signs
+static uint32_t voterCrc(const char *a, const char *b) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (const char *s : {a, b}) {
+    for (; *s; s++) {
+      crc ^= (uint8_t)*s;
+      for (int k = 0; k < 8; k++)
+        crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+struct Datagram {
+  uint64_t dueUs;
+  std::vector<uint8_t> data;
+  IPAddress ip;
+  uint16_t port;
+};
+
+class SimNet;
+
+class SimHost {
+public:
+  IPAddress ip;
+  uint16_t port;
+  char challenge[VOTER_CHALLENGE_LEN + 1];
+
+  // Echo impairments (client pings)
+  uint32_t delayUs = 0, jitterUs = 0;
+  double dropPct = 0.0;
+
+  // Outage: drops everything and sends nothing in [downFromUs, downUntilUs)
+  uint64_t downFromUs = 0, downUntilUs = 0;
+
+  // Results
+  bool authed = false;
+  uint32_t echoed = 0, dropped = 0;
+  uint32_t hostPingsSent = 0;
+  std::vector<uint32_t> hostRtts;
+  uint32_t frames = 0, gaps = 0, badDigest = 0, lostInOutage = 0;
+  uint32_t restarts = 0;
+
+  SimHost(SimNet *net, IPAddress hostIp, uint16_t hostPort, const char *chal)
+      : ip(hostIp), port(hostPort), _net(net), _rng(11) {
+    snprintf(challenge, sizeof(challenge), "%s", chal);
+  }
+
+  void receive(const uint8_t *data, uint16_t len);
+  void update();
+  bool isDown();
+
+private:
+  SimNet *_net;
+  std::mt19937 _rng;
+  char _clientChallenge[VOTER_CHALLENGE_LEN + 1] = {0};
+  uint64_t _nextPingUs = 0;
+  uint32_t _pingSeq = 0;
+  std::vector<uint64_t> _pingSentUs;
+  uint64_t _lastStamp = 0;
+  bool _wasDown = false;
+
+  void _send(uint16_t type, const uint8_t *payload, size_t len,
+             uint64_t delayUs);
+};
+
+// The client's one link: sends go straight to the addressed host, replies
+// wait in a queue until they are due
+class SimNet : public NetworkDriver {
+public:
+  std::vector<SimHost *> hosts;
+
+  bool begin(uint8_t *mac) override { return true; }
+  void update() override {}
+  bool isConnected() override { return true; }
+  IPAddress getLocalIP() override { return IPAddress(10, 0, 0, 2); }
+  DriverType getType() override { return DRIVER_ETHERNET; }
+
+  void setTarget(IPAddress ip, uint16_t port) override {
+    _ip = ip;
+    _port = port;
+  }
+  void sendPacket(const uint8_t *data, uint16_t len) override {
+    for (SimHost *h : hosts)
+      if (h->ip == _ip && h->port == _port)
+        h->receive(data, len);
+  }
+
+  int parsePacket() override {
+    _current.data.clear();
+    uint64_t now = hostNowUs();
+    for (size_t i = 0; i < _queue.size(); i++) {
+      if (_queue[i].dueUs <= now) {
+        _current = _queue[i];
+        _queue.erase(_queue.begin() + i);
+        return (int)_current.data.size();
+      }
+    }
+    return 0;
+  }
+  int read(uint8_t *buffer, size_t maxLen) override {
+    size_t n = std::min(maxLen, _current.data.size());
+    memcpy(buffer, _current.data.data(), n);
+    return (int)n;
+  }
+  IPAddress remoteIP() override { return _current.ip; }
+  uint16_t remotePort() override { return _current.port; }
+
+  void deliver(const Datagram &d) { _queue.push_back(d); }
+
+private:
+  IPAddress _ip;
+  uint16_t _port = 0;
+  std::deque<Datagram> _queue;
+  Datagram _current;
+};
+
+void SimHost::_send(uint16_t type, const uint8_t *payload, size_t len,
+                    uint64_t delayUs) {
+  Datagram d;
+  d.dueUs = hostNowUs() + delayUs;
+  d.data.resize(sizeof(VOTER_PACKET_HEADER) + len);
+  VOTER_PACKET_HEADER *hdr = (VOTER_PACKET_HEADER *)d.data.data();
+  memcpy(hdr->challenge, challenge, VOTER_CHALLENGE_LEN);
+  hdr->digest = my_htonl(voterCrc(_clientChallenge, kHostPwd));
+  hdr->payload_type = my_htons(type);
+  memcpy(d.data.data() + sizeof(VOTER_PACKET_HEADER), payload, len);
+  d.ip = ip;
+  d.port = port;
+  _net->deliver(d);
+}
+
+// Down, or just back: then restarted with a new challenge, so the client
+// has to authenticate again (as a restarted chan_voter)
+bool SimHost::isDown() {
+  uint64_t now = hostNowUs();
+  if (now >= downFromUs && now < downUntilUs) {
+    _wasDown = true;
+    return true;
+  }
+  if (_wasDown) {
+    _wasDown = false;
+    restarts++;
+    challenge[0]++;
+    authed = false;
+    _nextPingUs = 0;
+  }
+  return false;
+}
+
+void SimHost::receive(const uint8_t *data, uint16_t len) {
+  if (len < sizeof(VOTER_PACKET_HEADER))
+    return;
+  const VOTER_PACKET_HEADER *hdr = (const VOTER_PACKET_HEADER *)data;
+  uint16_t type = my_ntohs(hdr->payload_type);
+  if (isDown()) {
+    if (type == PAYLOAD_ULAW)
+      lostInOutage++;
+    return;
+  }
+  memcpy(_clientChallenge, hdr->challenge, VOTER_CHALLENGE_LEN);
+  bool signedOk = my_ntohl(hdr->digest) == voterCrc(challenge, kClientPwd);
+
+  if (type == PAYLOAD_AUTH) {
+    _send(PAYLOAD_AUTH, nullptr, 0, 0);
+    if (signedOk)
+      authed = true;
+    return;
+  }
+  if (!signedOk) {
+    // Signed for an old session: answer with our challenge, as the host does
+    // for an unknown client, so it authenticates again
+    badDigest++;
+    _send(PAYLOAD_AUTH, nullptr, 0, 0);
+    return;
+  }
+  if (type == PAYLOAD_ULAW) {
+    const PROXY_AUDIO_PACKET *pkt = (const PROXY_AUDIO_PACKET *)data;
+    uint64_t stamp = (uint64_t)my_ntohl(pkt->header.curtime.vtime_sec) *
+                         1000000ULL +
+                     my_ntohl(pkt->header.curtime.vtime_nsec) / 1000;
+    if (_lastStamp && stamp > _lastStamp)
+      gaps += (uint32_t)((stamp - _lastStamp + 10000) / 20000) - 1;
+    _lastStamp = stamp;
+    frames++;
+    return;
+  }
+  if (type != PAYLOAD_PING || !authed)
+    return;
+
+  const uint8_t *payload = data + sizeof(VOTER_PACKET_HEADER);
+  size_t payloadLen = len - sizeof(VOTER_PACKET_HEADER);
+  const VOTER_PING *ping = (const VOTER_PING *)payload;
+  if (payloadLen >= sizeof(VOTER_PING) &&
+      my_ntohl(ping->magic) == PING_MAGIC) {
+    // Client ping: echo back re-signed, payload untouched
+    if (std::uniform_real_distribution<double>(0.0, 100.0)(_rng) < dropPct) {
+      dropped++;
+      return;
+    }
+    uint32_t jitter =
+        jitterUs ? std::uniform_int_distribution<uint32_t>(0, jitterUs)(_rng)
+                 : 0;
+    _send(PAYLOAD_PING, payload, payloadLen, delayUs + jitter);
+    echoed++;
+  } else if (payloadLen >= 4) {
+    // Echo of one of our host pings
+    uint32_t seq;
+    memcpy(&seq, payload, 4);
+    seq = my_ntohl(seq);
+    if (seq < _pingSentUs.size())
+      hostRtts.push_back((uint32_t)(hostNowUs() - _pingSentUs[seq]));
+  }
+}
+
+void SimHost::update() {
+  if (isDown() || !authed || hostNowUs() < _nextPingUs)
+    return;
+  _nextPingUs = hostNowUs() + 1000000;
+  uint8_t payload[sizeof(VOTER_PING)] = {0};
+  uint32_t seq = my_htonl(_pingSeq++);
+  memcpy(payload, &seq, 4);
+  _pingSentUs.push_back(hostNowUs());
+  _send(PAYLOAD_PING, payload, sizeof(payload), 0);
+  hostPingsSent++;
+}
+
+// loop(): the network and the client every 250us, and with `audio` a uLaw
+// frame every 20ms stamped with its GPS time
+static void run(NetworkManager &net, VoterClient &client,
+                std::vector<SimHost *> &hosts, uint32_t ms,
+                bool audio = false) {
+  static const uint64_t kEpochUs = 1700000000ULL * 1000000ULL;
+  uint8_t ulaw[FRAME_SIZE];
+  memset(ulaw, 0xFF, sizeof(ulaw));
+  uint64_t end = hostNowUs() + ms * 1000ULL;
+  while (hostNowUs() < end) {
+    hostSetUs(hostNowUs() + 250);
+    for (SimHost *h : hosts)
+      h->update();
+    net.update();
+    client.update();
+    if (audio && hostNowUs() % 20000 == 0) {
+      uint64_t us = kEpochUs + hostNowUs();
+      VTIME t = {(uint32_t)(us / 1000000), (uint32_t)(us % 1000000 * 1000)};
+      client.processAudioFrame(ulaw, 128, t);
+    }
+  }
+}
+
+// 300 pings through 25ms + 0-10ms of delay with 5% dropped: every ping is
+// either answered or lost, the losses are the drops, and the RTTs are the
+// echo delays (plus up to one loop() pass)
+static void testPing() {
+  static SimNet link;
+  static NetworkManager net;
+  static GPSManager gps;
+  static VoterClient client;
+  SimHost host(&link, IPAddress(10, 0, 0, 1), 1667, "1234567890");
+  std::vector<SimHost *> hosts = {&host};
+  link.hosts = hosts;
+  host.delayUs = 25000;
+  host.jitterUs = 10000;
+  host.dropPct = 5.0;
+
+  hostSetUs(1000000);
+  uint8_t mac[6] = {0};
+  net.begin(&link, mac);
+  client.begin(&net, &gps, host.ip, host.port, kClientPwd, kHostPwd);
+  run(net, client, hosts, 3000);
+  CHECK(host.authed);
+  CHECK(client.isConnected());
+
+  client.startPing(300, VOTER_PING_INTERVAL_MS);
+  run(net, client, hosts, 300 * VOTER_PING_INTERVAL_MS + 2000);
+  CHECK(!client.isPinging());
+
+  const LatencyHistogram &h = client.getPingStats();
+  printf("Ping: %lu sent, %lu replies, %lu lost (%lu dropped) | RTT %.2f / "
+         "%.2f / %.2f ms, p50 %.2f p90 %.2f p99 %.2f ms\n",
+         (unsigned long)client.getPingsSent(), (unsigned long)h.getCount(),
+         (unsigned long)client.getPingsLost(), (unsigned long)host.dropped,
+         h.getMin() / 1000.0, h.getMean() / 1000.0, h.getMax() / 1000.0,
+         h.getPercentile(50) / 1000.0, h.getPercentile(90) / 1000.0,
+         h.getPercentile(99) / 1000.0);
+  CHECK(client.getPingsSent() == 300);
+  CHECK(h.getCount() == host.echoed);
+  CHECK(client.getPingsLost() == host.dropped);
+  CHECK(host.dropped > 0);
+  CHECK(h.getMin() >= host.delayUs);
+  CHECK(h.getMax() <= host.delayUs + host.jitterUs + 250);
+  CHECK(h.getMean() > host.delayUs + host.jitterUs / 2 - 1000 &&
+        h.getMean() < host.delayUs + host.jitterUs / 2 + 1000);
+
+  // Host pings: each echoed on the next loop() pass
+  printf("Host pings: %lu sent, %lu echoed, %zu answered\n",
+         (unsigned long)host.hostPingsSent,
+         (unsigned long)client.getPingsEchoed(), host.hostRtts.size());
+  CHECK(client.getPingsEchoed() == host.hostPingsSent);
+  CHECK(host.hostRtts.size() == host.hostPingsSent);
+  for (uint32_t rtt : host.hostRtts)
+    CHECK(rtt <= 250);
+}
+
+// Primary and backup host on one IP (told apart by port), 15s of audio with
+// the backup silent from 6s to 9s and then restarted: the primary gets every
+// frame; the backup misses the outage and the frames up to its new session,
+// and the client re-authenticates with it on its own.
+static void testTwoHosts() {
+  static SimNet link;
+  static NetworkManager net;
+  static GPSManager gps;
+  static VoterClient client;
+  SimHost primary(&link, IPAddress(10, 0, 0, 1), 1667, "0123456789");
+  SimHost backup(&link, IPAddress(10, 0, 0, 1), 1668, "1123456789");
+  std::vector<SimHost *> hosts = {&primary, &backup};
+  link.hosts = hosts;
+
+  hostSetUs(1000000);
+  uint8_t mac[6] = {0};
+  net.begin(&link, mac);
+  client.begin(&net, &gps, primary.ip, primary.port, kClientPwd, kHostPwd);
+  CHECK(client.addHost(backup.ip, backup.port) == 1);
+  run(net, client, hosts, 3000);
+  CHECK(client.isConnected(0) && client.isConnected(1));
+
+  backup.downFromUs = hostNowUs() + 6000000;
+  backup.downUntilUs = hostNowUs() + 9000000;
+  run(net, client, hosts, 15000, true);
+
+  const VoterHostStats &s0 = client.getHost(0).stats;
+  const VoterHostStats &s1 = client.getHost(1).stats;
+  printf("Two hosts, 15s, backup out 6-9s: %lu frames\n",
+         (unsigned long)client.getAudioPackets());
+  for (int i = 0; i < 2; i++) {
+    const VoterHostStats &st = client.getHost(i).stats;
+    printf("  Host %d: received %lu, gaps %lu, lost in outage %lu, bad digest "
+           "%lu, restarts %lu | client: sent %lu missed %lu, %lu connects, %lu "
+           "timeouts\n",
+           i, (unsigned long)hosts[i]->frames, (unsigned long)hosts[i]->gaps,
+           (unsigned long)hosts[i]->lostInOutage,
+           (unsigned long)hosts[i]->badDigest,
+           (unsigned long)hosts[i]->restarts, (unsigned long)st.audioSent,
+           (unsigned long)st.audioMissed, (unsigned long)st.connects,
+           (unsigned long)st.timeouts);
+  }
+  CHECK(client.getAudioPackets() == 750);
+  CHECK(primary.frames == 750 && primary.gaps == 0 && primary.badDigest == 0);
+  CHECK(s0.connects == 1 && s0.timeouts == 0 && s0.audioMissed == 0);
+
+  CHECK(backup.restarts == 1);
+  CHECK(backup.lostInOutage == 150);
+  CHECK(backup.badDigest == 1);
+  CHECK(backup.frames == s1.audioSent - backup.lostInOutage - 1);
+  CHECK(backup.gaps == 750 - backup.frames);
+  CHECK(s1.connects == 2 && s1.challenges == 2 && s1.timeouts == 1);
+  CHECK(client.isConnected(1));
+}
+
+int main() {
+  testPing();
+  testTwoHosts();
+  return hostTestResult();
+}
@@ -0,0 +1,401 @@
+// VoterClient receive path fed from a real capture. The host -> client
+// datagrams of traces/realvotertrace.pcap (the busiest host and its busiest
+// client) are replayed through a NetworkDriver into update() / _receive(),
+// re-signed for this client's session as tools/voter_pcap_replay.py does:
+// - at the trace's own timing, with loop() every 1ms
+// - in bursts of 16 every 5ms, which must drain VOTER_RX_BATCH per pass
+// - with malformed and foreign datagrams mixed in, which must be dropped
+// and counted by kind
+// Then the per-type counts, the TX handler's frames and the session state.
+#include "HostTest.h"
+#include "VoterClient.h"
+#include <deque>
+#include <map>
+#include <stdio.h>
+#include <vector>
+
+#ifndef TRACE_DIR
+#define TRACE_DIR "../traces"
+#endif
+
+// GPSManager stand-in: never locked (zero times, default position)
+GPSManager::GPSManager() {}
+bool GPSManager::isLocked() { return false; }
+void GPSManager::getNetworkTime(VTIME *t) { memset(t, 0, sizeof(*t)); }
+void GPSManager::getGPSStrings(char *lat, char *lon, char *elev) {}
+
+static inline uint32_t my_htonl(uint32_t x) { return __builtin_bswap32(x); }
+static inline uint16_t my_htons(uint16_t x) { return __builtin_bswap16(x); }
+static inline uint16_t my_ntohs(uint16_t x) { return __builtin_bswap16(x); }
+
+static const char *kClientPwd = "pinky";
+static const char *kHostPwd = "bloodhound";
+static const char kChallenge[] = "1234567890"; // voter_pcap_replay.py's
+static const IPAddress kHostIp(10, 0, 0, 1);
+static const uint16_t kHostPort = 1667;
+
+// CRC32(a + b), C strings, as chan_voter signs
+static uint32_t voterCrc(const char *a, const char *b) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (const char *s : {a, b}) {
+    for (; *s; s++) {
+      crc ^= (uint8_t)*s;
+      for (int k = 0; k < 8; k++)
+        crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+struct TraceDatagram {
+  uint64_t us; // Since the first datagram of the trace
+  uint32_t src, dst;
+  std::vector<uint8_t> data;
+};
+
+// Voter datagrams (UDP to or from port 1667) of an Ethernet pcap
+static std::vector<TraceDatagram> readPcap(const char *path) {
+  std::vector<TraceDatagram> out;
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return out;
+  uint8_t gh[24];
+  if (fread(gh, 1, 24, f) != 24) {
+    fclose(f);
+    return out;
+  }
+  bool swap = gh[0] == 0xA1; // Big-endian file
+  bool nano = (gh[0] == 0x4D || gh[3] == 0x4D);
+  auto u32 = [swap](const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return swap ? __builtin_bswap32(v) : v;
+  };
+  uint64_t first = 0;
+  uint8_t rh[16];
+  while (fread(rh, 1, 16, f) == 16) {
+    uint32_t len = u32(rh + 8);
+    std::vector<uint8_t> pkt(len);
+    if (fread(pkt.data(), 1, len, f) != len)
+      break;
+    uint64_t us = (uint64_t)u32(rh) * 1000000 +
+                  (nano ? u32(rh + 4) / 1000 : u32(rh + 4));
+    if (len < 42 || pkt[12] != 0x08 || pkt[13] != 0x00 || pkt[23] != 17)
+      continue;
+    size_t udp = 14 + (pkt[14] & 0x0F) * 4;
+    uint16_t sport = (uint16_t)(pkt[udp] << 8 | pkt[udp + 1]);
+    uint16_t dport = (uint16_t)(pkt[udp + 2] << 8 | pkt[udp + 3]);
+    uint16_t ulen = (uint16_t)(pkt[udp + 4] << 8 | pkt[udp + 5]);
+    if ((sport != 1667 && dport != 1667) || udp + ulen > len || ulen < 8)
+      continue;
+    TraceDatagram d;
+    if (out.empty())
+      first = us;
+    d.us = us - first;
+    memcpy(&d.src, &pkt[26], 4);
+    memcpy(&d.dst, &pkt[30], 4);
+    d.data.assign(pkt.begin() + udp + 8, pkt.begin() + udp + ulen);
+    out.push_back(d);
+  }
+  fclose(f);
+  return out;
+}
+
+// Most frequent value of key over the datagrams
+template <typename F>
+static uint32_t busiest(const std::vector<TraceDatagram> &v, F key) {
+  std::map<uint32_t, int> n;
+  uint32_t best = 0;
+  for (const TraceDatagram &d : v)
+    if (++n[key(d)] > n[best])
+      best = key(d);
+  return best;
+}
+
+struct Datagram {
+  std::vector<uint8_t> data;
+  IPAddress ip;
+  uint16_t port;
+};
+
+// The client's link. A minimal host on it answers auth with its challenge
+// and a signed keepalive; replayed datagrams queue until the client reads
+// them.
+class ReplayNet : public NetworkDriver {
+public:
+  uint32_t digest = 0; // Ours, for the client's challenge
+  uint32_t authAnswered = 0;
+
+  bool begin(uint8_t *mac) override { return true; }
+  void update() override {}
+  bool isConnected() override { return true; }
+  IPAddress getLocalIP() override { return IPAddress(10, 0, 0, 2); }
+  DriverType getType() override { return DRIVER_ETHERNET; }
+
+  void setTarget(IPAddress ip, uint16_t port) override {
+    _ip = ip;
+    _port = port;
+  }
+  void sendPacket(const uint8_t *data, uint16_t len) override {
+    const VOTER_PACKET_HEADER *hdr = (const VOTER_PACKET_HEADER *)data;
+    if (_ip != kHostIp || _port != kHostPort ||
+        my_ntohs(hdr->payload_type) != PAYLOAD_AUTH)
+      return;
+    char client[VOTER_CHALLENGE_LEN + 1] = {0};
+    memcpy(client, hdr->challenge, VOTER_CHALLENGE_LEN);
+    digest = voterCrc(client, kHostPwd);
+    deliver(signedPacket(PAYLOAD_AUTH));
+    deliver(signedPacket(PAYLOAD_GPS));
+    authAnswered++;
+  }
+
+  int parsePacket() override {
+    if (_queue.empty())
+      return 0;
+    _current = _queue.front();
+    _queue.pop_front();
+    return (int)_current.data.size();
+  }
+  int read(uint8_t *buffer, size_t maxLen) override {
+    size_t n = std::min(maxLen, _current.data.size());
+    memcpy(buffer, _current.data.data(), n);
+    return (int)n;
+  }
+  IPAddress remoteIP() override { return _current.ip; }
+  uint16_t remotePort() override { return _current.port; }
+
+  // A trace datagram, re-signed: our challenge and digest, the rest as is
+  void deliver(const std::vector<uint8_t> &data, IPAddress ip = kHostIp,
+               uint16_t port = kHostPort) {
+    _queue.push_back({data, ip, port});
+  }
+  std::vector<uint8_t> resign(std::vector<uint8_t> data) const {
+    VOTER_PACKET_HEADER *hdr = (VOTER_PACKET_HEADER *)data.data();
+    memcpy(hdr->challenge, kChallenge, VOTER_CHALLENGE_LEN);
+    hdr->digest = my_htonl(digest);
+    return data;
+  }
+  std::vector<uint8_t> signedPacket(uint16_t type) const {
+    std::vector<uint8_t> d(sizeof(VOTER_PACKET_HEADER), 0);
+    ((VOTER_PACKET_HEADER *)d.data())->payload_type = my_htons(type);
+    return resign(d);
+  }
+  size_t queued() const { return _queue.size(); }
+
+private:
+  IPAddress _ip;
+  uint16_t _port = 0;
+  std::deque<Datagram> _queue;
+  Datagram _current;
+};
+
+static uint32_t g_txFrames = 0;
+static void onTx(const VTIME &t, const uint8_t *ulaw) { g_txFrames++; }
+
+static ReplayNet link;
+static NetworkManager net;
+static GPSManager gps;
+static VoterClient client;
+static std::vector<std::vector<uint8_t>> g_trace; // Host -> client payloads
+static std::vector<uint64_t> g_traceUs;
+static uint32_t g_traceUlaw = 0, g_traceGps = 0;
+static uint32_t g_authsToConnect = 0;
+
+// loop(): the network and the client every 1ms
+static void runMs(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++) {
+    hostSetUs(hostNowUs() + 1000);
+    net.update();
+    client.update();
+  }
+}
+
+static bool loadTrace() {
+  std::vector<TraceDatagram> all = readPcap(TRACE_DIR "/realvotertrace.pcap");
+  // The host is the address everybody sends to; its busiest client is ours
+  uint32_t host = busiest(all, [](const TraceDatagram &d) { return d.dst; });
+  std::vector<TraceDatagram> down;
+  for (const TraceDatagram &d : all)
+    if (d.src == host && d.data.size() >= sizeof(VOTER_PACKET_HEADER))
+      down.push_back(d);
+  uint32_t dst = busiest(down, [](const TraceDatagram &d) { return d.dst; });
+  for (const TraceDatagram &d : down) {
+    if (d.dst != dst)
+      continue;
+    uint16_t type = my_ntohs(((const VOTER_PACKET_HEADER *)d.data.data())
+                                 ->payload_type);
+    g_traceUlaw += type == PAYLOAD_ULAW;
+    g_traceGps += type == PAYLOAD_GPS;
+    g_trace.push_back(d.data);
+    g_traceUs.push_back(d.us - down.front().us);
+  }
+  uint8_t *h = (uint8_t *)&host, *c = (uint8_t *)&dst;
+  printf("Trace: %zu Voter datagrams, %u.%u.%u.%u -> %u.%u.%u.%u: %zu (%u "
+         "ULAW, %u GPS) over %.1f s\n",
+         all.size(), h[0], h[1], h[2], h[3], c[0], c[1], c[2], c[3],
+         g_trace.size(), g_traceUlaw, g_traceGps,
+         g_trace.empty() ? 0.0 : g_traceUs.back() / 1e6);
+  return !g_trace.empty();
+}
+
+// Auth, then the first signed keepalive connects
+static void testConnect() {
+  hostSetUs(1000000);
+  uint8_t mac[6] = {0};
+  net.begin(&link, mac);
+  client.begin(&net, &gps, kHostIp, kHostPort, kClientPwd, kHostPwd);
+  // A backup host that never answers: datagrams from neither are foreign
+  CHECK(client.addHost(IPAddress(10, 0, 0, 9), kHostPort) == 1);
+  client.onTxAudio(onTx);
+  runMs(1000);
+  const VoterHostSession &s = client.getHost(0);
+  CHECK(client.isConnected(0) && !client.isConnected(1));
+  CHECK(s.stats.connects == 1 && s.stats.challenges == 1);
+  CHECK(client.getRxStats().byType[PAYLOAD_AUTH] >= 1);
+  g_authsToConnect = link.authAnswered;
+}
+
+// The trace at its own timing: one datagram per pass, every ULAW frame to
+// the TX handler
+static void testTraceTiming() {
+  VoterRxStats before = client.getRxStats();
+  uint32_t tx0 = g_txFrames;
+  uint64_t start = hostNowUs();
+  for (size_t i = 0; i < g_trace.size(); i++) {
+    while (hostNowUs() - start < g_traceUs[i])
+      runMs(1);
+    link.deliver(link.resign(g_trace[i]));
+  }
+  runMs(10);
+  const VoterRxStats &rx = client.getRxStats();
+  uint32_t passes = rx.passes - before.passes;
+  uint32_t packets = rx.packets - before.packets;
+  printf("Trace timing: %u datagrams in %u passes, %u ULAW to the TX "
+         "handler, %u GPS\n",
+         packets, passes, g_txFrames - tx0,
+         rx.byType[PAYLOAD_GPS] - before.byType[PAYLOAD_GPS]);
+  CHECK(packets == g_trace.size());
+  CHECK(passes == packets); // The trace never has two within 1ms
+  CHECK(rx.byType[PAYLOAD_ULAW] - before.byType[PAYLOAD_ULAW] == g_traceUlaw);
+  CHECK(rx.byType[PAYLOAD_GPS] - before.byType[PAYLOAD_GPS] >= g_traceGps);
+  CHECK(g_txFrames - tx0 == g_traceUlaw);
+  CHECK(rx.fullPasses == before.fullPasses);
+}
+
+// Bursts of 16 every 5ms: each pass takes VOTER_RX_BATCH and leaves the
+// rest in the driver for the next
+static void testBursts() {
+  VoterRxStats before = client.getRxStats();
+  uint32_t tx0 = g_txFrames;
+  size_t left = 0;
+  bool drainOk = true;
+  for (size_t i = 0; i < g_trace.size(); i += 16) {
+    size_t n = std::min(g_trace.size() - i, (size_t)16);
+    for (size_t k = 0; k < n; k++)
+      link.deliver(link.resign(g_trace[i + k]));
+    hostSetUs(hostNowUs() + 1000);
+    net.update();
+    client.update();
+    left = n > VOTER_RX_BATCH ? n - VOTER_RX_BATCH : 0;
+    drainOk &= link.queued() == left;
+    runMs(4);
+  }
+  runMs(10);
+  const VoterRxStats &rx = client.getRxStats();
+  uint32_t passes = rx.passes - before.passes;
+  uint32_t full = rx.fullPasses - before.fullPasses;
+  printf("Bursts of 16 every 5ms: %u datagrams in %u passes, %u full (%d), "
+         "largest batch %u, %u ULAW to the TX handler\n",
+         rx.packets - before.packets, passes, full, VOTER_RX_BATCH,
+         rx.maxBatch, g_txFrames - tx0);
+  size_t bursts = (g_trace.size() + 15) / 16;
+  size_t wantFull = g_trace.size() / VOTER_RX_BATCH;
+  CHECK(drainOk);
+  CHECK(rx.maxBatch == VOTER_RX_BATCH);
+  CHECK(full == wantFull);
+  CHECK(passes == wantFull + (g_trace.size() % VOTER_RX_BATCH ? 1 : 0));
+  CHECK(passes <= 2 * bursts);
+  CHECK(g_txFrames - tx0 == g_traceUlaw);
+}
+
+// Malformed and foreign datagrams between trace frames: each dropped and
+// counted by kind, the session untouched
+static void testDrops() {
+  VoterRxStats before = client.getRxStats();
+  uint32_t tx0 = g_txFrames;
+  const VoterHostSession &s = client.getHost(0);
+  uint32_t rx0 = s.stats.packetsRx;
+
+  std::vector<uint8_t> frame = g_trace[0];
+  for (size_t i = 0; i < g_trace.size(); i++) {
+    uint16_t type = my_ntohs(((const VOTER_PACKET_HEADER *)g_trace[i].data())
+                                 ->payload_type);
+    if (type == PAYLOAD_ULAW) {
+      frame = g_trace[i];
+      break;
+    }
+  }
+  link.deliver(std::vector<uint8_t>(sizeof(VOTER_PACKET_HEADER) - 1, 0));
+  link.deliver(std::vector<uint8_t>(VOTER_RX_MAX_LEN + 1, 0));
+  std::vector<uint8_t> badDigest = link.resign(frame);
+  ((VOTER_PACKET_HEADER *)badDigest.data())->digest ^= my_htonl(1);
+  link.deliver(badDigest);
+  link.deliver(link.resign(frame), IPAddress(10, 0, 0, 77));
+  std::vector<uint8_t> unknown = link.resign(frame);
+  ((VOTER_PACKET_HEADER *)unknown.data())->payload_type = my_htons(9);
+  link.deliver(unknown);
+  link.deliver(link.resign(frame));
+  runMs(5);
+
+  const VoterRxStats &rx = client.getRxStats();
+  printf("Drops: short %u, long %u, bad digest %u, no host %u, unknown type "
+         "%u; %u ULAW through\n",
+         rx.dropShort - before.dropShort, rx.dropLong - before.dropLong,
+         rx.dropDigest - before.dropDigest, rx.dropNoHost - before.dropNoHost,
+         rx.dropType - before.dropType, g_txFrames - tx0);
+  CHECK(rx.packets - before.packets == 6);
+  CHECK(rx.dropShort - before.dropShort == 1);
+  CHECK(rx.dropLong - before.dropLong == 1);
+  CHECK(rx.dropDigest - before.dropDigest == 1);
+  CHECK(rx.dropNoHost - before.dropNoHost == 1);
+  CHECK(rx.dropType - before.dropType == 1);
+  CHECK(g_txFrames - tx0 == 1);
+  CHECK(s.stats.packetsRx - rx0 == 2); // Unknown type was still signed
+  CHECK(rx.passes - before.passes == 1);
+}
+
+static void testSession() {
+  const VoterHostSession &s = client.getHost(0);
+  const VoterHostSession &b = client.getHost(1);
+  const VoterRxStats &rx = client.getRxStats();
+  uint32_t typed = 0;
+  for (int t = 0; t < VOTER_RX_TYPES; t++)
+    typed += rx.byType[t];
+  printf("Session: host 0 %s, %u packets, %u connects, %u challenges, %u "
+         "timeouts; backup %s\n",
+         client.isConnected(0) ? "connected" : "not connected",
+         s.stats.packetsRx, s.stats.connects, s.stats.challenges,
+         s.stats.timeouts, client.isConnected(1) ? "connected" : "not");
+  CHECK(client.isConnected(0) && !s.silent);
+  CHECK(s.stats.connects == 1 && s.stats.challenges == 1);
+  CHECK(s.stats.timeouts == 0);
+  CHECK(link.authAnswered == g_authsToConnect); // None after connecting
+  CHECK(!client.isConnected(1) && b.stats.packetsRx == 0);
+  CHECK(typed + rx.dropType == s.stats.packetsRx);
+  // Every datagram read is accepted, dropped, or the one new challenge
+  CHECK(rx.packets == s.stats.packetsRx + s.stats.challenges + rx.dropShort +
+                          rx.dropLong + rx.dropDigest + rx.dropNoHost);
+}
+
+int main() {
+  if (!loadTrace()) {
+    printf("Cannot read %s/realvotertrace.pcap\n", TRACE_DIR);
+    return 1;
+  }
+  testConnect();
+  testTraceTiming();
+  testBursts();
+  testDrops();
+  testSession();
+  return hostTestResult();
+}
@@ -0,0 +1,162 @@
+"""
+Voter Multi Host - several simulated Voter hosts for redundant-host tests.
+
+Runs N independent mock hosts on consecutive UDP ports, each with its own
+server challenge, so a client configured with a primary and backup host
+([1]/[2] and [K] on the Teensy) can be checked for:
+  - an independent auth session per host (digest checked per host),
+  - every audio frame reaching every host (per-host frame count and gaps
+    in the 20ms timestamp sequence),
+  - recovery after a host outage: --outage H:START-END silences host H for
+    that window (drops everything, sends nothing), then restarts it with a
+    new challenge, as a restarted chan_voter would.
+
+Each host sends a signed keepalive every second so the client goes (and
+stays) CONNECTED. Compare the report with CLI [V] on the client.
+
+Examples:
+  python voter_multi_host.py --hosts 2 --seconds 30
+  python voter_multi_host.py --hosts 2 --outage 1:10-15
+"""
+import argparse
+import select
+import socket
+import struct
+import time
+import zlib
+
+# Protocol (see voter_host.py / VoterProtocol.h)
+PAYLOAD_AUTH = 0
+PAYLOAD_ULAW = 1
+PAYLOAD_GPS = 2
+PAYLOAD_ADPCM = 3
+HEADER_FMT = '>II10sIH'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+FRAME_NS = 20000000
+
+
+def voter_crc32(challenge, password):
+    """CRC32(challenge + password), C-string semantics (as in voter_host.py)"""
+    challenge = challenge.split(b'\x00')[0]
+    return zlib.crc32(password, zlib.crc32(challenge)) & 0xFFFFFFFF
+
+
+class MockHost:
+    def __init__(self, index, port, args):
+        self.index = index
+        self.port = port
+        self.args = args
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('0.0.0.0', port))
+        self.restarts = 0
+        self.challenge = self._new_challenge()
+        self.client = None      # (addr, client challenge)
+        self.next_keepalive = 0.0
+        self.frames = 0
+        self.bad_digest = 0
+        self.gaps = 0           # Missing frames between received ones
+        self.last_stamp = None
+        self.outage = None
+        self.was_down = False
+
+    def _new_challenge(self):
+        return (b"%d%09d" % (self.index, 123456789 + self.restarts))[:10]
+
+    def down(self, t):
+        return self.outage is not None and self.outage[0] <= t < self.outage[1]
+
+    def restart(self):
+        """Host came back: new challenge, client has to authenticate again"""
+        self.restarts += 1
+        self.challenge = self._new_challenge()
+        self.client = None
+        print(f"[H{self.index}] Restarted, challenge {self.challenge.decode()}")
+
+    def service(self, t):
+        if self.client and t >= self.next_keepalive:
+            self.next_keepalive = t + 1.0
+            addr, client_chal = self.client
+            sign = voter_crc32(client_chal, self.args.host_pwd.encode('ascii'))
+            self.sock.sendto(struct.pack(HEADER_FMT, int(t), 0, self.challenge,
+                                         sign, PAYLOAD_GPS), addr)
+
+    def receive(self, data, addr):
+        if len(data) < HEADER_SIZE:
+            return
+        sec, nsec, chal, digest, ptype = struct.unpack(HEADER_FMT, data[:HEADER_SIZE])
+        expect = voter_crc32(self.challenge, self.args.client_pwd.encode('ascii'))
+
+        if ptype == PAYLOAD_AUTH:
+            sign = voter_crc32(chal, self.args.host_pwd.encode('ascii'))
+            self.sock.sendto(struct.pack(HEADER_FMT, 0, 0, self.challenge, sign,
+                                         PAYLOAD_AUTH), addr)
+            if digest == expect and self.client is None:
+                print(f"[H{self.index}] Client {addr[0]}:{addr[1]} authenticated")
+                self.client = (addr, chal)
+                self.next_keepalive = 0.0
+            return
+
+        if digest != expect:
+            # Signed for an old session: answer with our challenge, as the
+            # host does for an unknown client, so it authenticates again
+            self.bad_digest += 1
+            self.sock.sendto(struct.pack(HEADER_FMT, 0, 0, self.challenge, 0,
+                                         PAYLOAD_AUTH), addr)
+            return
+        if ptype not in (PAYLOAD_ULAW, PAYLOAD_ADPCM):
+            return
+
+        self.frames += 1
+        stamp = sec * 1000000000 + nsec
+        step = FRAME_NS * (2 if ptype == PAYLOAD_ADPCM else 1)
+        if self.last_stamp is not None and stamp > self.last_stamp:
+            missing = round((stamp - self.last_stamp) / step) - 1
+            self.gaps += max(0, missing)
+        self.last_stamp = stamp
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate redundant Voter hosts")
+    parser.add_argument('--hosts', type=int, default=2)
+    parser.add_argument('--base-port', type=int, default=1667)
+    parser.add_argument('--host-pwd', type=str, default="bloodhound")
+    parser.add_argument('--client-pwd', type=str, default="teensyvoter")
+    parser.add_argument('--seconds', type=float, default=30.0)
+    parser.add_argument('--outage', action='append', default=[],
+                        help='H:START-END (seconds), host H silent then restarted')
+    args = parser.parse_args()
+
+    hosts = [MockHost(i, args.base_port + i, args) for i in range(args.hosts)]
+    for o in args.outage:
+        h, span = o.split(':')
+        start, end = (float(x) for x in span.split('-'))
+        hosts[int(h)].outage = (start, end)
+    print(f"[*] {args.hosts} hosts on ports {args.base_port}-{args.base_port + args.hosts - 1}")
+
+    t0 = time.time()
+    while time.time() - t0 < args.seconds:
+        t = time.time() - t0
+        for h in hosts:
+            if h.down(t):
+                h.was_down = True
+            elif h.was_down:
+                h.was_down = False
+                h.restart()
+            else:
+                h.service(time.time())
+
+        ready, _, _ = select.select([h.sock for h in hosts], [], [], 0.005)
+        for h in hosts:
+            if h.sock in ready:
+                data, addr = h.sock.recvfrom(4096)
+                if not h.down(time.time() - t0):
+                    h.receive(data, addr)
+
+    print("[*] Per host:")
+    for h in hosts:
+        print(f"    H{h.index} :{h.port}  frames {h.frames}, gaps {h.gaps}, "
+              f"bad digest {h.bad_digest}, restarts {h.restarts}")
+
+
+if __name__ == "__main__":
+    main()
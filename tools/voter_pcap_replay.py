@@ -0,0 +1,177 @@
+"""
+Voter PCAP Replay - host side test for the client receive path.
+
+Acts as a minimal Voter host: answers the client's auth request, then
+replays the host -> client datagrams of a captured trace (default
+traces/realvotertrace.pcap) to the TeensyVoter. Each packet is re-signed
+with our challenge and the digest for the client's challenge, so the
+client accepts it as if the captured host had sent it.
+
+Timing:
+  --speed S     original inter-packet gaps divided by S (default 1.0)
+  --burst N     ignore the trace timing, send N packets back to back every
+                --burst-ms (exercises the per-update() drain, VOTER_RX_BATCH)
+  --retime      rewrite VTIME so the first frame is --lead-ms ahead of now,
+                keeping the trace's spacing (TX audio then plays out)
+
+At the end the per-type counts sent are printed; compare them with the RX
+section of CLI [V] on the client (packets, per type, drops).
+
+Examples:
+  python voter_pcap_replay.py --retime
+  python voter_pcap_replay.py --burst 16 --burst-ms 20
+  python voter_pcap_replay.py --client 10.10.11.84 --speed 4
+"""
+import argparse
+import collections
+import socket
+import struct
+import time
+import zlib
+
+# Protocol (see voter_host.py / VoterProtocol.h)
+PAYLOAD_AUTH = 0
+PAYLOAD_ULAW = 1
+PAYLOAD_GPS = 2
+PAYLOAD_ADPCM = 3
+PAYLOAD_NULAW = 4
+PAYLOAD_PING = 5
+TYPE_NAMES = {0: 'AUTH', 1: 'ULAW', 2: 'GPS', 3: 'ADPCM', 4: 'NULAW', 5: 'PING'}
+HEADER_FMT = '>II10sIH'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+SERVER_CHALLENGE = b"1234567890"
+
+
+def voter_crc32(challenge, password):
+    """CRC32(challenge + password), C-string semantics (as in voter_host.py)"""
+    challenge = challenge.split(b'\x00')[0]
+    return zlib.crc32(password, zlib.crc32(challenge)) & 0xFFFFFFFF
+
+
+def read_pcap(path, host_port):
+    """Yield (time, src ip, dst ip, payload) for Voter datagrams on host_port.
+    Ethernet (link type 1) captures, either byte order."""
+    with open(path, 'rb') as f:
+        header = f.read(24)
+        magic = header[:4]
+        if magic in (b'\xd4\xc3\xb2\xa1', b'\x4d\x3c\xb2\xa1'):
+            endian = '<'
+        elif magic in (b'\xa1\xb2\xc3\xd4', b'\xa1\xb2\x3c\x4d'):
+            endian = '>'
+        else:
+            raise SystemExit(f"{path}: not a pcap file")
+        nano = magic in (b'\x4d\x3c\xb2\xa1', b'\xa1\xb2\x3c\x4d')
+        while True:
+            rec = f.read(16)
+            if len(rec) < 16:
+                return
+            ts_sec, ts_frac, incl_len, _ = struct.unpack(endian + 'IIII', rec)
+            data = f.read(incl_len)
+            if len(data) < 34 or data[12:14] != b'\x08\x00':
+                continue
+            ihl = (data[14] & 0x0F) * 4
+            if data[23] != 17:  # UDP
+                continue
+            udp = 14 + ihl
+            sport, dport, ulen = struct.unpack('>HHH', data[udp:udp + 6])
+            if host_port not in (sport, dport):
+                continue
+            payload = data[udp + 8:udp + ulen]
+            if len(payload) < HEADER_SIZE:
+                continue
+            t = ts_sec + ts_frac / (1e9 if nano else 1e6)
+            yield t, socket.inet_ntoa(data[26:30]), socket.inet_ntoa(data[30:34]), payload
+
+
+def wait_for_client(sock, host_pwd):
+    """Answer auth until the client signs our challenge; return its address
+    and the digest we must sign with."""
+    print("[*] Waiting for client auth...")
+    while True:
+        data, addr = sock.recvfrom(4096)
+        if len(data) < HEADER_SIZE:
+            continue
+        sec, nsec, chal, digest, ptype = struct.unpack(HEADER_FMT, data[:HEADER_SIZE])
+        reply_digest = voter_crc32(chal, host_pwd.encode('ascii'))
+        if digest != 0:
+            print(f"[+] Client {addr[0]}:{addr[1]} answered our challenge")
+            return addr, reply_digest
+        if ptype == PAYLOAD_AUTH:
+            sock.sendto(struct.pack(HEADER_FMT, 0, 0, SERVER_CHALLENGE, reply_digest,
+                                    PAYLOAD_AUTH), addr)
+            print(f"    Auth reply to {addr[0]}:{addr[1]}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay captured host traffic to a TeensyVoter")
+    parser.add_argument('--pcap', type=str, default="traces/realvotertrace.pcap")
+    parser.add_argument('--trace-host', type=str, help='Host IP in the trace (default: busiest)')
+    parser.add_argument('--client', type=str, help='Client IP in the trace (default: busiest)')
+    parser.add_argument('--trace-port', type=int, default=1667, help='Host port in the trace')
+    parser.add_argument('--port', type=int, default=1667)
+    parser.add_argument('--host-pwd', type=str, default="bloodhound")
+    parser.add_argument('--speed', type=float, default=1.0)
+    parser.add_argument('--burst', type=int, default=0, help='Packets per burst (0 = trace timing)')
+    parser.add_argument('--burst-ms', type=float, default=20.0)
+    parser.add_argument('--retime', action='store_true', help='Rewrite VTIME relative to now')
+    parser.add_argument('--lead-ms', type=float, default=200.0)
+    parser.add_argument('--repeat', type=int, default=1, help='Replay the trace N times')
+    args = parser.parse_args()
+
+    # Clients use the Voter port too: the host is the one everybody sends to
+    packets = list(read_pcap(args.pcap, args.trace_port))
+    if not packets:
+        raise SystemExit("No Voter datagrams in the trace")
+    host = args.trace_host or collections.Counter(d for _, _, d, _ in packets).most_common(1)[0][0]
+    packets = [(t, dst, p) for t, src, dst, p in packets if src == host]
+    if not packets:
+        raise SystemExit(f"No datagrams from {host} in the trace")
+    client = args.client or collections.Counter(d for _, d, _ in packets).most_common(1)[0][0]
+    packets = [(t, p) for t, dst, p in packets if dst == client]
+    print(f"[*] {len(packets)} {host} -> {client} datagrams in {args.pcap}")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('0.0.0.0', args.port))
+    addr, digest = wait_for_client(sock, args.host_pwd)
+
+    # One signed keepalive first: the client goes CONNECTED on it
+    sock.sendto(struct.pack(HEADER_FMT, int(time.time()), 0, SERVER_CHALLENGE, digest,
+                            PAYLOAD_GPS), addr)
+    time.sleep(0.1)
+
+    sock.setblocking(False)
+    sent = collections.Counter()
+    t_first = packets[0][0]
+    stamps = [struct.unpack('>II', p[:8]) for _, p in packets]
+    stamp_first = next((s + ns / 1e9 for s, ns in stamps if s), 0.0)
+
+    for rep in range(args.repeat):
+        start = time.time()
+        shift = start + args.lead_ms / 1000.0 - stamp_first
+        for k, (t, payload) in enumerate(packets):
+            if args.burst:
+                send_at = start + (k // args.burst) * args.burst_ms / 1000.0
+            else:
+                send_at = start + (t - t_first) / args.speed
+            while time.time() < send_at:
+                try:
+                    sock.recvfrom(4096)  # Drain uplink traffic
+                except BlockingIOError:
+                    time.sleep(0.0002)
+
+            sec, nsec, _, _, ptype = struct.unpack(HEADER_FMT, payload[:HEADER_SIZE])
+            if args.retime and sec:
+                stamp = sec + nsec / 1e9 + shift
+                sec = int(stamp)
+                nsec = int(round((stamp - sec) * 1e9)) % 1000000000
+            pkt = struct.pack(HEADER_FMT, sec, nsec, SERVER_CHALLENGE, digest, ptype)
+            sock.sendto(pkt + payload[HEADER_SIZE:], addr)
+            sent[ptype] += 1
+
+    total = sum(sent.values())
+    print(f"[*] Done: {total} sent ({', '.join(f'{TYPE_NAMES.get(k, k)} {v}' for k, v in sorted(sent.items()))})")
+    print("    Plus 1 GPS keepalive. Compare with the RX lines of CLI [V] on the client.")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+"""
+Voter Ping Host - host side stand-in for round-trip latency tests.
+
+Acts as a minimal Voter host:
+  - answers the client's auth request,
+  - echoes the client's PAYLOAD_PING requests back, re-signed with the host
+    challenge/digest and the payload unchanged (the client then reports
+    RTT min/avg/max/percentiles on CLI [Q] and the web status page),
+  - sends its own pings (as chan_voter's "voter ping" does), which also
+    moves the client to CONNECTED, and measures the client's echo.
+
+Impairments can be added to the echoes to check that the client measures
+what the network does: --delay-ms, --jitter-ms, --drop.
+
+If this machine's clock is NTP/GPS disciplined, the uplink one-way delay is
+printed from the GPS send time in each client ping.
+
+Examples:
+  python voter_ping_host.py
+  python voter_ping_host.py --delay-ms 25 --jitter-ms 10 --drop 5
+"""
+import argparse
+import random
+import socket
+import struct
+import time
+import zlib
+
+# Protocol (see voter_host.py / VoterProtocol.h)
+PAYLOAD_AUTH = 0
+PAYLOAD_PING = 5
+HEADER_FMT = '>II10sIH'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+PING_FMT = '>IIIII'  # magic, seq, txtime sec, txtime nsec, txMicros
+PING_MAGIC = 0x54565047
+SERVER_CHALLENGE = b"1234567890"
+
+
+def voter_crc32(challenge, password):
+    """CRC32(challenge + password), C-string semantics (as in voter_host.py)"""
+    challenge = challenge.split(b'\x00')[0]
+    return zlib.crc32(password, zlib.crc32(challenge)) & 0xFFFFFFFF
+
+
+def percentile(sorted_vals, pct):
+    """Nearest rank, as LatencyHistogram::getPercentile()"""
+    rank = max(1, (len(sorted_vals) * pct + 99) // 100)
+    return sorted_vals[rank - 1]
+
+
+def summary(name, rtts, sent):
+    if not rtts:
+        print(f"[*] {name}: {sent} sent, no replies")
+        return
+    s = sorted(rtts)
+    print(f"[*] {name}: {sent} sent, {len(s)} replies | RTT min {s[0]:.2f} / "
+          f"avg {sum(s) / len(s):.2f} / max {s[-1]:.2f} ms | "
+          f"p50 {percentile(s, 50):.2f} p90 {percentile(s, 90):.2f} "
+          f"p99 {percentile(s, 99):.2f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Answer TeensyVoter pings")
+    parser.add_argument('--port', type=int, default=1667)
+    parser.add_argument('--host-pwd', type=str, default="bloodhound")
+    parser.add_argument('--delay-ms', type=float, default=0.0, help='Added to each echo')
+    parser.add_argument('--jitter-ms', type=float, default=0.0, help='Random extra delay (0..N)')
+    parser.add_argument('--drop', type=float, default=0.0, help='Percent of echoes dropped')
+    parser.add_argument('--ping-interval', type=float, default=1.0,
+                        help='Seconds between host pings (0 = off, client never connects)')
+    parser.add_argument('--seconds', type=float, default=0.0, help='Run time (0 = until Ctrl-C)')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('0.0.0.0', args.port))
+    sock.setblocking(False)
+    print(f"[*] Ping host on 0.0.0.0:{args.port}")
+
+    client = None        # (addr, digest we sign with)
+    pending = []         # (send_at, packet) delayed echoes
+    host_seq = 0
+    host_sent = {}       # seq -> send time
+    host_rtts = []
+    echoed = dropped = 0
+    uplink = []
+    next_host_ping = 0.0
+    end = time.time() + args.seconds if args.seconds > 0 else None
+
+    try:
+        while end is None or time.time() < end:
+            now = time.time()
+
+            # 1. Delayed echoes that are due
+            due = [p for p in pending if p[0] <= now]
+            pending = [p for p in pending if p[0] > now]
+            for _, pkt in due:
+                sock.sendto(pkt, client[0])
+                echoed += 1
+
+            # 2. Host pings (also what makes the client go CONNECTED)
+            if client and args.ping_interval > 0 and now >= next_host_ping:
+                next_host_ping = now + args.ping_interval
+                hdr = struct.pack(HEADER_FMT, int(now), int((now % 1) * 1e9),
+                                  SERVER_CHALLENGE, client[1], PAYLOAD_PING)
+                sock.sendto(hdr + struct.pack('>I', host_seq) + bytes(16), client[0])
+                host_sent[host_seq] = now
+                host_seq += 1
+
+            # 3. Receive
+            try:
+                data, addr = sock.recvfrom(4096)
+            except BlockingIOError:
+                time.sleep(0.0002)
+                continue
+            rx = time.time()
+            if len(data) < HEADER_SIZE:
+                continue
+            sec, nsec, chal, digest, ptype = struct.unpack(HEADER_FMT, data[:HEADER_SIZE])
+            sign = voter_crc32(chal, args.host_pwd.encode('ascii'))
+
+            if ptype == PAYLOAD_AUTH:
+                sock.sendto(struct.pack(HEADER_FMT, 0, 0, SERVER_CHALLENGE, sign,
+                                        PAYLOAD_AUTH), addr)
+                if digest != 0 and client is None:
+                    print(f"[+] Client {addr[0]}:{addr[1]} authenticated")
+                    client = (addr, sign)
+                continue
+
+            if ptype != PAYLOAD_PING or client is None:
+                continue
+            payload = data[HEADER_SIZE:]
+
+            if len(payload) >= struct.calcsize(PING_FMT) and \
+                    struct.unpack('>I', payload[:4])[0] == PING_MAGIC:
+                # Client ping: echo back re-signed, payload untouched
+                _, seq, tsec, tnsec, _ = struct.unpack(PING_FMT, payload[:struct.calcsize(PING_FMT)])
+                if tsec:
+                    uplink.append((rx - (tsec + tnsec / 1e9)) * 1000.0)
+                if random.uniform(0, 100) < args.drop:
+                    dropped += 1
+                    continue
+                echo = struct.pack(HEADER_FMT, sec, nsec, SERVER_CHALLENGE,
+                                   client[1], PAYLOAD_PING) + payload
+                delay = (args.delay_ms + random.uniform(0, args.jitter_ms)) / 1000.0
+                if delay > 0:
+                    pending.append((rx + delay, echo))
+                else:
+                    sock.sendto(echo, client[0])
+                    echoed += 1
+            elif len(payload) >= 4:
+                # Echo of one of our host pings
+                seq = struct.unpack('>I', payload[:4])[0]
+                if seq in host_sent:
+                    host_rtts.append((rx - host_sent.pop(seq)) * 1000.0)
+    except KeyboardInterrupt:
+        pass
+
+    print(f"[*] Client pings: {echoed} echoed, {dropped} dropped")
+    if uplink:
+        s = sorted(uplink)
+        print(f"[*] Uplink one-way (client GPS -> host clock): median {percentile(s, 50):.2f} ms")
+    summary("Host pings", host_rtts, host_seq)
+
+
+if __name__ == "__main__":
+    main()
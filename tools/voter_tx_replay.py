@@ -0,0 +1,147 @@
+"""
+Voter TX Replay - host side test for the downlink (TX) audio path.
+
+Acts as a minimal Voter host: answers the client's auth request, then sends
+timed uLaw frames (PAYLOAD_ULAW, VTIME = host clock) so the client's jitter
+buffer, GPS-timed playout and PTT can be exercised. Network impairments
+(jitter, loss, reordering) can be injected to drive the client's
+late/early/lost counters (CLI [A] on the Teensy).
+
+The host clock must be GPS/NTP disciplined for timed playout to line up;
+use --offset-ms to compensate a known offset.
+
+Examples:
+  python voter_tx_replay.py --tone 1000 --seconds 5
+  python voter_tx_replay.py --wav test.wav --jitter-ms 40 --drop 2
+  python voter_tx_replay.py --marker --seconds 10   # 1 click per frame (scope)
+"""
+import argparse
+import math
+import random
+import socket
+import struct
+import time
+import wave
+import zlib
+
+# Protocol (see voter_host.py / VoterProtocol.h)
+PAYLOAD_AUTH = 0
+PAYLOAD_ULAW = 1
+HEADER_FMT = '>II10sIH'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+
+FRAME_SIZE = 160   # 20ms @ 8kHz
+FRAME_SEC = 0.020
+SERVER_CHALLENGE = b"1234567890"
+
+
+def voter_crc32(challenge, password):
+    """CRC32(challenge + password), C-string semantics (as in voter_host.py)"""
+    challenge = challenge.split(b'\x00')[0]
+    return zlib.crc32(password, zlib.crc32(challenge)) & 0xFFFFFFFF
+
+
+def ulaw_encode(pcm):
+    """G.711 uLaw, same as ulawEncode() in ULaw.h"""
+    mask = 0xFF
+    if pcm < 0:
+        pcm = -pcm
+        mask = 0x7F
+    pcm = min(pcm, 32635) + 0x84
+    seg = pcm.bit_length() - 8
+    return ((seg << 4) | ((pcm >> (seg + 3)) & 0x0F)) ^ mask
+
+
+def source_frames(args):
+    """Yield FRAME_SIZE lists of int16 samples"""
+    total = int(args.seconds / FRAME_SEC)
+    if args.wav:
+        with wave.open(args.wav, 'rb') as w:
+            if w.getframerate() != 8000 or w.getsampwidth() != 2 or w.getnchannels() != 1:
+                raise SystemExit("WAV must be 8kHz, 16-bit, mono")
+            while True:
+                raw = w.readframes(FRAME_SIZE)
+                if len(raw) < FRAME_SIZE * 2:
+                    return
+                yield list(struct.unpack('<%dh' % FRAME_SIZE, raw))
+    n = 0
+    for _ in range(total):
+        if args.marker:
+            frame = [0] * FRAME_SIZE
+            frame[0] = 20000  # Click at the frame timestamp
+        else:
+            frame = [int(args.level * math.sin(2 * math.pi * args.tone * (n + i) / 8000.0))
+                     for i in range(FRAME_SIZE)]
+        n += FRAME_SIZE
+        yield frame
+
+
+def wait_for_client(sock, host_pwd):
+    """Answer auth until the client signs our challenge; return its address.
+    The client goes CONNECTED on our first signed non-auth packet (the audio)."""
+    print("[*] Waiting for client auth...")
+    while True:
+        data, addr = sock.recvfrom(4096)
+        if len(data) < HEADER_SIZE:
+            continue
+        sec, nsec, chal, digest, ptype = struct.unpack(HEADER_FMT, data[:HEADER_SIZE])
+        reply_digest = voter_crc32(chal, host_pwd.encode('ascii'))
+        if digest != 0:
+            print(f"[+] Client {addr[0]}:{addr[1]} answered our challenge")
+            return addr, reply_digest
+        if ptype == PAYLOAD_AUTH:
+            sock.sendto(struct.pack(HEADER_FMT, 0, 0, SERVER_CHALLENGE, reply_digest,
+                                    PAYLOAD_AUTH), addr)
+            print(f"    Auth reply to {addr[0]}:{addr[1]}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay timed TX audio to a TeensyVoter")
+    parser.add_argument('--port', type=int, default=1667)
+    parser.add_argument('--host-pwd', type=str, default="bloodhound")
+    parser.add_argument('--wav', type=str, help='8kHz 16-bit mono WAV to send')
+    parser.add_argument('--tone', type=float, default=1000.0, help='Tone (Hz) if no WAV')
+    parser.add_argument('--level', type=float, default=8000.0, help='Tone peak (int16)')
+    parser.add_argument('--marker', action='store_true', help='One click per frame')
+    parser.add_argument('--seconds', type=float, default=5.0)
+    parser.add_argument('--jitter-ms', type=float, default=0.0, help='Random send delay (0..N)')
+    parser.add_argument('--drop', type=float, default=0.0, help='Percent of frames dropped')
+    parser.add_argument('--offset-ms', type=float, default=0.0, help='Added to timestamps')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('0.0.0.0', args.port))
+    addr, digest = wait_for_client(sock, args.host_pwd)
+
+    # Stamp frames on 20ms boundaries, starting a little in the future
+    start = math.floor(time.time() / FRAME_SEC + 5) * FRAME_SEC
+    queue = []  # (send_at, packet)
+    sent = dropped = 0
+    for k, frame in enumerate(source_frames(args)):
+        stamp = start + k * FRAME_SEC + args.offset_ms / 1000.0
+        sec = int(stamp)
+        nsec = int(round((stamp - sec) * 1e9))
+        pkt = struct.pack(HEADER_FMT, sec, nsec, SERVER_CHALLENGE, digest, PAYLOAD_ULAW)
+        pkt += b'\x00' + bytes(ulaw_encode(s) for s in frame)  # RSSI 0 + audio
+        if random.uniform(0, 100) < args.drop:
+            dropped += 1
+            continue
+        send_at = start + k * FRAME_SEC + random.uniform(0, args.jitter_ms) / 1000.0
+        queue.append((send_at, pkt))
+
+    queue.sort(key=lambda q: q[0])  # Jitter may reorder
+    print(f"[*] Sending {len(queue)} frames ({dropped} dropped), first at {start:.3f}")
+    sock.setblocking(False)
+    for send_at, pkt in queue:
+        while time.time() < send_at:
+            try:
+                sock.recvfrom(4096)  # Drain uplink traffic
+            except BlockingIOError:
+                time.sleep(0.0005)
+        sock.sendto(pkt, addr)
+        sent += 1
+    print(f"[*] Done: {sent} sent. Check CLI [A] on the client for late/early/lost.")
+
+
+if __name__ == "__main__":
+    main()